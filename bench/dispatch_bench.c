@@ -0,0 +1,117 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "cpu.h"
+#include "mmu.h"
+#include "log.h"
+
+#if defined(YOBEMAG_JIT)
+    #include "jit.h"
+#endif
+
+#define INSTRUCTIONS (100000000u)
+
+#if defined(YOBEMAG_JIT)
+    #define DISPATCH_NAME "jit"
+#elif defined(YOBEMAG_BLOCK_CACHE)
+    #define DISPATCH_NAME "block cache"
+#elif defined(YOBEMAG_THREADED_DISPATCH)
+    #define DISPATCH_NAME "threaded"
+#else
+    #define DISPATCH_NAME "table"
+#endif
+
+typedef struct Workload {
+    const char *name;
+    uint16_t address;
+    const uint8_t *code;
+    uint16_t size;
+} Workload;
+
+// Register-to-register loads, 16-bit increments, a NOP and a backwards jump.
+// Only instructions which do not depend on memory contents are used so that the loop never leaves WRAM.
+static const uint8_t register_loop[] = {
+    0x41,      // LD B, C
+    0x03,      // INC BC
+    0x57,      // LD D, A
+    0x00,      // NOP
+    0x5A,      // LD E, D
+    0x7B,      // LD A, E
+    0x03,      // INC BC
+    0x18, 0xF7 // JR -9
+};
+
+// A checksum over 128 bytes of WRAM which writes its results back, like the inner loops of CPU test ROMs
+static const uint8_t memory_loop[] = {
+    0x21, 0x00, 0xD0, // LD HL, 0xD000
+    0x11, 0x00, 0xD1, // LD DE, 0xD100
+    0x2A,             // LD A, (HL+)
+    0x86,             // ADD A, (HL)
+    0xA8,             // XOR A, B
+    0x47,             // LD B, A
+    0x12,             // LD (DE), A
+    0x1C,             // INC E
+    0x88,             // ADC A, B
+    0x77,             // LD (HL), A
+    0x7D,             // LD A, L
+    0xFE, 0x80,       // CP A, 0x80
+    0x20, 0xF3,       // JR NZ, -13
+    0x2E, 0x00,       // LD L, 0
+    0x18, 0xEF        // JR -17
+};
+
+// Counters in HRAM, where games keep their hottest variables
+static const uint8_t hram_loop[] = {
+    0xF0, 0x80, // LDH A, (0x80)
+    0x3C,       // INC A
+    0xE0, 0x80, // LDH (0x80), A
+    0xF0, 0x81, // LDH A, (0x81)
+    0x80,       // ADD A, B
+    0xE0, 0x81, // LDH (0x81), A
+    0x18, 0xF4  // JR -12
+};
+
+static const Workload workloads[] = {
+    {"register", 0xC000, register_loop, sizeof(register_loop)},
+    {"memory", 0xC100, memory_loop, sizeof(memory_loop)},
+    {"hram", 0xC200, hram_loop, sizeof(hram_loop)},
+};
+
+static double elapsed_seconds(const struct timespec *start, const struct timespec *end) {
+    return (double) (end->tv_sec - start->tv_sec) + (double) (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void run_workload(const Workload *workload) {
+    mmu_init();
+    cpu_init();
+    for (uint16_t i = 0; i < workload->size; ++i) {
+        mmu_write_byte((uint16_t) (workload->address + i), workload->code[i]);
+    }
+    cpu.PC = workload->address;
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    cpu_step_n(INSTRUCTIONS);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double seconds = elapsed_seconds(&start, &end);
+    // the emulated clock runs at 4.194304 MHz on hardware
+    printf("%-11s dispatch, %-8s loop: %u instructions in %.3fs (%.1f MIPS, %.1f emulated MHz)\n", DISPATCH_NAME,
+           workload->name, INSTRUCTIONS, seconds, (double) INSTRUCTIONS / seconds / 1e6,
+           (double) cpu.cycle_count / seconds / 1e6);
+}
+
+int main(void) {
+    log_set_lvl(ERROR);
+
+#if defined(YOBEMAG_JIT)
+    jit_init();
+#endif
+    for (size_t i = 0; i < sizeof(workloads) / sizeof(workloads[0]); ++i) {
+        run_workload(&workloads[i]);
+    }
+
+    return EXIT_SUCCESS;
+}
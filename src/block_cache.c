@@ -0,0 +1,96 @@
+#define LOG_CATEGORY LOG_CAT_CPU
+
+#include <string.h>
+
+#include "block_cache.h"
+#include "log.h"
+
+/******************************************************
+ *** LOCAL VARIABLES                                ***
+ ******************************************************/
+
+// Direct-mapped, must be a power of two
+#define BLOCK_CACHE_SIZE (2048)
+
+static Block blocks[BLOCK_CACHE_SIZE];
+
+// Bumping a page's generation invalidates all blocks covering it without having to search for them
+static uint32_t page_generation[CODE_PAGE_COUNT];
+
+uint8_t block_cache_code_pages[CODE_PAGE_COUNT];
+uint32_t block_cache_epoch;
+
+/******************************************************
+ *** LOCAL METHODS                                  ***
+ ******************************************************/
+
+__attribute__((const)) static inline uint_fast16_t block_cache_slot(uint16_t pc, uint16_t bank) {
+    return (uint_fast16_t) (pc ^ (bank << 5)) & (BLOCK_CACHE_SIZE - 1);
+}
+
+__attribute__((pure)) static inline uint8_t first_page(const Block *block) {
+    return (uint8_t) (block->start >> CODE_PAGE_SHIFT);
+}
+
+__attribute__((pure)) static inline uint8_t last_page(const Block *block) {
+    return (uint8_t) ((block->end - 1) >> CODE_PAGE_SHIFT);
+}
+
+/******************************************************
+ *** EXPOSED METHODS                                ***
+ ******************************************************/
+
+Block *block_cache_find(uint16_t pc, uint16_t bank) {
+    Block *block = &blocks[block_cache_slot(pc, bank)];
+
+    if (block->op_count == 0 || block->start != pc || block->bank != bank) {
+        return NULL;
+    }
+
+    if (block->generation[0] != page_generation[first_page(block)] ||
+        block->generation[1] != page_generation[last_page(block)]) {
+        return NULL;
+    }
+
+    return block;
+}
+
+Block *block_cache_alloc(uint16_t pc, uint16_t bank) {
+    Block *block    = &blocks[block_cache_slot(pc, bank)];
+    block->start    = pc;
+    block->bank     = bank;
+    block->op_count = 0;
+#if defined(YOBEMAG_JIT)
+    block->exec_count = 0;
+    block->jit_code   = NULL;
+#endif
+
+    return block;
+}
+
+void block_cache_commit(Block *block) {
+    uint8_t first = first_page(block);
+    uint8_t last  = last_page(block);
+
+    block->generation[0]          = page_generation[first];
+    block->generation[1]          = page_generation[last];
+    block_cache_code_pages[first] = 1;
+    block_cache_code_pages[last]  = 1;
+
+    LOG_DEBUG("Cached block 0x%04X-0x%04X (bank %u, %u ops)", block->start, block->end, block->bank,
+              block->op_count);
+}
+
+void block_cache_invalidate_page(uint8_t page) {
+    LOG_DEBUG("Invalidating blocks on code page 0x%02X", page);
+
+    block_cache_code_pages[page] = 0;
+    ++page_generation[page];
+    ++block_cache_epoch;
+}
+
+void block_cache_flush(void) {
+    memset(blocks, 0, sizeof(blocks));
+    memset(block_cache_code_pages, 0, sizeof(block_cache_code_pages));
+    ++block_cache_epoch;
+}
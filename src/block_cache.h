@@ -0,0 +1,99 @@
+#ifndef YOBEMAG_BLOCK_CACHE_H
+#define YOBEMAG_BLOCK_CACHE_H
+
+#include <stdint.h>
+
+#include "cpu.h"
+
+#define BLOCK_MAX_OPS   (32)
+#define CODE_PAGE_SHIFT (8)
+#define CODE_PAGE_COUNT (0x10000 >> CODE_PAGE_SHIFT)
+
+/**
+ * @brief A single pre-decoded instruction
+ */
+typedef struct MicroOp {
+    op_function execute;
+    uint16_t operand;
+    uint8_t opcode;
+    uint8_t length;
+    uint8_t cycles;
+} MicroOp;
+
+/**
+ * @brief Native translation of a block, returns the number of instructions it executed
+ *
+ * @note  Executes at least the whole block, hence @p budget must not be smaller than the block's op count.
+ */
+typedef uint32_t (*jit_function)(uint32_t budget);
+
+/**
+ * @brief Straight-line run of instructions, decoded once and keyed by its (bank, start address)
+ *
+ * @note  A block ends after the first instruction which can change the control flow,
+ *        hence only the last micro-op of a block may modify the PC.
+ */
+typedef struct Block {
+    uint16_t start;
+    uint16_t bank;
+    /**
+     * @brief First address after the block's last instruction
+     */
+    uint16_t end;
+    uint8_t op_count;
+    /**
+     * @brief Upper bound of the cycles a single pass through the block takes, including taken branches
+     */
+    uint16_t max_cycles;
+    /**
+     * @brief Generations of the first and last code page covered by this block at decode time
+     */
+    uint32_t generation[2];
+#if defined(YOBEMAG_JIT)
+    uint32_t exec_count;
+    jit_function jit_code;
+#endif
+    MicroOp ops[BLOCK_MAX_OPS];
+} Block;
+
+/**
+ * @brief Non-zero for every code page that is covered by at least one cached block
+ */
+extern uint8_t block_cache_code_pages[CODE_PAGE_COUNT];
+
+/**
+ * @brief Incremented on every invalidation and by ::cpu_yield(), allows the executor to notice self-modifying code
+ *        and state changes which require leaving the current block cheaply
+ */
+extern uint32_t block_cache_epoch;
+
+/**
+ * @brief   Find a valid block starting at @p pc in @p bank
+ *
+ * @return  The cached block or NULL on a miss
+ */
+__attribute__((pure)) Block *block_cache_find(uint16_t pc, uint16_t bank);
+
+/**
+ * @brief   Get the slot for a block starting at @p pc in @p bank, evicting its previous content
+ *
+ * @note    The caller fills in the micro-ops and `end`, then publishes the block via ::block_cache_commit()
+ */
+Block *block_cache_alloc(uint16_t pc, uint16_t bank);
+
+void block_cache_commit(Block *block);
+void block_cache_invalidate_page(uint8_t page);
+void block_cache_flush(void);
+
+/**
+ * @brief Drop every block covering the page of @p addr, called for each write to memory
+ */
+static inline void block_cache_invalidate(uint16_t addr) {
+    uint8_t page = (uint8_t) (addr >> CODE_PAGE_SHIFT);
+
+    if (__builtin_expect(block_cache_code_pages[page], 0)) {
+        block_cache_invalidate_page(page);
+    }
+}
+
+#endif // YOBEMAG_BLOCK_CACHE_H
@@ -11,7 +11,9 @@
  *** LOCAL VARIABLES                                ***
  ******************************************************/
 
-static const char *usage_str = "Usage: yobemag [-l <0..4>] <ROM>";
+static const char *usage_str =
+    "Usage: yobemag [-l <0..4>] [-t <cpu|mmu|lcd|rom>] [-J] [-u] [-I] [-P <profile>] [-S <sym>] [-T <trace>] "
+    "[-C <timeline>] [-H] [-F <stats>] [-V <coverage>] [-M <heatmap>] [-R] [-B] <ROM>";
 
 /******************************************************
  *** LOCAL METHODS                                  ***
@@ -48,17 +50,78 @@ void cli_parse(CLIArguments *const cli_args, const int argc, char **const argv)
     }
 
     // set default values
-    cli_args->logging_level = FATAL;
+    cli_args->logging_level      = FATAL;
+    cli_args->trace_categories   = 0;
+    cli_args->jit                = true;
+    cli_args->unthrottled        = false;
+    cli_args->idle_loop_skipping = true;
+    cli_args->profile_path       = NULL;
+    cli_args->sym_path           = NULL;
+    cli_args->trace_path         = NULL;
+    cli_args->timeline_path      = NULL;
+    cli_args->perf_counters      = false;
+    cli_args->frame_stats_path   = NULL;
+    cli_args->coverage_path      = NULL;
+    cli_args->heatmap_path       = NULL;
+    cli_args->rtc_host_time      = false;
+    cli_args->boot_rom           = false;
 
     // parse all options first
     int strtol_in;
     int c;
-    while ((c = getopt(argc, argv, "l:")) != -1) {
+    LogCategory category;
+    while ((c = getopt(argc, argv, "l:t:JuIP:S:T:C:HF:V:M:RB")) != -1) {
         switch (c) {
             case 'l':
                 safe_strtol(optarg, &strtol_in);
                 cli_args->logging_level = (LoggingLevel) strtol_in;
                 break;
+            case 't':
+                category = log_category_from_name(optarg);
+                if (category == LOG_CAT_COUNT) {
+                    YOBEMAG_EXIT("Unknown trace category %s! %s", optarg, usage_str);
+                }
+                cli_args->trace_categories |= 1u << category;
+                break;
+            case 'J':
+                cli_args->jit = false;
+                break;
+            case 'u':
+                cli_args->unthrottled = true;
+                break;
+            case 'I':
+                cli_args->idle_loop_skipping = false;
+                break;
+            case 'P':
+                cli_args->profile_path = optarg;
+                break;
+            case 'S':
+                cli_args->sym_path = optarg;
+                break;
+            case 'T':
+                cli_args->trace_path = optarg;
+                break;
+            case 'C':
+                cli_args->timeline_path = optarg;
+                break;
+            case 'H':
+                cli_args->perf_counters = true;
+                break;
+            case 'F':
+                cli_args->frame_stats_path = optarg;
+                break;
+            case 'V':
+                cli_args->coverage_path = optarg;
+                break;
+            case 'M':
+                cli_args->heatmap_path = optarg;
+                break;
+            case 'R':
+                cli_args->rtc_host_time = true;
+                break;
+            case 'B':
+                cli_args->boot_rom = true;
+                break;
             default:
                 YOBEMAG_EXIT("%s", usage_str);
         }
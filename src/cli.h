@@ -2,6 +2,7 @@
 #define YOBEMAG_CLI_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 #include "log.h"
 
@@ -10,9 +11,68 @@
  */
 typedef struct CLIArguments {
     /**
-     * @brief Indicates the minimum logging level (checked by ::log_str())
+     * @brief Indicates the minimum logging level (checked by the `LOG_*` macros)
      */
     LoggingLevel logging_level;
+    /**
+     * @brief Bitmask of ::LogCategory values whose debug output should be printed regardless of ::logging_level
+     */
+    uint32_t trace_categories;
+    /**
+     * @brief Translate hot blocks to native code, only has an effect if built with `JIT=1`
+     */
+    bool jit;
+    /**
+     * @brief Run as fast as possible instead of sleeping to keep the emulated clock in sync with the wall clock
+     */
+    bool unthrottled;
+    /**
+     * @brief Skip the passes of idle loops up to the next event, see ::cpu_set_idle_loop_skipping()
+     */
+    bool idle_loop_skipping;
+    /**
+     * @brief Write sampled call stacks to this file on exit, NULL if the profiler is not used
+     */
+    const char *profile_path;
+    /**
+     * @brief RGBDS symbol file used to name the functions in the profile, may be NULL
+     */
+    const char *sym_path;
+    /**
+     * @brief Record a binary trace of the executed instructions to this file, NULL if not tracing.
+     *        Only has an effect if built with `TRACE=1`
+     */
+    const char *trace_path;
+    /**
+     * @brief Write a Chrome trace-event timeline of frames, scanlines, interrupts and SDL calls here, may be NULL
+     */
+    const char *timeline_path;
+    /**
+     * @brief Read host performance counters around every frame and print their percentiles on exit
+     */
+    bool perf_counters;
+    /**
+     * @brief Write histograms of the host time per frame as JSON here on exit and on SIGUSR1, may be NULL
+     */
+    const char *frame_stats_path;
+    /**
+     * @brief Write a bitmap of the executed ROM bytes to this file and print the coverage per bank on exit, NULL if
+     *        not recording. Only has an effect if built with `ROM_COVERAGE=1`
+     */
+    const char *coverage_path;
+    /**
+     * @brief Write the reads and writes per memory page as CSV to this file on exit, NULL if not recording.
+     *        Only has an effect if built with `MEM_HEATMAP=1`
+     */
+    const char *heatmap_path;
+    /**
+     * @brief Let the clock of MBC3 cartridges follow the host's wall clock instead of the emulated one
+     */
+    bool rtc_host_time;
+    /**
+     * @brief Run the boot ROM from 0x0000 instead of starting at 0x0100 in the state it leaves behind
+     */
+    bool boot_rom;
     /**
      * @brief Propagated to ::rom_load() to create a memory map to rom file
      */
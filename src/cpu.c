@@ -1,14 +1,42 @@
+#define LOG_CATEGORY LOG_CAT_CPU
+
 #include <stdint.h>
+#include <inttypes.h>
 
 #include "mmu.h"
 #include "cpu.h"
 #include "log.h"
+#include "scheduler.h"
+#include "interrupt.h"
+#include "timer.h"
+#include "opcode_profile.h"
+#include "pc_profiler.h"
+#include "trace.h"
+#include "rom_coverage.h"
+
+#include <stdbool.h>
+
+#if defined(YOBEMAG_BLOCK_CACHE)
+    #include "block_cache.h"
+#endif
+
+#if defined(YOBEMAG_JIT)
+    #include "jit.h"
+#endif
+
+#if defined(YOBEMAG_PROFILE) && defined(YOBEMAG_JIT)
+    #error "Native blocks cannot be profiled, YOBEMAG_PROFILE requires the JIT to be disabled"
+#endif
+
+#if defined(YOBEMAG_TRACE) && defined(YOBEMAG_BLOCK_CACHE)
+    #error "Recording would more than halve the speed of the block cache, YOBEMAG_TRACE requires it to be disabled"
+#endif
 
 #define LO_NIBBLE_MASK (0x0F)
 #define HI_NIBBLE_MASK (0xF0)
 #define BYTE_MASK      (0xFF)
 
-typedef void (*op_function)(void);
+#define BREAKPOINT_BITS (0x10000 / 8)
 
 // Function is used for instruction array initialization, not recognized by compiler
 #pragma GCC diagnostic push
@@ -36,10 +64,7 @@ _Noreturn static void UNKNOWN_OPCODE(void) {
 
 // internal prototypes
 void OPC_RST_x(uint16_t address);
-void OPC_LD_xx_u16(uint16_t load_addr);
-
-static op_function instr_lookup[0xFF + 1]       = {[0 ... 0xFF] = &UNKNOWN_OPCODE};
-static op_function cb_prefixed_lookup[0xFF + 1] = {[0 ... 0xFF] = &UNKNOWN_OPCODE};
+void OPC_LD_xx_u16(uint16_t *dreg);
 
 CPU cpu = {
     .HL.dword = 0,
@@ -52,337 +77,972 @@ CPU cpu = {
     0,
 };
 
+// One bit per address, ::cpu_run() only looks at them while at least one is set
+static uint8_t breakpoints[BREAKPOINT_BITS];
+static unsigned breakpoint_count;
+
+// Set by event handlers to end the current ::cpu_run()
+static bool stop_requested;
+
+// The executors return once the clock reaches it, ::cpu_yield() lowers it to leave early
+static uint64_t execute_until;
+
+// Longest loop body (without the branch) which is checked for being idle, polling loops are only a few bytes long
+#define IDLE_LOOP_MAX_LENGTH (16)
+
+// Backward branch taken last in the current batch of instructions, see idle_loop_check()
+static struct {
+    bool valid;
+    uint16_t branch;
+    uint16_t af;
+    uint64_t cycle;
+    // Branch of the last loop whose body cannot be idle, keeps busy loops from being analysed on every pass
+    uint16_t busy;
+} idle_loop;
+
+static bool idle_loop_skipping = true;
+static uint64_t idle_cycles_skipped;
+
 __attribute__((always_inline)) inline static void LD_REG_REG(uint8_t *register_one, uint8_t register_two) {
     *register_one = register_two;
 }
 
 static void LD_REG_d8(uint8_t *reg_addr) {
-    uint8_t immediate = mmu_get_byte(cpu.PC + 1);
-    LD_REG_REG(reg_addr, immediate);
+    LD_REG_REG(reg_addr, CPU_OPERAND_U8);
 }
 
-static void optable_init(void) {
-    // Set up lookup table
-    instr_lookup[0x00] = OPC_NOP;
-    instr_lookup[0xF3] = OPC_DI;
-    instr_lookup[0x03] = OPC_INC_BC;
+// Bit fields of an opcode xx yyy zzz: y is the destination register (or ALU operation, bit index), z the source
+#define OPCODE_Y(opcode) (((opcode) >> 3) & 0x07)
+#define OPCODE_Z(opcode) ((opcode) & 0x07)
+
+// Register index of the memory operand (HL)
+#define REG_HL_INDIRECT (6)
+
+// Registers in the order of their 3-bit encoding, (HL) has no entry as it is a memory operand
+static uint8_t *const reg_index[8] = {
+    &CPU_REG_B, &CPU_REG_C, &CPU_REG_D, &CPU_REG_E, &CPU_REG_H, &CPU_REG_L, NULL, &CPU_REG_A};
+
+// Overriding the UNKNOWN_OPCODE default of a range designator is intended here
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Woverride-init"
+
+static const op_function instr_lookup[0xFF + 1] = {
+    [0 ... 0xFF] = &UNKNOWN_OPCODE,
 
-    instr_lookup[0x31] = OPC_LD_SP;
+    [0x00] = OPC_NOP,
+    [0xF3] = OPC_DI,
+    [0xFB] = OPC_EI,
+    [0xC9] = OPC_RET,
+    [0xD9] = OPC_RETI,
+    [0x03] = OPC_INC_BC,
 
     // misc
-    instr_lookup[0x20] = OPC_JR_NZ;
-    instr_lookup[0x30] = OPC_JR_NC;
-    instr_lookup[0x28] = OPC_JR_Z;
-    instr_lookup[0x38] = OPC_JR_C;
+    [0x20] = OPC_JR_NZ,
+    [0x30] = OPC_JR_NC,
+    [0x28] = OPC_JR_Z,
+    [0x38] = OPC_JR_C,
 
-    instr_lookup[0xC2] = OPC_JP_NZ;
-    instr_lookup[0xD2] = OPC_JP_NC;
-    instr_lookup[0xCA] = OPC_JP_Z;
-    instr_lookup[0xDA] = OPC_JP_C;
+    [0xC2] = OPC_JP_NZ,
+    [0xD2] = OPC_JP_NC,
+    [0xCA] = OPC_JP_Z,
+    [0xDA] = OPC_JP_C,
 
     // 8-bit loads
-    instr_lookup[0x02] = OPC_LD_BC_A;
-    instr_lookup[0x12] = OPC_LD_DE_A;
-    instr_lookup[0x22] = OPC_LD_HL_PLUS_A;
-    instr_lookup[0x32] = OPC_LD_HL_MINUS_A;
-
-    instr_lookup[0x0A] = OPC_LD_A_BC;
-    instr_lookup[0x1A] = OPC_LD_A_DE;
-    instr_lookup[0x2A] = OPC_LD_A_HL_PLUS;
-    instr_lookup[0x3A] = OPC_LD_A_HL_MINUS;
-
-    instr_lookup[0xE0] = OPC_LD_FF00a8_A;
-    instr_lookup[0xE2] = OPC_LD_FF00C_A;
-    instr_lookup[0xF0] = OPC_LD_A_FF00a8;
-    instr_lookup[0xF2] = OPC_LD_A_FF00C;
-
-    instr_lookup[0xEA] = OPC_LD_a16_A;
-    instr_lookup[0xFA] = OPC_LD_A_a16;
-
-    instr_lookup[0x40] = OPC_LD_B_B;
-    instr_lookup[0x41] = OPC_LD_B_C;
-    instr_lookup[0x42] = OPC_LD_B_D;
-    instr_lookup[0x43] = OPC_LD_B_E;
-    instr_lookup[0x44] = OPC_LD_B_H;
-    instr_lookup[0x45] = OPC_LD_B_L;
-    instr_lookup[0x46] = OPC_LD_B_HL;
-    instr_lookup[0x47] = OPC_LD_B_A;
-    instr_lookup[0x06] = OPC_LD_B_d8;
-
-    instr_lookup[0x48] = OPC_LD_C_B;
-    instr_lookup[0x49] = OPC_LD_C_C;
-    instr_lookup[0x4A] = OPC_LD_C_D;
-    instr_lookup[0x4B] = OPC_LD_C_E;
-    instr_lookup[0x4C] = OPC_LD_C_H;
-    instr_lookup[0x4D] = OPC_LD_C_L;
-    instr_lookup[0x4E] = OPC_LD_C_HL;
-    instr_lookup[0x4F] = OPC_LD_C_A;
-    instr_lookup[0x0E] = OPC_LD_C_d8;
-
-    instr_lookup[0x50] = OPC_LD_D_B;
-    instr_lookup[0x51] = OPC_LD_D_C;
-    instr_lookup[0x52] = OPC_LD_D_D;
-    instr_lookup[0x53] = OPC_LD_D_E;
-    instr_lookup[0x54] = OPC_LD_D_H;
-    instr_lookup[0x55] = OPC_LD_D_L;
-    instr_lookup[0x56] = OPC_LD_D_HL;
-    instr_lookup[0x57] = OPC_LD_D_A;
-    instr_lookup[0x16] = OPC_LD_D_d8;
-
-    instr_lookup[0x58] = OPC_LD_E_B;
-    instr_lookup[0x59] = OPC_LD_E_C;
-    instr_lookup[0x5A] = OPC_LD_E_D;
-    instr_lookup[0x5B] = OPC_LD_E_E;
-    instr_lookup[0x5C] = OPC_LD_E_H;
-    instr_lookup[0x5D] = OPC_LD_E_L;
-    instr_lookup[0x5E] = OPC_LD_E_HL;
-    instr_lookup[0x5F] = OPC_LD_E_A;
-    instr_lookup[0x1E] = OPC_LD_E_d8;
-
-    instr_lookup[0x60] = OPC_LD_H_B;
-    instr_lookup[0x61] = OPC_LD_H_C;
-    instr_lookup[0x62] = OPC_LD_H_D;
-    instr_lookup[0x63] = OPC_LD_H_E;
-    instr_lookup[0x64] = OPC_LD_H_H;
-    instr_lookup[0x65] = OPC_LD_H_L;
-    instr_lookup[0x66] = OPC_LD_H_HL;
-    instr_lookup[0x67] = OPC_LD_H_A;
-    instr_lookup[0x26] = OPC_LD_H_d8;
-
-    instr_lookup[0x68] = OPC_LD_L_B;
-    instr_lookup[0x69] = OPC_LD_L_C;
-    instr_lookup[0x6A] = OPC_LD_L_D;
-    instr_lookup[0x6B] = OPC_LD_L_E;
-    instr_lookup[0x6C] = OPC_LD_L_H;
-    instr_lookup[0x6D] = OPC_LD_L_L;
-    instr_lookup[0x6E] = OPC_LD_L_HL;
-    instr_lookup[0x6F] = OPC_LD_L_A;
-    instr_lookup[0x2E] = OPC_LD_L_d8;
-
-    instr_lookup[0x70] = OPC_LD_HL_B;
-    instr_lookup[0x71] = OPC_LD_HL_C;
-    instr_lookup[0x72] = OPC_LD_HL_D;
-    instr_lookup[0x73] = OPC_LD_HL_E;
-    instr_lookup[0x74] = OPC_LD_HL_H;
-    instr_lookup[0x75] = OPC_LD_HL_L;
-    instr_lookup[0x77] = OPC_LD_HL_A;
-    instr_lookup[0x36] = OPC_LD_HL_d8;
-
-    instr_lookup[0x78] = OPC_LD_A_B;
-    instr_lookup[0x79] = OPC_LD_A_C;
-    instr_lookup[0x7A] = OPC_LD_A_D;
-    instr_lookup[0x7B] = OPC_LD_A_E;
-    instr_lookup[0x7C] = OPC_LD_A_H;
-    instr_lookup[0x7D] = OPC_LD_A_L;
-    instr_lookup[0x7E] = OPC_LD_A_HL;
-    instr_lookup[0x7F] = OPC_LD_A_A;
-    instr_lookup[0x3E] = OPC_LD_A_d8;
-
-    // 8-bit ALU: ADD A,n
-    instr_lookup[0x80] = OPC_ADD_A_B;
-    instr_lookup[0x81] = OPC_ADD_A_C;
-    instr_lookup[0x82] = OPC_ADD_A_D;
-    instr_lookup[0x83] = OPC_ADD_A_E;
-    instr_lookup[0x84] = OPC_ADD_A_H;
-    instr_lookup[0x85] = OPC_ADD_A_L;
-    instr_lookup[0x86] = OPC_ADD_A_HL;
-    instr_lookup[0x87] = OPC_ADD_A_A;
-    instr_lookup[0xC6] = OPC_ADD_A_d8;
-
-    // 8-bit ALU: ADC A,n
-    instr_lookup[0x88] = OPC_ADC_A_B;
-    instr_lookup[0x89] = OPC_ADC_A_C;
-    instr_lookup[0x8A] = OPC_ADC_A_D;
-    instr_lookup[0x8B] = OPC_ADC_A_E;
-    instr_lookup[0x8C] = OPC_ADC_A_H;
-    instr_lookup[0x8D] = OPC_ADC_A_L;
-    instr_lookup[0x8E] = OPC_ADC_A_HL;
-    instr_lookup[0x8F] = OPC_ADC_A_A;
-    instr_lookup[0xCE] = OPC_ADC_A_d8;
-
-    // 8-bit ALU: SUB A,n
-    instr_lookup[0x90] = OPC_SUB_A_B;
-    instr_lookup[0x91] = OPC_SUB_A_C;
-    instr_lookup[0x92] = OPC_SUB_A_D;
-    instr_lookup[0x93] = OPC_SUB_A_E;
-    instr_lookup[0x94] = OPC_SUB_A_H;
-    instr_lookup[0x95] = OPC_SUB_A_L;
-    instr_lookup[0x96] = OPC_SUB_A_HL;
-    instr_lookup[0x97] = OPC_SUB_A_A;
-    instr_lookup[0xD6] = OPC_SUB_A_d8;
-
-    // 8-bit ALU: SUB A,n
-    instr_lookup[0x98] = OPC_SBC_A_B;
-    instr_lookup[0x99] = OPC_SBC_A_C;
-    instr_lookup[0x9A] = OPC_SBC_A_D;
-    instr_lookup[0x9B] = OPC_SBC_A_E;
-    instr_lookup[0x9C] = OPC_SBC_A_H;
-    instr_lookup[0x9D] = OPC_SBC_A_L;
-    instr_lookup[0x9E] = OPC_SBC_A_HL;
-    instr_lookup[0x9F] = OPC_SBC_A_A;
-    instr_lookup[0xDE] = OPC_SBC_A_d8;
-
-    // 8-bit ALU: AND A,n
-    instr_lookup[0xA0] = OPC_AND_A_B;
-    instr_lookup[0xA1] = OPC_AND_A_C;
-    instr_lookup[0xA2] = OPC_AND_A_D;
-    instr_lookup[0xA3] = OPC_AND_A_E;
-    instr_lookup[0xA4] = OPC_AND_A_H;
-    instr_lookup[0xA5] = OPC_AND_A_L;
-    instr_lookup[0xA6] = OPC_AND_A_HL;
-    instr_lookup[0xA7] = OPC_AND_A_A;
-    instr_lookup[0xE6] = OPC_AND_A_d8;
-
-    // 8-bit ALU: OR A,n
-    instr_lookup[0xB0] = OPC_OR_A_B;
-    instr_lookup[0xB1] = OPC_OR_A_C;
-    instr_lookup[0xB2] = OPC_OR_A_D;
-    instr_lookup[0xB3] = OPC_OR_A_E;
-    instr_lookup[0xB4] = OPC_OR_A_H;
-    instr_lookup[0xB5] = OPC_OR_A_L;
-    instr_lookup[0xB6] = OPC_OR_A_HL;
-    instr_lookup[0xB7] = OPC_OR_A_A;
-    instr_lookup[0xF6] = OPC_OR_A_d8;
-
-    // 8-bit ALU: XOR A,n
-    instr_lookup[0xA8] = OPC_XOR_A_B;
-    instr_lookup[0xA9] = OPC_XOR_A_C;
-    instr_lookup[0xAA] = OPC_XOR_A_D;
-    instr_lookup[0xAB] = OPC_XOR_A_E;
-    instr_lookup[0xAC] = OPC_XOR_A_H;
-    instr_lookup[0xAD] = OPC_XOR_A_L;
-    instr_lookup[0xAE] = OPC_XOR_A_HL;
-    instr_lookup[0xAF] = OPC_XOR_A_A;
-    instr_lookup[0xEE] = OPC_XOR_A_d8;
-
-    // 8-bit ALU: CP A,n
-    instr_lookup[0xB8] = OPC_CP_A_B;
-    instr_lookup[0xB9] = OPC_CP_A_C;
-    instr_lookup[0xBA] = OPC_CP_A_D;
-    instr_lookup[0xBB] = OPC_CP_A_E;
-    instr_lookup[0xBC] = OPC_CP_A_H;
-    instr_lookup[0xBD] = OPC_CP_A_L;
-    instr_lookup[0xBE] = OPC_CP_A_HL;
-    instr_lookup[0xBF] = OPC_CP_A_A;
-    instr_lookup[0xFE] = OPC_CP_A_d8;
-
-    // 8-bit: ALU: INC n
-    instr_lookup[0x04] = OPC_INC_B;
-    instr_lookup[0x0C] = OPC_INC_C;
-    instr_lookup[0x14] = OPC_INC_D;
-    instr_lookup[0x1C] = OPC_INC_E;
-    instr_lookup[0x24] = OPC_INC_H;
-    instr_lookup[0x2C] = OPC_INC_L;
-    instr_lookup[0x34] = OPC_INC_HL;
-    instr_lookup[0x3C] = OPC_INC_A;
-
-    // 8-bit ALU: DEC n
-    instr_lookup[0x05] = OPC_DEC_B;
-    instr_lookup[0x0D] = OPC_DEC_C;
-    instr_lookup[0x15] = OPC_DEC_D;
-    instr_lookup[0x1D] = OPC_DEC_E;
-    instr_lookup[0x25] = OPC_DEC_H;
-    instr_lookup[0x2D] = OPC_DEC_L;
-    instr_lookup[0x35] = OPC_DEC_HL;
-    instr_lookup[0x3D] = OPC_DEC_A;
-
-    instr_lookup[0xCF] = OPC_RST_08;
-    instr_lookup[0xDF] = OPC_RST_18;
-    instr_lookup[0xEF] = OPC_RST_28;
-    instr_lookup[0xFF] = OPC_RST_38;
+    [0x02] = OPC_LD_BC_A,
+    [0x12] = OPC_LD_DE_A,
+    [0x22] = OPC_LD_HL_PLUS_A,
+    [0x32] = OPC_LD_HL_MINUS_A,
+
+    [0x0A] = OPC_LD_A_BC,
+    [0x1A] = OPC_LD_A_DE,
+    [0x2A] = OPC_LD_A_HL_PLUS,
+    [0x3A] = OPC_LD_A_HL_MINUS,
+
+    [0xE0] = OPC_LD_FF00a8_A,
+    [0xE2] = OPC_LD_FF00C_A,
+    [0xF0] = OPC_LD_A_FF00a8,
+    [0xF2] = OPC_LD_A_FF00C,
+
+    [0xEA] = OPC_LD_a16_A,
+    [0xFA] = OPC_LD_A_a16,
+
+    // 8-bit loads with the registers encoded in the opcode: LD r, r' (01 yyy zzz) and LD r, d8 (00 yyy 110)
+    [0x40 ... 0x7F] = OPC_LD_r_r,
+    [0x46]          = OPC_LD_r_HL,
+    [0x4E]          = OPC_LD_r_HL,
+    [0x56]          = OPC_LD_r_HL,
+    [0x5E]          = OPC_LD_r_HL,
+    [0x66]          = OPC_LD_r_HL,
+    [0x6E]          = OPC_LD_r_HL,
+    [0x7E]          = OPC_LD_r_HL,
+    [0x70 ... 0x77] = OPC_LD_HL_r,
+    [0x76]          = OPC_HALT,
+
+    [0x06] = OPC_LD_r_d8,
+    [0x0E] = OPC_LD_r_d8,
+    [0x16] = OPC_LD_r_d8,
+    [0x1E] = OPC_LD_r_d8,
+    [0x26] = OPC_LD_r_d8,
+    [0x2E] = OPC_LD_r_d8,
+    [0x36] = OPC_LD_HL_d8,
+    [0x3E] = OPC_LD_r_d8,
+
+    // 8-bit ALU: ADD, ADC, SUB, SBC, AND, XOR, OR, CP A,n with the operation in y (10 yyy zzz and 11 yyy 110)
+    [0x80 ... 0xBF] = OPC_ALU_A_r,
+    [0x86]          = OPC_ALU_A_HL,
+    [0x8E]          = OPC_ALU_A_HL,
+    [0x96]          = OPC_ALU_A_HL,
+    [0x9E]          = OPC_ALU_A_HL,
+    [0xA6]          = OPC_ALU_A_HL,
+    [0xAE]          = OPC_ALU_A_HL,
+    [0xB6]          = OPC_ALU_A_HL,
+    [0xBE]          = OPC_ALU_A_HL,
+
+    [0xC6] = OPC_ALU_A_d8,
+    [0xCE] = OPC_ALU_A_d8,
+    [0xD6] = OPC_ALU_A_d8,
+    [0xDE] = OPC_ALU_A_d8,
+    [0xE6] = OPC_ALU_A_d8,
+    [0xEE] = OPC_ALU_A_d8,
+    [0xF6] = OPC_ALU_A_d8,
+    [0xFE] = OPC_ALU_A_d8,
+
+    // 8-bit: ALU: INC n (00 yyy 100)
+    [0x04] = OPC_INC_r,
+    [0x0C] = OPC_INC_r,
+    [0x14] = OPC_INC_r,
+    [0x1C] = OPC_INC_r,
+    [0x24] = OPC_INC_r,
+    [0x2C] = OPC_INC_r,
+    [0x34] = OPC_INC_HL,
+    [0x3C] = OPC_INC_r,
+
+    // 8-bit ALU: DEC n (00 yyy 101)
+    [0x05] = OPC_DEC_r,
+    [0x0D] = OPC_DEC_r,
+    [0x15] = OPC_DEC_r,
+    [0x1D] = OPC_DEC_r,
+    [0x25] = OPC_DEC_r,
+    [0x2D] = OPC_DEC_r,
+    [0x35] = OPC_DEC_HL,
+    [0x3D] = OPC_DEC_r,
+
+    // CB prefixed rotates, shifts and bit operations, decoded from the operand
+    [0xCB] = OPC_PREFIX_CB,
+
+    [0xCF] = OPC_RST_08,
+    [0xDF] = OPC_RST_18,
+    [0xEF] = OPC_RST_28,
+    [0xFF] = OPC_RST_38,
 
     // LD, XX u16
-    instr_lookup[0x01] = OPC_LD_BC_u16;
-    instr_lookup[0x11] = OPC_LD_DE_u16;
-    instr_lookup[0x21] = OPC_LD_HL_u16;
-    instr_lookup[0x31] = OPC_LD_SP_u16;
+    [0x01] = OPC_LD_BC_u16,
+    [0x11] = OPC_LD_DE_u16,
+    [0x21] = OPC_LD_HL_u16,
+    [0x31] = OPC_LD_SP_u16,
 
     // JR i8
-    instr_lookup[0x18] = OPC_JR_i8;
+    [0x18] = OPC_JR_i8,
 
     // CALL u16
-    instr_lookup[0xcd] = OPC_CALL_u16;
+    [0xCD] = OPC_CALL_u16,
 
     // CALL cc, u16
-    instr_lookup[0xc4] = OPC_CALL_NZ_u16;
-    instr_lookup[0xcc] = OPC_CALL_Z_u16;
-    instr_lookup[0xd4] = OPC_CALL_NC_u16;
-    instr_lookup[0xdc] = OPC_CALL_C_u16;
+    [0xC4] = OPC_CALL_NZ_u16,
+    [0xCC] = OPC_CALL_Z_u16,
+    [0xD4] = OPC_CALL_NC_u16,
+    [0xDC] = OPC_CALL_C_u16,
 
     // TODO: 0xC3
+};
 
-    cb_prefixed_lookup[0x0] = UNKNOWN_OPCODE;
-}
+// Flags written by an instruction (set, cleared or computed), as a mask over F
+#define FLAGS_NONE (0)
+#define FLAGS_NH   (1 << N_FLAG | 1 << H_FLAG)
+#define FLAGS_NHC  (1 << N_FLAG | 1 << H_FLAG | 1 << C_FLAG)
+#define FLAGS_ZHC  (1 << Z_FLAG | 1 << H_FLAG | 1 << C_FLAG)
+#define FLAGS_ZNH  (1 << Z_FLAG | 1 << N_FLAG | 1 << H_FLAG)
+#define FLAGS_ZNHC (1 << Z_FLAG | 1 << N_FLAG | 1 << H_FLAG | 1 << C_FLAG)
+
+/**
+ * Static description of an opcode. The executors advance PC by `length` and the clock by `cycles`
+ * before calling the handler, hence handlers only do the data work.
+ */
+typedef struct OpcodeInfo {
+    /**
+     * @brief Length in bytes including the opcode
+     */
+    uint8_t length;
+    /**
+     * @brief T-cycles, for conditional branches those of the branch not being taken
+     */
+    uint8_t cycles;
+    /**
+     * @brief T-cycles of a taken conditional branch, 0 for every other instruction
+     */
+    uint8_t cycles_taken;
+    /**
+     * @brief Flags written by the instruction, see FLAGS_*
+     */
+    uint8_t flags;
+    /**
+     * @brief The instruction may leave the straight-line path (jumps, calls, returns, restarts, HALT/STOP, DI/EI)
+     */
+    bool ends_block;
+} OpcodeInfo;
+
+// CB prefixed instructions take 8 cycles on a register, the extra cycles of (HL) operands are added by the handler
+static const OpcodeInfo opcode_info[0xFF + 1] = {
+    [0x00] = {1, 4, 0, FLAGS_NONE, false},  // NOP
+    [0x01] = {3, 12, 0, FLAGS_NONE, false}, // LD BC, d16
+    [0x02] = {1, 8, 0, FLAGS_NONE, false},  // LD (BC), A
+    [0x03] = {1, 8, 0, FLAGS_NONE, false},  // INC BC
+    [0x04] = {1, 4, 0, FLAGS_ZNH, false},   // INC B
+    [0x05] = {1, 4, 0, FLAGS_ZNH, false},   // DEC B
+    [0x06] = {2, 8, 0, FLAGS_NONE, false},  // LD B, d8
+    [0x07] = {1, 4, 0, FLAGS_ZNHC, false},  // RLCA
+    [0x08] = {3, 20, 0, FLAGS_NONE, false}, // LD (a16), SP
+    [0x09] = {1, 8, 0, FLAGS_NHC, false},   // ADD HL, BC
+    [0x0A] = {1, 8, 0, FLAGS_NONE, false},  // LD A, (BC)
+    [0x0B] = {1, 8, 0, FLAGS_NONE, false},  // DEC BC
+    [0x0C] = {1, 4, 0, FLAGS_ZNH, false},   // INC C
+    [0x0D] = {1, 4, 0, FLAGS_ZNH, false},   // DEC C
+    [0x0E] = {2, 8, 0, FLAGS_NONE, false},  // LD C, d8
+    [0x0F] = {1, 4, 0, FLAGS_ZNHC, false},  // RRCA
+    [0x10] = {2, 4, 0, FLAGS_NONE, true},   // STOP
+    [0x11] = {3, 12, 0, FLAGS_NONE, false}, // LD DE, d16
+    [0x12] = {1, 8, 0, FLAGS_NONE, false},  // LD (DE), A
+    [0x13] = {1, 8, 0, FLAGS_NONE, false},  // INC DE
+    [0x14] = {1, 4, 0, FLAGS_ZNH, false},   // INC D
+    [0x15] = {1, 4, 0, FLAGS_ZNH, false},   // DEC D
+    [0x16] = {2, 8, 0, FLAGS_NONE, false},  // LD D, d8
+    [0x17] = {1, 4, 0, FLAGS_ZNHC, false},  // RLA
+    [0x18] = {2, 12, 0, FLAGS_NONE, true},  // JR r8
+    [0x19] = {1, 8, 0, FLAGS_NHC, false},   // ADD HL, DE
+    [0x1A] = {1, 8, 0, FLAGS_NONE, false},  // LD A, (DE)
+    [0x1B] = {1, 8, 0, FLAGS_NONE, false},  // DEC DE
+    [0x1C] = {1, 4, 0, FLAGS_ZNH, false},   // INC E
+    [0x1D] = {1, 4, 0, FLAGS_ZNH, false},   // DEC E
+    [0x1E] = {2, 8, 0, FLAGS_NONE, false},  // LD E, d8
+    [0x1F] = {1, 4, 0, FLAGS_ZNHC, false},  // RRA
+    [0x20] = {2, 8, 12, FLAGS_NONE, true},  // JR NZ, r8
+    [0x21] = {3, 12, 0, FLAGS_NONE, false}, // LD HL, d16
+    [0x22] = {1, 8, 0, FLAGS_NONE, false},  // LD (HL+), A
+    [0x23] = {1, 8, 0, FLAGS_NONE, false},  // INC HL
+    [0x24] = {1, 4, 0, FLAGS_ZNH, false},   // INC H
+    [0x25] = {1, 4, 0, FLAGS_ZNH, false},   // DEC H
+    [0x26] = {2, 8, 0, FLAGS_NONE, false},  // LD H, d8
+    [0x27] = {1, 4, 0, FLAGS_ZHC, false},   // DAA
+    [0x28] = {2, 8, 12, FLAGS_NONE, true},  // JR Z, r8
+    [0x29] = {1, 8, 0, FLAGS_NHC, false},   // ADD HL, HL
+    [0x2A] = {1, 8, 0, FLAGS_NONE, false},  // LD A, (HL+)
+    [0x2B] = {1, 8, 0, FLAGS_NONE, false},  // DEC HL
+    [0x2C] = {1, 4, 0, FLAGS_ZNH, false},   // INC L
+    [0x2D] = {1, 4, 0, FLAGS_ZNH, false},   // DEC L
+    [0x2E] = {2, 8, 0, FLAGS_NONE, false},  // LD L, d8
+    [0x2F] = {1, 4, 0, FLAGS_NH, false},    // CPL
+    [0x30] = {2, 8, 12, FLAGS_NONE, true},  // JR NC, r8
+    [0x31] = {3, 12, 0, FLAGS_NONE, false}, // LD SP, d16
+    [0x32] = {1, 8, 0, FLAGS_NONE, false},  // LD (HL-), A
+    [0x33] = {1, 8, 0, FLAGS_NONE, false},  // INC SP
+    [0x34] = {1, 12, 0, FLAGS_ZNH, false},  // INC (HL)
+    [0x35] = {1, 12, 0, FLAGS_ZNH, false},  // DEC (HL)
+    [0x36] = {2, 12, 0, FLAGS_NONE, false}, // LD (HL), d8
+    [0x37] = {1, 4, 0, FLAGS_NHC, false},   // SCF
+    [0x38] = {2, 8, 12, FLAGS_NONE, true},  // JR C, r8
+    [0x39] = {1, 8, 0, FLAGS_NHC, false},   // ADD HL, SP
+    [0x3A] = {1, 8, 0, FLAGS_NONE, false},  // LD A, (HL-)
+    [0x3B] = {1, 8, 0, FLAGS_NONE, false},  // DEC SP
+    [0x3C] = {1, 4, 0, FLAGS_ZNH, false},   // INC A
+    [0x3D] = {1, 4, 0, FLAGS_ZNH, false},   // DEC A
+    [0x3E] = {2, 8, 0, FLAGS_NONE, false},  // LD A, d8
+    [0x3F] = {1, 4, 0, FLAGS_NHC, false},   // CCF
+    [0x40] = {1, 4, 0, FLAGS_NONE, false},  // LD B, B
+    [0x41] = {1, 4, 0, FLAGS_NONE, false},  // LD B, C
+    [0x42] = {1, 4, 0, FLAGS_NONE, false},  // LD B, D
+    [0x43] = {1, 4, 0, FLAGS_NONE, false},  // LD B, E
+    [0x44] = {1, 4, 0, FLAGS_NONE, false},  // LD B, H
+    [0x45] = {1, 4, 0, FLAGS_NONE, false},  // LD B, L
+    [0x46] = {1, 8, 0, FLAGS_NONE, false},  // LD B, (HL)
+    [0x47] = {1, 4, 0, FLAGS_NONE, false},  // LD B, A
+    [0x48] = {1, 4, 0, FLAGS_NONE, false},  // LD C, B
+    [0x49] = {1, 4, 0, FLAGS_NONE, false},  // LD C, C
+    [0x4A] = {1, 4, 0, FLAGS_NONE, false},  // LD C, D
+    [0x4B] = {1, 4, 0, FLAGS_NONE, false},  // LD C, E
+    [0x4C] = {1, 4, 0, FLAGS_NONE, false},  // LD C, H
+    [0x4D] = {1, 4, 0, FLAGS_NONE, false},  // LD C, L
+    [0x4E] = {1, 8, 0, FLAGS_NONE, false},  // LD C, (HL)
+    [0x4F] = {1, 4, 0, FLAGS_NONE, false},  // LD C, A
+    [0x50] = {1, 4, 0, FLAGS_NONE, false},  // LD D, B
+    [0x51] = {1, 4, 0, FLAGS_NONE, false},  // LD D, C
+    [0x52] = {1, 4, 0, FLAGS_NONE, false},  // LD D, D
+    [0x53] = {1, 4, 0, FLAGS_NONE, false},  // LD D, E
+    [0x54] = {1, 4, 0, FLAGS_NONE, false},  // LD D, H
+    [0x55] = {1, 4, 0, FLAGS_NONE, false},  // LD D, L
+    [0x56] = {1, 8, 0, FLAGS_NONE, false},  // LD D, (HL)
+    [0x57] = {1, 4, 0, FLAGS_NONE, false},  // LD D, A
+    [0x58] = {1, 4, 0, FLAGS_NONE, false},  // LD E, B
+    [0x59] = {1, 4, 0, FLAGS_NONE, false},  // LD E, C
+    [0x5A] = {1, 4, 0, FLAGS_NONE, false},  // LD E, D
+    [0x5B] = {1, 4, 0, FLAGS_NONE, false},  // LD E, E
+    [0x5C] = {1, 4, 0, FLAGS_NONE, false},  // LD E, H
+    [0x5D] = {1, 4, 0, FLAGS_NONE, false},  // LD E, L
+    [0x5E] = {1, 8, 0, FLAGS_NONE, false},  // LD E, (HL)
+    [0x5F] = {1, 4, 0, FLAGS_NONE, false},  // LD E, A
+    [0x60] = {1, 4, 0, FLAGS_NONE, false},  // LD H, B
+    [0x61] = {1, 4, 0, FLAGS_NONE, false},  // LD H, C
+    [0x62] = {1, 4, 0, FLAGS_NONE, false},  // LD H, D
+    [0x63] = {1, 4, 0, FLAGS_NONE, false},  // LD H, E
+    [0x64] = {1, 4, 0, FLAGS_NONE, false},  // LD H, H
+    [0x65] = {1, 4, 0, FLAGS_NONE, false},  // LD H, L
+    [0x66] = {1, 8, 0, FLAGS_NONE, false},  // LD H, (HL)
+    [0x67] = {1, 4, 0, FLAGS_NONE, false},  // LD H, A
+    [0x68] = {1, 4, 0, FLAGS_NONE, false},  // LD L, B
+    [0x69] = {1, 4, 0, FLAGS_NONE, false},  // LD L, C
+    [0x6A] = {1, 4, 0, FLAGS_NONE, false},  // LD L, D
+    [0x6B] = {1, 4, 0, FLAGS_NONE, false},  // LD L, E
+    [0x6C] = {1, 4, 0, FLAGS_NONE, false},  // LD L, H
+    [0x6D] = {1, 4, 0, FLAGS_NONE, false},  // LD L, L
+    [0x6E] = {1, 8, 0, FLAGS_NONE, false},  // LD L, (HL)
+    [0x6F] = {1, 4, 0, FLAGS_NONE, false},  // LD L, A
+    [0x70] = {1, 8, 0, FLAGS_NONE, false},  // LD (HL), B
+    [0x71] = {1, 8, 0, FLAGS_NONE, false},  // LD (HL), C
+    [0x72] = {1, 8, 0, FLAGS_NONE, false},  // LD (HL), D
+    [0x73] = {1, 8, 0, FLAGS_NONE, false},  // LD (HL), E
+    [0x74] = {1, 8, 0, FLAGS_NONE, false},  // LD (HL), H
+    [0x75] = {1, 8, 0, FLAGS_NONE, false},  // LD (HL), L
+    [0x76] = {1, 4, 0, FLAGS_NONE, true},   // HALT
+    [0x77] = {1, 8, 0, FLAGS_NONE, false},  // LD (HL), A
+    [0x78] = {1, 4, 0, FLAGS_NONE, false},  // LD A, B
+    [0x79] = {1, 4, 0, FLAGS_NONE, false},  // LD A, C
+    [0x7A] = {1, 4, 0, FLAGS_NONE, false},  // LD A, D
+    [0x7B] = {1, 4, 0, FLAGS_NONE, false},  // LD A, E
+    [0x7C] = {1, 4, 0, FLAGS_NONE, false},  // LD A, H
+    [0x7D] = {1, 4, 0, FLAGS_NONE, false},  // LD A, L
+    [0x7E] = {1, 8, 0, FLAGS_NONE, false},  // LD A, (HL)
+    [0x7F] = {1, 4, 0, FLAGS_NONE, false},  // LD A, A
+    [0x80] = {1, 4, 0, FLAGS_ZNHC, false},  // ADD A, B
+    [0x81] = {1, 4, 0, FLAGS_ZNHC, false},  // ADD A, C
+    [0x82] = {1, 4, 0, FLAGS_ZNHC, false},  // ADD A, D
+    [0x83] = {1, 4, 0, FLAGS_ZNHC, false},  // ADD A, E
+    [0x84] = {1, 4, 0, FLAGS_ZNHC, false},  // ADD A, H
+    [0x85] = {1, 4, 0, FLAGS_ZNHC, false},  // ADD A, L
+    [0x86] = {1, 8, 0, FLAGS_ZNHC, false},  // ADD A, (HL)
+    [0x87] = {1, 4, 0, FLAGS_ZNHC, false},  // ADD A, A
+    [0x88] = {1, 4, 0, FLAGS_ZNHC, false},  // ADC A, B
+    [0x89] = {1, 4, 0, FLAGS_ZNHC, false},  // ADC A, C
+    [0x8A] = {1, 4, 0, FLAGS_ZNHC, false},  // ADC A, D
+    [0x8B] = {1, 4, 0, FLAGS_ZNHC, false},  // ADC A, E
+    [0x8C] = {1, 4, 0, FLAGS_ZNHC, false},  // ADC A, H
+    [0x8D] = {1, 4, 0, FLAGS_ZNHC, false},  // ADC A, L
+    [0x8E] = {1, 8, 0, FLAGS_ZNHC, false},  // ADC A, (HL)
+    [0x8F] = {1, 4, 0, FLAGS_ZNHC, false},  // ADC A, A
+    [0x90] = {1, 4, 0, FLAGS_ZNHC, false},  // SUB B
+    [0x91] = {1, 4, 0, FLAGS_ZNHC, false},  // SUB C
+    [0x92] = {1, 4, 0, FLAGS_ZNHC, false},  // SUB D
+    [0x93] = {1, 4, 0, FLAGS_ZNHC, false},  // SUB E
+    [0x94] = {1, 4, 0, FLAGS_ZNHC, false},  // SUB H
+    [0x95] = {1, 4, 0, FLAGS_ZNHC, false},  // SUB L
+    [0x96] = {1, 8, 0, FLAGS_ZNHC, false},  // SUB (HL)
+    [0x97] = {1, 4, 0, FLAGS_ZNHC, false},  // SUB A
+    [0x98] = {1, 4, 0, FLAGS_ZNHC, false},  // SBC A, B
+    [0x99] = {1, 4, 0, FLAGS_ZNHC, false},  // SBC A, C
+    [0x9A] = {1, 4, 0, FLAGS_ZNHC, false},  // SBC A, D
+    [0x9B] = {1, 4, 0, FLAGS_ZNHC, false},  // SBC A, E
+    [0x9C] = {1, 4, 0, FLAGS_ZNHC, false},  // SBC A, H
+    [0x9D] = {1, 4, 0, FLAGS_ZNHC, false},  // SBC A, L
+    [0x9E] = {1, 8, 0, FLAGS_ZNHC, false},  // SBC A, (HL)
+    [0x9F] = {1, 4, 0, FLAGS_ZNHC, false},  // SBC A, A
+    [0xA0] = {1, 4, 0, FLAGS_ZNHC, false},  // AND B
+    [0xA1] = {1, 4, 0, FLAGS_ZNHC, false},  // AND C
+    [0xA2] = {1, 4, 0, FLAGS_ZNHC, false},  // AND D
+    [0xA3] = {1, 4, 0, FLAGS_ZNHC, false},  // AND E
+    [0xA4] = {1, 4, 0, FLAGS_ZNHC, false},  // AND H
+    [0xA5] = {1, 4, 0, FLAGS_ZNHC, false},  // AND L
+    [0xA6] = {1, 8, 0, FLAGS_ZNHC, false},  // AND (HL)
+    [0xA7] = {1, 4, 0, FLAGS_ZNHC, false},  // AND A
+    [0xA8] = {1, 4, 0, FLAGS_ZNHC, false},  // XOR B
+    [0xA9] = {1, 4, 0, FLAGS_ZNHC, false},  // XOR C
+    [0xAA] = {1, 4, 0, FLAGS_ZNHC, false},  // XOR D
+    [0xAB] = {1, 4, 0, FLAGS_ZNHC, false},  // XOR E
+    [0xAC] = {1, 4, 0, FLAGS_ZNHC, false},  // XOR H
+    [0xAD] = {1, 4, 0, FLAGS_ZNHC, false},  // XOR L
+    [0xAE] = {1, 8, 0, FLAGS_ZNHC, false},  // XOR (HL)
+    [0xAF] = {1, 4, 0, FLAGS_ZNHC, false},  // XOR A
+    [0xB0] = {1, 4, 0, FLAGS_ZNHC, false},  // OR B
+    [0xB1] = {1, 4, 0, FLAGS_ZNHC, false},  // OR C
+    [0xB2] = {1, 4, 0, FLAGS_ZNHC, false},  // OR D
+    [0xB3] = {1, 4, 0, FLAGS_ZNHC, false},  // OR E
+    [0xB4] = {1, 4, 0, FLAGS_ZNHC, false},  // OR H
+    [0xB5] = {1, 4, 0, FLAGS_ZNHC, false},  // OR L
+    [0xB6] = {1, 8, 0, FLAGS_ZNHC, false},  // OR (HL)
+    [0xB7] = {1, 4, 0, FLAGS_ZNHC, false},  // OR A
+    [0xB8] = {1, 4, 0, FLAGS_ZNHC, false},  // CP B
+    [0xB9] = {1, 4, 0, FLAGS_ZNHC, false},  // CP C
+    [0xBA] = {1, 4, 0, FLAGS_ZNHC, false},  // CP D
+    [0xBB] = {1, 4, 0, FLAGS_ZNHC, false},  // CP E
+    [0xBC] = {1, 4, 0, FLAGS_ZNHC, false},  // CP H
+    [0xBD] = {1, 4, 0, FLAGS_ZNHC, false},  // CP L
+    [0xBE] = {1, 8, 0, FLAGS_ZNHC, false},  // CP (HL)
+    [0xBF] = {1, 4, 0, FLAGS_ZNHC, false},  // CP A
+    [0xC0] = {1, 8, 20, FLAGS_NONE, true},  // RET NZ
+    [0xC1] = {1, 12, 0, FLAGS_NONE, false}, // POP BC
+    [0xC2] = {3, 12, 16, FLAGS_NONE, true}, // JP NZ, a16
+    [0xC3] = {3, 16, 0, FLAGS_NONE, true},  // JP a16
+    [0xC4] = {3, 12, 24, FLAGS_NONE, true}, // CALL NZ, a16
+    [0xC5] = {1, 16, 0, FLAGS_NONE, false}, // PUSH BC
+    [0xC6] = {2, 8, 0, FLAGS_ZNHC, false},  // ADD A, d8
+    [0xC7] = {1, 16, 0, FLAGS_NONE, true},  // RST 00H
+    [0xC8] = {1, 8, 20, FLAGS_NONE, true},  // RET Z
+    [0xC9] = {1, 16, 0, FLAGS_NONE, true},  // RET
+    [0xCA] = {3, 12, 16, FLAGS_NONE, true}, // JP Z, a16
+    [0xCB] = {2, 8, 0, FLAGS_NONE, false},  // PREFIX CB
+    [0xCC] = {3, 12, 24, FLAGS_NONE, true}, // CALL Z, a16
+    [0xCD] = {3, 24, 0, FLAGS_NONE, true},  // CALL a16
+    [0xCE] = {2, 8, 0, FLAGS_ZNHC, false},  // ADC A, d8
+    [0xCF] = {1, 16, 0, FLAGS_NONE, true},  // RST 08H
+    [0xD0] = {1, 8, 20, FLAGS_NONE, true},  // RET NC
+    [0xD1] = {1, 12, 0, FLAGS_NONE, false}, // POP DE
+    [0xD2] = {3, 12, 16, FLAGS_NONE, true}, // JP NC, a16
+    [0xD3] = {1, 4, 0, FLAGS_NONE, false},  // illegal
+    [0xD4] = {3, 12, 24, FLAGS_NONE, true}, // CALL NC, a16
+    [0xD5] = {1, 16, 0, FLAGS_NONE, false}, // PUSH DE
+    [0xD6] = {2, 8, 0, FLAGS_ZNHC, false},  // SUB d8
+    [0xD7] = {1, 16, 0, FLAGS_NONE, true},  // RST 10H
+    [0xD8] = {1, 8, 20, FLAGS_NONE, true},  // RET C
+    [0xD9] = {1, 16, 0, FLAGS_NONE, true},  // RETI
+    [0xDA] = {3, 12, 16, FLAGS_NONE, true}, // JP C, a16
+    [0xDB] = {1, 4, 0, FLAGS_NONE, false},  // illegal
+    [0xDC] = {3, 12, 24, FLAGS_NONE, true}, // CALL C, a16
+    [0xDD] = {1, 4, 0, FLAGS_NONE, false},  // illegal
+    [0xDE] = {2, 8, 0, FLAGS_ZNHC, false},  // SBC A, d8
+    [0xDF] = {1, 16, 0, FLAGS_NONE, true},  // RST 18H
+    [0xE0] = {2, 12, 0, FLAGS_NONE, false}, // LDH (a8), A
+    [0xE1] = {1, 12, 0, FLAGS_NONE, false}, // POP HL
+    [0xE2] = {1, 8, 0, FLAGS_NONE, false},  // LD (C), A
+    [0xE3] = {1, 4, 0, FLAGS_NONE, false},  // illegal
+    [0xE4] = {1, 4, 0, FLAGS_NONE, false},  // illegal
+    [0xE5] = {1, 16, 0, FLAGS_NONE, false}, // PUSH HL
+    [0xE6] = {2, 8, 0, FLAGS_ZNHC, false},  // AND d8
+    [0xE7] = {1, 16, 0, FLAGS_NONE, true},  // RST 20H
+    [0xE8] = {2, 16, 0, FLAGS_ZNHC, false}, // ADD SP, r8
+    [0xE9] = {1, 4, 0, FLAGS_NONE, true},   // JP (HL)
+    [0xEA] = {3, 16, 0, FLAGS_NONE, false}, // LD (a16), A
+    [0xEB] = {1, 4, 0, FLAGS_NONE, false},  // illegal
+    [0xEC] = {1, 4, 0, FLAGS_NONE, false},  // illegal
+    [0xED] = {1, 4, 0, FLAGS_NONE, false},  // illegal
+    [0xEE] = {2, 8, 0, FLAGS_ZNHC, false},  // XOR d8
+    [0xEF] = {1, 16, 0, FLAGS_NONE, true},  // RST 28H
+    [0xF0] = {2, 12, 0, FLAGS_NONE, false}, // LDH A, (a8)
+    [0xF1] = {1, 12, 0, FLAGS_ZNHC, false}, // POP AF
+    [0xF2] = {1, 8, 0, FLAGS_NONE, false},  // LD A, (C)
+    [0xF3] = {1, 4, 0, FLAGS_NONE, true},   // DI
+    [0xF4] = {1, 4, 0, FLAGS_NONE, false},  // illegal
+    [0xF5] = {1, 16, 0, FLAGS_NONE, false}, // PUSH AF
+    [0xF6] = {2, 8, 0, FLAGS_ZNHC, false},  // OR d8
+    [0xF7] = {1, 16, 0, FLAGS_NONE, true},  // RST 30H
+    [0xF8] = {2, 12, 0, FLAGS_ZNHC, false}, // LD HL, SP+r8
+    [0xF9] = {1, 8, 0, FLAGS_NONE, false},  // LD SP, HL
+    [0xFA] = {3, 16, 0, FLAGS_NONE, false}, // LD A, (a16)
+    [0xFB] = {1, 4, 0, FLAGS_NONE, true},   // EI
+    [0xFC] = {1, 4, 0, FLAGS_NONE, false},  // illegal
+    [0xFD] = {1, 4, 0, FLAGS_NONE, false},  // illegal
+    [0xFE] = {2, 8, 0, FLAGS_ZNHC, false},  // CP d8
+    [0xFF] = {1, 16, 0, FLAGS_NONE, true},  // RST 38H
+};
+
+#pragma GCC diagnostic pop
 
 /* ------------------ CPU Funcs */
-void cpu_init(void) {
-    optable_init();
-
-    CPU_DREG_AF     = 0x01B0;
-    CPU_DREG_BC     = 0x0013;
-    CPU_DREG_DE     = 0x00D8;
-    CPU_DREG_HL     = 0x014D;
-    cpu.SP          = 0xFFFE;
-    cpu.PC          = 0x0100;
+static void reset(void) {
     cpu.cycle_count = 0;
+    cpu.halted      = false;
+
+    idle_loop.valid     = false;
+    idle_loop.busy      = 0;
+    idle_cycles_skipped = 0;
+}
+
+void cpu_init(void) {
+    reset();
+    CPU_DREG_AF = 0x01B0;
+    CPU_DREG_BC = 0x0013;
+    CPU_DREG_DE = 0x00D8;
+    CPU_DREG_HL = 0x014D;
+    cpu.SP      = 0xFFFE;
+    cpu.PC      = 0x0100;
+
+    mmu_unmap_boot_rom();
+}
+
+void cpu_power_on(void) {
+    reset();
+    CPU_DREG_AF = 0;
+    CPU_DREG_BC = 0;
+    CPU_DREG_DE = 0;
+    CPU_DREG_HL = 0;
+    cpu.SP      = 0;
+    cpu.PC      = 0x0000;
 }
 
 void cpu_print_registers(void) {
-    LOG_INFO("PC: %04X AF: %02X%02X, BC: %02X%02X, DE: %02X%02X, HL: %02X%02X, SP: %04X, cycles: %d", cpu.PC, CPU_REG_A,
-             CPU_REG_F, CPU_REG_B, CPU_REG_C, CPU_REG_D, CPU_REG_E, CPU_REG_H, CPU_REG_L, cpu.SP, cpu.cycle_count);
+    LOG_INFO("PC: %04X AF: %02X%02X, BC: %02X%02X, DE: %02X%02X, HL: %02X%02X, SP: %04X, cycles: %" PRIu64, cpu.PC,
+             CPU_REG_A, CPU_REG_F, CPU_REG_B, CPU_REG_C, CPU_REG_D, CPU_REG_E, CPU_REG_H, CPU_REG_L, cpu.SP,
+             cpu.cycle_count);
+}
+
+__attribute__((always_inline)) inline static uint16_t fetch_operand(uint16_t addr, uint8_t length) {
+    switch (length) {
+        case 2:
+            return mmu_get_byte((uint16_t) (addr + 1));
+        case 3:
+            return mmu_get_two_bytes((uint16_t) (addr + 1));
+        default:
+            return 0;
+    }
 }
 
+// Fetches opcode and operand, afterwards the PC points to the next instruction and the clock includes its cycles
+#define DECODE_INSTRUCTION()                                                                                            \
+    do {                                                                                                                \
+        LOG_DEBUG("PC 0x%04X", cpu.PC);                                                                                 \
+        LOG_DEBUG("MMU[PC]: 0x%04X", mmu_get_byte(cpu.PC));                                                             \
+        LOG_DEBUG("MMU[PC+1]: 0x%04X", mmu_get_byte(cpu.PC + 1));                                                       \
+        LOG_DEBUG("MMU[PC+2]: 0x%04X", mmu_get_byte(cpu.PC + 2));                                                       \
+                                                                                                                        \
+        uint16_t decode_pc     = cpu.PC;                                                                                \
+        const OpcodeInfo *info = &opcode_info[mmu_fetch_byte(decode_pc)];                                               \
+        cpu.opcode             = (uint8_t) (info - opcode_info);                                                        \
+        cpu.operand            = fetch_operand(decode_pc, info->length);                                                \
+        cpu.PC                 = (uint16_t) (decode_pc + info->length);                                                 \
+        cpu.cycle_count        = cpu.cycle_count + info->cycles;                                                        \
+        ROM_COVERAGE_MARK(decode_pc, info->length);                                                                     \
+    } while (0)
+
+#if defined(YOBEMAG_BLOCK_CACHE)
+
+// CB prefixed (HL) operands take up to 8 more cycles than the table lists
+__attribute__((const)) static uint8_t max_cycles(uint8_t opcode) {
+    const OpcodeInfo *info = &opcode_info[opcode];
+    uint8_t cycles         = info->cycles_taken > info->cycles ? info->cycles_taken : info->cycles;
+
+    return opcode == 0xCB ? (uint8_t) (cycles + 8) : cycles;
+}
+
+static Block *cpu_decode_block(uint16_t pc, uint16_t bank) {
+    Block *block  = block_cache_alloc(pc, bank);
+    uint16_t addr = pc;
+
+    const MicroOp *op;
+    do {
+        MicroOp *next = &block->ops[block->op_count++];
+        next->opcode  = mmu_get_byte(addr);
+        next->length  = opcode_info[next->opcode].length;
+        next->cycles  = opcode_info[next->opcode].cycles;
+        next->operand = fetch_operand(addr, next->length);
+        next->execute = instr_lookup[next->opcode];
+        addr          = (uint16_t) (addr + next->length);
+        op            = next;
+        // stop at the end of a 16 KiB region as the next one may be banked independently
+    } while (block->op_count < BLOCK_MAX_OPS && !opcode_info[op->opcode].ends_block && (addr & 0xC000) == (pc & 0xC000));
+
+    block->end        = addr;
+    block->max_cycles = 0;
+    for (uint8_t i = 0; i < block->op_count; ++i) {
+        block->max_cycles = (uint16_t) (block->max_cycles + max_cycles(block->ops[i].opcode));
+    }
+    block_cache_commit(block);
+
+    return block;
+}
+
+/**
+ * Executes pre-decoded blocks, hence opcodes and operands are only fetched from memory once per block.
+ * The budget of @p instructions is exact, a block is left early if it is larger than the remaining budget
+ * or once the clock reached @p until (or ::cpu_yield() was called).
+ */
+static void cpu_execute(uint_fast32_t instructions, uint64_t until) {
+    OPCODE_PROFILE_DECLARE();
+
+    execute_until = until;
+    while (instructions && cpu.cycle_count < execute_until) {
+        uint16_t bank = mmu_get_bank(cpu.PC);
+        Block *block  = block_cache_find(cpu.PC, bank);
+        if (block == NULL) {
+            block = cpu_decode_block(cpu.PC, bank);
+        }
+
+#if defined(YOBEMAG_JIT)
+        if (block->jit_code == NULL && jit_enabled && ++block->exec_count == JIT_THRESHOLD) {
+            jit_compile(block);
+            if (block->op_count == 0) {
+                // the code buffer was exhausted and the block cache flushed, the block has to be decoded again
+                continue;
+            }
+        }
+
+        // native blocks always run to their end and only count instructions, hence they are only used if the budget
+        // allows it and their instruction budget is limited to the passes which certainly end before `until`
+        uint64_t passes = 0;
+        if (block->jit_code != NULL && block->max_cycles != 0) {
+            passes = (execute_until - cpu.cycle_count) / block->max_cycles;
+        }
+        if (passes != 0 && instructions >= block->op_count) {
+            uint64_t budget = passes < instructions / block->op_count ? passes * block->op_count : instructions;
+            ROM_COVERAGE_MARK(block->start, (unsigned) (block->end - block->start));
+    #if defined(YOBEMAG_LAZY_FLAGS)
+            // native code computes F right away
+            cpu_sync_flags();
+    #endif
+            instructions -= block->jit_code(budget > UINT32_MAX ? UINT32_MAX : (uint32_t) budget);
+            continue;
+        }
+#endif
+
+        uint32_t epoch     = block_cache_epoch;
+        const MicroOp *op  = block->ops;
+        const MicroOp *end = op + (instructions < block->op_count ? instructions : block->op_count);
+        while (op != end) {
+            LOG_DEBUG("PC 0x%04X: 0x%02X", cpu.PC, op->opcode);
+
+            OPCODE_PROFILE_BEGIN();
+            ROM_COVERAGE_MARK(cpu.PC, op->length);
+            cpu.opcode      = op->opcode;
+            cpu.operand     = op->operand;
+            cpu.PC          = (uint16_t) (cpu.PC + op->length);
+            cpu.cycle_count += op->cycles;
+            (*(op->execute))();
+            OPCODE_PROFILE_END();
+            ++op;
+
+            // a write into a code page may have modified the remainder of this very block
+            if (__builtin_expect(block_cache_epoch != epoch || cpu.cycle_count >= execute_until, 0)) {
+                break;
+            }
+        }
+
+        instructions -= (uint_fast32_t) (op - block->ops);
+    }
+}
+
+#elif defined(YOBEMAG_THREADED_DISPATCH)
+
+    #define FOR_EACH_OPCODE(X)                                                                                          \
+        X(00) X(01) X(02) X(03) X(04) X(05) X(06) X(07) X(08) X(09) X(0A) X(0B) X(0C) X(0D) X(0E) X(0F)                 \
+        X(10) X(11) X(12) X(13) X(14) X(15) X(16) X(17) X(18) X(19) X(1A) X(1B) X(1C) X(1D) X(1E) X(1F)                 \
+        X(20) X(21) X(22) X(23) X(24) X(25) X(26) X(27) X(28) X(29) X(2A) X(2B) X(2C) X(2D) X(2E) X(2F)                 \
+        X(30) X(31) X(32) X(33) X(34) X(35) X(36) X(37) X(38) X(39) X(3A) X(3B) X(3C) X(3D) X(3E) X(3F)                 \
+        X(40) X(41) X(42) X(43) X(44) X(45) X(46) X(47) X(48) X(49) X(4A) X(4B) X(4C) X(4D) X(4E) X(4F)                 \
+        X(50) X(51) X(52) X(53) X(54) X(55) X(56) X(57) X(58) X(59) X(5A) X(5B) X(5C) X(5D) X(5E) X(5F)                 \
+        X(60) X(61) X(62) X(63) X(64) X(65) X(66) X(67) X(68) X(69) X(6A) X(6B) X(6C) X(6D) X(6E) X(6F)                 \
+        X(70) X(71) X(72) X(73) X(74) X(75) X(76) X(77) X(78) X(79) X(7A) X(7B) X(7C) X(7D) X(7E) X(7F)                 \
+        X(80) X(81) X(82) X(83) X(84) X(85) X(86) X(87) X(88) X(89) X(8A) X(8B) X(8C) X(8D) X(8E) X(8F)                 \
+        X(90) X(91) X(92) X(93) X(94) X(95) X(96) X(97) X(98) X(99) X(9A) X(9B) X(9C) X(9D) X(9E) X(9F)                 \
+        X(A0) X(A1) X(A2) X(A3) X(A4) X(A5) X(A6) X(A7) X(A8) X(A9) X(AA) X(AB) X(AC) X(AD) X(AE) X(AF)                 \
+        X(B0) X(B1) X(B2) X(B3) X(B4) X(B5) X(B6) X(B7) X(B8) X(B9) X(BA) X(BB) X(BC) X(BD) X(BE) X(BF)                 \
+        X(C0) X(C1) X(C2) X(C3) X(C4) X(C5) X(C6) X(C7) X(C8) X(C9) X(CA) X(CB) X(CC) X(CD) X(CE) X(CF)                 \
+        X(D0) X(D1) X(D2) X(D3) X(D4) X(D5) X(D6) X(D7) X(D8) X(D9) X(DA) X(DB) X(DC) X(DD) X(DE) X(DF)                 \
+        X(E0) X(E1) X(E2) X(E3) X(E4) X(E5) X(E6) X(E7) X(E8) X(E9) X(EA) X(EB) X(EC) X(ED) X(EE) X(EF)                 \
+        X(F0) X(F1) X(F2) X(F3) X(F4) X(F5) X(F6) X(F7) X(F8) X(F9) X(FA) X(FB) X(FC) X(FD) X(FE) X(FF)
+
+    #define DISPATCH_LABEL(op) [0x##op] = &&opcode_##op,
+
+    // instr_lookup is const, hence the compiler resolves (and usually inlines) each handler call at its label
+    #define DISPATCH_CASE(op)                                                                                           \
+        opcode_##op : (*(instr_lookup[0x##op]))();                                                                      \
+        OPCODE_PROFILE_END();                                                                                           \
+        DISPATCH();
+
+    #define DISPATCH()                                                                                                  \
+        do {                                                                                                            \
+            if (instructions-- == 0 || cpu.cycle_count >= execute_until)                                                \
+                return;                                                                                                 \
+            TRACE_INSTRUCTION();                                                                                        \
+            OPCODE_PROFILE_BEGIN();                                                                                     \
+            DECODE_INSTRUCTION();                                                                                       \
+            goto *dispatch_table[cpu.opcode];                                                                           \
+        } while (0)
+
+// Labels as values are a GNU extension supported by both GCC and clang
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#pragma clang diagnostic ignored "-Wgnu-label-as-value"
+
+/**
+ * Threaded code: every handler ends with its own fetch and indirect jump to the next handler,
+ * which spreads the dispatch over many branch sites and avoids the call/return of the table dispatch.
+ */
+static void cpu_execute(uint_fast32_t instructions, uint64_t until) {
+    static const void *const dispatch_table[0xFF + 1] = {FOR_EACH_OPCODE(DISPATCH_LABEL)};
+    OPCODE_PROFILE_DECLARE();
+
+    execute_until = until;
+    DISPATCH();
+    FOR_EACH_OPCODE(DISPATCH_CASE)
+}
+
+#pragma GCC diagnostic pop
+
+#else
+
+static void cpu_execute(uint_fast32_t instructions, uint64_t until) {
+    OPCODE_PROFILE_DECLARE();
+
+    execute_until = until;
+    for (; instructions && cpu.cycle_count < execute_until; --instructions) {
+        TRACE_INSTRUCTION();
+        OPCODE_PROFILE_BEGIN();
+        DECODE_INSTRUCTION();
+
+        // Get and Execute c.opcode
+        (*(instr_lookup[cpu.opcode]))();
+        OPCODE_PROFILE_END();
+
+        LOG_DEBUG("-----------------");
+    }
+}
+
+#endif // defined(YOBEMAG_BLOCK_CACHE)
+
 void cpu_step(void) {
-    LOG_DEBUG("PC 0x%04X", cpu.PC);
-    LOG_DEBUG("MMU[PC]: 0x%04X", mmu_get_byte(cpu.PC));
-    LOG_DEBUG("MMU[PC+1]: 0x%04X", mmu_get_byte(cpu.PC + 1));
-    LOG_DEBUG("MMU[PC+2]: 0x%04X", mmu_get_byte(cpu.PC + 2));
+    cpu_execute(1, EVENT_NEVER);
+}
+
+void cpu_step_n(uint32_t instructions) {
+    cpu_execute(instructions, EVENT_NEVER);
+}
+
+// Timer registers are computed from the clock when read, every other register only changes at events
+__attribute__((const)) static inline bool idle_read_allowed(uint16_t addr) {
+    return addr < TIMER_DIV || addr > TIMER_TAC;
+}
+
+/**
+ * Whether the instruction at @p addr may be part of an idle loop: it writes neither memory nor any register but A
+ * and F, hence BC, DE and HL still hold the addresses it reads from, and it does not read the timer.
+ */
+__attribute__((pure)) static bool idle_loop_instruction(uint16_t addr) {
+    uint8_t opcode  = mmu_get_byte(addr);
+    uint8_t operand = mmu_get_byte((uint16_t) (addr + 1));
+
+    switch (opcode) {
+        case 0x00: // NOP
+            return true;
+        case 0x0A: // LD A, (BC)
+            return idle_read_allowed(CPU_DREG_BC);
+        case 0x1A: // LD A, (DE)
+            return idle_read_allowed(CPU_DREG_DE);
+        case 0xF0: // LDH A, (a8)
+            return idle_read_allowed((uint16_t) (IO_START + operand));
+        case 0xF2: // LD A, (C)
+            return idle_read_allowed((uint16_t) (IO_START + CPU_REG_C));
+        case 0xFA: // LD A, (a16)
+            return idle_read_allowed(mmu_get_two_bytes((uint16_t) (addr + 1)));
+        case 0xCB: // BIT b, r
+            return (operand & 0xC0) == 0x40 &&
+                   (OPCODE_Z(operand) != REG_HL_INDIRECT || idle_read_allowed(CPU_DREG_HL));
+        default:
+            break;
+    }
+
+    // LD A, r and the ALU operations on A and r
+    if (opcode >= 0x78 && opcode <= 0xBF) {
+        return OPCODE_Z(opcode) != REG_HL_INDIRECT || idle_read_allowed(CPU_DREG_HL);
+    }
+
+    // ALU operations on A and d8
+    return (opcode & 0xC7) == 0xC6;
+}
+
+// The straight-line code from @p target up to the branch at @p branch only consists of idle loop instructions
+__attribute__((pure)) static bool idle_loop_body(uint16_t target, uint16_t branch) {
+    uint16_t addr = target;
+
+    while (addr < branch) {
+        if (!idle_loop_instruction(addr)) {
+            return false;
+        }
+        addr = (uint16_t) (addr + opcode_info[mmu_get_byte(addr)].length);
+    }
+
+    return addr == branch;
+}
+
+/**
+ * Called for every taken backward branch at @p branch, the PC already points to its target. If the same branch is
+ * taken twice within a batch (hence without an event or interrupt in between), A and F did not change and the body
+ * of the loop neither writes anything nor reads the clock, every further pass does exactly the same until an event
+ * changes the memory the loop polls (e.g. LY or a flag set by an interrupt handler). Those passes are skipped at once.
+ */
+static void idle_loop_check(uint16_t branch) {
+    if (!idle_loop_skipping || branch == idle_loop.busy) {
+        return;
+    }
 
-    cpu.opcode = mmu_get_byte(cpu.PC++);
+    uint16_t af = CPU_DREG_AF;
+    if (!idle_loop.valid || idle_loop.branch != branch || idle_loop.af != af) {
+        idle_loop.valid  = true;
+        idle_loop.branch = branch;
+        idle_loop.af     = af;
+        idle_loop.cycle  = cpu.cycle_count;
+        return;
+    }
+
+    uint64_t pass   = cpu.cycle_count - idle_loop.cycle;
+    idle_loop.cycle = cpu.cycle_count;
+    if ((uint16_t) (branch - cpu.PC) > IDLE_LOOP_MAX_LENGTH || !idle_loop_body(cpu.PC, branch)) {
+        idle_loop.busy = branch;
+        return;
+    }
+
+    // single steps outside of cpu_run() have no event to skip to
+    if (execute_until == EVENT_NEVER || execute_until <= cpu.cycle_count) {
+        return;
+    }
+
+    // only whole passes which end by the next event, the last one runs normally so that the event still happens
+    // at the same instruction as without skipping
+    uint64_t skipped = (execute_until - cpu.cycle_count) / pass * pass;
+    if (skipped == 0) {
+        return;
+    }
+
+    LOG_DEBUG("Skipping %" PRIu64 " cycles of the idle loop at 0x%04X", skipped, cpu.PC);
+    cpu.cycle_count     = cpu.cycle_count + skipped;
+    idle_cycles_skipped = idle_cycles_skipped + skipped;
+    OPCODE_PROFILE_DISCOUNT(skipped);
+    cpu_yield();
+}
+
+__attribute__((pure)) static inline bool breakpoint_at(uint16_t addr) {
+    return breakpoints[addr >> 3] & (1 << (addr & 0x07));
+}
+
+CPURunResult cpu_run(uint64_t budget) {
+    uint64_t start = cpu.cycle_count;
+    uint64_t end   = budget > EVENT_NEVER - start ? EVENT_NEVER : start + budget;
+
+    stop_requested       = false;
+    CPUStopReason reason = CPU_STOP_BUDGET;
+    for (;;) {
+        // events and interrupts may change what a loop polls, hence it has to prove being idle again
+        idle_loop.valid = false;
+
+        scheduler_run_due();
+        if (stop_requested) {
+            reason = CPU_STOP_EVENT;
+            break;
+        }
+        // interrupts are dispatched at the instruction boundary where they become pending, even if that is the end
+        if (__builtin_expect(interrupts.dirty, 0)) {
+            interrupt_dispatch();
+            continue;
+        }
+        if (cpu.cycle_count >= end) {
+            break;
+        }
+
+        // run uninterrupted up to the next event, only single-step while breakpoints have to be checked
+        uint64_t next  = scheduler_next_deadline();
+        uint64_t until = next < end ? next : end;
+        if (__builtin_expect(cpu.halted, 0)) {
+            if (interrupts.enable & interrupts.flags & IF_MASK) {
+                // wakes up even if IME is cleared, then it just continues after the HALT
+                cpu.halted       = false;
+                interrupts.dirty = true;
+            } else {
+                // only events can request an interrupt, hence the idle cycles up to the next one are skipped at once
+                cpu.cycle_count = until;
+            }
+        } else if (__builtin_expect(breakpoint_count == 0, 1)) {
+            cpu_execute(UINT_FAST32_MAX, until);
+        } else if (cpu.cycle_count != start && breakpoint_at(cpu.PC)) {
+            reason = CPU_STOP_BREAKPOINT;
+            break;
+        } else {
+            cpu_execute(1, until);
+        }
+    }
+
+    return (CPURunResult){.cycles = cpu.cycle_count - start, .reason = reason};
+}
+
+void cpu_yield(void) {
+    execute_until = 0;
+#if defined(YOBEMAG_BLOCK_CACHE)
+    // native blocks do not look at the clock, but leave at the next epoch check
+    ++block_cache_epoch;
+#endif
+}
+
+void cpu_yield_at(uint64_t cycle) {
+    if (cycle >= execute_until) {
+        return;
+    }
+
+    execute_until = cycle;
+#if defined(YOBEMAG_BLOCK_CACHE)
+    // native blocks computed their budget from the previous limit
+    ++block_cache_epoch;
+#endif
+}
+
+void cpu_set_idle_loop_skipping(bool enabled) {
+    idle_loop_skipping = enabled;
+}
+
+uint64_t cpu_idle_cycles_skipped(void) {
+    return idle_cycles_skipped;
+}
+
+void cpu_request_stop(void) {
+    stop_requested = true;
+}
 
-    // Get and Execute c.opcode
-    (*(instr_lookup[cpu.opcode]))();
-    // We cannot know (here) the exact number of increments that the PC and cycle count need,
-    // hence the instructions themselves do it
+void cpu_set_breakpoint(uint16_t addr, bool enabled) {
+    uint8_t mask = (uint8_t) (1 << (addr & 0x07));
+    if (breakpoint_at(addr) == enabled) {
+        return;
+    }
 
-    LOG_DEBUG("-----------------");
+    breakpoints[addr >> 3] ^= mask;
+    breakpoint_count = enabled ? breakpoint_count + 1 : breakpoint_count - 1;
 }
 
 // OP-Codes
 void OPC_NOP(void) {
     LOG_DEBUG("OPC_NOP(void)");
-    ++cpu.cycle_count;
 }
 
 void OPC_INC_BC(void) {
     LOG_DEBUG("OPC_INC_BC(void)");
     ++CPU_DREG_BC;
-    cpu.cycle_count += 2;
 }
 
 void OPC_LD_SP(void) {
     LOG_DEBUG("OPC_LD_SP(void)");
-    cpu.SP = mmu_get_byte(cpu.PC);
-    cpu.PC += 2;
-    cpu.cycle_count += 3;
+    cpu.SP = CPU_OPERAND_U16;
 }
 
 /******************************************************
  *** Misc                                           ***
  ******************************************************/
+// The clock already includes the cycles of the branch not being taken
+__attribute__((always_inline)) inline static void branch_taken(void) {
+    cpu.cycle_count += (uint8_t) (opcode_info[cpu.opcode].cycles_taken - opcode_info[cpu.opcode].cycles);
+}
+
 static void OPC_JR_cc_n(uint8_t bit, uint8_t branching_condition) {
     LOG_DEBUG("OPC_JR_cc_n(uint8_t bit, uint8_t branching_condition)");
-    int8_t n = (int8_t) mmu_get_byte(cpu.PC + 1);
-
-    // doing the PC increment before the opcode's override because we are emulating
-    // two CPU cycles beforehand (fetching opcode in cpu_step, and fetching n above)
-    cpu.PC += 2;
+    int8_t n = (int8_t) CPU_OPERAND_U8;
 
     if (bit == branching_condition) {
-        cpu.PC = (uint16_t) (cpu.PC + n);
-        cpu.cycle_count += 12;
-    } else {
-        cpu.cycle_count += 8;
+        uint16_t next = cpu.PC;
+        cpu.PC        = (uint16_t) (next + n);
+        branch_taken();
+        if (n < 0) {
+            idle_loop_check((uint16_t) (next - 2));
+        }
     }
 }
 
@@ -408,14 +1068,15 @@ void OPC_JR_C(void) {
 
 static void OPC_JP_cc_a16(uint8_t bit, uint8_t branching_condition) {
     LOG_DEBUG("OPC_JP_cc_a16(uint8_t bit, uint8_t branching_condition)");
-    uint16_t n = mmu_get_two_bytes(cpu.PC + 1);
+    uint16_t n = CPU_OPERAND_U16;
 
     if (bit == branching_condition) {
-        cpu.PC = n;
-        cpu.cycle_count += 16;
-    } else {
-        cpu.PC += 3;
-        cpu.cycle_count += 12;
+        uint16_t branch = (uint16_t) (cpu.PC - 3);
+        cpu.PC          = n;
+        branch_taken();
+        if (n <= branch) {
+            idle_loop_check(branch);
+        }
     }
 }
 
@@ -445,1501 +1106,530 @@ void OPC_JP_C(void) {
 void OPC_LD_BC_A(void) {
     LOG_DEBUG("OPC_LD_BC_A(void)");
     mmu_write_byte(CPU_DREG_BC, CPU_REG_A);
-
-    cpu.cycle_count += 8;
-    ++cpu.PC;
 }
 
 void OPC_LD_DE_A(void) {
     LOG_DEBUG("OPC_LD_DE_A(void)");
     mmu_write_byte(CPU_DREG_DE, CPU_REG_A);
-
-    cpu.cycle_count += 8;
-    ++cpu.PC;
 }
 
 void OPC_LD_HL_PLUS_A(void) {
     LOG_DEBUG("OPC_LD_HL_PLUS_A(void)");
     mmu_write_byte(CPU_DREG_HL, CPU_REG_A);
     ++CPU_DREG_HL;
-
-    cpu.cycle_count += 8;
-    ++cpu.PC;
 }
 
 void OPC_LD_HL_MINUS_A(void) {
     LOG_DEBUG("OPC_LD_HL_MINUS_A(void)");
     mmu_write_byte(CPU_DREG_HL, CPU_REG_A);
     --CPU_DREG_HL;
-
-    cpu.cycle_count += 8;
-    ++cpu.PC;
 }
 
 void OPC_LD_A_BC(void) {
     LOG_DEBUG("OPC_LD_A_BC(void)");
     LD_REG_REG(&CPU_REG_A, mmu_get_byte(CPU_DREG_BC));
-
-    cpu.cycle_count += 8;
-    ++cpu.PC;
 }
 
 void OPC_LD_A_DE(void) {
     LOG_DEBUG("OPC_LD_A_DE(void)");
     LD_REG_REG(&CPU_REG_A, mmu_get_byte(CPU_DREG_DE));
-
-    cpu.cycle_count += 8;
-    ++cpu.PC;
 }
 
 void OPC_LD_A_HL_PLUS(void) {
     LOG_DEBUG("OPC_LD_A_HL_PLUS(void)");
     LD_REG_REG(&CPU_REG_A, mmu_get_byte(CPU_DREG_HL));
     ++CPU_DREG_HL;
-
-    cpu.cycle_count += 8;
-    ++cpu.PC;
 }
 
 void OPC_LD_A_HL_MINUS(void) {
     LOG_DEBUG("OPC_LD_A_HL_MINUS(void)");
     LD_REG_REG(&CPU_REG_A, mmu_get_byte(CPU_DREG_HL));
     --CPU_DREG_HL;
-
-    cpu.cycle_count += 8;
-    ++cpu.PC;
 }
 
 void OPC_LD_FF00a8_A(void) {
     LOG_DEBUG("OPC_LD_FF00a8_A(void)");
-    uint16_t intermediate = 0xFF00 + mmu_get_byte(cpu.PC + 1);
+    uint16_t intermediate = 0xFF00 + CPU_OPERAND_U8;
     mmu_write_byte(intermediate, CPU_REG_A);
-
-    cpu.cycle_count += 12;
-    cpu.PC += 2;
 }
 
 void OPC_LD_A_FF00a8(void) {
     LOG_DEBUG("OPC_LD_A_FF00a8(void)");
-    uint16_t intermediate = 0xFF00 + mmu_get_byte(cpu.PC + 1);
+    uint16_t intermediate = 0xFF00 + CPU_OPERAND_U8;
     LD_REG_REG(&CPU_REG_A, mmu_get_byte(intermediate));
-
-    cpu.cycle_count += 12;
-    cpu.PC += 2;
 }
 
 void OPC_LD_FF00C_A(void) {
     LOG_DEBUG("OPC_LD_FF00C_A(void)");
     uint16_t intermediate = 0xFF00 + CPU_REG_C;
     mmu_write_byte(intermediate, CPU_REG_A);
-
-    cpu.cycle_count += 8;
-    ++cpu.PC;
 }
 
 void OPC_LD_A_FF00C(void) {
     LOG_DEBUG("OPC_LD_A_FF00C(void)");
     uint16_t intermediate = 0xFF00 + CPU_REG_C;
     LD_REG_REG(&CPU_REG_A, mmu_get_byte(intermediate));
-
-    cpu.cycle_count += 8;
-    ++cpu.PC;
 }
 
 void OPC_LD_a16_A(void) {
     LOG_DEBUG("OPC_LD_a16_A(void)");
-    uint16_t intermediate = mmu_get_two_bytes(cpu.PC + 1);
+    uint16_t intermediate = CPU_OPERAND_U16;
 
     mmu_write_byte(intermediate, CPU_REG_A);
-
-    cpu.cycle_count += 16;
-    cpu.PC += 3;
 }
 
 void OPC_LD_A_a16(void) {
     LOG_DEBUG("OPC_LD_A_a16(void)");
-    uint16_t intermediate = mmu_get_two_bytes(cpu.PC + 1);
+    uint16_t intermediate = CPU_OPERAND_U16;
 
     LD_REG_REG(&CPU_REG_A, mmu_get_byte(intermediate));
-
-    cpu.cycle_count += 16;
-    cpu.PC += 3;
 }
 
-// LD B, n
-void OPC_LD_B_B(void) {
-    LOG_DEBUG("OPC_LD_B_B(void)");
-    LD_REG_REG(&CPU_REG_B, CPU_REG_B);
-
-    cpu.cycle_count += 4;
-}
-
-void OPC_LD_B_C(void) {
-    LOG_DEBUG("OPC_LD_B_C(void)");
-    LD_REG_REG(&CPU_REG_B, CPU_REG_C);
-
-    cpu.cycle_count += 4;
+void OPC_LD_r_r(void) {
+    LOG_DEBUG("OPC_LD_r_r(void)");
+    LD_REG_REG(reg_index[OPCODE_Y(cpu.opcode)], *reg_index[OPCODE_Z(cpu.opcode)]);
 }
 
-void OPC_LD_B_D(void) {
-    LOG_DEBUG("OPC_LD_B_D(void)");
-    LD_REG_REG(&CPU_REG_B, CPU_REG_D);
-
-    cpu.cycle_count += 4;
+void OPC_LD_r_HL(void) {
+    LOG_DEBUG("OPC_LD_r_HL(void)");
+    LD_REG_REG(reg_index[OPCODE_Y(cpu.opcode)], mmu_get_byte(CPU_DREG_HL));
 }
 
-void OPC_LD_B_E(void) {
-    LOG_DEBUG("OPC_LD_B_E(void)");
-    LD_REG_REG(&CPU_REG_B, CPU_REG_E);
-
-    cpu.cycle_count += 4;
+void OPC_LD_r_d8(void) {
+    LOG_DEBUG("OPC_LD_r_d8(void)");
+    LD_REG_d8(reg_index[OPCODE_Y(cpu.opcode)]);
 }
 
-void OPC_LD_B_H(void) {
-    LOG_DEBUG("OPC_LD_B_H(void)");
-    LD_REG_REG(&CPU_REG_B, CPU_REG_H);
-
-    cpu.cycle_count += 4;
+void OPC_LD_HL_r(void) {
+    LOG_DEBUG("OPC_LD_HL_r(void)");
+    mmu_write_byte(CPU_DREG_HL, *reg_index[OPCODE_Z(cpu.opcode)]);
 }
 
-void OPC_LD_B_L(void) {
-    LOG_DEBUG("OPC_LD_B_L(void)");
-    LD_REG_REG(&CPU_REG_B, CPU_REG_L);
-
-    cpu.cycle_count += 4;
+void OPC_LD_HL_d8(void) {
+    LOG_DEBUG("OPC_LD_HL_d8(void)");
+    uint8_t immediate = CPU_OPERAND_U8;
+    mmu_write_byte(CPU_DREG_HL, immediate);
 }
 
-void OPC_LD_B_HL(void) {
-    LOG_DEBUG("OPC_LD_B_HL(void)");
-    LD_REG_REG(&CPU_REG_B, mmu_get_byte(CPU_DREG_HL));
-    ++cpu.PC;
-
-    cpu.cycle_count += 8;
+/******************************************************
+ *** 8-BIT ALU                                      ***
+ ******************************************************/
+/**
+ * @brief Computes F for an ALU operation, see FlagOp for the meaning of @p lhs, @p rhs and @p aux.
+ */
+__attribute__((always_inline, const)) inline static uint8_t alu_flags(FlagOp op, uint8_t lhs, uint8_t rhs,
+                                                                      uint8_t aux) {
+    switch (op) {
+        case FLAG_OP_ADD: {
+            uint_fast16_t result = (uint_fast16_t) (lhs + rhs + aux);
+            // N is implicitly cleared
+            return (uint8_t) (((result & BYTE_MASK) == 0) << Z_FLAG |
+                              ((lhs & LO_NIBBLE_MASK) + (rhs & LO_NIBBLE_MASK) + aux > LO_NIBBLE_MASK) << H_FLAG |
+                              (result > BYTE_MASK) << C_FLAG);
+        }
+        case FLAG_OP_SUB:
+            return (uint8_t) (((uint8_t) (lhs - aux - rhs) == 0) << Z_FLAG | 1 << N_FLAG |
+                              (((rhs + aux) & LO_NIBBLE_MASK) > (lhs & LO_NIBBLE_MASK)) << H_FLAG |
+                              ((rhs + aux) > lhs) << C_FLAG);
+        case FLAG_OP_AND:
+            // C and N are implicitly cleared
+            return (uint8_t) ((lhs == 0) << Z_FLAG | 1 << H_FLAG);
+        case FLAG_OP_OR:
+            // C, H, and N are implicitly cleared
+            return (uint8_t) ((lhs == 0) << Z_FLAG);
+        case FLAG_OP_INC:
+            // Flag C is not affected, N is implicitly cleared
+            return (uint8_t) (aux << C_FLAG | (lhs == 0) << Z_FLAG | ((lhs & 0x10) == 0x10) << H_FLAG);
+        case FLAG_OP_DEC:
+            // Simplifications made for half carry flag check:
+            // (lhs & LO_NIBBLE_MASK) < (n & LO_NIBBLE_MASK) where n = 1
+            // (lhs & LO_NIBBLE_MASK) == 0
+            // Flag C is not affected
+            return (uint8_t) (aux << C_FLAG | ((lhs & LO_NIBBLE_MASK) == 0) << H_FLAG |
+                              ((uint8_t) (lhs - 1) == 0) << Z_FLAG | 1 << N_FLAG);
+        case FLAG_OP_NONE:
+        default:
+            return aux;
+    }
 }
 
-void OPC_LD_B_A(void) {
-    LOG_DEBUG("OPC_LD_B_A(void)");
-    LD_REG_REG(&CPU_REG_B, CPU_REG_A);
-
-    cpu.cycle_count += 4;
+/**
+ * @brief Sets the flags of an ALU operation, or only records its operands if flags are evaluated lazily.
+ */
+__attribute__((always_inline)) inline static void update_flags(FlagOp op, uint8_t lhs, uint8_t rhs, uint8_t aux) {
+#if defined(YOBEMAG_LAZY_FLAGS)
+    cpu.flags = (LazyFlags){.op = op, .lhs = lhs, .rhs = rhs, .aux = aux};
+#else
+    cpu.AF.words.lo = alu_flags(op, lhs, rhs, aux);
+#endif
+}
+
+#if defined(YOBEMAG_LAZY_FLAGS)
+
+void cpu_materialize_flags(void) {
+    cpu.AF.words.lo = alu_flags(cpu.flags.op, cpu.flags.lhs, cpu.flags.rhs, cpu.flags.aux);
+    cpu.flags.op    = FLAG_OP_NONE;
+}
+
+#endif
+
+/**
+ * @brief The C flag. With lazy flags it is computed from the pending ALU operation alone, the rest of F stays pending.
+ */
+__attribute__((always_inline)) inline static uint8_t carry_flag(void) {
+#if defined(YOBEMAG_LAZY_FLAGS)
+    switch (cpu.flags.op) {
+        case FLAG_OP_ADD:
+            return cpu.flags.lhs + cpu.flags.rhs + cpu.flags.aux > BYTE_MASK;
+        case FLAG_OP_SUB:
+            return cpu.flags.rhs + cpu.flags.aux > cpu.flags.lhs;
+        case FLAG_OP_AND:
+        case FLAG_OP_OR:
+            return 0;
+        case FLAG_OP_INC:
+        case FLAG_OP_DEC:
+            return cpu.flags.aux;
+        case FLAG_OP_NONE:
+        default:
+            break;
+    }
+#endif
+    return get_flag(C_FLAG);
 }
 
-void OPC_LD_B_d8(void) {
-    LOG_DEBUG("OPC_LD_B_d8(void)");
-    LD_REG_d8(&CPU_REG_B);
-    ++cpu.PC;
-
-    cpu.cycle_count += 8;
-}
+static void ADD_A_n(uint8_t n) {
+    uint8_t A = CPU_REG_A;
 
-// LD C, n
-void OPC_LD_C_B(void) {
-    LOG_DEBUG("OPC_LD_C_B(void)");
-    LD_REG_REG(&CPU_REG_C, CPU_REG_B);
+    update_flags(FLAG_OP_ADD, A, n, 0);
 
-    cpu.cycle_count += 4;
+    CPU_REG_A = (uint8_t) (A + n);
 }
 
-void OPC_LD_C_C(void) {
-    LOG_DEBUG("OPC_LD_C_C(void)");
-    LD_REG_REG(&CPU_REG_C, CPU_REG_C);
-
-    cpu.cycle_count += 4;
-}
+static void ADC_A_n(uint8_t n) {
+    uint8_t A      = CPU_REG_A;
+    uint8_t c_flag = get_flag(C_FLAG);
 
-void OPC_LD_C_D(void) {
-    LOG_DEBUG("OPC_LD_C_D(void)");
-    LD_REG_REG(&CPU_REG_C, CPU_REG_D);
+    update_flags(FLAG_OP_ADD, A, n, c_flag);
 
-    cpu.cycle_count += 4;
+    CPU_REG_A = (uint8_t) (A + n + c_flag);
 }
 
-void OPC_LD_C_E(void) {
-    LOG_DEBUG("OPC_LD_C_E(void)");
-    LD_REG_REG(&CPU_REG_C, CPU_REG_E);
-
-    cpu.cycle_count += 4;
-}
+static void SUB_A_n(uint8_t n) {
+    uint8_t A = CPU_REG_A;
 
-void OPC_LD_C_H(void) {
-    LOG_DEBUG("OPC_LD_C_H(void)");
-    LD_REG_REG(&CPU_REG_C, CPU_REG_H);
+    update_flags(FLAG_OP_SUB, A, n, 0);
 
-    cpu.cycle_count += 4;
+    CPU_REG_A = (uint8_t) (A - n);
 }
 
-void OPC_LD_C_L(void) {
-    LOG_DEBUG("OPC_LD_C_L(void)");
-    LD_REG_REG(&CPU_REG_C, CPU_REG_L);
-
-    cpu.cycle_count += 4;
-}
+static void SBC_A_n(uint8_t n) {
+    uint8_t A     = CPU_REG_A;
+    uint8_t carry = get_flag(C_FLAG);
 
-void OPC_LD_C_HL(void) {
-    LOG_DEBUG("OPC_LD_C_HL(void)");
-    LD_REG_REG(&CPU_REG_C, mmu_get_byte(CPU_DREG_HL));
-    ++cpu.PC;
+    update_flags(FLAG_OP_SUB, A, n, carry);
 
-    cpu.cycle_count += 8;
+    CPU_REG_A = (uint8_t) (A - carry - n);
 }
 
-void OPC_LD_C_A(void) {
-    LOG_DEBUG("OPC_LD_C_A(void)");
-    LD_REG_REG(&CPU_REG_C, CPU_REG_A);
-
-    cpu.cycle_count += 4;
-}
+static void AND_A_n(uint8_t n) {
+    uint8_t result = CPU_REG_A & n;
 
-void OPC_LD_C_d8(void) {
-    LOG_DEBUG("OPC_LD_C_d8(void)");
-    LD_REG_d8(&CPU_REG_C);
-    ++cpu.PC;
+    update_flags(FLAG_OP_AND, result, 0, 0);
 
-    cpu.cycle_count += 8;
+    CPU_REG_A = result;
 }
 
-// LD D, n
-void OPC_LD_D_B(void) {
-    LOG_DEBUG("OPC_LD_D_B(void)");
-    LD_REG_REG(&CPU_REG_D, CPU_REG_B);
-
-    cpu.cycle_count += 4;
-}
+static void OR_A_n(uint8_t n) {
+    uint8_t result = CPU_REG_A | n;
 
-void OPC_LD_D_C(void) {
-    LOG_DEBUG("OPC_LD_D_C(void)");
-    LD_REG_REG(&CPU_REG_D, CPU_REG_C);
+    update_flags(FLAG_OP_OR, result, 0, 0);
 
-    cpu.cycle_count += 4;
+    CPU_REG_A = result;
 }
 
-void OPC_LD_D_D(void) {
-    LOG_DEBUG("OPC_LD_D_D(void)");
-    LD_REG_REG(&CPU_REG_D, CPU_REG_D);
+static void XOR_A_n(uint8_t n) {
+    CPU_REG_A ^= n;
 
-    cpu.cycle_count += 4;
+    update_flags(FLAG_OP_OR, CPU_REG_A, 0, 0);
 }
 
-void OPC_LD_D_E(void) {
-    LOG_DEBUG("OPC_LD_D_E(void)");
-    LD_REG_REG(&CPU_REG_D, CPU_REG_E);
-
-    cpu.cycle_count += 4;
+static void CP_A_n(uint8_t n) {
+    // Same flags as SUB, but the result is discarded
+    update_flags(FLAG_OP_SUB, CPU_REG_A, n, 0);
+}
+
+// Executes the ALU operation encoded in y of the opcode
+__attribute__((always_inline)) inline static void ALU_A_n(uint8_t operation, uint8_t n) {
+    switch (operation) {
+        case 0:
+            ADD_A_n(n);
+            break;
+        case 1:
+            ADC_A_n(n);
+            break;
+        case 2:
+            SUB_A_n(n);
+            break;
+        case 3:
+            SBC_A_n(n);
+            break;
+        case 4:
+            AND_A_n(n);
+            break;
+        case 5:
+            XOR_A_n(n);
+            break;
+        case 6:
+            OR_A_n(n);
+            break;
+        default:
+            CP_A_n(n);
+            break;
+    }
 }
 
-void OPC_LD_D_H(void) {
-    LOG_DEBUG("OPC_LD_D_H(void)");
-    LD_REG_REG(&CPU_REG_D, CPU_REG_H);
-
-    cpu.cycle_count += 4;
+void OPC_ALU_A_r(void) {
+    LOG_DEBUG("OPC_ALU_A_r(void)");
+    ALU_A_n(OPCODE_Y(cpu.opcode), *reg_index[OPCODE_Z(cpu.opcode)]);
 }
 
-void OPC_LD_D_L(void) {
-    LOG_DEBUG("OPC_LD_D_L(void)");
-    LD_REG_REG(&CPU_REG_D, CPU_REG_L);
-
-    cpu.cycle_count += 4;
+void OPC_ALU_A_HL(void) {
+    LOG_DEBUG("OPC_ALU_A_HL(void)");
+    ALU_A_n(OPCODE_Y(cpu.opcode), mmu_get_byte(CPU_DREG_HL));
 }
 
-void OPC_LD_D_HL(void) {
-    LOG_DEBUG("OPC_LD_D_HL(void)");
-    LD_REG_REG(&CPU_REG_D, mmu_get_byte(CPU_DREG_HL));
-    ++cpu.PC;
-
-    cpu.cycle_count += 8;
+void OPC_ALU_A_d8(void) {
+    LOG_DEBUG("OPC_ALU_A_d8(void)");
+    uint8_t immediate = CPU_OPERAND_U8;
+    ALU_A_n(OPCODE_Y(cpu.opcode), immediate);
 }
 
-void OPC_LD_D_A(void) {
-    LOG_DEBUG("OPC_LD_D_A(void)");
-    LD_REG_REG(&CPU_REG_D, CPU_REG_A);
+static void INC_n(uint8_t *const reg) {
+    ++(*reg);
 
-    cpu.cycle_count += 4;
+    // C is kept, the previous F does not need to be materialized for it
+    update_flags(FLAG_OP_INC, *reg, 0, carry_flag());
 }
 
-void OPC_LD_D_d8(void) {
-    LOG_DEBUG("OPC_LD_D_d8(void)");
-    LD_REG_d8(&CPU_REG_D);
-    ++cpu.PC;
-
-    cpu.cycle_count += 8;
+void OPC_INC_r(void) {
+    LOG_DEBUG("OPC_INC_r(void)");
+    INC_n(reg_index[OPCODE_Y(cpu.opcode)]);
 }
 
-// LD E, n
-void OPC_LD_E_B(void) {
-    LOG_DEBUG("OPC_LD_E_B(void)");
-    LD_REG_REG(&CPU_REG_E, CPU_REG_B);
-
-    cpu.cycle_count += 4;
+void OPC_INC_HL(void) {
+    LOG_DEBUG("OPC_INC_HL(void)");
+    uint8_t value = mmu_get_byte(CPU_DREG_HL);
+    INC_n(&value);
+    mmu_write_byte(CPU_DREG_HL, value);
 }
 
-void OPC_LD_E_C(void) {
-    LOG_DEBUG("OPC_LD_E_C(void)");
-    LD_REG_REG(&CPU_REG_E, CPU_REG_C);
+static void DEC_n(uint8_t *const addr) {
+    // C is kept, the previous F does not need to be materialized for it
+    update_flags(FLAG_OP_DEC, *addr, 0, carry_flag());
 
-    cpu.cycle_count += 4;
+    --(*addr);
 }
 
-void OPC_LD_E_D(void) {
-    LOG_DEBUG("OPC_LD_E_D(void)");
-    LD_REG_REG(&CPU_REG_E, CPU_REG_D);
-
-    cpu.cycle_count += 4;
+void OPC_DEC_r(void) {
+    LOG_DEBUG("OPC_DEC_r(void)");
+    DEC_n(reg_index[OPCODE_Y(cpu.opcode)]);
 }
 
-void OPC_LD_E_E(void) {
-    LOG_DEBUG("OPC_LD_E_E(void)");
-    LD_REG_REG(&CPU_REG_E, CPU_REG_E);
-
-    cpu.cycle_count += 4;
+void OPC_DEC_HL(void) {
+    LOG_DEBUG("OPC_DEC_HL(void)");
+    uint8_t value = mmu_get_byte(CPU_DREG_HL);
+    DEC_n(&value);
+    mmu_write_byte(CPU_DREG_HL, value);
 }
 
-void OPC_LD_E_H(void) {
-    LOG_DEBUG("OPC_LD_E_H(void)");
-    LD_REG_REG(&CPU_REG_E, CPU_REG_H);
-
-    cpu.cycle_count += 4;
-}
+/******************************************************
+ *** CB prefixed                                    ***
+ ******************************************************/
+// Rotates and shifts, the operation is encoded in y: RLC, RRC, RL, RR, SLA, SRA, SWAP, SRL
+static uint8_t CB_SHIFT_n(uint8_t operation, uint8_t n) {
+    uint8_t carry;
+    uint8_t result;
+
+    switch (operation) {
+        case 0: // RLC
+            carry  = n >> 7;
+            result = (uint8_t) (n << 1 | carry);
+            break;
+        case 1: // RRC
+            carry  = n & 1;
+            result = (uint8_t) (n >> 1 | carry << 7);
+            break;
+        case 2: // RL
+            carry  = n >> 7;
+            result = (uint8_t) (n << 1 | get_flag(C_FLAG));
+            break;
+        case 3: // RR
+            carry  = n & 1;
+            result = (uint8_t) (n >> 1 | get_flag(C_FLAG) << 7);
+            break;
+        case 4: // SLA
+            carry  = n >> 7;
+            result = (uint8_t) (n << 1);
+            break;
+        case 5: // SRA
+            carry  = n & 1;
+            result = (uint8_t) (n >> 1 | (n & 0x80));
+            break;
+        case 6: // SWAP
+            carry  = 0;
+            result = (uint8_t) (n << 4 | n >> 4);
+            break;
+        default: // SRL
+            carry  = n & 1;
+            result = n >> 1;
+            break;
+    }
 
-void OPC_LD_E_L(void) {
-    LOG_DEBUG("OPC_LD_E_L(void)");
-    LD_REG_REG(&CPU_REG_E, CPU_REG_L);
+    clear_flag_register(); // N and H are implicitly cleared
+    set_flag(result == 0, Z_FLAG);
+    set_flag(carry, C_FLAG);
 
-    cpu.cycle_count += 4;
+    return result;
 }
 
-void OPC_LD_E_HL(void) {
-    LOG_DEBUG("OPC_LD_E_HL(void)");
-    LD_REG_REG(&CPU_REG_E, mmu_get_byte(CPU_DREG_HL));
-    ++cpu.PC;
-
-    cpu.cycle_count += 8;
-}
+static void CB_BIT_n(uint8_t bit, uint8_t n) {
+    uint8_t carry = get_flag(C_FLAG);
 
-void OPC_LD_E_A(void) {
-    LOG_DEBUG("OPC_LD_E_A(void)");
-    LD_REG_REG(&CPU_REG_E, CPU_REG_A);
+    clear_flag_register(); // N is implicitly cleared
+    set_flag(!(n & (1 << bit)), Z_FLAG);
+    set_flag(1, H_FLAG);
+    set_flag(carry, C_FLAG);
+}
+
+void OPC_PREFIX_CB(void) {
+    LOG_DEBUG("OPC_PREFIX_CB(void)");
+    uint8_t opcode = CPU_OPERAND_U8;
+    uint8_t y      = OPCODE_Y(opcode);
+    uint8_t z      = OPCODE_Z(opcode);
+    uint8_t value  = z == REG_HL_INDIRECT ? mmu_get_byte(CPU_DREG_HL) : *reg_index[z];
+
+    switch (opcode >> 6) {
+        case 0:
+            value = CB_SHIFT_n(y, value);
+            break;
+        case 1:
+            // BIT only reads its operand
+            CB_BIT_n(y, value);
+            if (z == REG_HL_INDIRECT) {
+                cpu.cycle_count += 4;
+            }
+            return;
+        case 2: // RES
+            value &= (uint8_t) ~(1 << y);
+            break;
+        default: // SET
+            value |= (uint8_t) (1 << y);
+            break;
+    }
 
-    cpu.cycle_count += 4;
+    if (z == REG_HL_INDIRECT) {
+        mmu_write_byte(CPU_DREG_HL, value);
+        cpu.cycle_count += 8;
+    } else {
+        *reg_index[z] = value;
+    }
 }
 
-void OPC_LD_E_d8(void) {
-    LOG_DEBUG("OPC_LD_E_d8(void)");
-    LD_REG_d8(&CPU_REG_E);
-    ++cpu.PC;
-
-    cpu.cycle_count += 8;
+void OPC_RST_x(uint16_t address) {
+    mmu_stack_push(cpu.PC);
+    pc_profiler_call(cpu.PC);
+    cpu.PC = address;
 }
 
-// LD H, n
-void OPC_LD_H_B(void) {
-    LOG_DEBUG("OPC_LD_H_B(void)");
-    LD_REG_REG(&CPU_REG_H, CPU_REG_B);
-
-    cpu.cycle_count += 4;
+void OPC_RST_00(void) {
+    LOG_DEBUG("OPC_RST_00");
+    OPC_RST_x(0x0000);
 }
-
-void OPC_LD_H_C(void) {
-    LOG_DEBUG("OPC_LD_H_C(void)");
-    LD_REG_REG(&CPU_REG_H, CPU_REG_C);
-
-    cpu.cycle_count += 4;
+void OPC_RST_10(void) {
+    LOG_DEBUG("OPC_RST_10");
+    OPC_RST_x(0x0010);
 }
-
-void OPC_LD_H_D(void) {
-    LOG_DEBUG("OPC_LD_H_D(void)");
-    LD_REG_REG(&CPU_REG_H, CPU_REG_D);
-
-    cpu.cycle_count += 4;
+void OPC_RST_20(void) {
+    LOG_DEBUG("OPC_RST_20");
+    OPC_RST_x(0x0020);
 }
-
-void OPC_LD_H_E(void) {
-    LOG_DEBUG("OPC_LD_H_E(void)");
-    LD_REG_REG(&CPU_REG_H, CPU_REG_E);
-
-    cpu.cycle_count += 4;
+void OPC_RST_30(void) {
+    LOG_DEBUG("OPC_RST_30");
+    OPC_RST_x(0x0030);
 }
-
-void OPC_LD_H_H(void) {
-    LOG_DEBUG("OPC_LD_H_H(void)");
-    LD_REG_REG(&CPU_REG_H, CPU_REG_H);
-
-    cpu.cycle_count += 4;
+void OPC_RST_08(void) {
+    LOG_DEBUG("OPC_RST_08");
+    OPC_RST_x(0x0008);
 }
-
-void OPC_LD_H_L(void) {
-    LOG_DEBUG("OPC_LD_H_L(void)");
-    LD_REG_REG(&CPU_REG_H, CPU_REG_L);
-
-    cpu.cycle_count += 4;
+void OPC_RST_18(void) {
+    LOG_DEBUG("OPC_RST_18");
+    OPC_RST_x(0x0018);
 }
-
-void OPC_LD_H_HL(void) {
-    LOG_DEBUG("OPC_LD_H_HL(void)");
-    LD_REG_REG(&CPU_REG_H, mmu_get_byte(CPU_DREG_HL));
-    ++cpu.PC;
-
-    cpu.cycle_count += 8;
+void OPC_RST_28(void) {
+    LOG_DEBUG("OPC_RST_28");
+    OPC_RST_x(0x0028);
 }
-
-void OPC_LD_H_A(void) {
-    LOG_DEBUG("OPC_LD_H_A(void)");
-    LD_REG_REG(&CPU_REG_H, CPU_REG_A);
-
-    cpu.cycle_count += 4;
+void OPC_RST_38(void) {
+    LOG_DEBUG("OPC_RST_38");
+    OPC_RST_x(0x0038);
 }
-
-void OPC_LD_H_d8(void) {
-    LOG_DEBUG("OPC_LD_H_d8(void)");
-    LD_REG_d8(&CPU_REG_H);
-    ++cpu.PC;
-
-    cpu.cycle_count += 8;
+void OPC_LD_xx_u16(uint16_t *dreg) {
+    *dreg = CPU_OPERAND_U16;
 }
 
-// LD L, n
-void OPC_LD_L_B(void) {
-    LOG_DEBUG("OPC_LD_L_B(void)");
-    LD_REG_REG(&CPU_REG_L, CPU_REG_B);
-
-    cpu.cycle_count += 4;
+void OPC_LD_BC_u16(void) {
+    LOG_DEBUG("OPC_LD_BC_u16");
+    OPC_LD_xx_u16(&CPU_DREG_BC);
 }
 
-void OPC_LD_L_C(void) {
-    LOG_DEBUG("OPC_LD_L_C(void)");
-    LD_REG_REG(&CPU_REG_L, CPU_REG_C);
-
-    cpu.cycle_count += 4;
+void OPC_LD_DE_u16(void) {
+    LOG_DEBUG("OPC_LD_DE_u16");
+    OPC_LD_xx_u16(&CPU_DREG_DE);
 }
 
-void OPC_LD_L_D(void) {
-    LOG_DEBUG("OPC_LD_L_D(void)");
-    LD_REG_REG(&CPU_REG_L, CPU_REG_D);
-
-    cpu.cycle_count += 4;
+void OPC_LD_HL_u16(void) {
+    LOG_DEBUG("OPC_LD_HL_u16");
+    OPC_LD_xx_u16(&CPU_DREG_HL);
 }
 
-void OPC_LD_L_E(void) {
-    LOG_DEBUG("OPC_LD_L_E(void)");
-    LD_REG_REG(&CPU_REG_L, CPU_REG_E);
-
-    cpu.cycle_count += 4;
+void OPC_LD_SP_u16(void) {
+    LOG_DEBUG("OPC_LD_SP_u16");
+    OPC_LD_xx_u16(&cpu.SP);
 }
 
-void OPC_LD_L_H(void) {
-    LOG_DEBUG("OPC_LD_L_H(void)");
-    LD_REG_REG(&CPU_REG_L, CPU_REG_H);
+void OPC_JR_i8(void) {
+    LOG_DEBUG("OPC_JR_i8");
+    int8_t n = (int8_t) CPU_OPERAND_U8;
 
-    cpu.cycle_count += 4;
+    LOG_DEBUG("Jumping to PC (0x%02x) + 0x%02x", cpu.PC, n);
+    uint16_t next = cpu.PC;
+    cpu.PC        = (uint16_t) (next + n);
+    if (n < 0) {
+        idle_loop_check((uint16_t) (next - 2));
+    }
 }
 
-void OPC_LD_L_L(void) {
-    LOG_DEBUG("OPC_LD_L_L(void)");
-    LD_REG_REG(&CPU_REG_L, CPU_REG_L);
-
-    cpu.cycle_count += 4;
-}
-
-void OPC_LD_L_HL(void) {
-    LOG_DEBUG("OPC_LD_L_HL(void)");
-    LD_REG_REG(&CPU_REG_L, mmu_get_byte(CPU_DREG_HL));
-    ++cpu.PC;
-
-    cpu.cycle_count += 8;
-}
-
-void OPC_LD_L_A(void) {
-    LOG_DEBUG("OPC_LD_L_A(void)");
-    LD_REG_REG(&CPU_REG_L, CPU_REG_A);
-
-    cpu.cycle_count += 4;
-}
-
-void OPC_LD_L_d8(void) {
-    LOG_DEBUG("OPC_LD_L_d8(void)");
-    LD_REG_d8(&CPU_REG_L);
-    ++cpu.PC;
-
-    cpu.cycle_count += 8;
-}
-
-// LD HL, n
-void OPC_LD_HL_B(void) {
-    LOG_DEBUG("OPC_LD_HL_B(void)");
-    mmu_write_byte(CPU_DREG_HL, CPU_REG_B);
-
-    cpu.cycle_count += 8;
-}
-
-void OPC_LD_HL_C(void) {
-    LOG_DEBUG("OPC_LD_HL_C(void)");
-    mmu_write_byte(CPU_DREG_HL, CPU_REG_C);
-
-    cpu.cycle_count += 8;
-}
-
-void OPC_LD_HL_D(void) {
-    LOG_DEBUG("OPC_LD_HL_D(void)");
-    mmu_write_byte(CPU_DREG_HL, CPU_REG_D);
-
-    cpu.cycle_count += 8;
-}
-
-void OPC_LD_HL_E(void) {
-    LOG_DEBUG("OPC_LD_HL_E(void)");
-    mmu_write_byte(CPU_DREG_HL, CPU_REG_E);
-
-    cpu.cycle_count += 8;
-}
-
-void OPC_LD_HL_H(void) {
-    LOG_DEBUG("OPC_LD_HL_H(void)");
-    mmu_write_byte(CPU_DREG_HL, CPU_REG_H);
-
-    cpu.cycle_count += 8;
-}
-
-void OPC_LD_HL_L(void) {
-    LOG_DEBUG("OPC_LD_HL_L(void)");
-    mmu_write_byte(CPU_DREG_HL, CPU_REG_L);
-
-    cpu.cycle_count += 8;
-}
-
-void OPC_LD_HL_A(void) {
-    LOG_DEBUG("OPC_LD_HL_A(void)");
-    mmu_write_byte(CPU_DREG_HL, CPU_REG_A);
-    ++cpu.PC;
-
-    cpu.cycle_count += 8;
-}
-
-void OPC_LD_HL_d8(void) {
-    LOG_DEBUG("OPC_LD_HL_d8(void)");
-    uint8_t immediate = mmu_get_byte(cpu.PC + 1);
-    mmu_write_byte(CPU_DREG_HL, immediate);
-    ++cpu.PC;
-
-    cpu.cycle_count += 12;
-}
-
-// LD A, n
-void OPC_LD_A_B(void) {
-    LOG_DEBUG("OPC_LD_A_B(void)");
-    LD_REG_REG(&CPU_REG_A, CPU_REG_B);
-
-    cpu.cycle_count += 4;
-}
-
-void OPC_LD_A_C(void) {
-    LOG_DEBUG("OPC_LD_A_C(void)");
-    LD_REG_REG(&CPU_REG_A, CPU_REG_C);
-
-    cpu.cycle_count += 4;
-}
-
-void OPC_LD_A_D(void) {
-    LOG_DEBUG("OPC_LD_A_D(void)");
-    LD_REG_REG(&CPU_REG_A, CPU_REG_D);
-
-    cpu.cycle_count += 4;
-}
-
-void OPC_LD_A_E(void) {
-    LOG_DEBUG("OPC_LD_A_E(void)");
-    LD_REG_REG(&CPU_REG_A, CPU_REG_E);
-
-    cpu.cycle_count += 4;
-}
-
-void OPC_LD_A_H(void) {
-    LOG_DEBUG("OPC_LD_A_H(void)");
-    LD_REG_REG(&CPU_REG_A, CPU_REG_H);
-
-    cpu.cycle_count += 4;
-}
-
-void OPC_LD_A_L(void) {
-    LOG_DEBUG("OPC_LD_A_L(void)");
-    LD_REG_REG(&CPU_REG_A, CPU_REG_L);
-
-    cpu.cycle_count += 4;
-}
-
-void OPC_LD_A_HL(void) {
-    LOG_DEBUG("OPC_LD_A_HL(void)");
-    LD_REG_REG(&CPU_REG_A, mmu_get_byte(CPU_DREG_HL));
-    ++cpu.PC;
-
-    cpu.cycle_count += 8;
-}
-
-void OPC_LD_A_A(void) {
-    LOG_DEBUG("OPC_LD_A_A(void)");
-    LD_REG_REG(&CPU_REG_A, CPU_REG_A);
-
-    cpu.cycle_count += 4;
-}
-
-void OPC_LD_A_d8(void) {
-    LOG_DEBUG("OPC_LD_A_d8(void)");
-    LD_REG_d8(&CPU_REG_A);
-    ++cpu.PC;
-
-    cpu.cycle_count += 8;
-}
-
-/******************************************************
- *** 8-BIT ALU                                      ***
- ******************************************************/
-static void ADD_A_n(uint8_t n) {
-    uint8_t A            = CPU_REG_A;
-    uint8_t A_nibble     = A & LO_NIBBLE_MASK;
-    uint8_t n_nibble     = n & LO_NIBBLE_MASK;
-    uint_fast16_t result = A + n;
-
-    clear_flag_register(); // N is implicitly cleared
-    set_flag(result > BYTE_MASK, C_FLAG);
-    set_flag(A_nibble + n_nibble > LO_NIBBLE_MASK, H_FLAG);
-    set_flag((result &= BYTE_MASK) == 0, Z_FLAG);
-
-    CPU_REG_A = (uint8_t) result;
-}
-
-void OPC_ADD_A_A(void) {
-    LOG_DEBUG("OPC_ADD_A_A(void)");
-    ADD_A_n(CPU_REG_A);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_ADD_A_B(void) {
-    LOG_DEBUG("OPC_ADD_A_B(void)");
-    ADD_A_n(CPU_REG_B);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_ADD_A_C(void) {
-    LOG_DEBUG("OPC_ADD_A_C(void)");
-    ADD_A_n(CPU_REG_C);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_ADD_A_D(void) {
-    LOG_DEBUG("OPC_ADD_A_D(void)");
-    ADD_A_n(CPU_REG_D);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_ADD_A_E(void) {
-    LOG_DEBUG("OPC_ADD_A_E(void)");
-    ADD_A_n(CPU_REG_E);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_ADD_A_H(void) {
-    LOG_DEBUG("OPC_ADD_A_H(void)");
-    ADD_A_n(CPU_REG_H);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_ADD_A_L(void) {
-    LOG_DEBUG("OPC_ADD_A_L(void)");
-    ADD_A_n(CPU_REG_L);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_ADD_A_HL(void) {
-    LOG_DEBUG("OPC_ADD_A_HL(void)");
-    ADD_A_n(mmu_get_byte(CPU_DREG_HL));
-    cpu.cycle_count += 8;
-    ++cpu.PC;
-}
-
-void OPC_ADD_A_d8(void) {
-    LOG_DEBUG("OPC_ADD_A_d8(void)");
-    uint8_t immediate = mmu_get_byte(cpu.PC + 1);
-    ADD_A_n(immediate);
-    cpu.cycle_count += 8;
-    cpu.PC += 2;
-}
-
-static void ADC_A_n(uint8_t n) {
-    uint8_t A            = CPU_REG_A;
-    uint8_t A_nibble     = A & LO_NIBBLE_MASK;
-    uint8_t n_nibble     = n & LO_NIBBLE_MASK;
-    uint8_t c_flag       = get_flag(C_FLAG);
-    uint_fast16_t result = (uint_fast16_t) (A + n + c_flag);
-
-    clear_flag_register(); // N is implicitly cleared
-    set_flag(result > BYTE_MASK, C_FLAG);
-    set_flag(A_nibble + n_nibble + c_flag > LO_NIBBLE_MASK, H_FLAG);
-    set_flag((result &= BYTE_MASK) == 0, Z_FLAG);
-
-    CPU_REG_A = (uint8_t) result;
-}
-
-void OPC_ADC_A_A(void) {
-    LOG_DEBUG("OPC_ADC_A_A(void)");
-    ADC_A_n(CPU_REG_A);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_ADC_A_B(void) {
-    LOG_DEBUG("OPC_ADC_A_B(void)");
-    ADC_A_n(CPU_REG_B);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_ADC_A_C(void) {
-    LOG_DEBUG("OPC_ADC_A_C(void)");
-    ADC_A_n(CPU_REG_C);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_ADC_A_D(void) {
-    LOG_DEBUG("OPC_ADC_A_D(void)");
-    ADC_A_n(CPU_REG_D);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_ADC_A_E(void) {
-    LOG_DEBUG("OPC_ADC_A_E(void)");
-    ADC_A_n(CPU_REG_E);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_ADC_A_H(void) {
-    LOG_DEBUG("OPC_ADC_A_H(void)");
-    ADC_A_n(CPU_REG_H);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_ADC_A_L(void) {
-    LOG_DEBUG("OPC_ADC_A_L(void)");
-    ADC_A_n(CPU_REG_L);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_ADC_A_HL(void) {
-    LOG_DEBUG("OPC_ADC_A_HL(void)");
-    ADC_A_n(mmu_get_byte(CPU_DREG_HL));
-    cpu.cycle_count += 8;
-    ++cpu.PC;
-}
-
-void OPC_ADC_A_d8(void) {
-    LOG_DEBUG("OPC_ADC_A_d8(void)");
-    uint8_t immediate = mmu_get_byte(cpu.PC + 1);
-    ADC_A_n(immediate);
-    cpu.cycle_count += 8;
-    cpu.PC += 2;
-}
-
-static void SUB_A_n(uint8_t n) {
-    uint8_t A      = CPU_REG_A;
-    uint8_t result = A - n;
-
-    clear_flag_register();
-    set_flag(!result, Z_FLAG);
-    set_flag(1, N_FLAG);
-    set_flag((n & LO_NIBBLE_MASK) > (A & LO_NIBBLE_MASK), H_FLAG);
-    set_flag(n > A, C_FLAG);
-
-    CPU_REG_A = result;
-}
-
-void OPC_SUB_A_A(void) {
-    LOG_DEBUG("OPC_SUB_A_A(void)");
-    SUB_A_n(CPU_REG_A);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_SUB_A_B(void) {
-    LOG_DEBUG("OPC_SUB_A_B(void)");
-    SUB_A_n(CPU_REG_B);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_SUB_A_C(void) {
-    LOG_DEBUG("OPC_SUB_A_C(void)");
-    SUB_A_n(CPU_REG_C);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_SUB_A_D(void) {
-    LOG_DEBUG("OPC_SUB_A_D(void)");
-    SUB_A_n(CPU_REG_D);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_SUB_A_E(void) {
-    LOG_DEBUG("OPC_SUB_A_E(void)");
-    SUB_A_n(CPU_REG_E);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_SUB_A_H(void) {
-    LOG_DEBUG("OPC_SUB_A_H(void)");
-    SUB_A_n(CPU_REG_H);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_SUB_A_L(void) {
-    LOG_DEBUG("OPC_SUB_A_L(void)");
-    SUB_A_n(CPU_REG_L);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_SUB_A_HL(void) {
-    LOG_DEBUG("OPC_SUB_A_HL(void)");
-    SUB_A_n(mmu_get_byte(CPU_DREG_HL));
-    cpu.cycle_count += 8;
-    ++cpu.PC;
-}
-
-void OPC_SUB_A_d8(void) {
-    LOG_DEBUG("OPC_SUB_A_d8(void)");
-    uint8_t immediate = mmu_get_byte(cpu.PC + 1);
-    SUB_A_n(immediate);
-    cpu.cycle_count += 8;
-    cpu.PC += 2;
-}
-
-static void SBC_A_n(uint8_t n) {
-    uint8_t A      = CPU_REG_A;
-    uint8_t carry  = get_flag(C_FLAG);
-    uint8_t result = (uint8_t) (A - carry - n);
-
-    clear_flag_register();
-    set_flag(!result, Z_FLAG);
-    set_flag(1, N_FLAG);
-    set_flag(((n + carry) & LO_NIBBLE_MASK) > (A & LO_NIBBLE_MASK), H_FLAG);
-    set_flag((n + carry) > A, C_FLAG);
-
-    CPU_REG_A = result;
-}
-
-void OPC_SBC_A_A(void) {
-    LOG_DEBUG("OPC_SBC_A_A(void)");
-    SBC_A_n(CPU_REG_A);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_SBC_A_B(void) {
-    LOG_DEBUG("OPC_SBC_A_B(void)");
-    SBC_A_n(CPU_REG_B);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_SBC_A_C(void) {
-    LOG_DEBUG("OPC_SBC_A_C(void)");
-    SBC_A_n(CPU_REG_C);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_SBC_A_D(void) {
-    LOG_DEBUG("OPC_SBC_A_D(void)");
-    SBC_A_n(CPU_REG_D);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_SBC_A_E(void) {
-    LOG_DEBUG("OPC_SBC_A_E(void)");
-    SBC_A_n(CPU_REG_E);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_SBC_A_H(void) {
-    LOG_DEBUG("OPC_SBC_A_H(void)");
-    SBC_A_n(CPU_REG_H);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_SBC_A_L(void) {
-    LOG_DEBUG("OPC_SBC_A_L(void)");
-    SBC_A_n(CPU_REG_L);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_SBC_A_HL(void) {
-    LOG_DEBUG("OPC_SBC_A_HL(void)");
-    SBC_A_n(mmu_get_byte(CPU_DREG_HL));
-    cpu.cycle_count += 8;
-    ++cpu.PC;
-}
-
-void OPC_SBC_A_d8(void) {
-    LOG_DEBUG("OPC_SBC_A_d8(void)");
-    uint8_t immediate = mmu_get_byte(cpu.PC + 1);
-    SBC_A_n(immediate);
-    cpu.cycle_count += 8;
-    cpu.PC += 2;
-}
-
-static void AND_A_n(uint8_t n) {
-    uint8_t result = CPU_REG_A & n;
-
-    clear_flag_register(); // C and N are implicitly cleared
-    set_flag(!result, Z_FLAG);
-    set_flag(1, H_FLAG);
-
-    CPU_REG_A = result;
-}
-
-void OPC_AND_A_A(void) {
-    LOG_DEBUG("OPC_AND_A_A(void)");
-    AND_A_n(CPU_REG_A);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_AND_A_B(void) {
-    LOG_DEBUG("OPC_AND_A_B(void)");
-    AND_A_n(CPU_REG_B);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_AND_A_C(void) {
-    LOG_DEBUG("OPC_AND_A_C(void)");
-    AND_A_n(CPU_REG_C);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_AND_A_D(void) {
-    LOG_DEBUG("OPC_AND_A_D(void)");
-    AND_A_n(CPU_REG_D);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_AND_A_E(void) {
-    LOG_DEBUG("OPC_AND_A_E(void)");
-    AND_A_n(CPU_REG_E);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_AND_A_H(void) {
-    LOG_DEBUG("OPC_AND_A_H(void)");
-    AND_A_n(CPU_REG_H);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_AND_A_L(void) {
-    LOG_DEBUG("OPC_AND_A_L(void)");
-    AND_A_n(CPU_REG_L);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_AND_A_HL(void) {
-    LOG_DEBUG("OPC_AND_A_HL(void)");
-    AND_A_n(mmu_get_byte(CPU_DREG_HL));
-    cpu.cycle_count += 8;
-    ++cpu.PC;
-}
-
-void OPC_AND_A_d8(void) {
-    LOG_DEBUG("OPC_AND_A_d8(void)");
-    uint8_t immediate = mmu_get_byte(cpu.PC + 1);
-    AND_A_n(immediate);
-    cpu.cycle_count += 8;
-    cpu.PC += 2;
-}
-
-static void OR_A_n(uint8_t n) {
-    uint8_t result = CPU_REG_A | n;
-
-    clear_flag_register(); // C, H, and N are implicitly cleared
-    set_flag(!result, Z_FLAG);
-
-    CPU_REG_A = result;
-}
-
-void OPC_OR_A_A(void) {
-    LOG_DEBUG("OPC_OR_A_A(void)");
-    OR_A_n(CPU_REG_A);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_OR_A_B(void) {
-    LOG_DEBUG("OPC_OR_A_B(void)");
-    OR_A_n(CPU_REG_B);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_OR_A_C(void) {
-    LOG_DEBUG("OPC_OR_A_C(void)");
-    OR_A_n(CPU_REG_C);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_OR_A_D(void) {
-    LOG_DEBUG("OPC_OR_A_D(void)");
-    OR_A_n(CPU_REG_D);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_OR_A_E(void) {
-    LOG_DEBUG("OPC_OR_A_E(void)");
-    OR_A_n(CPU_REG_E);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_OR_A_H(void) {
-    LOG_DEBUG("OPC_OR_A_H(void)");
-    OR_A_n(CPU_REG_H);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_OR_A_L(void) {
-    LOG_DEBUG("OPC_OR_A_L(void)");
-    OR_A_n(CPU_REG_L);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_OR_A_HL(void) {
-    LOG_DEBUG("OPC_OR_A_HL(void)");
-    OR_A_n(mmu_get_byte(CPU_DREG_HL));
-    cpu.cycle_count += 8;
-    ++cpu.PC;
-}
-
-void OPC_OR_A_d8(void) {
-    LOG_DEBUG("OPC_OR_A_d8(void)");
-    uint8_t immediate = mmu_get_byte(cpu.PC + 1);
-    OR_A_n(immediate);
-    cpu.cycle_count += 8;
-    cpu.PC += 2;
-}
-
-static void XOR_A_n(uint8_t n) {
-    clear_flag_register();
-
-    CPU_REG_A ^= n;
-    set_flag((CPU_REG_A == 0x00), Z_FLAG);
-}
-
-void OPC_XOR_A_A(void) {
-    LOG_DEBUG("OPC_XOR_A_A(void)");
-    XOR_A_n(CPU_REG_A);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_XOR_A_B(void) {
-    LOG_DEBUG("OPC_XOR_A_B(void)");
-    XOR_A_n(CPU_REG_B);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_XOR_A_C(void) {
-    LOG_DEBUG("OPC_XOR_A_C(void)");
-    XOR_A_n(CPU_REG_C);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_XOR_A_D(void) {
-    LOG_DEBUG("OPC_XOR_A_D(void)");
-    XOR_A_n(CPU_REG_D);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_XOR_A_E(void) {
-    LOG_DEBUG("OPC_XOR_A_E(void)");
-    XOR_A_n(CPU_REG_E);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_XOR_A_H(void) {
-    LOG_DEBUG("OPC_XOR_A_H(void)");
-    XOR_A_n(CPU_REG_H);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_XOR_A_L(void) {
-    LOG_DEBUG("OPC_XOR_A_L(void)");
-    XOR_A_n(CPU_REG_L);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_XOR_A_HL(void) {
-    LOG_DEBUG("OPC_XOR_A_HL(void)");
-    XOR_A_n(mmu_get_byte(CPU_DREG_HL));
-    cpu.cycle_count += 8;
-    ++cpu.PC;
-}
-
-void OPC_XOR_A_d8(void) {
-    LOG_DEBUG("OPC_XOR_A_d8(void)");
-    XOR_A_n(mmu_get_byte(cpu.PC + 1));
-    cpu.cycle_count += 8;
-    cpu.PC += 2;
-}
-
-static void CP_A_n(uint8_t n) {
-    uint8_t A      = CPU_REG_A;
-    uint8_t result = A - n;
-
-    clear_flag_register();
-    set_flag(!result, Z_FLAG);
-    set_flag(1, N_FLAG);
-    set_flag((n & LO_NIBBLE_MASK) > (A & LO_NIBBLE_MASK), H_FLAG);
-    set_flag(n > A, C_FLAG);
-}
-
-void OPC_CP_A_A(void) {
-    LOG_DEBUG("OPC_CP_A_A(void)");
-    CP_A_n(CPU_REG_A);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_CP_A_B(void) {
-    LOG_DEBUG("OPC_CP_A_B(void)");
-    CP_A_n(CPU_REG_B);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_CP_A_C(void) {
-    LOG_DEBUG("OPC_CP_A_C(void)");
-    CP_A_n(CPU_REG_C);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_CP_A_D(void) {
-    LOG_DEBUG("OPC_CP_A_D(void)");
-    CP_A_n(CPU_REG_D);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_CP_A_E(void) {
-    LOG_DEBUG("OPC_CP_A_E(void)");
-    CP_A_n(CPU_REG_E);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_CP_A_H(void) {
-    LOG_DEBUG("OPC_CP_A_H(void)");
-    CP_A_n(CPU_REG_H);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_CP_A_L(void) {
-    LOG_DEBUG("OPC_CP_A_L(void)");
-    CP_A_n(CPU_REG_L);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_CP_A_HL(void) {
-    LOG_DEBUG("OPC_CP_A_HL(void)");
-    CP_A_n(mmu_get_byte(CPU_DREG_HL));
-    cpu.cycle_count += 8;
-    ++cpu.PC;
-}
-
-void OPC_CP_A_d8(void) {
-    LOG_DEBUG("OPC_CP_A_d8(void)");
-    uint8_t immediate = mmu_get_byte(cpu.PC + 1);
-    CP_A_n(immediate);
-    cpu.cycle_count += 8;
-    cpu.PC += 2;
-}
-
-static void INC_n(uint8_t *const reg) {
-    ++(*reg);
-
-    set_flag(!(*reg), Z_FLAG);
-    set_flag(((*reg) & 0x10) == 0x10, H_FLAG);
-    clear_flag(N_FLAG);
-}
-
-void OPC_INC_B(void) {
-    LOG_DEBUG("OPC_INC_B(void)");
-    INC_n(&CPU_REG_B);
-
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_INC_C(void) {
-    LOG_DEBUG("OPC_INC_C(void)");
-    INC_n(&CPU_REG_C);
-
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_INC_D(void) {
-    LOG_DEBUG("OPC_INC_D(void)");
-    INC_n(&CPU_REG_D);
-
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_INC_E(void) {
-    LOG_DEBUG("OPC_INC_E(void)");
-    INC_n(&CPU_REG_E);
-
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_INC_H(void) {
-    LOG_DEBUG("OPC_INC_H(void)");
-    INC_n(&CPU_REG_H);
-
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_INC_L(void) {
-    LOG_DEBUG("OPC_INC_L(void)");
-    INC_n(&CPU_REG_L);
-
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_INC_A(void) {
-    LOG_DEBUG("OPC_INC_A(void)");
-    INC_n(&CPU_REG_A);
-
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_INC_HL(void) {
-    LOG_DEBUG("OPC_INC_HL(void)");
-    uint8_t value = mmu_get_byte(CPU_DREG_HL);
-    INC_n(&value);
-    mmu_write_byte(CPU_DREG_HL, value);
-
-    cpu.cycle_count += 12;
-    ++cpu.PC;
-}
-
-static void DEC_n(uint8_t *const addr) {
-    // Simplifications made for half carry flag check:
-    // (*addr & LO_NIBBLE_MASK) < (n & LO_NIBBLE_MASK) where n = 1
-    // (*addr & LO_NIBBLE_MASK) < (1 & LO_NIBBLE_MASK)
-    // (*addr & LO_NIBBLE_MASK) < 1
-    // (*addr & LO_NIBBLE_MASK) == 0
-    set_flag(!(*addr & LO_NIBBLE_MASK), H_FLAG);
-
-    --(*addr);
-
-    set_flag(!(*addr), Z_FLAG);
-    set_flag(1, N_FLAG);
-
-    // Flag C is not affected
-}
-
-void OPC_DEC_A(void) {
-    LOG_DEBUG("OPC_DEC_A(void)");
-    DEC_n(&CPU_REG_A);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_DEC_B(void) {
-    LOG_DEBUG("OPC_DEC_B(void)");
-    DEC_n(&CPU_REG_B);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_DEC_C(void) {
-    LOG_DEBUG("OPC_DEC_C(void)");
-    DEC_n(&CPU_REG_C);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_DEC_D(void) {
-    LOG_DEBUG("OPC_DEC_D(void)");
-    DEC_n(&CPU_REG_D);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_DEC_E(void) {
-    LOG_DEBUG("OPC_DEC_E(void)");
-    DEC_n(&CPU_REG_E);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_DEC_H(void) {
-    LOG_DEBUG("OPC_DEC_H(void)");
-    DEC_n(&CPU_REG_H);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_DEC_L(void) {
-    LOG_DEBUG("OPC_DEC_L(void)");
-    DEC_n(&CPU_REG_L);
-    cpu.cycle_count += 4;
-    ++cpu.PC;
-}
-
-void OPC_DEC_HL(void) {
-    LOG_DEBUG("OPC_DEC_HL(void)");
-    uint8_t value = mmu_get_byte(CPU_DREG_HL);
-    DEC_n(&value);
-    mmu_write_byte(CPU_DREG_HL, value);
-    cpu.cycle_count += 12;
-    ++cpu.PC;
-}
-
-void OPC_RST_x(uint16_t address) {
-    mmu_stack_push(cpu.PC);
-    cpu.PC = mmu_get_two_bytes(address);
-    cpu.cycle_count += 16;
-}
-
-void OPC_RST_00(void) {
-    LOG_DEBUG("OPC_RST_00");
-    OPC_RST_x(0x0000);
-}
-void OPC_RST_10(void) {
-    LOG_DEBUG("OPC_RST_10");
-    OPC_RST_x(0x0010);
-}
-void OPC_RST_20(void) {
-    LOG_DEBUG("OPC_RST_20");
-    OPC_RST_x(0x0020);
-}
-void OPC_RST_30(void) {
-    LOG_DEBUG("OPC_RST_30");
-    OPC_RST_x(0x0030);
-}
-void OPC_RST_08(void) {
-    LOG_DEBUG("OPC_RST_08");
-    OPC_RST_x(0x0008);
-}
-void OPC_RST_18(void) {
-    LOG_DEBUG("OPC_RST_18");
-    OPC_RST_x(0x0018);
-}
-void OPC_RST_28(void) {
-    LOG_DEBUG("OPC_RST_28");
-    OPC_RST_x(0x0028);
-}
-void OPC_RST_38(void) {
-    LOG_DEBUG("OPC_RST_38");
-    OPC_RST_x(0x0038);
-}
-void OPC_LD_xx_u16(uint16_t load_addr) {
-    mmu_write_two_bytes(load_addr, mmu_get_two_bytes(cpu.PC));
-    cpu.PC += 2;
-
-    cpu.cycle_count += 12;
-}
-
-void OPC_LD_BC_u16(void) {
-    LOG_DEBUG("OPC_LD_BC_u16");
-    OPC_LD_xx_u16(CPU_DREG_BC);
-}
-
-void OPC_LD_DE_u16(void) {
-    LOG_DEBUG("OPC_LD_DE_u16");
-    OPC_LD_xx_u16(CPU_DREG_DE);
-}
-
-void OPC_LD_HL_u16(void) {
-    LOG_DEBUG("OPC_LD_HL_u16");
-    OPC_LD_xx_u16(CPU_DREG_HL);
-}
-
-void OPC_LD_SP_u16(void) {
-    LOG_DEBUG("OPC_LD_SP_u16");
-    OPC_LD_xx_u16(cpu.SP);
-}
-
-void OPC_JR_i8(void) {
-    LOG_DEBUG("OPC_JR_i8");
-    int8_t n = (int8_t) mmu_get_byte(cpu.PC);
-    cpu.PC++;
-
-    LOG_DEBUG("Jumping to PC (0x%02x) + 0x%02x", cpu.PC, n);
-    cpu.PC = (uint16_t) (cpu.PC + n);
-    cpu.cycle_count += 12;
-}
-
-void CALL(uint16_t address);
-void CALL(uint16_t address) {
-    LOG_DEBUG("CALL");
-    mmu_stack_push(cpu.PC);
-    cpu.PC = address;
+void CALL(uint16_t address);
+void CALL(uint16_t address) {
+    LOG_DEBUG("CALL");
+    mmu_stack_push(cpu.PC);
+    pc_profiler_call(cpu.PC);
+    cpu.PC = address;
 }
 
 void OPC_CALL_u16(void) {
     LOG_DEBUG("OPC_CALL_u16");
-    uint16_t nn = mmu_get_two_bytes(cpu.PC);
+    uint16_t nn = CPU_OPERAND_U16;
     CALL(nn);
 }
 void OPC_CALL_cc_u16(uint8_t bit, uint8_t branching_condition);
 void OPC_CALL_cc_u16(uint8_t bit, uint8_t branching_condition) {
     LOG_DEBUG("OPC_CALL_cc_u16");
-    uint16_t nn = mmu_get_two_bytes(cpu.PC);
+    uint16_t nn = CPU_OPERAND_U16;
 
     if (bit == branching_condition) {
         CALL(nn);
-        cpu.cycle_count += 24;
-    } else {
-        cpu.cycle_count += 12;
+        branch_taken();
     }
 }
 
@@ -1965,5 +1655,33 @@ void OPC_CALL_NC_u16(void) {
 
 void OPC_DI(void) {
     LOG_DEBUG("OPC_DI(void)");
-    // TODO: implement interrupt
+    interrupt_disable();
+}
+
+void OPC_EI(void) {
+    LOG_DEBUG("OPC_EI(void)");
+    interrupt_enable();
+}
+
+void OPC_RET(void) {
+    LOG_DEBUG("OPC_RET(void)");
+    cpu.PC = mmu_stack_pop();
+    pc_profiler_return();
+}
+
+void OPC_HALT(void) {
+    LOG_DEBUG("OPC_HALT(void)");
+    if (!interrupts.ime && (interrupts.enable & interrupts.flags & IF_MASK)) {
+        return;
+    }
+
+    cpu.halted = true;
+    cpu_yield();
+}
+
+void OPC_RETI(void) {
+    LOG_DEBUG("OPC_RETI(void)");
+    cpu.PC = mmu_stack_pop();
+    pc_profiler_return();
+    interrupt_enable_now();
 }
@@ -2,6 +2,7 @@
 #define YOBEMAG_CPU_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 /**
  * Encodes bit positions for flag register A
@@ -25,6 +26,54 @@ typedef enum flag {
     Z_FLAG = 7,
 } Flag;
 
+/**
+ * Kind of flag-producing ALU operation, used to compute F from its operands
+ */
+typedef enum FlagOp {
+    /**
+     * @brief F is up to date, nothing is pending
+     */
+    FLAG_OP_NONE = 0,
+    /**
+     * @brief ADD/ADC: lhs + rhs + aux (carry in)
+     */
+    FLAG_OP_ADD,
+    /**
+     * @brief SUB/SBC/CP: lhs - rhs - aux (carry in)
+     */
+    FLAG_OP_SUB,
+    /**
+     * @brief AND: lhs is the result
+     */
+    FLAG_OP_AND,
+    /**
+     * @brief OR/XOR: lhs is the result
+     */
+    FLAG_OP_OR,
+    /**
+     * @brief INC: lhs is the result, aux the previous C flag
+     */
+    FLAG_OP_INC,
+    /**
+     * @brief DEC: lhs is the value before decrementing, aux the previous C flag
+     */
+    FLAG_OP_DEC,
+} FlagOp;
+
+#if defined(YOBEMAG_LAZY_FLAGS)
+
+/**
+ * Operands of the last ALU operation whose flags have not been written to F yet
+ */
+typedef struct LazyFlags {
+    uint8_t op; // FlagOp
+    uint8_t lhs;
+    uint8_t rhs;
+    uint8_t aux;
+} LazyFlags;
+
+#endif
+
 typedef union DoubleWordReg {
     struct {
         uint8_t lo; // F, C, E, L
@@ -42,13 +91,35 @@ typedef struct CPU {
     uint16_t SP;
     uint16_t PC;
 
-    uint16_t cycle_count;
+    /**
+     * @brief Master clock: T-cycles since power on, never wraps. Scheduled events are due at a value of this clock
+     */
+    uint64_t cycle_count;
 
     uint8_t opcode;
+
+    /**
+     * @brief Immediate operand (d8/a8/r8 or d16/a16) of the current instruction, fetched during decode
+     */
+    uint16_t operand;
+
+    /**
+     * @brief Set by HALT, no instructions are executed until an enabled interrupt is requested
+     */
+    bool halted;
+
+#if defined(YOBEMAG_LAZY_FLAGS)
+    /**
+     * @brief Pending flag computation, F is only materialized when it is read (see CPU_REG_F)
+     */
+    LazyFlags flags;
+#endif
 } CPU;
 
 extern CPU cpu;
 
+typedef void (*op_function)(void);
+
 #define CPU_DREG_HL cpu.HL.dword
 #define CPU_REG_H   cpu.HL.words.hi
 #define CPU_REG_L   cpu.HL.words.lo
@@ -61,17 +132,134 @@ extern CPU cpu;
 #define CPU_REG_B   cpu.BC.words.hi
 #define CPU_REG_C   cpu.BC.words.lo
 
-#define CPU_DREG_AF cpu.AF.dword
-#define CPU_REG_A   cpu.AF.words.hi
-#define CPU_REG_F   cpu.AF.words.lo
+#define CPU_REG_A cpu.AF.words.hi
+
+#if defined(YOBEMAG_LAZY_FLAGS)
+    // Every access to F (or AF) first writes back the flags of a pending ALU operation
+    #define CPU_DREG_AF (*(cpu_sync_flags(), &cpu.AF.dword))
+    #define CPU_REG_F   (*(cpu_sync_flags(), &cpu.AF.words.lo))
+#else
+    #define CPU_DREG_AF cpu.AF.dword
+    #define CPU_REG_F   cpu.AF.words.lo
+#endif
 
 #define CPU_SP cpu.SP
 
+/**
+ * @brief Cycles per second of the master clock
+ */
+#define CPU_CLOCK_HZ (4194304)
+
+#define CPU_OPERAND_U8  ((uint8_t) cpu.operand)
+#define CPU_OPERAND_U16 cpu.operand
+
+/**
+ * @brief Start at 0x0100 in the state the boot ROM leaves behind, which includes unmapping it
+ */
 void cpu_init(void);
+
+/**
+ * @brief Start at 0x0000 with cleared registers, i.e. run the boot ROM which ::mmu_init() mapped
+ */
+void cpu_power_on(void);
 void cpu_step(void);
 
+/**
+ * @brief Execute @p instructions instructions back to back.
+ *
+ * @note  Depending on the `DISPATCH` CMake option this uses the function table
+ *        or the threaded (computed goto) interpreter core.
+ */
+void cpu_step_n(uint32_t instructions);
+
+/**
+ * Why ::cpu_run() returned
+ */
+typedef enum CPUStopReason {
+    /**
+     * @brief The cycle budget has been spent
+     */
+    CPU_STOP_BUDGET,
+    /**
+     * @brief An event handler called ::cpu_request_stop(), e.g. because the user wants to quit
+     */
+    CPU_STOP_EVENT,
+    /**
+     * @brief The PC reached a breakpoint, the instruction there has not been executed yet
+     */
+    CPU_STOP_BREAKPOINT,
+} CPUStopReason;
+
+typedef struct CPURunResult {
+    /**
+     * @brief Cycles that actually ran, can exceed the budget by the rest of the last instruction
+     *        or an interrupt dispatch
+     */
+    uint64_t cycles;
+    CPUStopReason reason;
+} CPURunResult;
+
+/**
+ * @brief Execute instructions until @p budget cycles have been spent, running scheduled events when they are due.
+ *
+ * @note  A breakpoint at the current PC is ignored so that a run stopped by it can be resumed.
+ */
+CPURunResult cpu_run(uint64_t budget);
+
+/**
+ * @brief End the current batch of instructions after the running one, so that ::cpu_run() looks at the interrupts
+ *        before it continues
+ */
+void cpu_yield(void);
+
+/**
+ * @brief End the current batch of instructions once the clock reached @p cycle, if it would otherwise run longer
+ *
+ * @note  Used by ::scheduler_schedule(), a batch only runs up to the deadlines which were pending when it started.
+ */
+void cpu_yield_at(uint64_t cycle);
+
+/**
+ * @brief Enable or disable skipping idle loops (enabled by default).
+ *
+ * @note  A loop which polls memory without side effects, e.g. `LDH A, (LY); CP n; JR NZ`, does the same in every pass
+ *        until the next event changes the memory. ::cpu_run() then advances the clock by all passes up to that event
+ *        at once, the result is the same as executing them.
+ */
+void cpu_set_idle_loop_skipping(bool enabled);
+
+/**
+ * @brief Cycles skipped in idle loops since ::cpu_init()
+ */
+__attribute__((pure)) uint64_t cpu_idle_cycles_skipped(void);
+
+/**
+ * @brief Let the current ::cpu_run() return with ::CPU_STOP_EVENT once the running event handlers are done
+ */
+void cpu_request_stop(void);
+
+/**
+ * @brief Set or clear a breakpoint at @p addr, checked by ::cpu_run() before every instruction while any is set
+ */
+void cpu_set_breakpoint(uint16_t addr, bool enabled);
+
 void cpu_print_registers(void);
 
+#if defined(YOBEMAG_LAZY_FLAGS)
+
+/**
+ * @brief Computes F from the pending ALU operation recorded in `cpu.flags`.
+ */
+void cpu_materialize_flags(void);
+
+__attribute__((always_inline)) inline void cpu_sync_flags(void) {
+    if (__builtin_expect(cpu.flags.op != FLAG_OP_NONE, 0)) {
+        cpu_materialize_flags();
+    }
+}
+
+#endif
+
 __attribute((always_inline)) inline uint8_t get_flag(Flag f) {
     return (CPU_REG_F >> f) & 1;
 }
@@ -85,7 +273,10 @@ __attribute((always_inline)) inline void clear_flag(Flag f) {
 }
 
 __attribute__((always_inline)) inline void clear_flag_register(void) {
-    CPU_REG_F = 0;
+#if defined(YOBEMAG_LAZY_FLAGS)
+    cpu.flags.op = FLAG_OP_NONE;
+#endif
+    cpu.AF.words.lo = 0;
 }
 
 void REG_INC(uint8_t *reg);
@@ -147,505 +338,61 @@ void OPC_LD_A_BC(void);
 void OPC_LD_A_DE(void);
 void OPC_LD_A_HL_PLUS(void);
 void OPC_LD_A_HL_MINUS(void);
-void OPC_LD_B_B(void);
-void OPC_LD_B_C(void);
-void OPC_LD_B_D(void);
-void OPC_LD_B_E(void);
-void OPC_LD_B_H(void);
-void OPC_LD_B_L(void);
-void OPC_LD_B_HL(void);
-void OPC_LD_B_A(void);
-void OPC_LD_B_d8(void);
-void OPC_LD_C_B(void);
-void OPC_LD_C_C(void);
-void OPC_LD_C_D(void);
-void OPC_LD_C_E(void);
-void OPC_LD_C_H(void);
-void OPC_LD_C_L(void);
-void OPC_LD_C_HL(void);
-void OPC_LD_C_A(void);
-void OPC_LD_C_d8(void);
-void OPC_LD_D_B(void);
-void OPC_LD_D_C(void);
-void OPC_LD_D_D(void);
-void OPC_LD_D_E(void);
-void OPC_LD_D_H(void);
-void OPC_LD_D_L(void);
-void OPC_LD_D_HL(void);
-void OPC_LD_D_A(void);
-void OPC_LD_D_d8(void);
-void OPC_LD_E_B(void);
-void OPC_LD_E_C(void);
-void OPC_LD_E_D(void);
-void OPC_LD_E_E(void);
-void OPC_LD_E_H(void);
-void OPC_LD_E_L(void);
-void OPC_LD_E_HL(void);
-void OPC_LD_E_A(void);
-void OPC_LD_E_d8(void);
-void OPC_LD_H_B(void);
-void OPC_LD_H_C(void);
-void OPC_LD_H_D(void);
-void OPC_LD_H_E(void);
-void OPC_LD_H_H(void);
-void OPC_LD_H_L(void);
-void OPC_LD_H_HL(void);
-void OPC_LD_H_A(void);
-void OPC_LD_H_d8(void);
-void OPC_LD_L_B(void);
-void OPC_LD_L_C(void);
-void OPC_LD_L_D(void);
-void OPC_LD_L_E(void);
-void OPC_LD_L_H(void);
-void OPC_LD_L_L(void);
-void OPC_LD_L_HL(void);
-void OPC_LD_L_A(void);
-void OPC_LD_L_d8(void);
-void OPC_LD_HL_B(void);
-void OPC_LD_HL_C(void);
-void OPC_LD_HL_D(void);
-void OPC_LD_HL_E(void);
-void OPC_LD_HL_H(void);
-void OPC_LD_HL_L(void);
-void OPC_LD_HL_A(void);
-void OPC_LD_HL_d8(void);
-void OPC_LD_A_B(void);
-void OPC_LD_A_C(void);
-void OPC_LD_A_D(void);
-void OPC_LD_A_E(void);
-void OPC_LD_A_H(void);
-void OPC_LD_A_L(void);
-void OPC_LD_A_HL(void);
-void OPC_LD_A_A(void);
-void OPC_LD_A_d8(void);
-
-uint16_t cpu_get_two_bytes(uint16_t addr);
-
-/******************************************************
- *** 8-BIT ALU                                      ***
- ******************************************************/
-
-// 8-bit ALU: ADD A,n
-void OPC_ADD_A_A(void);
-
-void OPC_ADD_A_B(void);
-
-void OPC_ADD_A_C(void);
-
-void OPC_ADD_A_D(void);
-
-void OPC_ADD_A_E(void);
-
-void OPC_ADD_A_H(void);
-
-void OPC_ADD_A_L(void);
-
-/**
- * @brief First fetches a byte from the address `HL`,
- * 	      then adds the fetched byte to A.
- *
- * @note This instruction requires the PC to be incremented by 1,
- *       but takes 8 CPU cycles because of fetching a byte from memory
- */
-void OPC_ADD_A_HL(void);
-
-/**
- * @brief First fetches an immediate byte from PC + 1,
- * 	      then adds the fetched byte to A.
- *
- * @warning PC cannot be incremented before this operation is completed
- * 			since it reads the data from the opcode itself.
- *
- * @note This instruction requires the PC to be incremented by 2.
- */
-void OPC_ADD_A_d8(void);
-
-void OPC_ADC_A_A(void);
-
-void OPC_ADC_A_B(void);
-
-void OPC_ADC_A_C(void);
-
-void OPC_ADC_A_D(void);
-
-void OPC_ADC_A_E(void);
-
-void OPC_ADC_A_H(void);
-
-void OPC_ADC_A_L(void);
-
-/**
- * @brief First fetches a byte from the address `HL`,
- * 		  then adds the fetched byte to A together with
- * 		  the carry flag.
- *
- * @note This instruction requires the PC to be incremented by 1,
- *       but takes 8 CPU cycles because of fetching a byte from memory.
- */
-void OPC_ADC_A_HL(void);
-
-/**
- * @brief First fetches an immediate byte from PC + 1,
- * 		  then adds the fetched byte to A together with
- * 		  the carry flag.
- *
- * @warning PC cannot be incremented before this operation
- * 			is completed since it reads the data from the
- * 			opcode itself.
- *
- * @note This instruction requires the PC to be incremented by 2.
- */
-void OPC_ADC_A_d8(void);
-
-/**
- * @brief Subtract the value stored in Register A from
- * 	      the value stored in A and store it back into A.
- */
-void OPC_SUB_A_A(void);
-
-/**
- * @brief Subtract the value stored in Register B from
- * 	      the value stored in A and store it back into A.
- */
-void OPC_SUB_A_B(void);
-
-/**
- * @brief Subtract the value stored in Register C from
- * 	      the value stored in A and store it back into A.
- */
-void OPC_SUB_A_C(void);
-
-/**
- * @brief Subtract the value stored in Register D from
- * 	      the value stored in A and store it back into A.
- */
-void OPC_SUB_A_D(void);
-
-/**
- * @brief Subtract the value stored in Register E from
- * 	      the value stored in A and store it back into A.
- */
-void OPC_SUB_A_E(void);
-
-/**
- * @brief Subtract the value stored in Register H from
- * 	      the value stored in A and store it back into A.
- */
-void OPC_SUB_A_H(void);
-
-/**
- * @brief Subtract the value stored in Register L from
- * 	      the value stored in A and store it back into A.
- */
-void OPC_SUB_A_L(void);
-
-/**
- * @brief First fetches a byte from the address `HL`,
- * 	      then subtracts the fetched byte from A.
- *        As this operation fetches a byte from memory, this takes 8 cycles.
- */
-void OPC_SUB_A_HL(void);
-
-/**
- * @brief First fetches an immediate byte from PC + 1,
- * 	      then subtracts the fetched byte from A.
- *
- * @warning PC cannot be incremented before this operation is completed
- * 			since it reads the data from the opcode itself.
- *          As this operation fetches a byte from memory, this takes 8 cycles.
- */
-void OPC_SUB_A_d8(void);
-
-/**
- * @brief Subtract the value stored in Register A from the value stored in A,
- * 	      additionally subtract the carry flag, then store it in A.
- */
-void OPC_SBC_A_A(void);
-
-/**
- * @brief Subtract the value stored in Register B from the value stored in A,
- *        additionally subtract the carry flag, then store it in A.
- */
-void OPC_SBC_A_B(void);
-
-/**
- * @brief Subtract the value stored in Register C from the value stored in A,
- *        additionally, subtract the carry flag, then store it in A.
- */
-void OPC_SBC_A_C(void);
-
-/**
- * @brief Subtract the value stored in Register D from the value stored in A,
- *        additionally, subtract the carry flag, then store it in A.
- */
-void OPC_SBC_A_D(void);
-
-/**
- * @brief Subtract the value stored in Register E from the value stored in A,
- *        additionally, subtract the carry flag, then store it in A.
- */
-void OPC_SBC_A_E(void);
-
-/**
- * @brief Subtract the value stored in Register H from the value stored in A,
- *        additionally, subtract the carry flag, then store it in A.
- */
-void OPC_SBC_A_H(void);
-
-/**
- * @brief Subtract the value stored in Register L from the value stored in A,
- *        additionally, subtract the carry flag, then store it in A.
- */
-void OPC_SBC_A_L(void);
-
-/**
- * @brief First fetches a byte from the address `HL`, subtracts the fetched byte from A
- *        additionally, subtract the carry flag, then store it in A.
- *        As this operation fetches a byte from memory, this takes 8 cycles.
- */
-void OPC_SBC_A_HL(void);
-
-/**
- * @brief First fetches an immediate byte from PC + 1, subtracts the fetched byte from A
- *        additionally, subtract the carry flag, then store it in A.
- *
- * @warning PC cannot be incremented before this operation is completed
- * 			since it reads the data from the opcode itself.
- *          As this operation fetches a byte from memory, this takes 8 cycles.
- */
-void OPC_SBC_A_d8(void);
-
-void OPC_AND_A_A(void);
-
-void OPC_AND_A_B(void);
-
-void OPC_AND_A_C(void);
-
-void OPC_AND_A_D(void);
-
-void OPC_AND_A_E(void);
-
-void OPC_AND_A_H(void);
-
-void OPC_AND_A_L(void);
-
-/**
- * @brief First fetches a byte from the address `HL`,
- * 		  then logical ands the fetched byte to A.
- *
- * @note This instruction requires the PC to be incremented by 1,
- *       but takes 8 CPU cycles because of fetching a byte from memory.
- */
-void OPC_AND_A_HL(void);
-
-/**
- * @brief First fetches an immediate byte from PC + 1,
- * 		  then logical ands the fetched byte to A.
- *
- * @warning PC cannot be incremented before this operation
- * 			is completed since it reads the data from the
- * 			opcode itself.
- *
- * @note This instruction requires the PC to be incremented by 2.
- */
-void OPC_AND_A_d8(void);
-
-void OPC_OR_A_A(void);
-
-void OPC_OR_A_B(void);
-
-void OPC_OR_A_C(void);
-
-void OPC_OR_A_D(void);
-
-void OPC_OR_A_E(void);
-
-void OPC_OR_A_H(void);
-
-void OPC_OR_A_L(void);
 
 /**
- * @brief First fetches a byte from the address `HL`,
- * 		  then logical ands the fetched byte to A.
- *
- * @note This instruction requires the PC to be incremented by 1,
- *       but takes 8 CPU cycles because of fetching a byte from memory.
- */
-void OPC_OR_A_HL(void);
-
-/**
- * @brief First fetches an immediate byte from PC + 1,
- * 		  then logical ands the fetched byte to A.
- *
- * @warning PC cannot be incremented before this operation
- * 			is completed since it reads the data from the
- * 			opcode itself.
- *
- * @note This instruction requires the PC to be incremented by 2.
+ * @brief LD r, r': copies the register encoded in z of the opcode into the one encoded in y.
  */
-void OPC_OR_A_d8(void);
+void OPC_LD_r_r(void);
 
 /**
- * @brief XOR the value stored in Register A to the value stored in Register A.
+ * @brief LD r, (HL): loads the byte at address `HL` into the register encoded in y of the opcode.
  */
-void OPC_XOR_A_A(void);
+void OPC_LD_r_HL(void);
 
 /**
- * @brief XOR the value stored in Register B with the value stored in Register A
- *        and store it in Register A.
+ * @brief LD r, d8: loads the immediate byte into the register encoded in y of the opcode.
  */
-void OPC_XOR_A_B(void);
+void OPC_LD_r_d8(void);
 
 /**
- * @brief XOR the value stored in Register B with the value stored in Register A
- *        and store it in Register A.
+ * @brief LD (HL), r: stores the register encoded in z of the opcode at address `HL`.
  */
-void OPC_XOR_A_C(void);
+void OPC_LD_HL_r(void);
 
-/**
- * @brief XOR the value stored in Register B with the value stored in Register A
- *        and store it in Register A.
- */
-void OPC_XOR_A_D(void);
-
-/**
- * @brief XOR the value stored in Register B with the value stored in Register A
- *        and store it in Register A.
- */
-void OPC_XOR_A_E(void);
-
-/**
- * @brief XOR the value stored in Register B with the value stored in Register A
- *        and store it in Register A.
- */
-void OPC_XOR_A_H(void);
-
-/**
- * @brief XOR the value stored in Register B with the value stored in Register A
- *        and store it in Register A.
- */
-void OPC_XOR_A_L(void);
-
-/**
- * @brief First fetches a byte from the address `HL`,
- *        then XORs the byte with the value stored in Register A
- * 	      and store it in Register A.
- *
- * @note Since this operation fetches a byte from memory, it takes 8 cycles.
- */
-void OPC_XOR_A_HL(void);
-
-/**
- * @brief First fetches an immediate byte from PC + 1,
- * 	      then XORs the byte with the value stored in Register A
- * 	      and store it in Register A.
- *
- * @warning PC cannot be incremented before this operation is completed
- * 			since it reads the data from the opcode itself.
- *
- * @note Since this operation fetches a byte from memory, it takes 8 cycles.
- */
-void OPC_XOR_A_d8(void);
-
-/**
- * @brief Compare the value stored in Register A to the value stored in Register A.
- *
- * @note This instruction only sets flags, but does not save the result into Register A.
- */
-void OPC_CP_A_A(void);
-
-/**
- * @brief Compare the value stored in Register B to the value stored in Register A.
- *
- * @note This instruction only sets flags, but does not save the result into Register A.
- */
-void OPC_CP_A_B(void);
-
-/**
- * @brief Compare the value stored in Register C to the value stored in Register A.
- *
- * @note This instruction only sets flags, but does not save the result into Register A.
- */
-void OPC_CP_A_C(void);
-
-/**
- * @brief Compare the value stored in Register D to the value stored in Register A.
- *
- * @note This instruction only sets flags, but does not save the result into Register A.
- */
-void OPC_CP_A_D(void);
+void OPC_LD_HL_d8(void);
 
-/**
- * @brief Compare the value stored in Register E to the value stored in Register A.
- *
- * @note This instruction only sets flags, but does not save the result into Register A.
- */
-void OPC_CP_A_E(void);
+uint16_t cpu_get_two_bytes(uint16_t addr);
 
-/**
- * @brief Compare the value stored in Register H to the value stored in Register A.
- *
- * @note This instruction only sets flags, but does not save the result into Register A.
- */
-void OPC_CP_A_H(void);
+/******************************************************
+ *** 8-BIT ALU                                      ***
+ ******************************************************/
 
 /**
- * @brief Compare the value stored in Register L to the value stored in Register A.
+ * @brief ADD, ADC, SUB, SBC, AND, XOR, OR or CP (encoded in y of the opcode)
+ *        of A and the register encoded in z of the opcode.
  *
- * @note This instruction only sets flags, but does not save the result into Register A.
+ * @note The result is stored in A, except for CP which only sets flags.
  */
-void OPC_CP_A_L(void);
+void OPC_ALU_A_r(void);
 
 /**
- * @brief First fetches a byte from the address `HL`,
- * 	      then compares it to the value stored in Register A.
+ * @brief Like OPC_ALU_A_r, but the operand is the byte at address `HL`.
  *
  * @note Since this operation fetches a byte from memory, it takes 8 cycles.
- *       This instruction only sets flags, but does not save the result into Register A.
  */
-void OPC_CP_A_HL(void);
+void OPC_ALU_A_HL(void);
 
 /**
- * @brief First fetches an immediate byte from PC + 1,
- * 	      then compares it to the value stored in Register A.
- *
- * @warning PC cannot be incremented before this operation is completed
- * 			since it reads the data from the opcode itself.
+ * @brief Like OPC_ALU_A_r, but the operand is the immediate byte following the opcode.
  *
  * @note Since this operation fetches a byte from memory, it takes 8 cycles.
- *       This instruction only sets flags, but does not save the result into Register A.
  */
-void OPC_CP_A_d8(void);
+void OPC_ALU_A_d8(void);
 
 /**
- * @brief Increment the value stored in Register B.
+ * @brief Increment the register encoded in y of the opcode.
  */
-void OPC_INC_B(void);
-
-/**
- * @brief Increment the value stored in Register C.
- */
-void OPC_INC_C(void);
-
-/**
- * @brief Increment the value stored in Register D.
- */
-void OPC_INC_D(void);
-
-/**
- * @brief Increment the value stored in Register E.
- */
-void OPC_INC_E(void);
-
-/**
- * @brief Increment the value stored in Register H.
- */
-void OPC_INC_H(void);
-
-/**
- * @brief Increment the value stored in Register L.
- */
-void OPC_INC_L(void);
+void OPC_INC_r(void);
 
 /**
  * @brief Increment the value stored at address `HL`.
@@ -657,44 +404,9 @@ void OPC_INC_L(void);
 void OPC_INC_HL(void);
 
 /**
- * @brief Increment the value stored in Register A.
- */
-void OPC_INC_A(void);
-
-/**
- * @brief Decrement the value stored in Register A.
- */
-void OPC_DEC_A(void);
-
-/**
- * @brief Decrement the value stored in Register B.
+ * @brief Decrement the register encoded in y of the opcode.
  */
-void OPC_DEC_B(void);
-
-/**
- * @brief Decrement the value stored in Register C.
- */
-void OPC_DEC_C(void);
-
-/**
- * @brief Decrement the value stored in Register D.
- */
-void OPC_DEC_D(void);
-
-/**
- * @brief Decrement the value stored in Register E.
- */
-void OPC_DEC_E(void);
-
-/**
- * @brief Decrement the value stored in Register H.
- */
-void OPC_DEC_H(void);
-
-/**
- * @brief Decrement the value stored in Register L.
- */
-void OPC_DEC_L(void);
+void OPC_DEC_r(void);
 
 /**
  * @brief Decrement the value stored at address `HL`.
@@ -705,6 +417,19 @@ void OPC_DEC_L(void);
  */
 void OPC_DEC_HL(void);
 
+/******************************************************
+ *** CB prefixed                                    ***
+ ******************************************************/
+
+/**
+ * @brief Executes the CB prefixed instruction in the operand byte: xx yyy zzz where
+ *        x selects rotate/shift (y: RLC, RRC, RL, RR, SLA, SRA, SWAP, SRL), BIT, RES or SET (y: bit index)
+ *        and z the register, 6 being the byte at address `HL`.
+ *
+ * @note Takes 8 cycles, 16 if it operates on `HL` and 12 for BIT on `HL`.
+ */
+void OPC_PREFIX_CB(void);
+
 /**
  * @brief Push PC onto the stack and load 0x0030 into PC.
  *
@@ -774,5 +499,35 @@ void OPC_CALL_NZ_u16(void);
 void OPC_CALL_C_u16(void);
 void OPC_CALL_NC_u16(void);
 
+/******************************************************
+ *** Interrupts                                     ***
+ ******************************************************/
+
+/**
+ * @brief Disable interrupts, also cancels a preceding EI.
+ */
 void OPC_DI(void);
+
+/**
+ * @brief Enable interrupts after the next instruction.
+ */
+void OPC_EI(void);
+
+/**
+ * @brief Pop the return address off the stack and jump to it.
+ */
+void OPC_RET(void);
+
+/**
+ * @brief Stop executing instructions until an enabled interrupt is requested, see ::cpu_run().
+ *
+ * @note If IME is cleared and an interrupt is already pending, HALT does nothing. The HALT bug
+ *       (the next opcode byte being read twice) is not emulated.
+ */
+void OPC_HALT(void);
+
+/**
+ * @brief Like OPC_RET, but also enables interrupts immediately.
+ */
+void OPC_RETI(void);
 #endif // YOBEMAG_CPU_H
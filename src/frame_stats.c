@@ -0,0 +1,214 @@
+#define LOG_CATEGORY LOG_CAT_CPU
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <time.h>
+
+#include "frame_stats.h"
+#include "log.h"
+
+/******************************************************
+ *** LOCAL VARIABLES                                ***
+ ******************************************************/
+
+#define NS_PER_SECOND (1000000000u)
+
+// log2 of HISTOGRAM_SUB_BUCKETS
+#define SUB_BUCKET_BITS (4)
+
+static const char *const phase_names[FRAME_PHASE_COUNT] = {
+    [FRAME_PHASE_EMULATE] = "emulate",
+    [FRAME_PHASE_PRESENT] = "present",
+    [FRAME_PHASE_INPUT]   = "input",
+    [FRAME_PHASE_SLEEP]   = "sleep",
+    [FRAME_PHASE_TOTAL]   = "total",
+};
+
+static const double reported_percentiles[] = {50, 90, 99, 99.9};
+
+static Histogram histograms[FRAME_PHASE_COUNT];
+// Host work within cpu_run() of the current frame
+static uint64_t current[FRAME_PHASE_COUNT];
+
+static const char *output_path;
+static const char *rom;
+
+/******************************************************
+ *** LOCAL METHODS                                  ***
+ ******************************************************/
+
+__attribute__((const)) static unsigned bucket_index(uint64_t value) {
+    if (value < HISTOGRAM_SUB_BUCKETS) {
+        return (unsigned) value;
+    }
+
+    unsigned exponent = 63u - (unsigned) __builtin_clzll(value);
+    if (exponent >= HISTOGRAM_MAX_EXPONENT) {
+        return HISTOGRAM_BUCKETS - 1;
+    }
+    unsigned sub_bucket = (unsigned) (value >> (exponent - SUB_BUCKET_BITS)) & (HISTOGRAM_SUB_BUCKETS - 1);
+    return (exponent - SUB_BUCKET_BITS + 1) * HISTOGRAM_SUB_BUCKETS + sub_bucket;
+}
+
+__attribute__((const)) static uint64_t bucket_lowest(unsigned index) {
+    if (index < HISTOGRAM_SUB_BUCKETS) {
+        return index;
+    }
+
+    unsigned exponent   = index / HISTOGRAM_SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+    uint64_t sub_bucket = index % HISTOGRAM_SUB_BUCKETS;
+    return (HISTOGRAM_SUB_BUCKETS + sub_bucket) << (exponent - SUB_BUCKET_BITS);
+}
+
+__attribute__((const)) static uint64_t bucket_highest(unsigned index) {
+    return index + 1 < HISTOGRAM_BUCKETS ? bucket_lowest(index + 1) - 1 : UINT64_MAX;
+}
+
+// JSON strings must not contain raw quotes, backslashes or control characters, ROM paths could
+static void write_json_string(FILE *stream, const char *string) {
+    fputc('"', stream);
+    for (const char *c = string; *c != '\0'; ++c) {
+        if (*c == '"' || *c == '\\') {
+            fprintf(stream, "\\%c", *c);
+        } else if ((unsigned char) *c < 0x20) {
+            fprintf(stream, "\\u%04x", (unsigned) *c);
+        } else {
+            fputc(*c, stream);
+        }
+    }
+    fputc('"', stream);
+}
+
+static void write_histogram(FILE *stream, const Histogram *histogram) {
+    fprintf(stream, "{\"count\": %" PRIu64 ", \"min\": %" PRIu64 ", \"mean\": %" PRIu64 ", \"max\": %" PRIu64,
+            histogram->count, histogram->count ? histogram->min : 0,
+            histogram->count ? histogram->sum / histogram->count : 0, histogram->max);
+    for (size_t i = 0; i < sizeof(reported_percentiles) / sizeof(reported_percentiles[0]); ++i) {
+        fprintf(stream, ", \"p%g\": %" PRIu64, reported_percentiles[i],
+                histogram_percentile(histogram, reported_percentiles[i]));
+    }
+
+    // only the buckets that were hit, as [lowest value, count]
+    fputs(", \"buckets\": [", stream);
+    bool first = true;
+    for (unsigned index = 0; index < HISTOGRAM_BUCKETS; ++index) {
+        if (histogram->buckets[index] != 0) {
+            fprintf(stream, "%s[%" PRIu64 ", %" PRIu64 "]", first ? "" : ", ", bucket_lowest(index),
+                    histogram->buckets[index]);
+            first = false;
+        }
+    }
+    fputs("]}", stream);
+}
+
+/******************************************************
+ *** EXPOSED METHODS                                ***
+ ******************************************************/
+
+void histogram_record(Histogram *histogram, uint64_t value) {
+    if (histogram->count == 0 || value < histogram->min) {
+        histogram->min = value;
+    }
+    if (value > histogram->max) {
+        histogram->max = value;
+    }
+    ++histogram->buckets[bucket_index(value)];
+    ++histogram->count;
+    histogram->sum += value;
+}
+
+uint64_t histogram_percentile(const Histogram *histogram, double percentile) {
+    if (histogram->count == 0) {
+        return 0;
+    }
+
+    // nearest rank: the smallest value which at least `percentile` percent of the values are at or below
+    double exact  = (double) histogram->count * percentile / 100.0;
+    uint64_t rank = (uint64_t) exact;
+    if ((double) rank < exact || rank == 0) {
+        ++rank;
+    }
+
+    uint64_t seen = 0;
+    for (unsigned index = 0; index < HISTOGRAM_BUCKETS; ++index) {
+        seen += histogram->buckets[index];
+        if (seen >= rank) {
+            uint64_t highest = bucket_highest(index);
+            return highest < histogram->max ? highest : histogram->max;
+        }
+    }
+    return histogram->max;
+}
+
+uint64_t frame_stats_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * NS_PER_SECOND + (uint64_t) now.tv_nsec;
+}
+
+void frame_stats_init(const char *path, const char *rom_path) {
+    memset(histograms, 0, sizeof(histograms));
+    memset(current, 0, sizeof(current));
+    output_path = path;
+    rom         = rom_path;
+}
+
+void frame_stats_teardown(void) {
+    frame_stats_dump();
+    output_path = NULL;
+}
+
+void frame_stats_dump(void) {
+    if (output_path == NULL) {
+        return;
+    }
+
+    // readers never see a partially written file
+    char temporary[4096];
+    snprintf(temporary, sizeof(temporary), "%s.tmp", output_path);
+    FILE *stream = fopen(temporary, "w");
+    if (stream == NULL) {
+        LOG_ERROR("Could not open frame statistics output %s: %s", temporary, strerror(errno));
+        return;
+    }
+
+    frame_stats_write_json(stream);
+    if (fclose(stream) != 0 || rename(temporary, output_path) != 0) {
+        LOG_ERROR("Could not write frame statistics to %s: %s", output_path, strerror(errno));
+    }
+}
+
+void frame_stats_add(FramePhase phase, uint64_t ns) {
+    current[phase] += ns;
+}
+
+void frame_stats_end_frame(uint64_t run_ns, uint64_t sleep_ns) {
+    uint64_t host_work = current[FRAME_PHASE_PRESENT] + current[FRAME_PHASE_INPUT];
+
+    current[FRAME_PHASE_EMULATE] = run_ns > host_work ? run_ns - host_work : 0;
+    current[FRAME_PHASE_SLEEP]   = sleep_ns;
+    current[FRAME_PHASE_TOTAL]   = run_ns + sleep_ns;
+
+    for (unsigned phase = 0; phase < FRAME_PHASE_COUNT; ++phase) {
+        histogram_record(&histograms[phase], current[phase]);
+        current[phase] = 0;
+    }
+}
+
+const Histogram *frame_stats_histogram(FramePhase phase) {
+    return &histograms[phase];
+}
+
+void frame_stats_write_json(FILE *stream) {
+    fputs("{\"rom\": ", stream);
+    write_json_string(stream, rom != NULL ? rom : "");
+    fprintf(stream, ", \"unit\": \"ns\", \"frames\": %" PRIu64 ", \"phases\": {",
+            histograms[FRAME_PHASE_TOTAL].count);
+    for (unsigned phase = 0; phase < FRAME_PHASE_COUNT; ++phase) {
+        fprintf(stream, "%s\n  \"%s\": ", phase ? "," : "", phase_names[phase]);
+        write_histogram(stream, &histograms[phase]);
+    }
+    fputs("\n}}\n", stream);
+}
@@ -0,0 +1,115 @@
+#ifndef YOBEMAG_FRAME_STATS_H
+#define YOBEMAG_FRAME_STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/**
+ * @brief Linear sub-buckets per power of two, values are recorded with a relative error below 1/16
+ */
+#define HISTOGRAM_SUB_BUCKETS (16)
+
+/**
+ * @brief Values of 2^40 ns (18 minutes) and more share the last bucket
+ */
+#define HISTOGRAM_MAX_EXPONENT (40)
+#define HISTOGRAM_BUCKETS      ((HISTOGRAM_MAX_EXPONENT - 3) * HISTOGRAM_SUB_BUCKETS)
+
+/**
+ * @brief Log-linear histogram in the style of HdrHistogram: each power of two is split into
+ *        ::HISTOGRAM_SUB_BUCKETS equally wide buckets, values below ::HISTOGRAM_SUB_BUCKETS are exact
+ */
+typedef struct Histogram {
+    uint64_t buckets[HISTOGRAM_BUCKETS];
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+} Histogram;
+
+/**
+ * @brief Where the host spends the wall-clock time of an emulated frame
+ */
+typedef enum FramePhase {
+    /**
+     * @brief cpu_run() without the host work of its event handlers
+     */
+    FRAME_PHASE_EMULATE,
+    /**
+     * @brief SDL_UpdateWindowSurface
+     */
+    FRAME_PHASE_PRESENT,
+    /**
+     * @brief SDL_PollEvent and the keyboard state
+     */
+    FRAME_PHASE_INPUT,
+    /**
+     * @brief Waiting for the wall clock to catch up with the emulated one
+     */
+    FRAME_PHASE_SLEEP,
+    /**
+     * @brief The whole frame, i.e. the sum of the other phases
+     */
+    FRAME_PHASE_TOTAL,
+    FRAME_PHASE_COUNT
+} FramePhase;
+
+void histogram_record(Histogram *histogram, uint64_t value);
+
+/**
+ * @brief   The value below or at which @p percentile percent of the recorded values are
+ *
+ * @return  The upper end of the bucket the percentile falls into, but at most the largest recorded value.
+ *          0 if nothing was recorded.
+ */
+__attribute__((pure)) uint64_t histogram_percentile(const Histogram *histogram, double percentile);
+
+/**
+ * @brief Host monotonic clock in ns, the time base of the frame phases and the host timeline
+ */
+uint64_t frame_stats_now(void);
+
+/**
+ * @brief   Start over and write the histograms to @p path on ::frame_stats_teardown() and ::frame_stats_dump()
+ *
+ * @param   rom_path    Identifies the run in the JSON
+ */
+void frame_stats_init(const char *path, const char *rom_path);
+
+/**
+ * @brief Write the histograms if a path was given to ::frame_stats_init()
+ */
+void frame_stats_teardown(void);
+
+/**
+ * @brief   Write the histograms of all frames so far as JSON, replacing the file atomically
+ *
+ * @note    Does nothing if no path was given to ::frame_stats_init()
+ */
+void frame_stats_dump(void);
+
+/**
+ * @brief Attribute @p ns of the current frame to @p phase, for host work which happens within cpu_run()
+ */
+void frame_stats_add(FramePhase phase, uint64_t ns);
+
+/**
+ * @brief   Record the current frame and start the next one
+ *
+ * @param   run_ns      Time spent in cpu_run(), including the phases added with ::frame_stats_add()
+ * @param   sleep_ns    Time spent waiting afterwards
+ */
+void frame_stats_end_frame(uint64_t run_ns, uint64_t sleep_ns);
+
+/**
+ * @brief Histogram of @p phase over all recorded frames
+ */
+__attribute__((const)) const Histogram *frame_stats_histogram(FramePhase phase);
+
+/**
+ * @brief Write the histograms of all phases as JSON to @p stream
+ */
+void frame_stats_write_json(FILE *stream);
+
+#endif // YOBEMAG_FRAME_STATS_H
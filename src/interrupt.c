@@ -0,0 +1,122 @@
+#define LOG_CATEGORY LOG_CAT_CPU
+
+#include "interrupt.h"
+#include "cpu.h"
+#include "mmu.h"
+#include "log.h"
+#include "pc_profiler.h"
+#include "timeline.h"
+
+/******************************************************
+ *** LOCAL VARIABLES                                ***
+ ******************************************************/
+
+// Unused bits of IF always read as 1
+#define IF_UNUSED (0xE0)
+
+Interrupts interrupts;
+
+static const char *const interrupt_names[] = {"VBlank", "STAT", "timer", "serial", "joypad"};
+
+/******************************************************
+ *** LOCAL METHODS                                  ***
+ ******************************************************/
+
+// IE and IF are mirrored into memory so that reads of them do not need a special case in the MMU
+static void sync_registers(void) {
+    mmu_set_io_register(IO_IF, interrupts.flags | IF_UNUSED);
+    mmu_set_io_register(IO_IE, interrupts.enable);
+}
+
+// Makes the run loop look at the interrupts, but only if one of them can actually be dispatched
+static void check_pending(void) {
+    if ((interrupts.ime || interrupts.ime_delayed) && (interrupts.enable & interrupts.flags & IF_MASK)) {
+        interrupts.dirty = true;
+        cpu_yield();
+    }
+}
+
+/******************************************************
+ *** EXPOSED METHODS                                ***
+ ******************************************************/
+
+void interrupt_init(void) {
+    interrupts = (Interrupts){0};
+    sync_registers();
+
+    mmu_register_io_write(IO_IF, interrupt_write);
+    mmu_register_io_write(IO_IE, interrupt_write);
+}
+
+void interrupt_request(uint8_t flags) {
+    interrupts.flags |= flags;
+    sync_registers();
+    check_pending();
+}
+
+void interrupt_write(uint16_t addr, uint8_t value) {
+    if (addr == IO_IF) {
+        interrupts.flags = value & IF_MASK;
+    } else {
+        interrupts.enable = value;
+    }
+
+    sync_registers();
+    check_pending();
+}
+
+void interrupt_enable(void) {
+    if (interrupts.ime) {
+        return;
+    }
+
+    // the instruction after EI always runs first, hence the run loop has to step it and then set IME
+    interrupts.ime_delayed = true;
+    interrupts.dirty       = true;
+    cpu_yield();
+}
+
+void interrupt_disable(void) {
+    interrupts.ime         = false;
+    interrupts.ime_delayed = false;
+}
+
+void interrupt_enable_now(void) {
+    interrupts.ime         = true;
+    interrupts.ime_delayed = false;
+    check_pending();
+}
+
+void interrupt_dispatch(void) {
+    interrupts.dirty = false;
+
+    if (interrupts.ime_delayed) {
+        // DI or a dispatch in between clear the delay again
+        cpu_step();
+        if (interrupts.ime_delayed) {
+            interrupts.ime         = true;
+            interrupts.ime_delayed = false;
+        }
+    }
+
+    uint8_t pending = interrupts.enable & interrupts.flags & IF_MASK;
+    if (!interrupts.ime || !pending) {
+        return;
+    }
+
+    // the lowest bit has the highest priority
+    unsigned index = (unsigned) __builtin_ctz(pending);
+    LOG_DEBUG("Dispatching interrupt %u at PC 0x%04X", index, cpu.PC);
+
+    interrupts.ime   = false;
+    interrupts.flags = (uint8_t) (interrupts.flags & ~(1u << index));
+    cpu.halted       = false;
+    sync_registers();
+
+    mmu_stack_push(cpu.PC);
+    pc_profiler_call(cpu.PC);
+    timeline_cycles(TIMELINE_INTERRUPT, interrupt_names[index], cpu.cycle_count,
+                    cpu.cycle_count + INTERRUPT_DISPATCH_CYCLES, "pc", cpu.PC);
+    cpu.PC = (uint16_t) (INTERRUPT_VECTOR_BASE + 8 * index);
+    cpu.cycle_count += INTERRUPT_DISPATCH_CYCLES;
+}
@@ -0,0 +1,91 @@
+#ifndef YOBEMAG_INTERRUPT_H
+#define YOBEMAG_INTERRUPT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Interrupt flag register, the hardware sets one of the `IF_*` bits to request an interrupt
+ */
+#define IO_IF (0xFF0F)
+/**
+ * @brief Interrupt enable register, uses the same bits as IF
+ */
+#define IO_IE (0xFFFF)
+
+#define IF_VBLANK (0x01)
+#define IF_STAT   (0x02)
+#define IF_TIMER  (0x04)
+#define IF_SERIAL (0x08)
+#define IF_JOYPAD (0x10)
+#define IF_MASK   (0x1F)
+
+/**
+ * @brief Address of the handler of the lowest interrupt (VBlank), every other one follows 8 bytes later
+ */
+#define INTERRUPT_VECTOR_BASE (0x0040)
+
+/**
+ * @brief Cycles it takes to push the PC and jump to the vector
+ */
+#define INTERRUPT_DISPATCH_CYCLES (20)
+
+typedef struct Interrupts {
+    /**
+     * @brief Interrupt master enable, no interrupt is dispatched while it is cleared
+     */
+    bool ime;
+    /**
+     * @brief EI was executed, IME is set once the instruction following it has been executed
+     */
+    bool ime_delayed;
+    uint8_t enable;
+    uint8_t flags;
+    /**
+     * @brief IME, IE or IF changed such that an interrupt may have to be dispatched, see ::interrupt_dispatch()
+     */
+    bool dirty;
+} Interrupts;
+
+extern Interrupts interrupts;
+
+/**
+ * @brief Disable and clear all interrupts
+ */
+void interrupt_init(void);
+
+/**
+ * @brief Set @p flags in IF, called by the hardware which raises an interrupt
+ */
+void interrupt_request(uint8_t flags);
+
+/**
+ * @brief CPU write of @p value to IF or IE
+ */
+void interrupt_write(uint16_t addr, uint8_t value);
+
+/**
+ * @brief EI: set IME after the next instruction
+ */
+void interrupt_enable(void);
+
+/**
+ * @brief DI: clear IME, also cancels a preceding EI
+ */
+void interrupt_disable(void);
+
+/**
+ * @brief RETI: set IME immediately
+ */
+void interrupt_enable_now(void);
+
+/**
+ * @brief   Apply a delayed EI and dispatch the highest priority interrupt which is enabled and requested, if IME
+ *          allows it. Pushes the PC and jumps to its vector, which takes ::INTERRUPT_DISPATCH_CYCLES.
+ *
+ * @note    Only needs to be called while `interrupts.dirty` is set, the run loop does not look at IME, IE and IF
+ *          otherwise.
+ */
+void interrupt_dispatch(void);
+
+#endif // YOBEMAG_INTERRUPT_H
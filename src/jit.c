@@ -0,0 +1,1078 @@
+#define LOG_CATEGORY LOG_CAT_CPU
+
+#if defined(YOBEMAG_JIT)
+
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "jit.h"
+#include "cpu.h"
+#include "mmu.h"
+#include "log.h"
+#include "interrupt.h"
+
+/******************************************************
+ *** LOCAL VARIABLES                                ***
+ ******************************************************/
+
+#define JIT_BUFFER_SIZE (4 * 1024 * 1024)
+
+// Upper bound of emitted bytes per micro-op (including its slow path) and for prologue plus loop and exit
+#define JIT_MAX_OP_SIZE    (320)
+#define JIT_MAX_BLOCK_SIZE (BLOCK_MAX_OPS * JIT_MAX_OP_SIZE + 256)
+
+#define CPU_OFFSET(member) ((uint8_t) offsetof(CPU, member))
+#define REG_OFFSET(dreg, word)                                                                                         \
+    ((uint8_t) (offsetof(CPU, dreg) + offsetof(DoubleWordReg, words.word)))
+
+/*
+ * Guest registers in the order of the opcode encoding, (HL) has no register. While a block runs, every guest register
+ * lives in a host register, see guest_host.
+ */
+#define GUEST_HL_ADDR  (6)
+#define GUEST_A        (7)
+#define GUEST_F        (8)
+#define GUEST_SP       (9)
+#define GUEST_COUNT    (10)
+#define GUEST_ALL      ((uint16_t) ((1 << GUEST_COUNT) - 1 - (1 << GUEST_HL_ADDR)))
+#define GUEST_BIT(reg) ((uint16_t) (1 << (reg)))
+
+typedef enum HostReg {
+    HOST_RAX = 0,
+    HOST_RCX,
+    HOST_RDX,
+    HOST_RBX,
+    HOST_RSP,
+    HOST_RBP,
+    HOST_RSI,
+    HOST_RDI,
+    HOST_R8,
+    HOST_R9,
+    HOST_R10,
+    HOST_R11,
+    HOST_R12,
+    HOST_R13,
+    HOST_R14,
+    HOST_R15,
+} HostReg;
+
+/*
+ * While a block runs, rbx holds &cpu, r12 the read page table, r13 the code pages of the block cache and r14 the
+ * write page table, all of them callee-saved. The guest registers are zero-extended into the remaining registers,
+ * rax and rcx are scratch. Call-outs clobber the caller-saved guest registers, hence they are spilled to `cpu` before
+ * and reloaded after every call. PC is not held at all, it is a constant for each instruction of a block.
+ */
+static const uint8_t guest_host[GUEST_COUNT] = {
+    HOST_R8,  // B
+    HOST_R9,  // C
+    HOST_R10, // D
+    HOST_R11, // E
+    HOST_RSI, // H
+    HOST_RDI, // L
+    0,        // (HL)
+    HOST_RDX, // A
+    HOST_RBP, // F
+    HOST_R15, // SP
+};
+
+static const uint8_t guest_offset[GUEST_COUNT] = {
+    REG_OFFSET(BC, hi), REG_OFFSET(BC, lo), REG_OFFSET(DE, hi), REG_OFFSET(DE, lo), REG_OFFSET(HL, hi),
+    REG_OFFSET(HL, lo), 0,                  REG_OFFSET(AF, hi), REG_OFFSET(AF, lo), CPU_OFFSET(SP),
+};
+
+#define GUEST_B (0)
+#define GUEST_C (1)
+#define GUEST_D (2)
+#define GUEST_E (3)
+#define GUEST_H (4)
+#define GUEST_L (5)
+
+// Stack slots of a running block: instructions executed before the current pass, the budget and the epoch at entry
+#define FRAME_EXECUTED (0)
+#define FRAME_BUDGET   (4)
+#define FRAME_EPOCH    (8)
+#define FRAME_SIZE     (24)
+
+// Instruction encoding flags, see emit_prefixes()
+#define OP_WIDE    (1u << 0)
+#define OP_16      (1u << 1)
+#define OP_BYTE_RG (1u << 2)
+#define OP_BYTE_RM (1u << 3)
+
+// Two-byte opcodes are passed as 0x0Fxx
+#define OPC_ADD    (0x01)
+#define OPC_OR8    (0x08)
+#define OPC_OR     (0x09)
+#define OPC_ADC    (0x11)
+#define OPC_AND8   (0x20)
+#define OPC_SUB    (0x29)
+#define OPC_XOR8   (0x30)
+#define OPC_XOR    (0x31)
+#define OPC_CMP    (0x3B)
+#define OPC_TEST8  (0x84)
+#define OPC_MOV8   (0x88)
+#define OPC_MOV    (0x89)
+#define OPC_LOAD   (0x8B)
+#define OPC_MOVZX8 (0x0FB6)
+#define OPC_MOVZX  (0x0FB7)
+
+// Condition codes of jcc and setcc
+#define CC_AE (0x3)
+#define CC_E  (0x4)
+#define CC_NE (0x5)
+
+// Memory operands of the native loads and stores
+typedef enum Address {
+    ADDR_BC,
+    ADDR_DE,
+    ADDR_HL,
+    ADDR_IMMEDIATE,
+    ADDR_HIGH, // IO_START + the immediate operand, of LDH
+} Address;
+
+/**
+ * An out-of-line path which executes a memory instruction through its handler, taken if the access does not hit
+ * plain memory. It continues after the native code of the instruction.
+ */
+typedef struct SlowPath {
+    uint8_t *jumps[2];
+    const uint8_t *resume;
+    const MicroOp *op;
+    uint16_t pc;
+    uint16_t cycles;
+    uint16_t dirty;
+    uint8_t executed;
+} SlowPath;
+
+typedef struct Emitter {
+    uint8_t *pos;
+    /**
+     * @brief Guest registers written by native code since they were last spilled
+     */
+    uint16_t dirty;
+    /**
+     * @brief Cycles of native instructions which are not yet added to the clock
+     */
+    uint16_t cycles;
+    SlowPath slow_paths[BLOCK_MAX_OPS];
+    uint8_t slow_path_count;
+} Emitter;
+
+#if defined(YOBEMAG_MEM_HEATMAP)
+    // every access has to be counted by the MMU
+    #define JIT_NATIVE_MEMORY (false)
+#else
+    #define JIT_NATIVE_MEMORY (true)
+#endif
+
+bool jit_enabled;
+
+static uint8_t *code_buffer;
+static size_t code_used;
+
+/******************************************************
+ *** LOCAL METHODS                                  ***
+ ******************************************************/
+
+static void emit_u8(Emitter *e, uint8_t value) {
+    *e->pos++ = value;
+}
+
+static void emit_u16(Emitter *e, uint16_t value) {
+    memcpy(e->pos, &value, sizeof(value));
+    e->pos += sizeof(value);
+}
+
+static void emit_u32(Emitter *e, uint32_t value) {
+    memcpy(e->pos, &value, sizeof(value));
+    e->pos += sizeof(value);
+}
+
+static void emit_u64(Emitter *e, uint64_t value) {
+    memcpy(e->pos, &value, sizeof(value));
+    e->pos += sizeof(value);
+}
+
+/*
+ * x86-64 encoding: operand size prefix, REX (needed for r8-r15, 64-bit operands and the byte registers spl, bpl, sil
+ * and dil) and the opcode
+ */
+static void emit_prefixes(Emitter *e, unsigned flags, uint16_t opcode, uint8_t reg, uint8_t index, uint8_t base) {
+    if (flags & OP_16) {
+        emit_u8(e, 0x66);
+    }
+
+    uint8_t wide   = (flags & OP_WIDE) ? 0x08 : 0;
+    uint8_t rex    = (uint8_t) (0x40 | wide | (reg & 8) >> 1 | (index & 8) >> 2 | (base & 8) >> 3);
+    bool byte_regs = ((flags & OP_BYTE_RG) && reg >= HOST_RSP && reg <= HOST_RDI) ||
+                     ((flags & OP_BYTE_RM) && base >= HOST_RSP && base <= HOST_RDI);
+    if (rex != 0x40 || byte_regs) {
+        emit_u8(e, rex);
+    }
+
+    if (opcode > 0xFF) {
+        emit_u8(e, (uint8_t) (opcode >> 8));
+    }
+    emit_u8(e, (uint8_t) opcode);
+}
+
+// op reg, rm with two register operands
+static void emit_rr(Emitter *e, unsigned flags, uint16_t opcode, uint8_t reg, uint8_t rm) {
+    emit_prefixes(e, flags, opcode, reg, 0, rm);
+    emit_u8(e, (uint8_t) (0xC0 | (reg & 7) << 3 | (rm & 7)));
+}
+
+// op reg, [rbx + disp]: the guest state in `cpu`
+static void emit_cpu(Emitter *e, unsigned flags, uint16_t opcode, uint8_t reg, uint8_t disp) {
+    emit_prefixes(e, flags, opcode, reg, 0, HOST_RBX);
+    emit_u8(e, (uint8_t) (0x40 | (reg & 7) << 3 | HOST_RBX));
+    emit_u8(e, disp);
+}
+
+// op reg, [rsp + disp]: the stack frame
+static void emit_frame(Emitter *e, unsigned flags, uint16_t opcode, uint8_t reg, uint8_t disp) {
+    emit_prefixes(e, flags, opcode, reg, 0, HOST_RSP);
+    emit_u8(e, (uint8_t) (0x44 | (reg & 7) << 3));
+    emit_u8(e, 0x24);
+    emit_u8(e, disp);
+}
+
+// op reg, [base + index * 2^scale]
+static void emit_sib(Emitter *e, unsigned flags, uint16_t opcode, uint8_t reg, uint8_t base, uint8_t index,
+                     uint8_t scale) {
+    emit_prefixes(e, flags, opcode, reg, index, base);
+    // always with an 8-bit displacement of 0, base rbp and r13 cannot be encoded without one
+    emit_u8(e, (uint8_t) (0x44 | (reg & 7) << 3));
+    emit_u8(e, (uint8_t) (scale << 6 | (index & 7) << 3 | (base & 7)));
+    emit_u8(e, 0);
+}
+
+static void emit_mov(Emitter *e, uint8_t dest, uint8_t src) {
+    emit_rr(e, 0, OPC_MOV, src, dest);
+}
+
+static void emit_mov_imm(Emitter *e, uint8_t dest, uint32_t value) {
+    if (dest & 8) {
+        emit_u8(e, 0x41);
+    }
+    emit_u8(e, (uint8_t) (0xB8 | (dest & 7)));
+    emit_u32(e, value);
+}
+
+static void emit_movabs(Emitter *e, uint8_t dest, const void *value) {
+    emit_u8(e, (uint8_t) (0x48 | (dest & 8) >> 3));
+    emit_u8(e, (uint8_t) (0xB8 | (dest & 7)));
+    emit_u64(e, (uint64_t) value);
+}
+
+// ALU operation (given by the /digit of opcode 0x81) of a 32-bit register and an immediate
+static void emit_alu_imm(Emitter *e, uint8_t digit, uint8_t dest, uint32_t value) {
+    if (value <= 0x7F) {
+        emit_rr(e, 0, 0x83, digit, dest);
+        emit_u8(e, (uint8_t) value);
+    } else {
+        emit_rr(e, 0, 0x81, digit, dest);
+        emit_u32(e, value);
+    }
+}
+
+#define ALU_ADD (0)
+#define ALU_OR  (1)
+#define ALU_ADC (2)
+#define ALU_AND (4)
+#define ALU_SUB (5)
+
+#define SHIFT_LEFT  (4)
+#define SHIFT_RIGHT (5)
+
+static void emit_shift(Emitter *e, uint8_t digit, uint8_t dest, uint8_t count) {
+    emit_rr(e, 0, 0xC1, digit, dest);
+    emit_u8(e, count);
+}
+
+static void emit_movzx8(Emitter *e, uint8_t dest, uint8_t src) {
+    emit_rr(e, OP_BYTE_RM, OPC_MOVZX8, dest, src);
+}
+
+static void emit_setcc(Emitter *e, uint8_t cc, uint8_t dest) {
+    emit_rr(e, OP_BYTE_RM, (uint16_t) (0x0F90 | cc), 0, dest);
+}
+
+// CF = bit @p bit of @p reg
+static void emit_bt(Emitter *e, uint8_t reg, uint8_t bit) {
+    emit_rr(e, 0, 0x0FBA, 4, reg);
+    emit_u8(e, bit);
+}
+
+static void emit_call(Emitter *e, op_function function) {
+    emit_u8(e, 0x48); // movabs rax, function
+    emit_u8(e, 0xB8);
+    emit_u64(e, (uint64_t) function);
+    emit_u8(e, 0xFF); // call rax
+    emit_u8(e, 0xD0);
+}
+
+// Returns the location of the 32-bit displacement, see patch_jump()
+static uint8_t *emit_jcc(Emitter *e, uint8_t cc) {
+    emit_u8(e, 0x0F);
+    emit_u8(e, (uint8_t) (0x80 | cc));
+    emit_u32(e, 0);
+
+    return e->pos - sizeof(uint32_t);
+}
+
+static uint8_t *emit_jmp(Emitter *e) {
+    emit_u8(e, 0xE9);
+    emit_u32(e, 0);
+
+    return e->pos - sizeof(uint32_t);
+}
+
+static void patch_jump(uint8_t *displacement, const uint8_t *target) {
+    uint32_t offset = (uint32_t) (target - (displacement + sizeof(uint32_t)));
+    memcpy(displacement, &offset, sizeof(offset));
+}
+
+static void emit_load_guest(Emitter *e, uint8_t guest) {
+    emit_cpu(e, 0, guest == GUEST_SP ? OPC_MOVZX : OPC_MOVZX8, guest_host[guest], guest_offset[guest]);
+}
+
+static void emit_store_guest(Emitter *e, uint8_t guest) {
+    if (guest == GUEST_SP) {
+        emit_cpu(e, OP_16, OPC_MOV, guest_host[guest], guest_offset[guest]);
+    } else {
+        emit_cpu(e, OP_BYTE_RG, OPC_MOV8, guest_host[guest], guest_offset[guest]);
+    }
+}
+
+static void emit_reload(Emitter *e) {
+    for (uint8_t guest = 0; guest < GUEST_COUNT; ++guest) {
+        if (GUEST_ALL & GUEST_BIT(guest)) {
+            emit_load_guest(e, guest);
+        }
+    }
+}
+
+static void emit_spill(Emitter *e, uint16_t dirty) {
+    for (uint8_t guest = 0; guest < GUEST_COUNT; ++guest) {
+        if (dirty & GUEST_BIT(guest)) {
+            emit_store_guest(e, guest);
+        }
+    }
+}
+
+static void emit_store_imm_u8(Emitter *e, uint8_t offset, uint8_t value) {
+    emit_cpu(e, 0, 0xC6, 0, offset); // mov byte [rbx + offset], value
+    emit_u8(e, value);
+}
+
+static void emit_store_imm_u16(Emitter *e, uint8_t offset, uint16_t value) {
+    emit_cpu(e, OP_16, 0xC7, 0, offset); // mov word [rbx + offset], value
+    emit_u16(e, value);
+}
+
+// add or sub qword [rbx + cycle_count], cycles
+static void emit_clock(Emitter *e, uint8_t digit, uint16_t cycles) {
+    emit_cpu(e, OP_WIDE, 0x81, digit, CPU_OFFSET(cycle_count));
+    emit_u32(e, cycles);
+}
+
+static void emit_flush_cycles(Emitter *e) {
+    if (e->cycles != 0) {
+        emit_clock(e, ALU_ADD, e->cycles);
+        e->cycles = 0;
+    }
+}
+
+static void emit_load_epoch(Emitter *e) {
+    emit_movabs(e, HOST_RAX, &block_cache_epoch);
+    emit_u8(e, 0x8B); // mov eax, [rax]
+    emit_u8(e, 0x00);
+}
+
+// ZF is cleared if a handler wrote into a code page or yielded, the remainder of the block might be stale
+static void emit_epoch_compare(Emitter *e) {
+    emit_load_epoch(e);
+    emit_frame(e, 0, OPC_CMP, HOST_RAX, FRAME_EPOCH);
+}
+
+static void emit_prologue(Emitter *e) {
+    emit_u8(e, 0x53); // push rbx
+    emit_u8(e, 0x55); // push rbp
+    emit_u8(e, 0x41); // push r12
+    emit_u8(e, 0x54);
+    emit_u8(e, 0x41); // push r13
+    emit_u8(e, 0x55);
+    emit_u8(e, 0x41); // push r14
+    emit_u8(e, 0x56);
+    emit_u8(e, 0x41); // push r15
+    emit_u8(e, 0x57);
+    emit_u8(e, 0x48); // sub rsp, FRAME_SIZE, the stack is 16-byte aligned for calls afterwards
+    emit_u8(e, 0x83);
+    emit_u8(e, 0xEC);
+    emit_u8(e, FRAME_SIZE);
+
+    emit_movabs(e, HOST_RBX, &cpu);
+    emit_movabs(e, HOST_R12, mmu_read_page_table());
+    emit_movabs(e, HOST_R13, block_cache_code_pages);
+    emit_movabs(e, HOST_R14, mmu_write_page_table());
+
+    emit_frame(e, 0, OPC_MOV, HOST_RDI, FRAME_BUDGET);
+    emit_frame(e, 0, 0xC7, 0, FRAME_EXECUTED); // mov dword [rsp + FRAME_EXECUTED], 0
+    emit_u32(e, 0);
+    emit_load_epoch(e);
+    emit_frame(e, 0, OPC_MOV, HOST_RAX, FRAME_EPOCH);
+
+    emit_reload(e);
+}
+
+// Returns the instructions executed before this pass plus @p executed, the guest registers must have been spilled
+static void emit_exit(Emitter *e, uint32_t executed) {
+    emit_frame(e, 0, OPC_LOAD, HOST_RAX, FRAME_EXECUTED);
+    if (executed != 0) {
+        emit_alu_imm(e, ALU_ADD, HOST_RAX, executed);
+    }
+    emit_u8(e, 0x48); // add rsp, FRAME_SIZE
+    emit_u8(e, 0x83);
+    emit_u8(e, 0xC4);
+    emit_u8(e, FRAME_SIZE);
+    emit_u8(e, 0x41); // pop r15
+    emit_u8(e, 0x5F);
+    emit_u8(e, 0x41); // pop r14
+    emit_u8(e, 0x5E);
+    emit_u8(e, 0x41); // pop r13
+    emit_u8(e, 0x5D);
+    emit_u8(e, 0x41); // pop r12
+    emit_u8(e, 0x5C);
+    emit_u8(e, 0x5D); // pop rbp
+    emit_u8(e, 0x5B); // pop rbx
+    emit_u8(e, 0xC3); // ret
+}
+
+/**
+ * Calls the handler of @p op with the same state as the interpreter provides, PC and clock already include the
+ * instruction. Leaves the block afterwards if the handler changed the epoch, unless @p check_epoch is false.
+ */
+static void emit_handler_call(Emitter *e, const MicroOp *op, uint16_t pc, uint8_t executed, bool check_epoch) {
+    emit_store_imm_u16(e, CPU_OFFSET(PC), pc);
+    emit_store_imm_u8(e, CPU_OFFSET(opcode), op->opcode);
+    if (op->length > 1) {
+        emit_store_imm_u16(e, CPU_OFFSET(operand), op->operand);
+    }
+    emit_call(e, op->execute);
+
+#if defined(YOBEMAG_LAZY_FLAGS)
+    // native code reads and writes F itself, hence the flags of the handler are computed right away
+    emit_cpu(e, 0, 0x80, 7, (uint8_t) (offsetof(CPU, flags) + offsetof(LazyFlags, op))); // cmp byte [..], 0
+    emit_u8(e, FLAG_OP_NONE);
+    uint8_t *synced = emit_jcc(e, CC_E);
+    emit_call(e, cpu_materialize_flags);
+    patch_jump(synced, e->pos);
+#endif
+
+    if (check_epoch) {
+        emit_epoch_compare(e);
+        uint8_t *unchanged = emit_jcc(e, CC_E);
+        emit_exit(e, executed);
+        patch_jump(unchanged, e->pos);
+    }
+}
+
+// eax = the address of a memory operand
+static void emit_address(Emitter *e, Address address, uint16_t immediate) {
+    static const uint8_t pairs[3][2] = {
+        [ADDR_BC] = {GUEST_B, GUEST_C},
+        [ADDR_DE] = {GUEST_D, GUEST_E},
+        [ADDR_HL] = {GUEST_H, GUEST_L},
+    };
+
+    if (address == ADDR_IMMEDIATE) {
+        emit_mov_imm(e, HOST_RAX, immediate);
+        return;
+    }
+    if (address == ADDR_HIGH) {
+        emit_mov_imm(e, HOST_RAX, IO_START + (uint8_t) immediate);
+        return;
+    }
+
+    emit_mov(e, HOST_RAX, guest_host[pairs[address][0]]);
+    emit_shift(e, SHIFT_LEFT, HOST_RAX, 8);
+    emit_rr(e, 0, OPC_OR, guest_host[pairs[address][1]], HOST_RAX);
+}
+
+// Adds @p delta to the register pair @p hi, @p lo
+static void emit_pair_add(Emitter *e, uint8_t hi, uint8_t lo, uint32_t delta) {
+    emit_mov(e, HOST_RAX, guest_host[hi]);
+    emit_shift(e, SHIFT_LEFT, HOST_RAX, 8);
+    emit_rr(e, 0, OPC_OR, guest_host[lo], HOST_RAX);
+    emit_alu_imm(e, ALU_ADD, HOST_RAX, delta);
+    emit_rr(e, 0, OPC_MOVZX, HOST_RAX, HOST_RAX);
+    emit_movzx8(e, guest_host[lo], HOST_RAX);
+    emit_mov(e, guest_host[hi], HOST_RAX);
+    emit_shift(e, SHIFT_RIGHT, guest_host[hi], 8);
+    e->dirty |= GUEST_BIT(hi) | GUEST_BIT(lo);
+}
+
+static SlowPath *add_slow_path(Emitter *e, const MicroOp *op, uint16_t pc, uint8_t executed) {
+    SlowPath *slow = &e->slow_paths[e->slow_path_count++];
+    *slow          = (SlowPath){.op = op, .pc = pc, .cycles = e->cycles, .dirty = e->dirty, .executed = executed};
+
+    return slow;
+}
+
+/*
+ * The fast paths of mmu_get_byte() and mmu_write_byte(): with the address in eax, rcx + rax afterwards points to the
+ * byte in plain memory. Other accesses take the slow path. Writes additionally take it for pages holding cached code,
+ * the handler then invalidates the blocks.
+ */
+static void emit_read_page(Emitter *e, SlowPath *slow) {
+    emit_u8(e, 0x0F); // movzx ecx, ah
+    emit_u8(e, 0xB6);
+    emit_u8(e, 0xCC);
+    emit_sib(e, OP_WIDE, OPC_LOAD, HOST_RCX, HOST_R12, HOST_RCX, 3);
+    emit_rr(e, OP_WIDE, 0x85, HOST_RCX, HOST_RCX); // test rcx, rcx
+    slow->jumps[0] = emit_jcc(e, CC_E);
+    emit_movzx8(e, HOST_RAX, HOST_RAX);
+}
+
+static void emit_write_page(Emitter *e, SlowPath *slow) {
+    emit_u8(e, 0x0F); // movzx ecx, ah
+    emit_u8(e, 0xB6);
+    emit_u8(e, 0xCC);
+    emit_sib(e, 0, 0x80, 7, HOST_R13, HOST_RCX, 0); // cmp byte [r13 + rcx], 0
+    emit_u8(e, 0);
+    slow->jumps[0] = emit_jcc(e, CC_NE);
+    emit_sib(e, OP_WIDE, OPC_LOAD, HOST_RCX, HOST_R14, HOST_RCX, 3);
+    emit_rr(e, OP_WIDE, 0x85, HOST_RCX, HOST_RCX); // test rcx, rcx
+    slow->jumps[1] = emit_jcc(e, CC_E);
+    emit_movzx8(e, HOST_RAX, HOST_RAX);
+}
+
+// HRAM shares its page with the I/O registers, which is no plain memory. A constant address in HRAM is.
+static bool is_hram(Address address, uint16_t immediate) {
+    uint16_t addr = address == ADDR_HIGH ? (uint16_t) (IO_START + (uint8_t) immediate) : immediate;
+
+    return address >= ADDR_IMMEDIATE && addr >= HRAM_START && addr != IO_IE;
+}
+
+/*
+ * Like emit_read_page() and emit_write_page() for a constant address in HRAM, which has no entry in the page tables.
+ * Writes take the slow path while HRAM holds cached code.
+ */
+static void emit_hram_page(Emitter *e, SlowPath *slow) {
+    if (slow != NULL) {
+        emit_mov_imm(e, HOST_RCX, HRAM_START >> 8);
+        emit_sib(e, 0, 0x80, 7, HOST_R13, HOST_RCX, 0); // cmp byte [r13 + rcx], 0
+        emit_u8(e, 0);
+        slow->jumps[0] = emit_jcc(e, CC_NE);
+    }
+    emit_movabs(e, HOST_RCX, mmu_hram_page());
+    emit_movzx8(e, HOST_RAX, HOST_RAX);
+}
+
+// dest = byte [rcx + rax]
+static void emit_load_byte(Emitter *e, uint8_t dest) {
+    emit_sib(e, 0, OPC_MOVZX8, dest, HOST_RCX, HOST_RAX, 0);
+}
+
+// byte [rcx + rax] = src
+static void emit_store_byte(Emitter *e, uint8_t src) {
+    emit_sib(e, OP_BYTE_RG, OPC_MOV8, src, HOST_RCX, HOST_RAX, 0);
+}
+
+static void emit_load(Emitter *e, const MicroOp *op, uint16_t pc, uint8_t executed, Address address,
+                      uint8_t dest) {
+    emit_address(e, address, op->operand);
+    if (is_hram(address, op->operand)) {
+        emit_hram_page(e, NULL);
+    } else {
+        emit_read_page(e, add_slow_path(e, op, pc, executed));
+    }
+    emit_load_byte(e, guest_host[dest]);
+    e->dirty |= GUEST_BIT(dest);
+}
+
+/*
+ * Flags of the 8-bit ALU, computed exactly like alu_flags() in cpu.c. The operand is in ecx, zero-extended, and the
+ * result of the arithmetic operations is computed in eax, where bit 8 is the carry (or borrow) and bit 4 of
+ * lhs ^ rhs ^ result the half carry.
+ */
+static void emit_alu(Emitter *e, uint8_t operation) {
+    uint8_t a = guest_host[GUEST_A];
+    uint8_t f = guest_host[GUEST_F];
+
+    switch (operation) {
+        case 4: // AND
+        case 5: // XOR
+        case 6: // OR
+            emit_rr(e, OP_BYTE_RG | OP_BYTE_RM, operation == 4 ? OPC_AND8 : operation == 5 ? OPC_XOR8 : OPC_OR8,
+                    HOST_RCX, a);
+            emit_rr(e, 0, OPC_XOR, f, f);
+            emit_rr(e, OP_BYTE_RG | OP_BYTE_RM, OPC_TEST8, a, a);
+            emit_setcc(e, CC_E, f);
+            emit_shift(e, SHIFT_LEFT, f, Z_FLAG);
+            if (operation == 4) {
+                emit_alu_imm(e, ALU_OR, f, 1 << H_FLAG);
+            }
+            e->dirty |= GUEST_BIT(GUEST_A) | GUEST_BIT(GUEST_F);
+            return;
+        default:
+            break;
+    }
+
+    emit_mov(e, HOST_RAX, a);
+    switch (operation) {
+        case 0: // ADD
+            emit_rr(e, 0, OPC_ADD, HOST_RCX, HOST_RAX);
+            break;
+        case 1: // ADC
+            emit_bt(e, f, C_FLAG);
+            emit_rr(e, 0, OPC_ADC, HOST_RCX, HOST_RAX);
+            break;
+        case 3: // SBC, the carry is added to the operand first just like alu_flags() does
+            emit_bt(e, f, C_FLAG);
+            emit_rr(e, 0, 0x83, ALU_ADC, HOST_RCX); // adc ecx, 0
+            emit_u8(e, 0);
+            emit_rr(e, 0, OPC_SUB, HOST_RCX, HOST_RAX);
+            break;
+        default: // SUB, CP
+            emit_rr(e, 0, OPC_SUB, HOST_RCX, HOST_RAX);
+            break;
+    }
+
+    // H
+    emit_rr(e, 0, OPC_XOR, HOST_RAX, HOST_RCX);
+    emit_rr(e, 0, OPC_XOR, a, HOST_RCX);
+    emit_alu_imm(e, ALU_AND, HOST_RCX, 0x10);
+    emit_rr(e, 0, OPC_ADD, HOST_RCX, HOST_RCX);
+    // Z
+    emit_rr(e, 0, OPC_XOR, f, f);
+    emit_rr(e, OP_BYTE_RG | OP_BYTE_RM, OPC_TEST8, HOST_RAX, HOST_RAX);
+    emit_setcc(e, CC_E, f);
+    emit_shift(e, SHIFT_LEFT, f, Z_FLAG);
+    emit_rr(e, 0, OPC_OR, HOST_RCX, f);
+    // C
+    emit_mov(e, HOST_RCX, HOST_RAX);
+    emit_shift(e, SHIFT_RIGHT, HOST_RCX, 8 - C_FLAG);
+    emit_alu_imm(e, ALU_AND, HOST_RCX, 1 << C_FLAG);
+    emit_rr(e, 0, OPC_OR, HOST_RCX, f);
+    // N
+    if (operation >= 2) {
+        emit_alu_imm(e, ALU_OR, f, 1 << N_FLAG);
+    }
+
+    if (operation != 7) {
+        emit_movzx8(e, a, HOST_RAX);
+        e->dirty |= GUEST_BIT(GUEST_A);
+    }
+    e->dirty |= GUEST_BIT(GUEST_F);
+}
+
+// INC keeps C of the previous F, see alu_flags(). The result is in ecx.
+static void emit_inc_flags(Emitter *e) {
+    uint8_t f = guest_host[GUEST_F];
+
+    emit_rr(e, OP_BYTE_RG | OP_BYTE_RM, OPC_TEST8, HOST_RCX, HOST_RCX);
+    emit_setcc(e, CC_E, HOST_RAX);
+    emit_movzx8(e, HOST_RAX, HOST_RAX);
+    emit_shift(e, SHIFT_LEFT, HOST_RAX, Z_FLAG);
+    emit_alu_imm(e, ALU_AND, HOST_RCX, 0x10);
+    emit_rr(e, 0, OPC_ADD, HOST_RCX, HOST_RCX);
+    emit_rr(e, 0, OPC_OR, HOST_RCX, HOST_RAX);
+    emit_alu_imm(e, ALU_AND, f, 1 << C_FLAG);
+    emit_rr(e, 0, OPC_OR, HOST_RAX, f);
+    e->dirty |= GUEST_BIT(GUEST_F);
+}
+
+// DEC keeps C of the previous F, see alu_flags(). The value before decrementing is in ecx.
+static void emit_dec_flags(Emitter *e) {
+    uint8_t f = guest_host[GUEST_F];
+
+    emit_rr(e, OP_BYTE_RM, 0xF6, 0, HOST_RCX); // test cl, 0x0F
+    emit_u8(e, 0x0F);
+    emit_setcc(e, CC_E, HOST_RAX);
+    emit_movzx8(e, HOST_RAX, HOST_RAX);
+    emit_shift(e, SHIFT_LEFT, HOST_RAX, H_FLAG);
+    emit_rr(e, OP_BYTE_RM, 0x80, 7, HOST_RCX); // cmp cl, 1
+    emit_u8(e, 1);
+    emit_setcc(e, CC_E, HOST_RCX);
+    emit_movzx8(e, HOST_RCX, HOST_RCX);
+    emit_shift(e, SHIFT_LEFT, HOST_RCX, Z_FLAG);
+    emit_rr(e, 0, OPC_OR, HOST_RCX, HOST_RAX);
+    emit_alu_imm(e, ALU_OR, HOST_RAX, 1 << N_FLAG);
+    emit_alu_imm(e, ALU_AND, f, 1 << C_FLAG);
+    emit_rr(e, 0, OPC_OR, HOST_RAX, f);
+    e->dirty |= GUEST_BIT(GUEST_F);
+}
+
+// INC (HL) and DEC (HL) modify the byte in place, readable pages which are writable are the same memory
+static void emit_inc_dec_memory(Emitter *e, const MicroOp *op, uint16_t pc, uint8_t executed, bool inc) {
+    SlowPath *slow = add_slow_path(e, op, pc, executed);
+
+    emit_address(e, ADDR_HL, 0);
+    emit_write_page(e, slow);
+    emit_sib(e, 0, 0xFE, inc ? 0 : 1, HOST_RCX, HOST_RAX, 0); // inc/dec byte [rcx + rax]
+    emit_load_byte(e, HOST_RCX);
+    if (inc) {
+        emit_inc_flags(e);
+    } else {
+        emit_rr(e, OP_BYTE_RM, 0xFE, 0, HOST_RCX); // inc cl, the value before decrementing
+        emit_dec_flags(e);
+    }
+}
+
+// Stores @p src, or the immediate operand if it is GUEST_HL_ADDR
+static void emit_store(Emitter *e, const MicroOp *op, uint16_t pc, uint8_t executed, Address address, uint8_t src) {
+    SlowPath *slow = add_slow_path(e, op, pc, executed);
+
+    emit_address(e, address, op->operand);
+    if (is_hram(address, op->operand)) {
+        emit_hram_page(e, slow);
+    } else {
+        emit_write_page(e, slow);
+    }
+    if (src == GUEST_HL_ADDR) {
+        emit_sib(e, 0, 0xC6, 0, HOST_RCX, HOST_RAX, 0); // mov byte [rcx + rax], d8
+        emit_u8(e, (uint8_t) op->operand);
+    } else {
+        emit_store_byte(e, guest_host[src]);
+    }
+}
+
+// Loads and stores of plain memory, they take the slow path for everything else
+static bool emit_native_memory(Emitter *e, const MicroOp *op, uint16_t pc, uint8_t executed) {
+    uint8_t dest = (op->opcode >> 3) & 0x07;
+    uint8_t src  = op->opcode & 0x07;
+
+    // LD r, (HL)
+    if ((op->opcode & 0xC7) == 0x46 && dest != GUEST_HL_ADDR) {
+        emit_load(e, op, pc, executed, ADDR_HL, dest);
+        return true;
+    }
+
+    // LD (HL), r
+    if (op->opcode >= 0x70 && op->opcode <= 0x77 && src != GUEST_HL_ADDR) {
+        emit_store(e, op, pc, executed, ADDR_HL, src);
+        return true;
+    }
+
+    // ADD, ADC, SUB, SBC, AND, XOR, OR, CP (HL)
+    if ((op->opcode & 0xC7) == 0x86) {
+        SlowPath *slow = add_slow_path(e, op, pc, executed);
+        emit_address(e, ADDR_HL, 0);
+        emit_read_page(e, slow);
+        emit_load_byte(e, HOST_RCX);
+        emit_alu(e, dest);
+        return true;
+    }
+
+    switch (op->opcode) {
+        case 0x02: // LD (BC), A
+            emit_store(e, op, pc, executed, ADDR_BC, GUEST_A);
+            return true;
+        case 0x12: // LD (DE), A
+            emit_store(e, op, pc, executed, ADDR_DE, GUEST_A);
+            return true;
+        case 0x22: // LD (HL+), A
+        case 0x32: // LD (HL-), A
+            emit_store(e, op, pc, executed, ADDR_HL, GUEST_A);
+            emit_pair_add(e, GUEST_H, GUEST_L, op->opcode == 0x22 ? 1 : 0xFFFF);
+            return true;
+        case 0x0A: // LD A, (BC)
+            emit_load(e, op, pc, executed, ADDR_BC, GUEST_A);
+            return true;
+        case 0x1A: // LD A, (DE)
+            emit_load(e, op, pc, executed, ADDR_DE, GUEST_A);
+            return true;
+        case 0x2A: // LD A, (HL+)
+        case 0x3A: // LD A, (HL-)
+            emit_load(e, op, pc, executed, ADDR_HL, GUEST_A);
+            emit_pair_add(e, GUEST_H, GUEST_L, op->opcode == 0x2A ? 1 : 0xFFFF);
+            return true;
+        case 0x36: // LD (HL), d8
+            emit_store(e, op, pc, executed, ADDR_HL, GUEST_HL_ADDR);
+            return true;
+        case 0x34: // INC (HL)
+        case 0x35: // DEC (HL)
+            emit_inc_dec_memory(e, op, pc, executed, op->opcode == 0x34);
+            return true;
+        case 0xEA: // LD (a16), A
+        case 0xFA: // LD A, (a16)
+            // the I/O registers never are plain memory
+            if ((op->operand >> 8) == (IO_START >> 8) && !is_hram(ADDR_IMMEDIATE, op->operand)) {
+                return false;
+            }
+            if (op->opcode == 0xEA) {
+                emit_store(e, op, pc, executed, ADDR_IMMEDIATE, GUEST_A);
+            } else {
+                emit_load(e, op, pc, executed, ADDR_IMMEDIATE, GUEST_A);
+            }
+            return true;
+        case 0xE0: // LDH (a8), A
+        case 0xF0: // LDH A, (a8)
+            if (!is_hram(ADDR_HIGH, op->operand)) {
+                return false;
+            }
+            if (op->opcode == 0xE0) {
+                emit_store(e, op, pc, executed, ADDR_HIGH, GUEST_A);
+            } else {
+                emit_load(e, op, pc, executed, ADDR_HIGH, GUEST_A);
+            }
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Translates the loads, the 8-bit ALU and the 16-bit loads and increments which the interpreter implements. Their
+ * cycles are accounted for by the caller from the opcode table, just like for call-outs.
+ */
+static bool emit_native(Emitter *e, const MicroOp *op, uint16_t pc, uint8_t executed) {
+    uint8_t dest = (op->opcode >> 3) & 0x07;
+    uint8_t src  = op->opcode & 0x07;
+
+    // LD r, r'
+    if (op->opcode >= 0x40 && op->opcode <= 0x7F && dest != GUEST_HL_ADDR && src != GUEST_HL_ADDR) {
+        if (dest != src) {
+            emit_mov(e, guest_host[dest], guest_host[src]);
+            e->dirty |= GUEST_BIT(dest);
+        }
+        return true;
+    }
+
+    // LD r, d8
+    if ((op->opcode & 0xC7) == 0x06 && dest != GUEST_HL_ADDR) {
+        emit_mov_imm(e, guest_host[dest], (uint8_t) op->operand);
+        e->dirty |= GUEST_BIT(dest);
+        return true;
+    }
+
+    // ADD, ADC, SUB, SBC, AND, XOR, OR, CP r
+    if (op->opcode >= 0x80 && op->opcode <= 0xBF && src != GUEST_HL_ADDR) {
+        emit_mov(e, HOST_RCX, guest_host[src]);
+        emit_alu(e, dest);
+        return true;
+    }
+
+    // ADD, ADC, SUB, SBC, AND, XOR, OR, CP d8
+    if ((op->opcode & 0xC7) == 0xC6) {
+        emit_mov_imm(e, HOST_RCX, (uint8_t) op->operand);
+        emit_alu(e, dest);
+        return true;
+    }
+
+    // INC r
+    if ((op->opcode & 0xC7) == 0x04 && dest != GUEST_HL_ADDR) {
+        emit_rr(e, OP_BYTE_RM, 0xFE, 0, guest_host[dest]);
+        emit_mov(e, HOST_RCX, guest_host[dest]);
+        emit_inc_flags(e);
+        e->dirty |= GUEST_BIT(dest);
+        return true;
+    }
+
+    // DEC r
+    if ((op->opcode & 0xC7) == 0x05 && dest != GUEST_HL_ADDR) {
+        emit_mov(e, HOST_RCX, guest_host[dest]);
+        emit_dec_flags(e);
+        emit_rr(e, OP_BYTE_RM, 0xFE, 1, guest_host[dest]);
+        e->dirty |= GUEST_BIT(dest);
+        return true;
+    }
+
+    switch (op->opcode) {
+        case 0x00: // NOP
+            return true;
+        case 0x01: // LD BC, d16
+        case 0x11: // LD DE, d16
+        case 0x21: // LD HL, d16
+            emit_mov_imm(e, guest_host[dest], (uint8_t) (op->operand >> 8));
+            emit_mov_imm(e, guest_host[dest + 1], (uint8_t) op->operand);
+            e->dirty |= GUEST_BIT(dest) | GUEST_BIT(dest + 1);
+            return true;
+        case 0x31: // LD SP, d16
+            emit_mov_imm(e, guest_host[GUEST_SP], op->operand);
+            e->dirty |= GUEST_BIT(GUEST_SP);
+            return true;
+        case 0x03: // INC BC
+            emit_pair_add(e, GUEST_B, GUEST_C, 1);
+            return true;
+        default:
+            break;
+    }
+
+    return JIT_NATIVE_MEMORY && emit_native_memory(e, op, pc, executed);
+}
+
+// Everything else calls its handler, which may access any guest register
+static void emit_call_out(Emitter *e, const MicroOp *op, uint16_t pc, uint8_t executed, bool last) {
+    emit_spill(e, e->dirty);
+    e->dirty = 0;
+    emit_flush_cycles(e);
+    emit_handler_call(e, op, pc, executed, !last);
+    emit_reload(e);
+}
+
+/**
+ * Blocks which branch back to their own start (the typical busy or copy loop) are repeated natively as long as
+ * no code was modified and the budget suffices for another full run.
+ */
+static void emit_loop(Emitter *e, const Block *block, const uint8_t *loop_start) {
+    emit_frame(e, 0, 0x81, ALU_ADD, FRAME_EXECUTED); // add dword [rsp + FRAME_EXECUTED], op_count
+    emit_u32(e, block->op_count);
+
+    emit_cpu(e, OP_16, 0x81, 7, CPU_OFFSET(PC)); // cmp word [rbx + PC], start
+    emit_u16(e, block->start);
+    uint8_t *other_block = emit_jcc(e, CC_NE);
+
+    emit_epoch_compare(e);
+    uint8_t *epoch_changed = emit_jcc(e, CC_NE);
+
+    emit_frame(e, 0, OPC_LOAD, HOST_RAX, FRAME_BUDGET);
+    emit_frame(e, 0, 0x2B, HOST_RAX, FRAME_EXECUTED); // sub eax, [rsp + FRAME_EXECUTED]
+    emit_alu_imm(e, 7, HOST_RAX, block->op_count);    // cmp eax, op_count
+    patch_jump(emit_jcc(e, CC_AE), loop_start);
+
+    patch_jump(other_block, e->pos);
+    patch_jump(epoch_changed, e->pos);
+    emit_spill(e, e->dirty);
+    emit_exit(e, 0);
+}
+
+static void emit_slow_paths(Emitter *e) {
+    for (uint8_t i = 0; i < e->slow_path_count; ++i) {
+        const SlowPath *slow = &e->slow_paths[i];
+
+        for (uint8_t j = 0; j < 2; ++j) {
+            if (slow->jumps[j] != NULL) {
+                patch_jump(slow->jumps[j], e->pos);
+            }
+        }
+
+        // the clock only includes the pending cycles while the handler runs, the native path adds them later
+        emit_spill(e, slow->dirty);
+        if (slow->cycles != 0) {
+            emit_clock(e, ALU_ADD, slow->cycles);
+        }
+        emit_handler_call(e, slow->op, slow->pc, slow->executed, true);
+        if (slow->cycles != 0) {
+            emit_clock(e, ALU_SUB, slow->cycles);
+        }
+        emit_reload(e);
+        patch_jump(emit_jmp(e), slow->resume);
+    }
+}
+
+// Emits the block once, native code holds the registers in @p dirty unspilled at its start. Returns those at its end.
+static uint16_t emit_block(Emitter *e, const Block *block, uint16_t dirty) {
+    e->dirty           = dirty;
+    e->cycles          = 0;
+    e->slow_path_count = 0;
+
+    uint16_t pc   = block->start;
+    bool pc_stale = false;
+
+    emit_prologue(e);
+    const uint8_t *loop_start = e->pos;
+    for (uint8_t i = 0; i < block->op_count; ++i) {
+        const MicroOp *op   = &block->ops[i];
+        uint8_t executed    = (uint8_t) (i + 1);
+        pc                  = (uint16_t) (pc + op->length);
+        e->cycles           = (uint16_t) (e->cycles + op->cycles);
+        uint8_t slow_before = e->slow_path_count;
+
+        if (emit_native(e, op, pc, executed)) {
+            if (e->slow_path_count != slow_before) {
+                e->slow_paths[slow_before].resume = e->pos;
+            }
+            pc_stale = true;
+            continue;
+        }
+
+        emit_call_out(e, op, pc, executed, executed == block->op_count);
+        pc_stale = false;
+    }
+
+    emit_flush_cycles(e);
+    if (pc_stale) {
+        emit_store_imm_u16(e, CPU_OFFSET(PC), pc);
+    }
+
+    uint16_t dirty_at_end = e->dirty;
+    emit_loop(e, block, loop_start);
+    emit_slow_paths(e);
+
+    return dirty_at_end;
+}
+
+/******************************************************
+ *** EXPOSED METHODS                                ***
+ ******************************************************/
+
+void jit_init(void) {
+    void *buffer = mmap(NULL, JIT_BUFFER_SIZE, PROT_READ | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buffer == MAP_FAILED) {
+        LOG_ERROR("Could not map the JIT code buffer, falling back to the interpreter");
+        return;
+    }
+
+    code_buffer = buffer;
+    code_used   = 0;
+    jit_enabled = true;
+}
+
+void jit_teardown(void) {
+    if (code_buffer != NULL) {
+        munmap(code_buffer, JIT_BUFFER_SIZE);
+    }
+
+    code_buffer = NULL;
+    jit_enabled = false;
+}
+
+void jit_compile(Block *block) {
+    if (code_used + JIT_MAX_BLOCK_SIZE > JIT_BUFFER_SIZE) {
+        LOG_INFO("JIT code buffer exhausted, recycling it");
+        code_used = 0;
+        block_cache_flush();
+        return;
+    }
+
+    // the buffer is never writable and executable at the same time
+    if (mprotect(code_buffer, JIT_BUFFER_SIZE, PROT_READ | PROT_WRITE) != 0) {
+        LOG_ERROR("Could not make the JIT code buffer writable, disabling the JIT");
+        jit_enabled = false;
+        return;
+    }
+
+    static Emitter e;
+    uint8_t *entry = code_buffer + code_used;
+
+    // the registers left unspilled at the end of a pass are still unspilled when the loop starts over, hence the
+    // block is emitted a second time with them, overwriting the first attempt
+    e.pos              = entry;
+    uint16_t loop_live = emit_block(&e, block, 0);
+    e.pos              = entry;
+    emit_block(&e, block, loop_live);
+
+    if ((size_t) (e.pos - entry) > JIT_MAX_BLOCK_SIZE) {
+        YOBEMAG_EXIT("Block 0x%04X compiled to %zu bytes, JIT_MAX_OP_SIZE is too small", block->start,
+                     (size_t) (e.pos - entry));
+    }
+    code_used += (size_t) (e.pos - entry);
+
+    if (mprotect(code_buffer, JIT_BUFFER_SIZE, PROT_READ | PROT_EXEC) != 0) {
+        YOBEMAG_EXIT("Could not make the JIT code buffer executable");
+    }
+
+    // function pointers and object pointers are interchangeable on every platform that supports mmap
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+    block->jit_code = (jit_function) (void *) entry;
+#pragma GCC diagnostic pop
+
+    LOG_DEBUG("Compiled block 0x%04X (%u ops) to %zu bytes", block->start, block->op_count, (size_t) (e.pos - entry));
+}
+
+#endif // defined(YOBEMAG_JIT)
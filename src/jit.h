@@ -0,0 +1,35 @@
+#ifndef YOBEMAG_JIT_H
+#define YOBEMAG_JIT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "block_cache.h"
+
+/**
+ * @brief Number of executions after which a block gets translated to native code
+ */
+#define JIT_THRESHOLD (64)
+
+/**
+ * @brief Set by ::jit_init(), the interpreter keeps executing blocks itself while false
+ */
+extern bool jit_enabled;
+
+/**
+ * @brief Map the executable code buffer and enable the JIT
+ *
+ * @note  Logs an error and leaves the JIT disabled if the buffer cannot be mapped.
+ */
+void jit_init(void);
+void jit_teardown(void);
+
+/**
+ * @brief   Translate @p block to native code and store the entry point in the block
+ *
+ * @note    If the code buffer is exhausted, it is recycled and the whole block cache is flushed.
+ *          Blocks must thus be looked up again after calling this function.
+ */
+void jit_compile(Block *block);
+
+#endif // YOBEMAG_JIT_H
@@ -1,8 +1,15 @@
+#define LOG_CATEGORY LOG_CAT_LCD
+
 #include <stdio.h>
 #include <stdbool.h>
 
 #include "lcd.h"
 #include "log.h"
+#include "ppu.h"
+#include "cpu.h"
+#include "scheduler.h"
+#include "timeline.h"
+#include "frame_stats.h"
 
 /******************************************************
  *** LOCAL VARIABLES                                ***
@@ -11,45 +18,83 @@
 #define WINDOW_WIDTH  (640)
 #define WINDOW_HEIGHT (576)
 
+// Host input is polled once per emulated frame, SDL_PollEvent is far too expensive to call per instruction
+#define INPUT_POLL_CYCLES (CYCLES_PER_FRAME)
+
 static SDL_Window *window;
 static SDL_Surface *surface;
+static bool quit_requested;
 
 /******************************************************
- *** EXPOSED METHODS                                ***
+ *** LOCAL METHODS                                  ***
  ******************************************************/
 
-void lcd_init(void) {
-    SDL_Init(SDL_INIT_EVERYTHING);
+static void lcd_present_frame(uint64_t deadline) {
+    uint64_t start = frame_stats_now();
+    SDL_UpdateWindowSurface(window);
+    uint64_t end = frame_stats_now();
 
-    window = SDL_CreateWindow("yobemag GB Emulator", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, WINDOW_WIDTH,
-                              WINDOW_HEIGHT, SDL_WINDOW_INPUT_FOCUS);
-
-    surface = SDL_GetWindowSurface(window);
-}
+    frame_stats_add(FRAME_PHASE_PRESENT, end - start);
+    timeline_host_span("SDL_UpdateWindowSurface", start, end);
 
-void lcd_teardown(void) {
-    SDL_Quit();
+    scheduler_schedule(EVENT_FRAME, deadline + CYCLES_PER_FRAME);
 }
 
-bool lcd_step(void) {
+static void lcd_poll_input(uint64_t deadline) {
     SDL_Event e;
     const uint8_t *key_states;
 
-    key_states = SDL_GetKeyboardState(NULL);
+    uint64_t start = frame_stats_now();
+    key_states     = SDL_GetKeyboardState(NULL);
 
     while (SDL_PollEvent(&e)) {
         if (e.type == SDL_QUIT) {
-            return true;
+            quit_requested = true;
         }
     }
+    uint64_t end = frame_stats_now();
+
+    frame_stats_add(FRAME_PHASE_INPUT, end - start);
+    timeline_host_span("SDL_PollEvent", start, end);
 
     if (key_states[SDL_SCANCODE_Q]) {
-        return true;
+        quit_requested = true;
+    }
+
+    if (quit_requested) {
+        cpu_request_stop();
     }
 
     if (key_states[SDL_SCANCODE_A]) {
         LOG_INFO("a");
     }
 
-    return false;
+    scheduler_schedule(EVENT_INPUT_POLL, deadline + INPUT_POLL_CYCLES);
+}
+
+/******************************************************
+ *** EXPOSED METHODS                                ***
+ ******************************************************/
+
+void lcd_init(void) {
+    SDL_Init(SDL_INIT_EVERYTHING);
+
+    window = SDL_CreateWindow("yobemag GB Emulator", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, WINDOW_WIDTH,
+                              WINDOW_HEIGHT, SDL_WINDOW_INPUT_FOCUS);
+
+    surface = SDL_GetWindowSurface(window);
+
+    quit_requested = false;
+    scheduler_register(EVENT_FRAME, lcd_present_frame);
+    scheduler_register(EVENT_INPUT_POLL, lcd_poll_input);
+    scheduler_schedule(EVENT_FRAME, cpu.cycle_count + CYCLES_PER_FRAME);
+    scheduler_schedule(EVENT_INPUT_POLL, cpu.cycle_count + INPUT_POLL_CYCLES);
+}
+
+void lcd_teardown(void) {
+    SDL_Quit();
+}
+
+bool lcd_quit_requested(void) {
+    return quit_requested;
 }
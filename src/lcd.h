@@ -5,8 +5,15 @@
 #include <stdbool.h>
 #include <SDL2/SDL.h>
 
+/**
+ * @brief Open the window and schedule the frame and input poll events, requires ::scheduler_init()
+ */
 void lcd_init(void);
 void lcd_teardown(void);
-bool lcd_step(void);
+
+/**
+ * @brief Whether the window was closed or `Q` was pressed, updated by the input poll event
+ */
+__attribute__((pure)) bool lcd_quit_requested(void);
 
 #endif // YOBEMAG_LCD_H
@@ -12,7 +12,15 @@
 
 #define MAX_TIME_STR_LEN (20)
 
-static LoggingLevel min_log_lvl = FATAL;
+LoggingLevel log_category_lvl[LOG_CAT_COUNT] = {[0 ... LOG_CAT_COUNT - 1] = FATAL};
+
+static const char *const category_names[LOG_CAT_COUNT] = {
+    [LOG_CAT_GENERAL] = "general",
+    [LOG_CAT_CPU]     = "cpu",
+    [LOG_CAT_MMU]     = "mmu",
+    [LOG_CAT_LCD]     = "lcd",
+    [LOG_CAT_ROM]     = "rom",
+};
 
 /******************************************************
  *** LOCAL METHODS                                  ***
@@ -31,24 +39,48 @@ static void get_time(char *const time_str) {
  ******************************************************/
 
 void log_set_lvl(LoggingLevel log_lvl) {
-    min_log_lvl = log_lvl;
+    LoggingLevel min_log_lvl = log_lvl;
 
     // minimum logging level cannot be higher than fatal
     if (min_log_lvl > FATAL) {
-        min_log_lvl = WARNING;
+        log_category_lvl[LOG_CAT_GENERAL] = WARNING;
         LOG_WARNING("Provided logging level %d is higher than FATAL (%d).", min_log_lvl, FATAL);
         min_log_lvl = FATAL;
     }
 
     // minimum logging level cannot be lower than debug
     if (min_log_lvl < DEBUG) {
+        log_category_lvl[LOG_CAT_GENERAL] = WARNING;
         LOG_WARNING("Provided logging level %d is lower than DEBUG (%d).", min_log_lvl, DEBUG);
         min_log_lvl = DEBUG;
     }
 
+    for (unsigned category = 0; category < LOG_CAT_COUNT; ++category) {
+        log_category_lvl[category] = min_log_lvl;
+    }
+
     LOG_INFO("Log level initialized to %d.", min_log_lvl);
 }
 
+void log_set_category_lvl(LogCategory category, LoggingLevel log_lvl) {
+    if (category >= LOG_CAT_COUNT) {
+        LOG_WARNING("Provided logging category %d does not exist.", category);
+        return;
+    }
+
+    log_category_lvl[category] = log_lvl < DEBUG ? DEBUG : log_lvl;
+    LOG_INFO("Log level of category %s initialized to %d.", category_names[category], log_category_lvl[category]);
+}
+
+LogCategory log_category_from_name(const char *const name) {
+    for (unsigned category = 0; category < LOG_CAT_COUNT; ++category) {
+        if (strcmp(name, category_names[category]) == 0)
+            return (LogCategory) category;
+    }
+
+    return LOG_CAT_COUNT;
+}
+
 void log_teardown(void) {
     fflush(stderr);
     fflush(stdout);
@@ -73,10 +105,7 @@ void log_exit(const char *const file_path, const int line_number, const char *co
     exit(EXIT_FAILURE);
 }
 
-void log_str(const LoggingLevel log_lvl, const char *const log_lvl_str, FILE *stream, const char *const msg, ...) {
-    if (log_lvl < min_log_lvl)
-        return;
-
+void log_str(const char *const log_lvl_str, FILE *stream, const char *const msg, ...) {
 // This is necessary because Criterion is not correctly redirecting stdout.
 // Hence, we test the log messages by sending them through stderr (which works as intended)
 #if defined(YOBEMAG_TEST)
@@ -11,6 +11,24 @@ typedef enum LoggingLevel {
     FATAL
 } LoggingLevel;
 
+/**
+ * @brief Subsystems that can be traced independently of each other
+ */
+typedef enum LogCategory {
+    LOG_CAT_GENERAL,
+    LOG_CAT_CPU,
+    LOG_CAT_MMU,
+    LOG_CAT_LCD,
+    LOG_CAT_ROM,
+    LOG_CAT_COUNT
+} LogCategory;
+
+/**
+ * @brief Minimum logging level per ::LogCategory. Read by the logging macros so
+ *        that a disabled message costs a single compare and does not evaluate its arguments.
+ */
+extern LoggingLevel log_category_lvl[LOG_CAT_COUNT];
+
 /**
  * @brief   Set the minimum required of a log message to be printed to the console
  *
@@ -18,6 +36,24 @@ typedef enum LoggingLevel {
  */
 void log_set_lvl(LoggingLevel log_lvl);
 
+/**
+ * @brief   Override the minimum logging level of a single subsystem, e.g. to
+ *          trace the CPU without paying for debug output of the MMU
+ *
+ * @param   category    The subsystem to configure
+ * @param   log_lvl     The desired minimal logging level for @p category
+ */
+void log_set_category_lvl(LogCategory category, LoggingLevel log_lvl);
+
+/**
+ * @brief   Look up a ::LogCategory by its lower-case name (`cpu`, `mmu`, `lcd`, `rom`)
+ *
+ * @param   name    Name of the category
+ *
+ * @return  The matching category or ::LOG_CAT_COUNT if @p name is unknown
+ */
+__attribute__((pure)) LogCategory log_category_from_name(const char *name);
+
 /**
  * @brief   Flash stdout and stderr on exit
  */
@@ -38,17 +74,33 @@ _Noreturn __attribute__((format(printf, 3, 4))) void log_exit(const char *file_p
                                                               ...);
 
 /**
- * @brief   Log a string to @p stream with logging level @p dbg_lvl, (printed as @p log_lvl_str),
+ * @brief   Log a string to @p stream with its logging level printed as @p log_lvl_str,
  * 			formatted as @p msg with parameters @p ...
  *
- * @param   log_lvl     Logging level, represented as ::LoggingLevel
+ * @note    The level is not checked here, use the `LOG_*` macros which filter before the call.
+ *
  * @param   log_lvl_str Logging level string representation
  * @param   stream      Stream to print to (commonly stderr/stdout)
  * @param   msg         Format string for the log message
  * @param   ...         Parameters for format string
  */
-__attribute__((format(printf, 4, 5))) void log_str(LoggingLevel log_lvl, const char *log_lvl_str, FILE *stream,
-                                                   const char *msg, ...);
+__attribute__((format(printf, 3, 4))) void log_str(const char *log_lvl_str, FILE *stream, const char *msg, ...);
+
+/*
+ * Messages below YOBEMAG_LOG_CEILING are removed at compile time (see the `LOG_CEILING` CMake option).
+ * The numeric values correspond to ::LoggingLevel, since enumerators are not visible to the preprocessor.
+ */
+#if !defined(YOBEMAG_LOG_CEILING)
+ #define YOBEMAG_LOG_CEILING (-1)
+#endif
+
+/*
+ * A translation unit can define LOG_CATEGORY before including this header to tag
+ * all of its messages with a ::LogCategory.
+ */
+#if !defined(LOG_CATEGORY)
+ #define LOG_CATEGORY LOG_CAT_GENERAL
+#endif
 
 /*
  * This is necessary, since __VA_ARGS__ is a C GNU extension.
@@ -61,11 +113,34 @@ __attribute__((format(printf, 4, 5))) void log_str(LoggingLevel log_lvl, const c
 #pragma clang diagnostic ignored "-Wgnu-zero-variadic-macro-arguments"
 #pragma clang diagnostic ignored "-Wunused-macros"
 
-#define LOG_DEBUG(msg, ...)   log_str(DEBUG, "DEBUG", stdout, msg, ##__VA_ARGS__)
-#define LOG_INFO(msg, ...)    log_str(INFO, "INFO", stdout, msg, ##__VA_ARGS__)
-#define LOG_WARNING(msg, ...) log_str(WARNING, "WARNING", stdout, msg, ##__VA_ARGS__)
-#define LOG_ERROR(msg, ...)   log_str(ERROR, "ERROR", stderr, msg, ##__VA_ARGS__)
-#define LOG_FATAL(msg, ...)   log_str(FATAL, "FATAL", stderr, msg, ##__VA_ARGS__)
+#define LOG_AT(log_lvl, log_lvl_str, stream, msg, ...)                                                                  \
+    do {                                                                                                                \
+        if (__builtin_expect((log_lvl) >= log_category_lvl[LOG_CATEGORY], 0))                                           \
+            log_str(log_lvl_str, stream, msg, ##__VA_ARGS__);                                                           \
+    } while (0)
+
+// Keeps format checking of compiled-out messages, but never evaluates their arguments
+#define LOG_NOTHING(msg, ...)                                                                                           \
+    do {                                                                                                                \
+        if (0)                                                                                                          \
+            log_str("", stdout, msg, ##__VA_ARGS__);                                                                    \
+    } while (0)
+
+#if YOBEMAG_LOG_CEILING <= -1
+ #define LOG_DEBUG(msg, ...) LOG_AT(DEBUG, "DEBUG", stdout, msg, ##__VA_ARGS__)
+#else
+ #define LOG_DEBUG(msg, ...) LOG_NOTHING(msg, ##__VA_ARGS__)
+#endif
+
+#if YOBEMAG_LOG_CEILING <= 0
+ #define LOG_INFO(msg, ...) LOG_AT(INFO, "INFO", stdout, msg, ##__VA_ARGS__)
+#else
+ #define LOG_INFO(msg, ...) LOG_NOTHING(msg, ##__VA_ARGS__)
+#endif
+
+#define LOG_WARNING(msg, ...) LOG_AT(WARNING, "WARNING", stdout, msg, ##__VA_ARGS__)
+#define LOG_ERROR(msg, ...)   LOG_AT(ERROR, "ERROR", stderr, msg, ##__VA_ARGS__)
+#define LOG_FATAL(msg, ...)   LOG_AT(FATAL, "FATAL", stderr, msg, ##__VA_ARGS__)
 
 #define YOBEMAG_EXIT(msg, ...) log_exit(__FILE__, __LINE__, msg, ##__VA_ARGS__)
 
@@ -1,56 +1,213 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <time.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <signal.h>
 
 #include "lcd.h"
 #include "cpu.h"
 #include "rom.h"
 #include "mmu.h"
+#include "mbc.h"
 #include "cli.h"
 #include "log.h"
+#include "ppu.h"
+#include "timer.h"
+#include "scheduler.h"
+#include "interrupt.h"
+#include "opcode_profile.h"
+#include "pc_profiler.h"
+#include "trace.h"
+#include "timeline.h"
+#include "perf_counters.h"
+#include "frame_stats.h"
+#include "rom_coverage.h"
+#include "mem_heatmap.h"
+
+#if defined(YOBEMAG_JIT)
+    #include "jit.h"
+#endif
+
+#define NS_PER_SECOND (1000000000L)
+
+// Set by SIGUSR1, the frame statistics are written after the current frame
+static volatile sig_atomic_t frame_stats_requested;
 
 void run_console(bool *halt);
+void sleep_until_emulated_time(const struct timespec *start, uint64_t cycles);
+void request_frame_stats(int signal_number);
 
 int main(const int argc, char **const argv) {
     CLIArguments cli_args;
     cli_parse(&cli_args, argc, argv);
 
     log_set_lvl(cli_args.logging_level);
+    for (unsigned category = 0; category < LOG_CAT_COUNT; ++category) {
+        if (cli_args.trace_categories & (1u << category)) {
+            log_set_category_lvl((LogCategory) category, DEBUG);
+        }
+    }
     atexit(log_teardown);
 
     rom_init(cli_args.rom_path);
     atexit(rom_destroy);
     LOG_INFO("Successfully initialized ROM");
 
+    scheduler_init();
+
     mmu_init();
+    mbc_init(cli_args.rom_path, cli_args.rtc_host_time ? RTC_CLOCK_HOST : RTC_CLOCK_EMULATED);
+    atexit(mbc_teardown);
     LOG_INFO("Successfully initialized MMU");
 
+    interrupt_init();
+    ppu_init();
+    timer_init();
+
     lcd_init();
     atexit(lcd_teardown);
     LOG_INFO("Successfully initialized LCD");
 
-    cpu_init();
+    if (cli_args.boot_rom) {
+        cpu_power_on();
+    } else {
+        cpu_init();
+    }
+    cpu_set_idle_loop_skipping(cli_args.idle_loop_skipping);
     LOG_INFO("Successfully initialized CPU");
 
-    uint8_t iterations = 0;
-    bool halt          = false;
-    bool interactive   = false;
-    while (!halt) {
-        cpu_step();
+    if (cli_args.profile_path != NULL) {
+        pc_profiler_init(cli_args.profile_path, cli_args.sym_path);
+        atexit(pc_profiler_teardown);
+        LOG_INFO("Successfully initialized profiler");
+    }
 
-        if (lcd_step())
-            break;
+    if (cli_args.timeline_path != NULL) {
+        timeline_init(cli_args.timeline_path);
+        atexit(timeline_teardown);
+        LOG_INFO("Successfully initialized timeline");
+    }
+
+    bool perf_counters = cli_args.perf_counters && perf_counters_init();
+    if (cli_args.perf_counters) {
+        atexit(perf_counters_teardown);
+    }
+
+    frame_stats_init(cli_args.frame_stats_path, cli_args.rom_path);
+    if (cli_args.frame_stats_path != NULL) {
+        atexit(frame_stats_teardown);
+        signal(SIGUSR1, request_frame_stats);
+    }
+
+    if (cli_args.trace_path != NULL) {
+#if defined(YOBEMAG_TRACE)
+        trace_init(cli_args.trace_path, TRACE_DEFAULT_CAPACITY);
+        atexit(trace_teardown);
+#else
+        LOG_WARNING("Ignoring -T, tracing requires a build with TRACE=1");
+#endif
+    }
+
+    if (cli_args.coverage_path != NULL) {
+#if defined(YOBEMAG_ROM_COVERAGE)
+        rom_coverage_init(cli_args.coverage_path);
+        atexit(rom_coverage_teardown);
+#else
+        LOG_WARNING("Ignoring -V, ROM coverage requires a build with ROM_COVERAGE=1");
+#endif
+    }
+
+    if (cli_args.heatmap_path != NULL) {
+#if defined(YOBEMAG_MEM_HEATMAP)
+        mem_heatmap_init(cli_args.heatmap_path);
+        atexit(mem_heatmap_teardown);
+#else
+        LOG_WARNING("Ignoring -M, the memory heatmap requires a build with MEM_HEATMAP=1");
+#endif
+    }
+
+#if defined(YOBEMAG_JIT)
+    if (cli_args.jit) {
+        jit_init();
+        atexit(jit_teardown);
+        LOG_INFO("Successfully initialized JIT");
+    }
+#endif
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    uint64_t iterations = 0;
+    bool halt           = false;
+    bool interactive    = false;
+    while (!halt && !lcd_quit_requested()) {
+        // One frame per call, host work only happens in the event handlers
+        uint64_t frame_start = frame_stats_now();
+        if (perf_counters) {
+            perf_counters_begin();
+        }
+        cpu_run(CYCLES_PER_FRAME);
+        if (perf_counters) {
+            perf_counters_end();
+        }
+        uint64_t run_end = frame_stats_now();
+        if (!cli_args.unthrottled) {
+            sleep_until_emulated_time(&start, cpu.cycle_count);
+        }
+        uint64_t frame_end = frame_stats_now();
+
+        frame_stats_end_frame(run_end - frame_start, frame_end - run_end);
+        timeline_host_span("cpu_run", frame_start, run_end);
+        timeline_host_span("sleep", run_end, frame_end);
+        timeline_host_span("host frame", frame_start, frame_end);
+        if (frame_stats_requested) {
+            frame_stats_requested = 0;
+            frame_stats_dump();
+        }
 
         ++iterations;
         if (interactive) {
             run_console(&halt);
         }
     }
-    LOG_INFO("Total number of iterations: %d", iterations);
+    LOG_INFO("Total number of iterations: %" PRIu64, iterations);
+    LOG_INFO("Skipped %" PRIu64 " of %" PRIu64 " cycles in idle loops of %s", cpu_idle_cycles_skipped(), cpu.cycle_count,
+             cli_args.rom_path);
+#if defined(YOBEMAG_PROFILE)
+    opcode_profile_report(stdout);
+#endif
+    if (perf_counters) {
+        perf_counters_report(stdout);
+    }
 
     exit(EXIT_SUCCESS);
 }
 
+/**
+ * Sleeps until the wall clock has caught up with the emulated clock. Idle time of the emulated CPU (e.g. HALT) is
+ * skipped by ::cpu_run() and turns into sleeping here instead of spinning the host CPU.
+ */
+void sleep_until_emulated_time(const struct timespec *start, uint64_t cycles) {
+    struct timespec deadline = {
+        .tv_sec  = start->tv_sec + (time_t) (cycles / CPU_CLOCK_HZ),
+        .tv_nsec = start->tv_nsec + (long) ((cycles % CPU_CLOCK_HZ) * NS_PER_SECOND / CPU_CLOCK_HZ),
+    };
+    if (deadline.tv_nsec >= NS_PER_SECOND) {
+        ++deadline.tv_sec;
+        deadline.tv_nsec -= NS_PER_SECOND;
+    }
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {
+    }
+}
+
+void request_frame_stats(int signal_number) {
+    (void) signal_number;
+    frame_stats_requested = 1;
+}
+
 void run_console(bool *halt) {
     *halt = true;
     cpu_print_registers();
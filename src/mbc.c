@@ -0,0 +1,318 @@
+#define LOG_CATEGORY LOG_CAT_ROM
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "mbc.h"
+#include "mmu.h"
+#include "rom.h"
+#include "log.h"
+
+/******************************************************
+ *** LOCAL VARIABLES                                ***
+ ******************************************************/
+
+#define RAM_ENABLE_VALUE (0x0A)
+#define UNMAPPED_VALUE   (0xFF)
+
+#define MBC1_BANK_BITS  (5)
+#define MBC1_BANK_MASK  ((1u << MBC1_BANK_BITS) - 1)
+#define MBC1_UPPER_MASK (0x03)
+#define MBC3_BANK_MASK  (0x7F)
+#define MBC3_RAM_BANKS  (0x04)
+#define MBC3_LATCH_ARM  (0x00)
+#define MBC3_LATCH      (0x01)
+#define MBC5_RAM_MASK   (0x0F)
+
+typedef struct Controller {
+    const char *name;
+    /**
+     * @brief Writes into the ROM, NULL if the cartridge has no registers
+     */
+    IOWriteHandler write;
+    /**
+     * @brief The RAM (and the clock) keep their contents while the Game Boy is off, they are stored in the save file
+     */
+    bool battery;
+    bool timer;
+} Controller;
+
+static void mbc1_write(uint16_t addr, uint8_t value);
+static void mbc3_write(uint16_t addr, uint8_t value);
+static void mbc5_write(uint16_t addr, uint8_t value);
+
+// Indexed by the cartridge type, the ones which are not listed are not supported
+static const Controller controllers[0xFF + 1] = {
+    [0x00]          = {"ROM", NULL, false, false},
+    [0x01 ... 0x02] = {"MBC1", mbc1_write, false, false},
+    [0x03]          = {"MBC1", mbc1_write, true, false},
+    [0x08]          = {"ROM", NULL, false, false},
+    [0x09]          = {"ROM", NULL, true, false},
+    [0x0F ... 0x10] = {"MBC3", mbc3_write, true, true},
+    [0x11 ... 0x12] = {"MBC3", mbc3_write, false, false},
+    [0x13]          = {"MBC3", mbc3_write, true, false},
+    [0x19 ... 0x1A] = {"MBC5", mbc5_write, false, false},
+    [0x1B]          = {"MBC5", mbc5_write, true, false},
+    [0x1C ... 0x1D] = {"MBC5", mbc5_write, false, false},
+    [0x1E]          = {"MBC5", mbc5_write, true, false},
+};
+
+static const Controller *controller;
+// NULL if the cartridge has no battery or nothing is to be stored
+static char *save_path;
+
+static uint8_t *ram;
+static size_t ram_size;
+static size_t ram_banks;
+static uint16_t rom_banks;
+
+// The registers, not every controller uses all of them
+static bool ram_enabled;
+static uint16_t rom_bank;
+static uint8_t ram_bank;
+static bool banking_mode;
+static bool latch_armed;
+
+/******************************************************
+ *** LOCAL METHODS                                  ***
+ ******************************************************/
+
+// Bank numbers wrap around at the size of the ROM, like the unconnected upper bits of a real controller
+static void map_rom(uint16_t addr, unsigned bank) {
+    mmu_map_rom_bank(addr, (uint16_t) (bank % rom_banks));
+}
+
+static void map_ram(bool mapped, size_t bank) {
+    if (!mapped || ram == NULL) {
+        mmu_map_cart_ram(NULL, 0);
+        return;
+    }
+
+    size_t offset = bank % ram_banks * CART_RAM_BANK_SIZE;
+    mmu_map_cart_ram(&ram[offset], ram_size - offset);
+}
+
+static bool rtc_selected(void) {
+    return controller->timer && ram_enabled && ram_bank >= RTC_SECONDS && ram_bank <= RTC_DAYS_HIGH;
+}
+
+// Cart RAM reads while no RAM is mapped see the clock register the MBC3 selected, or else an open bus
+static uint8_t read_unmapped(uint16_t addr) {
+    (void) addr;
+    return rtc_selected() ? rtc_read((RTCRegister) ram_bank) : UNMAPPED_VALUE;
+}
+
+static void write_unmapped(uint16_t addr, uint8_t value) {
+    (void) addr;
+    if (rtc_selected()) {
+        rtc_write((RTCRegister) ram_bank, value);
+    }
+}
+
+// The save file is the ROM's path with the extension replaced by .sav
+static char *derive_save_path(const char *rom_path) {
+    const char *name      = strrchr(rom_path, '/');
+    const char *extension = strrchr(name != NULL ? name : rom_path, '.');
+    size_t length         = extension != NULL ? (size_t) (extension - rom_path) : strlen(rom_path);
+
+    char *path = malloc(length + sizeof(".sav"));
+    if (path == NULL) {
+        YOBEMAG_EXIT("Could not allocate the path of the save file");
+    }
+    memcpy(path, rom_path, length);
+    strcpy(&path[length], ".sav");
+    return path;
+}
+
+// The RAM followed by the clock state, a missing or short file leaves the rest as it is
+static void load_save(void) {
+    FILE *file = fopen(save_path, "rb");
+    if (file == NULL) {
+        LOG_INFO("No save file %s yet", save_path);
+        return;
+    }
+
+    size_t read = fread(ram, 1, ram_size, file);
+    if (controller->timer) {
+        uint8_t state[RTC_SAVE_SIZE];
+        if (fread(state, 1, sizeof(state), file) == sizeof(state)) {
+            rtc_load(state);
+        }
+    }
+    fclose(file);
+
+    LOG_INFO("Loaded %zu bytes of cart RAM from %s", read, save_path);
+}
+
+static void store_save(void) {
+    FILE *file = fopen(save_path, "wb");
+    if (file == NULL) {
+        LOG_ERROR("Could not open save file %s: %s", save_path, strerror(errno));
+        return;
+    }
+
+    bool written = fwrite(ram, 1, ram_size, file) == ram_size;
+    if (controller->timer) {
+        uint8_t state[RTC_SAVE_SIZE];
+        rtc_save(state);
+        written = written && fwrite(state, 1, sizeof(state), file) == sizeof(state);
+    }
+    if (fclose(file) != 0 || !written) {
+        LOG_ERROR("Could not write save file %s", save_path);
+    }
+}
+
+/*
+ * The two upper bits either extend the bank number of the switchable region, or, in banking mode 1, also select the
+ * bank mapped at 0x0000 and the RAM bank. A bank number of 0 in the lower five bits selects 1 instead.
+ */
+static unsigned mbc1_upper_bits(void) {
+    return banking_mode ? ram_bank : 0;
+}
+
+static void mbc1_map_switchable(void) {
+    map_rom(0x4000, (unsigned) ram_bank << MBC1_BANK_BITS | (rom_bank == 0 ? 1u : rom_bank));
+}
+
+// Every register only re-maps the regions it selects, and only when their mapping changes
+static void mbc1_write(uint16_t addr, uint8_t value) {
+    if (addr < 0x2000) {
+        bool enabled = (value & 0x0F) == RAM_ENABLE_VALUE;
+        if (enabled != ram_enabled) {
+            ram_enabled = enabled;
+            map_ram(ram_enabled, mbc1_upper_bits());
+        }
+        return;
+    }
+    if (addr < 0x4000) {
+        rom_bank = value & MBC1_BANK_MASK;
+        mbc1_map_switchable();
+        return;
+    }
+
+    unsigned previous = mbc1_upper_bits();
+    if (addr < 0x6000) {
+        ram_bank = value & MBC1_UPPER_MASK;
+        mbc1_map_switchable();
+    } else {
+        banking_mode = value & 0x01;
+    }
+
+    unsigned upper = mbc1_upper_bits();
+    if (upper != previous) {
+        map_rom(0x0000, upper << MBC1_BANK_BITS);
+        map_ram(ram_enabled, upper);
+    }
+}
+
+/*
+ * RAM banks 0x08 to 0x0C select a clock register instead, see ::RTCRegister. Writing 0x00 and then 0x01 latches the
+ * clock.
+ */
+static void mbc3_write(uint16_t addr, uint8_t value) {
+    if (addr < 0x2000) {
+        ram_enabled = (value & 0x0F) == RAM_ENABLE_VALUE;
+    } else if (addr < 0x4000) {
+        rom_bank = value & MBC3_BANK_MASK;
+        map_rom(0x4000, rom_bank == 0 ? 1u : rom_bank);
+        return;
+    } else if (addr < 0x6000) {
+        ram_bank = value;
+    } else {
+        if (controller->timer && latch_armed && value == MBC3_LATCH) {
+            rtc_latch();
+        }
+        latch_armed = value == MBC3_LATCH_ARM;
+        return;
+    }
+
+    map_ram(ram_enabled && ram_bank < MBC3_RAM_BANKS, ram_bank);
+}
+
+// The bank number has nine bits and 0 selects bank 0
+static void mbc5_write(uint16_t addr, uint8_t value) {
+    if (addr < 0x2000) {
+        ram_enabled = (value & 0x0F) == RAM_ENABLE_VALUE;
+    } else if (addr < 0x3000) {
+        rom_bank = (uint16_t) ((rom_bank & 0x100) | value);
+        map_rom(0x4000, rom_bank);
+        return;
+    } else if (addr < 0x4000) {
+        rom_bank = (uint16_t) ((rom_bank & 0xFF) | (value & 0x01) << 8);
+        map_rom(0x4000, rom_bank);
+        return;
+    } else if (addr < 0x6000) {
+        ram_bank = value & MBC5_RAM_MASK;
+    } else {
+        return;
+    }
+
+    map_ram(ram_enabled, ram_bank);
+}
+
+/******************************************************
+ *** EXPOSED METHODS                                ***
+ ******************************************************/
+
+void mbc_init(const char *rom_path, RTCClock clock) {
+    if (get_rom_bytes() == NULL) {
+        return;
+    }
+
+    uint8_t type = get_cartridge_type();
+    controller   = &controllers[type];
+    if (controller->name == NULL) {
+        LOG_WARNING("Cartridge type %02x is not supported, only ROM banks 0 and 1 are mapped", type);
+        controller = &controllers[0x00];
+    }
+
+    rom_banks    = (uint16_t) (get_rom_size() / ROM_BANK_SIZE);
+    rom_banks    = rom_banks > 0 ? rom_banks : 1;
+    ram_size     = get_cartridge_ram_size();
+    ram_banks    = (ram_size + CART_RAM_BANK_SIZE - 1) / CART_RAM_BANK_SIZE;
+    ram_enabled  = false;
+    rom_bank     = 1;
+    ram_bank     = 0;
+    banking_mode = false;
+    latch_armed  = false;
+
+    free(ram);
+    ram = NULL;
+    if (ram_size > 0) {
+        ram = calloc(ram_size, 1);
+        if (ram == NULL) {
+            YOBEMAG_EXIT("Could not allocate %zu bytes of cart RAM", ram_size);
+        }
+    }
+
+    if (controller->timer) {
+        rtc_init(clock);
+    }
+
+    free(save_path);
+    save_path = NULL;
+    if (rom_path != NULL && controller->battery) {
+        save_path = derive_save_path(rom_path);
+        load_save();
+    }
+
+    mmu_register_cartridge(controller->write, read_unmapped, write_unmapped);
+    // without a controller, the RAM cannot be disabled
+    map_ram(controller->write == NULL, 0);
+    LOG_INFO("Memory bank controller: %s, %u ROM banks, %zu RAM banks", controller->name, rom_banks, ram_banks);
+}
+
+void mbc_teardown(void) {
+    if (save_path != NULL) {
+        store_save();
+        free(save_path);
+        save_path = NULL;
+    }
+
+    free(ram);
+    ram = NULL;
+}
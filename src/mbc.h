@@ -0,0 +1,24 @@
+#ifndef YOBEMAG_MBC_H
+#define YOBEMAG_MBC_H
+
+#include "rtc.h"
+
+/**
+ * @brief   Set up the memory bank controller of the loaded ROM, which is picked by its cartridge type, and its RAM
+ *
+ * @param   rom_path    Battery-backed RAM and clock are loaded from and stored to the file next to it with the
+ *                      extension `.sav`, NULL to start empty and store nothing
+ * @param   clock       What the MBC3's clock counts the time with, if the cartridge has one
+ *
+ * @note    Call after ::mmu_init(), which maps banks 0 and 1. Banks are switched by repointing the MMU's pages into
+ *          the ROM and the cart RAM, the per-access path never looks at the controller. Cartridges without a
+ *          supported controller keep banks 0 and 1.
+ */
+void mbc_init(const char *rom_path, RTCClock clock);
+
+/**
+ * @brief Store the save file and free the cart RAM, does nothing if ::mbc_init() was not called
+ */
+void mbc_teardown(void);
+
+#endif // YOBEMAG_MBC_H
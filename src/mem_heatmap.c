@@ -0,0 +1,120 @@
+#define LOG_CATEGORY LOG_CAT_MMU
+
+#if defined(YOBEMAG_MEM_HEATMAP)
+
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include "mem_heatmap.h"
+#include "log.h"
+
+/******************************************************
+ *** LOCAL VARIABLES                                ***
+ ******************************************************/
+
+#define BANKED_SLOTS (MEM_HEATMAP_PAGES + MEM_HEATMAP_PAGE_SIZE)
+
+uint64_t mem_heatmap_reads[MEM_HEATMAP_SLOTS];
+uint64_t mem_heatmap_writes[MEM_HEATMAP_SLOTS];
+
+static const char *output_path;
+
+/******************************************************
+ *** LOCAL METHODS                                  ***
+ ******************************************************/
+
+__attribute__((const)) static const char *region_name(uint16_t addr) {
+    if (addr < 0x4000) {
+        return "rom0";
+    } else if (addr < ROM_LIMIT) {
+        return "romx";
+    } else if (addr < 0xA000) {
+        return "vram";
+    } else if (addr < 0xC000) {
+        return "cart_ram";
+    } else if (addr < 0xE000) {
+        return "wram";
+    } else if (addr < 0xFE00) {
+        return "echo";
+    } else if (addr < IO_START) {
+        return "oam";
+    } else if (addr < 0xFF80) {
+        return "io";
+    } else if (addr < 0xFFFF) {
+        return "hram";
+    }
+    return "ie";
+}
+
+static void write_row(FILE *stream, uint16_t first, uint16_t last, int bank, unsigned slot) {
+    fprintf(stream, "%s,%d,0x%04X,0x%04X,%" PRIu64 ",%" PRIu64 "\n", region_name(first), bank, first, last,
+            mem_heatmap_reads[slot], mem_heatmap_writes[slot]);
+}
+
+__attribute__((pure)) static bool bank_accessed(unsigned bank) {
+    for (unsigned page = 0; page < MEM_HEATMAP_BANK_PAGES; ++page) {
+        unsigned slot = BANKED_SLOTS + bank * MEM_HEATMAP_BANK_PAGES + page;
+        if (mem_heatmap_reads[slot] != 0 || mem_heatmap_writes[slot] != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/******************************************************
+ *** EXPOSED METHODS                                ***
+ ******************************************************/
+
+void mem_heatmap_init(const char *path) {
+    memset(mem_heatmap_reads, 0, sizeof(mem_heatmap_reads));
+    memset(mem_heatmap_writes, 0, sizeof(mem_heatmap_writes));
+    output_path = path;
+}
+
+void mem_heatmap_teardown(void) {
+    if (output_path == NULL) {
+        return;
+    }
+
+    FILE *stream = fopen(output_path, "w");
+    if (stream == NULL) {
+        LOG_ERROR("Could not open memory heatmap output %s: %s", output_path, strerror(errno));
+        return;
+    }
+
+    mem_heatmap_write_csv(stream);
+    if (fclose(stream) != 0) {
+        LOG_ERROR("Could not write the memory heatmap to %s: %s", output_path, strerror(errno));
+    }
+    output_path = NULL;
+}
+
+void mem_heatmap_write_csv(FILE *stream) {
+    fputs("region,bank,first,last,reads,writes\n", stream);
+
+    // bank 0 below the switchable region, the page index is its address' high byte
+    for (unsigned page = 0; page < 0x40; ++page) {
+        write_row(stream, (uint16_t) (page << 8), (uint16_t) (page << 8 | 0xFF), 0, page);
+    }
+    for (unsigned bank = 0; bank < MEM_HEATMAP_ROM_BANKS; ++bank) {
+        if (!bank_accessed(bank)) {
+            continue;
+        }
+        for (unsigned page = 0; page < MEM_HEATMAP_BANK_PAGES; ++page) {
+            uint16_t first = (uint16_t) (0x4000 + (page << 8));
+            write_row(stream, first, (uint16_t) (first | 0xFF), (int) bank,
+                      BANKED_SLOTS + bank * MEM_HEATMAP_BANK_PAGES + page);
+        }
+    }
+    for (unsigned page = ROM_LIMIT >> 8; page < MEM_HEATMAP_IO_PAGE; ++page) {
+        write_row(stream, (uint16_t) (page << 8), (uint16_t) (page << 8 | 0xFF), -1, page);
+    }
+    for (unsigned offset = 0; offset < MEM_HEATMAP_PAGE_SIZE; ++offset) {
+        uint16_t addr = (uint16_t) (IO_START + offset);
+        write_row(stream, addr, addr, -1, MEM_HEATMAP_PAGES + offset);
+    }
+}
+
+#endif // defined(YOBEMAG_MEM_HEATMAP)
@@ -0,0 +1,78 @@
+#ifndef YOBEMAG_MEM_HEATMAP_H
+#define YOBEMAG_MEM_HEATMAP_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Counts the CPU's reads and writes per 256-byte page. The switchable ROM region is counted per mapped bank and the
+ * I/O page (including HRAM and IE) per address, so that single hot registers stand out.
+ */
+
+/**
+ * @brief ROM banks of the largest cartridges (MBC5), the switchable region of each one has its own pages
+ */
+#define MEM_HEATMAP_ROM_BANKS (512)
+
+#define MEM_HEATMAP_PAGE_SIZE  (256)
+#define MEM_HEATMAP_PAGES      (0x10000 / MEM_HEATMAP_PAGE_SIZE)
+#define MEM_HEATMAP_IO_PAGE    (0xFF)
+#define MEM_HEATMAP_BANK_PAGES (0x4000 / MEM_HEATMAP_PAGE_SIZE)
+
+/**
+ * @brief One counter per page of the address space, then per address of the I/O page, then per page of each bank
+ */
+#define MEM_HEATMAP_SLOTS (MEM_HEATMAP_PAGES + MEM_HEATMAP_PAGE_SIZE + MEM_HEATMAP_ROM_BANKS * MEM_HEATMAP_BANK_PAGES)
+
+#if defined(YOBEMAG_MEM_HEATMAP)
+
+    #include "mmu.h"
+
+extern uint64_t mem_heatmap_reads[MEM_HEATMAP_SLOTS];
+extern uint64_t mem_heatmap_writes[MEM_HEATMAP_SLOTS];
+
+/**
+ * @brief   Reset the counters and write them to @p path as CSV on ::mem_heatmap_teardown()
+ *
+ * @param   path    May be NULL, the counters are then only kept in memory
+ */
+void mem_heatmap_init(const char *path);
+
+/**
+ * @brief Write the counters if a path was given to ::mem_heatmap_init()
+ */
+void mem_heatmap_teardown(void);
+
+/**
+ * @brief   Write a row of region, bank, first and last address, reads and writes per counter to @p stream
+ *
+ * @note    Rows of the switchable ROM region are only written for banks which were accessed.
+ */
+void mem_heatmap_write_csv(FILE *stream);
+
+/**
+ * @brief Index of the counter of @p addr in the ::mem_heatmap_reads and ::mem_heatmap_writes
+ */
+__attribute__((always_inline)) inline unsigned mem_heatmap_slot(uint16_t addr) {
+    unsigned page = addr / MEM_HEATMAP_PAGE_SIZE;
+    if (page == MEM_HEATMAP_IO_PAGE) {
+        return MEM_HEATMAP_PAGES + (addr & (MEM_HEATMAP_PAGE_SIZE - 1));
+    }
+    if (addr >= 0x4000 && addr < ROM_LIMIT) {
+        unsigned bank = mmu_get_bank(addr) & (MEM_HEATMAP_ROM_BANKS - 1);
+        return MEM_HEATMAP_PAGES + MEM_HEATMAP_PAGE_SIZE + bank * MEM_HEATMAP_BANK_PAGES + page - 0x40;
+    }
+    return page;
+}
+
+    #define MEM_HEATMAP_READ(addr)  (++mem_heatmap_reads[mem_heatmap_slot(addr)])
+    #define MEM_HEATMAP_WRITE(addr) (++mem_heatmap_writes[mem_heatmap_slot(addr)])
+
+#else
+
+    #define MEM_HEATMAP_READ(addr)
+    #define MEM_HEATMAP_WRITE(addr)
+
+#endif // defined(YOBEMAG_MEM_HEATMAP)
+
+#endif // YOBEMAG_MEM_HEATMAP_H
@@ -1,7 +1,16 @@
+#define LOG_CATEGORY LOG_CAT_MMU
+
 #include "mmu.h"
 #include "cpu.h"
 #include "log.h"
 #include "rom.h"
+#include "interrupt.h"
+#include "mem_heatmap.h"
+
+#if defined(YOBEMAG_BLOCK_CACHE)
+    #include "block_cache.h"
+#endif
+#include <stdbool.h>
 #include <stdint.h>
 #include <sys/types.h>
 
@@ -11,13 +20,49 @@ void dump_hex(const uint8_t *data, size_t size);
  *** LOCAL VARIABLES                                ***
  ******************************************************/
 
-#define MB0        (0x0000)
-#define MB0_LENGTH (0x4000)
-#define MB1        (0x4000)
-#define MB1_LENGTH (0x4000)
+#define MB0 (0x0000)
+#define MB1 (0x4000)
+
+#define PAGE_SIZE   (0x100)
+#define PAGE_COUNT  (MEM_SIZE / PAGE_SIZE)
+#define PAGE_OFFSET (PAGE_SIZE - 1)
+#define PAGE(addr)  ((unsigned) (addr) >> 8)
+
+#define ECHO_START (0xE000)
+#define ECHO_LIMIT (0xFE00)
+#define WRAM_START (0xC000)
 
 static uint8_t mem[MEM_SIZE];
 
+/**
+ * The memory a page is read from, e.g. a page of the mapped ROM bank. NULL for pages whose reads need more than a
+ * load (the I/O page), those are served by read_slow(). Until mmu_init(), every page is served from `mem` that way.
+ */
+static const uint8_t *read_pages[PAGE_COUNT];
+
+/**
+ * The memory a page is written to, NULL for pages whose writes need more than a store (the ROM, echo RAM and the
+ * I/O page), those are handled by write_slow()
+ */
+static uint8_t *write_pages[PAGE_COUNT];
+
+// Indexed by the low byte of the register, NULL for registers which are plain memory
+static IOWriteHandler io_write_handlers[IO_REGISTERS];
+static IOWriteHandler ie_write_handler;
+static IOReadHandler io_read_handlers[IO_REGISTERS];
+
+static IOWriteHandler rom_write_handler;
+static IOReadHandler cart_ram_read_handler;
+static IOWriteHandler cart_ram_write_handler;
+
+uint16_t mmu_rom_banks[ROM_LIMIT / ROM_BANK_SIZE] = {0, 1};
+
+// Overlays the first page of the ROM from power on until the CPU writes to IO_BOOT
+bool mmu_boot_rom_overlaid;
+
+const uint8_t *mmu_code_page;
+unsigned mmu_code_page_index = PAGE_COUNT;
+
 static const uint8_t boot_rom[BOOT_ROM_SIZE] = {
     0x31, 0xFE, 0xFF, 0xAF, 0x21, 0xFF, 0x9F, 0x32, 0xCB, 0x7C, 0x20, 0xFB, 0x21, 0x26, 0xFF, 0x0E, 0x11, 0x3E, 0x80,
     0x32, 0xE2, 0x0C, 0x3E, 0xF3, 0xE2, 0x32, 0x3E, 0x77, 0x77, 0x3E, 0xFC, 0xE0, 0x47, 0x11, 0x04, 0x01, 0x21, 0x10,
@@ -34,27 +79,150 @@ static const uint8_t boot_rom[BOOT_ROM_SIZE] = {
     0xA8, 0x00, 0x1A, 0x13, 0xBE, 0x20, 0xFE, 0x23, 0x7D, 0xFE, 0x34, 0x20, 0xF5, 0x06, 0x19, 0x78, 0x86, 0x23, 0x05,
     0x20, 0xFB, 0x86, 0x20, 0xFE, 0x3E, 0x01, 0xE0, 0x50};
 
+/******************************************************
+ *** LOCAL METHODS                                  ***
+ ******************************************************/
+
+static uint8_t read_slow(uint16_t addr) {
+    if (addr >= IO_START && addr < HRAM_START && io_read_handlers[addr - IO_START] != NULL) {
+        return io_read_handlers[addr - IO_START](addr);
+    }
+
+    if (addr >= CART_RAM_START && addr < CART_RAM_LIMIT && cart_ram_read_handler != NULL) {
+        return cart_ram_read_handler(addr);
+    }
+
+    return mem[addr];
+}
+
+// Maps @p length bytes from @p addr on to @p memory, of which only @p available exist, the rest is left to read_slow()
+static void map_read_pages(uint16_t addr, const uint8_t *memory, size_t length, size_t available) {
+    for (size_t offset = 0; offset < length; offset += PAGE_SIZE) {
+        read_pages[PAGE(addr + offset)] = offset < available ? &memory[offset] : NULL;
+    }
+}
+
+static void map_rom_bank(uint16_t addr, uint16_t bank) {
+    const uint8_t *rom_bytes = get_rom_bytes();
+    size_t rom_size          = get_rom_size();
+    size_t offset            = (size_t) bank * ROM_BANK_SIZE;
+
+    if (offset < rom_size) {
+        map_read_pages(addr, &rom_bytes[offset], ROM_BANK_SIZE, rom_size - offset);
+    } else {
+        map_read_pages(addr, NULL, ROM_BANK_SIZE, 0);
+    }
+    if (addr == MB0 && mmu_boot_rom_overlaid) {
+        read_pages[PAGE(MB0)] = boot_rom;
+    }
+
+    mmu_rom_banks[addr / ROM_BANK_SIZE] = bank;
+    mmu_code_page_index                 = PAGE_COUNT;
+}
+
+static void boot_write(uint16_t addr, uint8_t value) {
+    (void) addr;
+    if (value != 0) {
+        mmu_unmap_boot_rom();
+    }
+}
+
+static void store(uint16_t addr, uint8_t value) {
+    mem[addr] = value;
+
+#if defined(YOBEMAG_BLOCK_CACHE)
+    block_cache_invalidate(addr);
+#endif
+}
+
+static void write_slow(uint16_t addr, uint8_t value) {
+    if (addr >= IO_START) {
+        IOWriteHandler handler = addr < HRAM_START ? io_write_handlers[addr - IO_START]
+                                 : addr == IO_IE   ? ie_write_handler
+                                                   : NULL;
+        if (handler != NULL) {
+            handler(addr, value);
+        } else {
+            store(addr, value);
+        }
+        return;
+    }
+
+    // blocks are cached by the address they were decoded at, which is the WRAM address rather than the mirror
+    if (addr >= ECHO_START && addr < ECHO_LIMIT && read_pages[PAGE(addr)] != NULL) {
+        store((uint16_t) (addr - (ECHO_START - WRAM_START)), value);
+        return;
+    }
+
+    if (addr < ROM_LIMIT && rom_write_handler != NULL) {
+        rom_write_handler(addr, value);
+        return;
+    }
+
+    if (addr >= CART_RAM_START && addr < CART_RAM_LIMIT && cart_ram_write_handler != NULL) {
+        cart_ram_write_handler(addr, value);
+        return;
+    }
+
+    // the ROM cannot be written, without a ROM (e.g. in tests) its region is plain memory
+    if (read_pages[PAGE(addr)] == NULL) {
+        store(addr, value);
+    }
+}
+
 /******************************************************
  *** EXPOSED METHODS                                ***
  ******************************************************/
 
 void mmu_print_memory(void) {
-    dump_hex(mem, sizeof(mem));
+    static uint8_t visible[MEM_SIZE];
+
+    for (unsigned page = 0; page < PAGE_COUNT; ++page) {
+        memcpy(&visible[page * PAGE_SIZE], read_pages[page] != NULL ? read_pages[page] : &mem[page * PAGE_SIZE],
+               PAGE_SIZE);
+    }
+    dump_hex(visible, sizeof(visible));
 }
 
 void mmu_init(void) {
-    const uint8_t *rom_bytes = get_rom_bytes();
+    mmu_boot_rom_overlaid = true;
 
-    memcpy(&mem[MB0], &rom_bytes[MB0], MB0_LENGTH);
-    memcpy(&mem[MB1], &rom_bytes[MB1], MB1_LENGTH);
+    // the ROM is read in place, banks 0 and 1 are mapped until a memory bank controller switches them. Without a ROM
+    // (e.g. in benchmarks) its pages stay in `mem`.
+    if (get_rom_bytes() != NULL) {
+        map_rom_bank(MB0, 0);
+        map_rom_bank(MB1, 1);
+    }
+    read_pages[PAGE(MB0)] = boot_rom;
+    mmu_register_io_write(IO_BOOT, boot_write);
+
+    for (unsigned page = PAGE(ROM_LIMIT); page < PAGE(IO_START); ++page) {
+        read_pages[page]  = &mem[page * PAGE_SIZE];
+        write_pages[page] = &mem[page * PAGE_SIZE];
+    }
+    // echo RAM mirrors the start of WRAM
+    for (unsigned page = PAGE(ECHO_START); page < PAGE(ECHO_LIMIT); ++page) {
+        read_pages[page]  = &mem[(page - PAGE(ECHO_START - WRAM_START)) * PAGE_SIZE];
+        write_pages[page] = NULL;
+    }
+    read_pages[PAGE(IO_START)]  = NULL;
+    write_pages[PAGE(IO_START)] = NULL;
+    mmu_code_page_index         = PAGE_COUNT;
 }
 
 uint8_t mmu_get_byte(uint16_t addr) {
-    if (addr < BOOT_ROM_SIZE) {
-        return boot_rom[addr];
+    MEM_HEATMAP_READ(addr);
+
+    const uint8_t *page = read_pages[PAGE(addr)];
+    if (__builtin_expect(page != NULL, 1)) {
+        return page[addr & PAGE_OFFSET];
+    }
+    // HRAM and IE share their page with the I/O registers, but are plain memory
+    if (addr >= HRAM_START) {
+        return mem[addr];
     }
 
-    return mem[addr];
+    return read_slow(addr);
 }
 
 void mmu_write_byte(uint16_t dest_addr, uint8_t value) {
@@ -62,23 +230,155 @@ void mmu_write_byte(uint16_t dest_addr, uint8_t value) {
     //     LOG_ERROR("Cannot write 0x%02x into 0x%02x as it is reserved for ROM space", value, dest_addr);
     //     exit(1);
     // }
+    MEM_HEATMAP_WRITE(dest_addr);
+
+    uint8_t *page = write_pages[PAGE(dest_addr)];
+    if (__builtin_expect(page == NULL, 0)) {
+        // HRAM shares its page with the I/O registers, but is plain memory
+        if (dest_addr >= HRAM_START && dest_addr != IO_IE) {
+            store(dest_addr, value);
+        } else {
+            write_slow(dest_addr, value);
+        }
+        return;
+    }
+
+    page[dest_addr & PAGE_OFFSET] = value;
 
-    mem[dest_addr] = value;
+#if defined(YOBEMAG_BLOCK_CACHE)
+    block_cache_invalidate(dest_addr);
+#endif
+}
+
+uint8_t mmu_fetch_slow(uint16_t addr) {
+    const uint8_t *page = read_pages[PAGE(addr)];
+    if (page != NULL) {
+        mmu_code_page       = page;
+        mmu_code_page_index = PAGE(addr);
+    }
+
+    return mmu_get_byte(addr);
 }
 
 uint16_t mmu_get_two_bytes(uint16_t addr) {
+    // both bytes are read at once unless they lie on different pages
+    const uint8_t *page = read_pages[PAGE(addr)];
+    if (__builtin_expect(page != NULL && (addr & PAGE_OFFSET) != PAGE_OFFSET, 1)) {
+        MEM_HEATMAP_READ(addr);
+        MEM_HEATMAP_READ(addr + 1);
+
+        uint16_t value;
+        memcpy(&value, &page[addr & PAGE_OFFSET], sizeof(value));
+        return value;
+    }
+
     return (uint16_t) (mmu_get_byte(addr) | (mmu_get_byte(addr + 1) << 8));
 }
 
-void mmu_write_two_bytes(uint16_t dest_addr, uint16_t value) {
-    if (dest_addr < ROM_LIMIT) {
-        LOG_ERROR("Cannot write into 0x%x as it is reserved for ROM space", dest_addr);
+uint32_t mmu_get_four_bytes(uint16_t addr) {
+    // instructions run from plain memory almost always, which is read at once
+    const uint8_t *page = read_pages[PAGE(addr)];
+    if (__builtin_expect(page != NULL && (addr & PAGE_OFFSET) <= PAGE_SIZE - sizeof(uint32_t), 1)) {
+        uint32_t value;
+        memcpy(&value, &page[addr & PAGE_OFFSET], sizeof(value));
+        return value;
     }
 
+    return (uint32_t) mmu_get_two_bytes(addr) | (uint32_t) mmu_get_two_bytes((uint16_t) (addr + 2)) << 16;
+}
+
+void mmu_write_two_bytes(uint16_t dest_addr, uint16_t value) {
     mmu_write_byte(dest_addr, (uint8_t) value);
     mmu_write_byte(dest_addr + 1, (uint8_t) (value >> 8));
 }
 
+const uint8_t *const *mmu_read_page_table(void) {
+    return read_pages;
+}
+
+uint8_t *const *mmu_write_page_table(void) {
+    return write_pages;
+}
+
+uint8_t *mmu_hram_page(void) {
+    return &mem[PAGE(HRAM_START) * PAGE_SIZE];
+}
+
+void mmu_unmap_boot_rom(void) {
+    if (!mmu_boot_rom_overlaid) {
+        return;
+    }
+
+    mmu_boot_rom_overlaid = false;
+    if (get_rom_bytes() != NULL) {
+        map_rom_bank(MB0, mmu_rom_banks[0]);
+    } else {
+        read_pages[PAGE(MB0)] = NULL;
+    }
+    mmu_code_page_index = PAGE_COUNT;
+
+#if defined(YOBEMAG_BLOCK_CACHE)
+    // blocks on the first page were decoded from the boot ROM
+    block_cache_invalidate(MB0);
+#endif
+    LOG_DEBUG("Unmapped the boot ROM");
+}
+
+void mmu_register_cartridge(IOWriteHandler rom_write, IOReadHandler ram_read, IOWriteHandler ram_write) {
+    rom_write_handler      = rom_write;
+    cart_ram_read_handler  = ram_read;
+    cart_ram_write_handler = ram_write;
+}
+
+void mmu_map_rom_bank(uint16_t addr, uint16_t bank) {
+    if (mmu_rom_banks[addr / ROM_BANK_SIZE] == bank) {
+        return;
+    }
+
+    map_rom_bank(addr, bank);
+
+#if defined(YOBEMAG_BLOCK_CACHE)
+    // the running block was decoded from the previous bank, blocks of the new one are cached under its number
+    ++block_cache_epoch;
+#endif
+}
+
+void mmu_map_cart_ram(uint8_t *memory, size_t available) {
+    for (size_t offset = 0; offset < CART_RAM_BANK_SIZE; offset += PAGE_SIZE) {
+        unsigned page     = PAGE(CART_RAM_START + offset);
+        uint8_t *mapped   = memory != NULL && offset < available ? &memory[offset] : NULL;
+        read_pages[page]  = mapped;
+        write_pages[page] = mapped;
+
+#if defined(YOBEMAG_BLOCK_CACHE)
+        // blocks in cart RAM are cached by address only, they were decoded from the previous bank
+        block_cache_invalidate((uint16_t) (CART_RAM_START + offset));
+#endif
+    }
+    mmu_code_page_index = PAGE_COUNT;
+}
+
+void mmu_set_io_register(uint16_t addr, uint8_t value) {
+    mem[addr] = value;
+}
+
+void mmu_register_io_write(uint16_t addr, IOWriteHandler handler) {
+    if (addr == IO_IE) {
+        ie_write_handler = handler;
+    } else if (addr >= IO_START && addr < HRAM_START) {
+        io_write_handlers[addr - IO_START] = handler;
+    } else {
+        YOBEMAG_EXIT("Cannot register a write handler for 0x%04X, which is no I/O register", addr);
+    }
+}
+
+void mmu_register_io_read(uint16_t addr, IOReadHandler handler) {
+    if (addr < IO_START || addr >= HRAM_START) {
+        YOBEMAG_EXIT("Cannot register a read handler for 0x%04X, which is no I/O register", addr);
+    }
+    io_read_handlers[addr - IO_START] = handler;
+}
+
 void mmu_stack_push(uint16_t push_value) {
     uint8_t upper = (uint8_t) (push_value >> 8);
     uint8_t lower = (uint8_t) (push_value & 0xFF);
@@ -90,6 +390,15 @@ void mmu_stack_push(uint16_t push_value) {
     LOG_DEBUG("Push %04x to %02x", push_value, cpu.SP);
 }
 
+uint16_t mmu_stack_pop(void) {
+    uint16_t value = mmu_get_two_bytes(cpu.SP);
+    cpu.SP         = (uint16_t) (cpu.SP + 2);
+
+    LOG_DEBUG("Pop %04x from %02x", value, cpu.SP);
+
+    return value;
+}
+
 void dump_hex(const uint8_t *data, size_t size) {
     unsigned char ascii[17];
     size_t i, j;
@@ -2,21 +2,191 @@
 #define YOBEMAG_MEM_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 
-#define ROM_LIMIT     (0x8000)
-#define BOOT_ROM_SIZE (256)
-#define MEM_SIZE      (65536)
+#include "rom.h"
+
+#define ROM_LIMIT          (0x8000)
+#define BOOT_ROM_SIZE      (256)
+#define MEM_SIZE           (65536)
+#define CART_RAM_START     (0xA000)
+#define CART_RAM_BANK_SIZE (0x2000)
+#define CART_RAM_LIMIT     (CART_RAM_START + CART_RAM_BANK_SIZE)
+#define IO_START           (0xFF00)
+#define IO_BOOT            (0xFF50)
+#define HRAM_START         (0xFF80)
+#define IO_REGISTERS       (HRAM_START - IO_START)
+
+#if defined(YOBEMAG_MEM_HEATMAP)
+    // reads are counted, hence the compiler must neither merge nor drop them
+    #define MMU_READ_ATTRIBUTES
+#else
+    #define MMU_READ_ATTRIBUTES __attribute__((pure))
+#endif
+
+/**
+ * @brief CPU write of @p value to the I/O register at @p addr, see ::mmu_register_io_write()
+ */
+typedef void (*IOWriteHandler)(uint16_t addr, uint8_t value);
+
+/**
+ * @brief CPU read of the I/O register at @p addr, see ::mmu_register_io_read()
+ */
+typedef uint8_t (*IOReadHandler)(uint16_t addr);
+
+/**
+ * @brief   The page instructions were last fetched from, see ::mmu_fetch_byte()
+ *
+ * @note    Owned by the MMU, which sets ::mmu_code_page_index to an invalid page whenever pages are remapped.
+ */
+extern const uint8_t *mmu_code_page;
+extern unsigned mmu_code_page_index;
+
+/**
+ * @brief   The ROM bank mapped into each region of ::ROM_BANK_SIZE bytes, and whether the boot ROM overlays the first
+ *          page of the ROM, see ::mmu_get_bank() and ::mmu_boot_rom_mapped()
+ *
+ * @note    Owned by the MMU. Exposed so that lookups made for every instruction, e.g. to record coverage, are inlined.
+ */
+extern uint16_t mmu_rom_banks[ROM_LIMIT / ROM_BANK_SIZE];
+extern bool mmu_boot_rom_overlaid;
 
 void mmu_print_memory(void);
+
+/**
+ * @brief Map the memory as at power on, with the boot ROM overlaying the first page of the ROM
+ */
 void mmu_init(void);
-__attribute__((pure)) uint8_t mmu_get_byte(uint16_t addr);
+MMU_READ_ATTRIBUTES uint8_t mmu_get_byte(uint16_t addr);
 void mmu_write_byte(uint16_t dest_addr, uint8_t value);
-__attribute__((pure)) uint16_t mmu_get_two_bytes(uint16_t addr);
+MMU_READ_ATTRIBUTES uint16_t mmu_get_two_bytes(uint16_t addr);
 void mmu_write_two_bytes(uint16_t dest_addr, uint16_t value);
+
+/**
+ * @brief Read the four bytes from @p addr on, e.g. an instruction and what follows it, the byte at @p addr being the
+ *        lowest one
+ */
+MMU_READ_ATTRIBUTES uint32_t mmu_get_four_bytes(uint16_t addr);
 void mmu_stack_push(uint16_t value);
+
+/**
+ * @brief ::mmu_get_byte() which remembers the page, refills ::mmu_code_page if @p addr is on another one
+ */
+uint8_t mmu_fetch_slow(uint16_t addr);
+
+/**
+ * @brief   Read the instruction byte at @p addr
+ *
+ * @note    Instructions are mostly fetched from the page of the previous one. Reading it from ::mmu_code_page instead
+ *          of looking it up in the page table keeps the lookup off the dependency chain from one PC to the next.
+ */
+__attribute__((always_inline)) inline uint8_t mmu_fetch_byte(uint16_t addr) {
+#if !defined(YOBEMAG_MEM_HEATMAP)
+    if (__builtin_expect((unsigned) addr >> 8 == mmu_code_page_index, 1)) {
+        return mmu_code_page[addr & 0xFF];
+    }
+#endif
+    return mmu_fetch_slow(addr);
+}
+
+/**
+ * @brief   Pop the two bytes at SP off the stack
+ *
+ * @return  The popped value, the byte at the lower address being its lower byte
+ */
+uint16_t mmu_stack_pop(void);
+
+/**
+ * @brief   Store @p value in the I/O register at @p addr without the side effects of a CPU write
+ *
+ * @note    Used by the hardware which owns the register, e.g. the PPU updating LY.
+ */
+void mmu_set_io_register(uint16_t addr, uint8_t value);
+
+/**
+ * @brief   Let @p handler perform the CPU's writes to the register at @p addr instead of storing them
+ *
+ * @param   addr    An I/O register (::IO_START up to ::HRAM_START) or IE
+ * @param   handler Stores the value with ::mmu_set_io_register() if it is readable, NULL to store writes again
+ *
+ * @note    The hardware blocks register their handlers when they are initialized, the handlers persist across
+ *          ::mmu_init().
+ */
+void mmu_register_io_write(uint16_t addr, IOWriteHandler handler);
+
+/**
+ * @brief   Let @p handler provide the value of the I/O register at @p addr, for registers which are derived from
+ *          other state when they are read (e.g. DIV from the clock)
+ *
+ * @param   handler NULL to read the stored value again
+ */
+void mmu_register_io_read(uint16_t addr, IOReadHandler handler);
+
+/**
+ * @brief   Let the cartridge handle the CPU's writes into the ROM and its accesses to cart RAM while no RAM is mapped,
+ *          see ::mmu_map_cart_ram()
+ *
+ * @param   rom_write   E.g. the bank registers of a memory bank controller, NULL to ignore writes into a mapped ROM
+ */
+void mmu_register_cartridge(IOWriteHandler rom_write, IOReadHandler ram_read, IOWriteHandler ram_write);
+
+/**
+ * @brief   Map bank @p bank of the loaded ROM into the 16K region at @p addr, where it is read in place
+ *
+ * @param   addr    0x0000 or 0x4000
+ *
+ * @note    Blocks stay cached per bank, switching banks only ends the block which is running.
+ */
+void mmu_map_rom_bank(uint16_t addr, uint16_t bank);
+
+/**
+ * @brief   Map the 8K of cart RAM from @p memory on, of which @p available bytes exist
+ *
+ * @param   memory  NULL to leave every cart RAM access to the handlers of ::mmu_register_cartridge(), e.g. while the
+ *                  RAM is disabled
+ */
+void mmu_map_cart_ram(uint8_t *memory, size_t available);
+
+/**
+ * @brief   Replace the boot ROM with the first page of the ROM, as a non-zero write to ::IO_BOOT does at the end of
+ *          the boot ROM
+ *
+ * @note    The boot ROM cannot be mapped again until ::mmu_init().
+ */
+void mmu_unmap_boot_rom(void);
+
+__attribute__((always_inline)) inline bool mmu_boot_rom_mapped(void) {
+    return mmu_boot_rom_overlaid;
+}
+
+/**
+ * @brief   Identify the memory bank which is currently mapped at @p addr
+ *
+ * @return  The ROM bank for addresses in the ROM, 0 otherwise
+ */
+__attribute__((always_inline)) inline uint16_t mmu_get_bank(uint16_t addr) {
+    return addr < ROM_LIMIT ? mmu_rom_banks[addr / ROM_BANK_SIZE] : 0;
+}
+
+/**
+ * @brief   The page tables behind ::mmu_get_byte() and ::mmu_write_byte(), indexed by the high byte of an address
+ *
+ * @note    For the JIT, which inlines their fast paths. The tables stay at the same address, their entries change
+ *          whenever memory is remapped.
+ */
+__attribute__((const)) const uint8_t *const *mmu_read_page_table(void);
+__attribute__((const)) uint8_t *const *mmu_write_page_table(void);
+
+/**
+ * @brief   The memory of the page holding HRAM, indexed by the low byte of an address
+ *
+ * @note    For the JIT, which accesses constant addresses in HRAM directly. HRAM shares its page with the I/O
+ *          registers, hence it has no entry in the page tables. Only HRAM is plain memory on this page.
+ */
+__attribute__((const)) uint8_t *mmu_hram_page(void);
 void mmu_destroy(void);
 
 #endif // YOBEMAG_MEM_H
@@ -0,0 +1,89 @@
+#if defined(YOBEMAG_PROFILE)
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "opcode_profile.h"
+
+/******************************************************
+ *** LOCAL VARIABLES                                ***
+ ******************************************************/
+
+// Entries of the report: the 256 opcodes followed by the 256 CB prefixed ones
+#define PROFILE_ENTRIES (0x200)
+#define CB_ENTRY        (0x100)
+
+// Characters of a bar that represents all cycles
+#define BAR_WIDTH (50)
+
+OpcodeProfile opcode_profile;
+
+/******************************************************
+ *** LOCAL METHODS                                  ***
+ ******************************************************/
+
+__attribute__((pure)) static uint64_t entry_count(unsigned entry) {
+    return entry < CB_ENTRY ? opcode_profile.count[entry] : opcode_profile.cb_count[entry - CB_ENTRY];
+}
+
+__attribute__((pure)) static uint64_t entry_cycles(unsigned entry) {
+    return entry < CB_ENTRY ? opcode_profile.cycles[entry] : opcode_profile.cb_cycles[entry - CB_ENTRY];
+}
+
+// Most cycles first, ties in opcode order
+static int compare_entries(const void *lhs, const void *rhs) {
+    unsigned a = *(const unsigned *) lhs;
+    unsigned b = *(const unsigned *) rhs;
+
+    if (entry_cycles(a) != entry_cycles(b)) {
+        return entry_cycles(a) > entry_cycles(b) ? -1 : 1;
+    }
+    return a < b ? -1 : 1;
+}
+
+/******************************************************
+ *** EXPOSED METHODS                                ***
+ ******************************************************/
+
+void opcode_profile_reset(void) {
+    memset(&opcode_profile, 0, sizeof(opcode_profile));
+}
+
+void opcode_profile_report(FILE *stream) {
+    unsigned entries[PROFILE_ENTRIES];
+    unsigned executed     = 0;
+    uint64_t total_cycles = 0;
+
+    for (unsigned entry = 0; entry < PROFILE_ENTRIES; ++entry) {
+        if (entry_count(entry) != 0) {
+            entries[executed++] = entry;
+            total_cycles        = total_cycles + entry_cycles(entry);
+        }
+    }
+    qsort(entries, executed, sizeof(entries[0]), compare_entries);
+
+    fprintf(stream, "Opcode profile: %u opcodes executed in %" PRIu64 " cycles\n", executed, total_cycles);
+    fprintf(stream, "%-6s %14s %14s %7s %6s\n", "opcode", "executions", "cycles", "cycles%", "avg");
+    for (unsigned i = 0; i < executed; ++i) {
+        unsigned entry  = entries[i];
+        uint64_t count  = entry_count(entry);
+        uint64_t cycles = entry_cycles(entry);
+        double share    = (double) cycles / (double) total_cycles;
+
+        char bar[BAR_WIDTH + 1];
+        size_t length = (size_t) (share * BAR_WIDTH + 0.5);
+        memset(bar, '#', length);
+        bar[length] = '\0';
+
+        if (entry < CB_ENTRY) {
+            fprintf(stream, "%02X    ", entry);
+        } else {
+            fprintf(stream, "CB %02X ", entry - CB_ENTRY);
+        }
+        fprintf(stream, " %14" PRIu64 " %14" PRIu64 " %6.2f%% %6.2f %s\n", count, cycles, share * 100,
+                (double) cycles / (double) count, bar);
+    }
+}
+
+#endif // defined(YOBEMAG_PROFILE)
@@ -0,0 +1,63 @@
+#ifndef YOBEMAG_OPCODE_PROFILE_H
+#define YOBEMAG_OPCODE_PROFILE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#if defined(YOBEMAG_PROFILE)
+
+    #include "cpu.h"
+
+/**
+ * @brief Executions and cycles of every opcode, CB prefixed instructions are counted by their second byte.
+ *        Plain counters, the CPU is only ever run by a single thread.
+ */
+typedef struct OpcodeProfile {
+    uint64_t count[0x100];
+    uint64_t cycles[0x100];
+    uint64_t cb_count[0x100];
+    uint64_t cb_cycles[0x100];
+} OpcodeProfile;
+
+extern OpcodeProfile opcode_profile;
+
+__attribute__((always_inline)) inline void opcode_profile_record(uint8_t opcode, uint16_t operand, uint64_t cycles) {
+    if (opcode == 0xCB) {
+        ++opcode_profile.cb_count[(uint8_t) operand];
+        opcode_profile.cb_cycles[(uint8_t) operand] += cycles;
+    } else {
+        ++opcode_profile.count[opcode];
+        opcode_profile.cycles[opcode] += cycles;
+    }
+}
+
+    // Clock before the instruction being executed, declared once per executor
+    #define OPCODE_PROFILE_DECLARE() uint64_t opcode_profile_clock = 0
+    #define OPCODE_PROFILE_BEGIN()   (opcode_profile_clock = cpu.cycle_count)
+    #define OPCODE_PROFILE_END()                                                                                        \
+        opcode_profile_record(cpu.opcode, cpu.operand, cpu.cycle_count - opcode_profile_clock)
+    // Cycles a handler added to the clock without executing them, e.g. skipped idle loop passes
+    #define OPCODE_PROFILE_DISCOUNT(skipped) (opcode_profile.cycles[cpu.opcode] -= (skipped))
+
+/**
+ * @brief Clear all counters
+ */
+void opcode_profile_reset(void);
+
+/**
+ * @brief   Write a table of all executed opcodes to @p stream, sorted by the cycles spent in them
+ *
+ * @note    Each line has the executions, the cycles, their share of all cycles and a bar of that share.
+ */
+void opcode_profile_report(FILE *stream);
+
+#else
+
+    #define OPCODE_PROFILE_DECLARE()
+    #define OPCODE_PROFILE_BEGIN()
+    #define OPCODE_PROFILE_END()
+    #define OPCODE_PROFILE_DISCOUNT(skipped)
+
+#endif // defined(YOBEMAG_PROFILE)
+
+#endif // YOBEMAG_OPCODE_PROFILE_H
@@ -0,0 +1,286 @@
+#define LOG_CATEGORY LOG_CAT_CPU
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+
+#include "pc_profiler.h"
+#include "cpu.h"
+#include "mmu.h"
+#include "scheduler.h"
+#include "log.h"
+
+/******************************************************
+ *** LOCAL VARIABLES                                ***
+ ******************************************************/
+
+// Distinct stacks that are counted, must be a power of two. Samples of further stacks are dropped.
+#define STACK_TABLE_SIZE (8192)
+
+#define SYMBOL_NAME_LEN (128)
+
+// Bank and address of a code location, ordered like the symbols
+#define LOCATION(bank, addr) ((uint32_t) (bank) << 16 | (addr))
+
+typedef struct Frame {
+    uint32_t return_location;
+    /**
+     * @brief SP after the return address was pushed, the frame is gone once SP is above it
+     */
+    uint16_t sp;
+} Frame;
+
+/**
+ * @brief A distinct sampled stack: the return locations of its frames, outermost first, followed by the PC
+ */
+typedef struct StackSample {
+    uint32_t count;
+    uint8_t depth;
+    uint32_t locations[PC_PROFILER_MAX_DEPTH + 1];
+} StackSample;
+
+typedef struct Symbol {
+    uint32_t location;
+    char name[SYMBOL_NAME_LEN];
+} Symbol;
+
+bool pc_profiler_enabled;
+
+static Frame frames[PC_PROFILER_MAX_DEPTH];
+static uint8_t depth;
+// Frames beyond PC_PROFILER_MAX_DEPTH, they are dropped by pc_profiler_pop() like any other
+static uint64_t frames_dropped;
+
+static StackSample *stacks;
+static uint64_t samples_dropped;
+
+static Symbol *symbols;
+static size_t symbol_count;
+
+static FILE *output;
+
+/******************************************************
+ *** LOCAL METHODS                                  ***
+ ******************************************************/
+
+__attribute__((pure)) static uint32_t hash_stack(const uint32_t *locations, uint8_t count) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (uint8_t i = 0; i < count; ++i) {
+        hash = (hash ^ locations[i]) * 16777619u;
+    }
+
+    return hash;
+}
+
+static void record_sample(const uint32_t *locations, uint8_t count) {
+    uint32_t slot = hash_stack(locations, count) & (STACK_TABLE_SIZE - 1);
+
+    // linear probing, an empty slot ends the search
+    for (uint32_t probe = 0; probe < STACK_TABLE_SIZE; ++probe) {
+        StackSample *stack = &stacks[(slot + probe) & (STACK_TABLE_SIZE - 1)];
+        if (stack->count == 0) {
+            stack->depth = count;
+            memcpy(stack->locations, locations, count * sizeof(locations[0]));
+        }
+        if (stack->depth == count && memcmp(stack->locations, locations, count * sizeof(locations[0])) == 0) {
+            ++stack->count;
+            return;
+        }
+    }
+
+    ++samples_dropped;
+}
+
+// Symbols have no size, hence a label never covers addresses in another region (ROM0, ROMX, 4 KiB RAM blocks)
+__attribute__((const)) static inline unsigned memory_region(uint16_t addr) {
+    return addr < ROM_LIMIT ? addr >> 14 : addr >> 12;
+}
+
+__attribute__((pure)) static const Symbol *find_symbol(uint32_t location) {
+    // find the last symbol at or before location
+    size_t low  = 0;
+    size_t high = symbol_count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (symbols[mid].location <= location) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    if (low == 0) {
+        return NULL;
+    }
+
+    const Symbol *symbol = &symbols[low - 1];
+    if (symbol->location >> 16 != location >> 16 ||
+        memory_region((uint16_t) symbol->location) != memory_region((uint16_t) location)) {
+        return NULL;
+    }
+    return symbol;
+}
+
+// Samples in the same function are counted together, code without a symbol is counted per address
+__attribute__((pure)) static uint32_t function_location(uint32_t location) {
+    const Symbol *symbol = find_symbol(location);
+
+    return symbol != NULL ? symbol->location : location;
+}
+
+static void pc_profiler_sample(uint64_t deadline) {
+    uint32_t locations[PC_PROFILER_MAX_DEPTH + 1];
+
+    for (uint8_t i = 0; i < depth; ++i) {
+        locations[i] = function_location(frames[i].return_location);
+    }
+    locations[depth] = function_location(LOCATION(mmu_get_bank(cpu.PC), cpu.PC));
+    record_sample(locations, (uint8_t) (depth + 1));
+
+    scheduler_schedule(EVENT_PROFILE_SAMPLE, deadline + PC_PROFILER_PERIOD);
+}
+
+static int compare_symbols(const void *lhs, const void *rhs) {
+    uint32_t a = ((const Symbol *) lhs)->location;
+    uint32_t b = ((const Symbol *) rhs)->location;
+
+    return (a > b) - (a < b);
+}
+
+/**
+ * Reads the `bank:addr name` lines of an RGBDS symbol file. Local labels (`Function.loop`) are skipped, so that
+ * samples are attributed to the function they belong to.
+ */
+static void load_symbols(const char *sym_path) {
+    FILE *file = fopen(sym_path, "r");
+    if (file == NULL) {
+        YOBEMAG_EXIT("Could not open symbol file %s: %s", sym_path, strerror(errno));
+    }
+
+    size_t capacity = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        unsigned bank;
+        unsigned addr;
+        char name[SYMBOL_NAME_LEN];
+        // comments start with ';', the format string limits the name to SYMBOL_NAME_LEN - 1 characters
+        if (line[0] == ';' || sscanf(line, "%x:%x %127s", &bank, &addr, name) != 3 || strchr(name, '.') != NULL) {
+            continue;
+        }
+
+        if (symbol_count == capacity) {
+            capacity = capacity ? 2 * capacity : 256;
+            symbols  = realloc(symbols, capacity * sizeof(Symbol));
+            if (symbols == NULL) {
+                YOBEMAG_EXIT("Could not allocate %zu symbols", capacity);
+            }
+        }
+        symbols[symbol_count].location = LOCATION(bank & 0xFFFF, addr & 0xFFFF);
+        strcpy(symbols[symbol_count].name, name);
+        ++symbol_count;
+    }
+    fclose(file);
+
+    qsort(symbols, symbol_count, sizeof(Symbol), compare_symbols);
+    LOG_INFO("Loaded %zu symbols from %s", symbol_count, sym_path);
+}
+
+static void write_location(uint32_t location) {
+    const Symbol *symbol = find_symbol(location);
+
+    if (symbol != NULL) {
+        fputs(symbol->name, output);
+    } else {
+        fprintf(output, "%02X:%04X", location >> 16, location & 0xFFFF);
+    }
+}
+
+/******************************************************
+ *** EXPOSED METHODS                                ***
+ ******************************************************/
+
+void pc_profiler_init(const char *output_path, const char *sym_path) {
+    output = fopen(output_path, "w");
+    if (output == NULL) {
+        YOBEMAG_EXIT("Could not open profile output %s: %s", output_path, strerror(errno));
+    }
+
+    stacks = calloc(STACK_TABLE_SIZE, sizeof(StackSample));
+    if (stacks == NULL) {
+        YOBEMAG_EXIT("Could not allocate the profiler's stack table");
+    }
+
+    if (sym_path != NULL) {
+        load_symbols(sym_path);
+    }
+
+    depth               = 0;
+    frames_dropped      = 0;
+    samples_dropped     = 0;
+    pc_profiler_enabled = true;
+    scheduler_register(EVENT_PROFILE_SAMPLE, pc_profiler_sample);
+    scheduler_schedule(EVENT_PROFILE_SAMPLE, cpu.cycle_count + PC_PROFILER_PERIOD);
+}
+
+void pc_profiler_teardown(void) {
+    if (!pc_profiler_enabled) {
+        return;
+    }
+
+    uint64_t samples = 0;
+    for (size_t i = 0; i < STACK_TABLE_SIZE; ++i) {
+        const StackSample *stack = &stacks[i];
+        if (stack->count == 0) {
+            continue;
+        }
+
+        for (uint8_t frame = 0; frame < stack->depth; ++frame) {
+            if (frame != 0) {
+                fputc(';', output);
+            }
+            write_location(stack->locations[frame]);
+        }
+        fprintf(output, " %u\n", stack->count);
+        samples = samples + stack->count;
+    }
+
+    LOG_INFO("Wrote %" PRIu64 " samples, dropped %" PRIu64 " samples and %" PRIu64 " frames", samples, samples_dropped,
+             frames_dropped);
+
+    scheduler_cancel(EVENT_PROFILE_SAMPLE);
+    fclose(output);
+    free(stacks);
+    free(symbols);
+    output              = NULL;
+    stacks              = NULL;
+    symbols             = NULL;
+    symbol_count        = 0;
+    pc_profiler_enabled = false;
+}
+
+void pc_profiler_push(uint16_t return_addr) {
+    if (depth == PC_PROFILER_MAX_DEPTH) {
+        ++frames_dropped;
+        return;
+    }
+
+    frames[depth].return_location = LOCATION(mmu_get_bank(return_addr), return_addr);
+    frames[depth].sp              = cpu.SP;
+    ++depth;
+}
+
+void pc_profiler_pop(void) {
+    // also drops frames which were left without a return, e.g. by popping the return address and jumping
+    while (depth != 0 && frames[depth - 1].sp < cpu.SP) {
+        --depth;
+    }
+}
+
+const char *pc_profiler_symbol(uint16_t bank, uint16_t addr) {
+    const Symbol *symbol = find_symbol(LOCATION(bank, addr));
+
+    return symbol != NULL ? symbol->name : NULL;
+}
@@ -0,0 +1,69 @@
+#ifndef YOBEMAG_PC_PROFILER_H
+#define YOBEMAG_PC_PROFILER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Cycles between two samples of the PC and the call stack
+ */
+#define PC_PROFILER_PERIOD (4096)
+
+/**
+ * @brief Deepest call stack that is recorded, calls beyond it are attributed to their caller
+ */
+#define PC_PROFILER_MAX_DEPTH (32)
+
+/**
+ * @brief Set by ::pc_profiler_init(), CALL, RST, RET and interrupts only maintain the shadow call stack while true
+ */
+extern bool pc_profiler_enabled;
+
+/**
+ * @brief   Start sampling the PC and the call stack every ::PC_PROFILER_PERIOD cycles
+ *
+ * @param   output_path Collapsed stacks (`caller;callee;leaf count` per line) are written there by
+ *                      ::pc_profiler_teardown(), e.g. for flamegraph.pl
+ * @param   sym_path    RGBDS symbol file (`bank:addr name` per line) to name the functions, NULL to print
+ *                      addresses as `bank:addr` instead
+ *
+ * @note    Must be called after ::cpu_init() and ::scheduler_init(), exits if a file cannot be opened.
+ */
+void pc_profiler_init(const char *output_path, const char *sym_path);
+
+/**
+ * @brief Write the collapsed stacks and release everything, does nothing if the profiler is not running
+ */
+void pc_profiler_teardown(void);
+
+/**
+ * @brief A call, restart or interrupt just pushed @p return_addr, it becomes a frame of the shadow call stack
+ */
+void pc_profiler_push(uint16_t return_addr);
+
+/**
+ * @brief A return just popped its address, drops all frames whose return address is no longer on the stack
+ */
+void pc_profiler_pop(void);
+
+/**
+ * @brief   Name of the function containing @p addr in @p bank: the closest global label at or before it
+ *          within the same memory region
+ *
+ * @return  The label or NULL if no symbols are loaded or none precedes @p addr in @p bank
+ */
+__attribute__((pure)) const char *pc_profiler_symbol(uint16_t bank, uint16_t addr);
+
+__attribute__((always_inline)) inline void pc_profiler_call(uint16_t return_addr) {
+    if (__builtin_expect(pc_profiler_enabled, 0)) {
+        pc_profiler_push(return_addr);
+    }
+}
+
+__attribute__((always_inline)) inline void pc_profiler_return(void) {
+    if (__builtin_expect(pc_profiler_enabled, 0)) {
+        pc_profiler_pop();
+    }
+}
+
+#endif // YOBEMAG_PC_PROFILER_H
@@ -0,0 +1,195 @@
+#define LOG_CATEGORY LOG_CAT_CPU
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "perf_counters.h"
+#include "log.h"
+
+/******************************************************
+ *** LOCAL VARIABLES                                ***
+ ******************************************************/
+
+// Slices the sample buffer initially has room for, about a minute of frames
+#define INITIAL_SLICES (4096)
+
+typedef struct CounterConfig {
+    const char *name;
+    uint32_t type;
+    uint64_t config;
+} CounterConfig;
+
+static const CounterConfig counter_configs[PERF_COUNTER_COUNT] = {
+    [PERF_COUNTER_CYCLES]        = {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    [PERF_COUNTER_INSTRUCTIONS]  = {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    [PERF_COUNTER_BRANCH_MISSES] = {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    [PERF_COUNTER_ICACHE_MISSES] = {"L1-icache-misses", PERF_TYPE_HW_CACHE,
+                                    PERF_COUNT_HW_CACHE_L1I | PERF_COUNT_HW_CACHE_OP_READ << 8 |
+                                        PERF_COUNT_HW_CACHE_RESULT_MISS << 16},
+    [PERF_COUNTER_TASK_CLOCK]    = {"task-clock (ns)", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+};
+
+// -1 for counters which are not open
+static int fds[PERF_COUNTER_COUNT] = {-1, -1, -1, -1, -1};
+static uint64_t slice_start[PERF_COUNTER_COUNT];
+
+// Deltas of every recorded slice, PERF_COUNTER_COUNT per slice
+static uint64_t *slices;
+static size_t slice_count;
+static size_t slice_capacity;
+
+/******************************************************
+ *** LOCAL METHODS                                  ***
+ ******************************************************/
+
+static int open_counter(const CounterConfig *counter) {
+    struct perf_event_attr attr = {
+        .size           = sizeof(attr),
+        .type           = counter->type,
+        .config         = counter->config,
+        .exclude_kernel = 1,
+        .exclude_hv     = 1,
+    };
+    // this thread on any CPU, glibc has no wrapper
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static void read_counters(uint64_t values[PERF_COUNTER_COUNT]) {
+    for (unsigned counter = 0; counter < PERF_COUNTER_COUNT; ++counter) {
+        if (fds[counter] != -1 && read(fds[counter], &values[counter], sizeof(values[counter])) != sizeof(uint64_t)) {
+            values[counter] = 0;
+        }
+    }
+}
+
+static int compare_doubles(const void *lhs, const void *rhs) {
+    double a = *(const double *) lhs;
+    double b = *(const double *) rhs;
+    return (a > b) - (a < b);
+}
+
+// Nearest-rank percentile of the sorted @p values
+__attribute__((pure)) static double percentile(const double *values, size_t count, unsigned p) {
+    size_t rank = (count * p + 99) / 100;
+    return values[rank > 0 ? rank - 1 : 0];
+}
+
+static void report_metric(FILE *stream, const char *name, double *values) {
+    qsort(values, slice_count, sizeof(values[0]), compare_doubles);
+    fprintf(stream, "%-18s %14.2f %14.2f %14.2f %14.2f\n", name, percentile(values, slice_count, 50),
+            percentile(values, slice_count, 90), percentile(values, slice_count, 99), values[slice_count - 1]);
+}
+
+__attribute__((pure)) static double slice_value(size_t slice, PerfCounter counter) {
+    return (double) slices[slice * PERF_COUNTER_COUNT + counter];
+}
+
+/******************************************************
+ *** EXPOSED METHODS                                ***
+ ******************************************************/
+
+bool perf_counters_init(void) {
+    bool any_open = false;
+    for (unsigned counter = 0; counter < PERF_COUNTER_COUNT; ++counter) {
+        fds[counter] = open_counter(&counter_configs[counter]);
+        if (fds[counter] == -1) {
+            LOG_WARNING("Counter %s is not available: %s", counter_configs[counter].name, strerror(errno));
+        }
+        any_open = any_open || fds[counter] != -1;
+    }
+
+    slice_count    = 0;
+    slice_capacity = INITIAL_SLICES;
+    slices         = malloc(slice_capacity * PERF_COUNTER_COUNT * sizeof(slices[0]));
+    if (slices == NULL) {
+        YOBEMAG_EXIT("Could not allocate the performance counter samples");
+    }
+
+    return any_open;
+}
+
+void perf_counters_teardown(void) {
+    for (unsigned counter = 0; counter < PERF_COUNTER_COUNT; ++counter) {
+        if (fds[counter] != -1) {
+            close(fds[counter]);
+            fds[counter] = -1;
+        }
+    }
+
+    free(slices);
+    slices      = NULL;
+    slice_count = 0;
+}
+
+void perf_counters_begin(void) {
+    read_counters(slice_start);
+}
+
+void perf_counters_end(void) {
+    uint64_t deltas[PERF_COUNTER_COUNT];
+    read_counters(deltas);
+    for (unsigned counter = 0; counter < PERF_COUNTER_COUNT; ++counter) {
+        deltas[counter] -= slice_start[counter];
+    }
+
+    perf_counters_record(deltas);
+}
+
+void perf_counters_record(const uint64_t deltas[PERF_COUNTER_COUNT]) {
+    if (slice_count == slice_capacity) {
+        slice_capacity *= 2;
+        slices = realloc(slices, slice_capacity * PERF_COUNTER_COUNT * sizeof(slices[0]));
+        if (slices == NULL) {
+            YOBEMAG_EXIT("Could not grow the performance counter samples");
+        }
+    }
+
+    memcpy(&slices[slice_count * PERF_COUNTER_COUNT], deltas, PERF_COUNTER_COUNT * sizeof(slices[0]));
+    ++slice_count;
+}
+
+void perf_counters_report(FILE *stream) {
+    fprintf(stream, "Host performance counters per slice: %zu slices\n", slice_count);
+    if (slice_count == 0) {
+        return;
+    }
+
+    double *values = malloc(slice_count * sizeof(values[0]));
+    if (values == NULL) {
+        YOBEMAG_EXIT("Could not allocate the performance counter report");
+    }
+
+    fprintf(stream, "%-18s %14s %14s %14s %14s\n", "counter", "p50", "p90", "p99", "max");
+    for (unsigned counter = 0; counter < PERF_COUNTER_COUNT; ++counter) {
+        if (fds[counter] == -1) {
+            continue;
+        }
+        for (size_t slice = 0; slice < slice_count; ++slice) {
+            values[slice] = slice_value(slice, (PerfCounter) counter);
+        }
+        report_metric(stream, counter_configs[counter].name, values);
+    }
+
+    // ratios are computed per slice, so that a few long slices do not hide the typical one
+    if (fds[PERF_COUNTER_INSTRUCTIONS] != -1 && fds[PERF_COUNTER_CYCLES] != -1) {
+        for (size_t slice = 0; slice < slice_count; ++slice) {
+            double cycles = slice_value(slice, PERF_COUNTER_CYCLES);
+            values[slice] = cycles > 0 ? slice_value(slice, PERF_COUNTER_INSTRUCTIONS) / cycles : 0;
+        }
+        report_metric(stream, "IPC", values);
+    }
+    if (fds[PERF_COUNTER_INSTRUCTIONS] != -1 && fds[PERF_COUNTER_BRANCH_MISSES] != -1) {
+        for (size_t slice = 0; slice < slice_count; ++slice) {
+            double instructions = slice_value(slice, PERF_COUNTER_INSTRUCTIONS);
+            values[slice] = instructions > 0 ? 1000 * slice_value(slice, PERF_COUNTER_BRANCH_MISSES) / instructions : 0;
+        }
+        report_metric(stream, "branch-misses/1k", values);
+    }
+
+    free(values);
+}
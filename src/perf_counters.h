@@ -0,0 +1,56 @@
+#ifndef YOBEMAG_PERF_COUNTERS_H
+#define YOBEMAG_PERF_COUNTERS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/**
+ * @brief Host counters which are read around every cpu_run() slice, each one is optional
+ */
+typedef enum PerfCounter {
+    PERF_COUNTER_CYCLES,
+    PERF_COUNTER_INSTRUCTIONS,
+    PERF_COUNTER_BRANCH_MISSES,
+    PERF_COUNTER_ICACHE_MISSES,
+    /**
+     * @brief ns the emulator ran on a host CPU, available even where the hardware counters are not (e.g. in VMs)
+     */
+    PERF_COUNTER_TASK_CLOCK,
+    PERF_COUNTER_COUNT
+} PerfCounter;
+
+/**
+ * @brief   Open the counters for the calling thread with perf_event_open, counting user space only
+ *
+ * @return  Whether any counter could be opened. Counters the host does not support (or forbids, see
+ *          `/proc/sys/kernel/perf_event_paranoid`) are left out of the report.
+ */
+bool perf_counters_init(void);
+
+/**
+ * @brief Close the counters and drop the recorded slices, does nothing if not initialized
+ */
+void perf_counters_teardown(void);
+
+/**
+ * @brief Start measuring a slice, e.g. before the cpu_run() of a frame
+ */
+void perf_counters_begin(void);
+
+/**
+ * @brief End the slice started by ::perf_counters_begin() and record what the counters advanced by during it
+ */
+void perf_counters_end(void);
+
+/**
+ * @brief Record a slice during which the counters advanced by @p deltas, the ones that are not open are ignored
+ */
+void perf_counters_record(const uint64_t deltas[PERF_COUNTER_COUNT]);
+
+/**
+ * @brief Print p50, p90, p99 and max per slice of every open counter, IPC and branch misses per 1000 instructions
+ */
+void perf_counters_report(FILE *stream);
+
+#endif // YOBEMAG_PERF_COUNTERS_H
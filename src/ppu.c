@@ -0,0 +1,177 @@
+#define LOG_CATEGORY LOG_CAT_LCD
+
+#include <stdbool.h>
+
+#include "ppu.h"
+#include "mmu.h"
+#include "interrupt.h"
+#include "log.h"
+#include "cpu.h"
+#include "scheduler.h"
+#include "timeline.h"
+
+/******************************************************
+ *** LOCAL VARIABLES                                ***
+ ******************************************************/
+
+#define STAT_MODE_MASK  (0x03)
+#define STAT_COINCIDENT (0x04)
+// Mode and coincidence flag are set by the PPU only, the unused bit 7 always reads as 1
+#define STAT_READ_ONLY (STAT_MODE_MASK | STAT_COINCIDENT)
+#define STAT_UNUSED    (0x80)
+
+// Duration of each mode within a visible line, HBlank takes the rest of the line
+#define OAM_SCAN_CYCLES (80)
+#define TRANSFER_CYCLES (172)
+#define HBLANK_CYCLES   (CYCLES_PER_LINE - OAM_SCAN_CYCLES - TRANSFER_CYCLES)
+
+static const char *const mode_names[] = {
+    [PPU_MODE_HBLANK]   = "HBlank",
+    [PPU_MODE_VBLANK]   = "VBlank",
+    [PPU_MODE_OAM_SCAN] = "OAM scan",
+    [PPU_MODE_TRANSFER] = "pixel transfer",
+};
+
+static PPUMode mode;
+static uint8_t ly;
+static bool enabled;
+
+// Cycles at which the current mode, line and frame began, for the timeline
+static uint64_t mode_start;
+static uint64_t line_start;
+static uint64_t frame_start;
+
+/******************************************************
+ *** LOCAL METHODS                                  ***
+ ******************************************************/
+
+static void set_mode(PPUMode next) {
+    mode         = next;
+    uint8_t stat = mmu_get_byte(PPU_STAT);
+    mmu_set_io_register(PPU_STAT, (uint8_t) ((stat & (uint8_t) ~STAT_MODE_MASK) | (uint8_t) next));
+}
+
+static void set_ly(uint8_t line) {
+    ly           = line;
+    uint8_t stat = mmu_get_byte(PPU_STAT) & (uint8_t) ~STAT_COINCIDENT;
+    if (ly == mmu_get_byte(PPU_LYC)) {
+        stat |= STAT_COINCIDENT;
+    }
+
+    mmu_set_io_register(PPU_LY, ly);
+    mmu_set_io_register(PPU_STAT, stat);
+}
+
+static void start_frame(uint64_t now) {
+    mode_start  = now;
+    line_start  = now;
+    frame_start = now;
+    set_ly(0);
+    set_mode(PPU_MODE_OAM_SCAN);
+    scheduler_schedule(EVENT_PPU_MODE, now + OAM_SCAN_CYCLES);
+}
+
+// A line ends when HBlank ends and every 456 cycles during VBlank
+static void end_line(uint64_t deadline) {
+    timeline_cycles(TIMELINE_PPU, "line", line_start, deadline, "ly", ly);
+    line_start = deadline;
+}
+
+// Advance to the mode after the current one, which ended at `deadline`
+static void ppu_mode_change(uint64_t deadline) {
+    timeline_cycles(TIMELINE_PPU, mode_names[mode], mode_start, deadline, "ly", ly);
+    mode_start = deadline;
+
+    switch (mode) {
+        case PPU_MODE_OAM_SCAN:
+            set_mode(PPU_MODE_TRANSFER);
+            scheduler_schedule(EVENT_PPU_MODE, deadline + TRANSFER_CYCLES);
+            break;
+        case PPU_MODE_TRANSFER:
+            set_mode(PPU_MODE_HBLANK);
+            scheduler_schedule(EVENT_PPU_MODE, deadline + HBLANK_CYCLES);
+            break;
+        case PPU_MODE_HBLANK:
+            end_line(deadline);
+            set_ly((uint8_t) (ly + 1));
+            if (ly == VISIBLE_LINES) {
+                set_mode(PPU_MODE_VBLANK);
+                interrupt_request(IF_VBLANK);
+                scheduler_schedule(EVENT_PPU_MODE, deadline + CYCLES_PER_LINE);
+            } else {
+                set_mode(PPU_MODE_OAM_SCAN);
+                scheduler_schedule(EVENT_PPU_MODE, deadline + OAM_SCAN_CYCLES);
+            }
+            break;
+        case PPU_MODE_VBLANK:
+            end_line(deadline);
+            if (ly + 1 == LINES_PER_FRAME) {
+                timeline_cycles(TIMELINE_PPU, "frame", frame_start, deadline, NULL, 0);
+                start_frame(deadline);
+            } else {
+                set_ly((uint8_t) (ly + 1));
+                scheduler_schedule(EVENT_PPU_MODE, deadline + CYCLES_PER_LINE);
+            }
+            break;
+        default:
+            LOG_ERROR("Invalid PPU mode %d", mode);
+            break;
+    }
+}
+
+static void lcdc_write(uint16_t addr, uint8_t value) {
+    mmu_set_io_register(addr, value);
+    ppu_write_lcdc(value);
+}
+
+static void stat_write(uint16_t addr, uint8_t value) {
+    uint8_t stat = mmu_get_byte(addr);
+    mmu_set_io_register(addr, (uint8_t) ((value & ~STAT_READ_ONLY) | (stat & STAT_READ_ONLY) | STAT_UNUSED));
+}
+
+static void ly_write(uint16_t addr, uint8_t value) {
+    // read-only
+    (void) addr;
+    (void) value;
+}
+
+// The transfer is done at once instead of over 160 machine cycles
+static void dma_write(uint16_t addr, uint8_t value) {
+    mmu_set_io_register(addr, value);
+
+    uint16_t source = (uint16_t) (value << 8);
+    for (uint16_t offset = 0; offset < OAM_LENGTH; ++offset) {
+        mmu_write_byte(OAM_START + offset, mmu_get_byte(source + offset));
+    }
+}
+
+/******************************************************
+ *** EXPOSED METHODS                                ***
+ ******************************************************/
+
+void ppu_init(void) {
+    enabled = false;
+    scheduler_register(EVENT_PPU_MODE, ppu_mode_change);
+    mmu_register_io_write(PPU_LCDC, lcdc_write);
+    mmu_register_io_write(PPU_STAT, stat_write);
+    mmu_register_io_write(PPU_LY, ly_write);
+    mmu_register_io_write(PPU_DMA, dma_write);
+    ppu_write_lcdc(mmu_get_byte(PPU_LCDC));
+}
+
+void ppu_write_lcdc(uint8_t value) {
+    bool enable = value & LCDC_ENABLE;
+    if (enable == enabled) {
+        return;
+    }
+
+    enabled = enable;
+    if (enabled) {
+        start_frame(cpu.cycle_count);
+    } else {
+        // LY stays at 0 and STAT reports HBlank while the LCD is off
+        scheduler_cancel(EVENT_PPU_MODE);
+        set_ly(0);
+        set_mode(PPU_MODE_HBLANK);
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef YOBEMAG_PPU_H
+#define YOBEMAG_PPU_H
+
+#include <stdint.h>
+
+#define PPU_LCDC (0xFF40)
+#define PPU_STAT (0xFF41)
+#define PPU_LY   (0xFF44)
+#define PPU_LYC  (0xFF45)
+#define PPU_DMA  (0xFF46)
+
+#define OAM_START  (0xFE00)
+#define OAM_LENGTH (0xA0)
+
+#define LCDC_ENABLE (0x80)
+
+#define CYCLES_PER_LINE  (456)
+#define VISIBLE_LINES    (144)
+#define LINES_PER_FRAME  (154)
+#define CYCLES_PER_FRAME (CYCLES_PER_LINE * LINES_PER_FRAME)
+
+/**
+ * @brief Mode of the PPU, as reported in the lower two bits of STAT
+ */
+typedef enum PPUMode {
+    PPU_MODE_HBLANK   = 0,
+    PPU_MODE_VBLANK   = 1,
+    PPU_MODE_OAM_SCAN = 2,
+    PPU_MODE_TRANSFER = 3,
+} PPUMode;
+
+/**
+ * @brief Register the mode change event and the PPU's registers and start the PPU at line 0 if the LCD is enabled
+ *        in LCDC, requires ::scheduler_init()
+ */
+void ppu_init(void);
+
+/**
+ * @brief CPU write of @p value to LCDC, switching the LCD on or off starts or stops the mode change events
+ */
+void ppu_write_lcdc(uint8_t value);
+
+#endif // YOBEMAG_PPU_H
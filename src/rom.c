@@ -1,3 +1,5 @@
+#define LOG_CATEGORY LOG_CAT_ROM
+
 #include <stdio.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -16,6 +18,7 @@
 #define ROM_TITLE_START_ADDR (0x134)
 #define CARTRIDGE_TYPE_ADDR  (0x147)
 #define CARTRIDGE_SIZE_ADDR  (0x148)
+#define CARTRIDGE_RAM_ADDR   (0x149)
 
 static const char *cartridge_types[0xFF + 1] = {
     [0x00] = "ROM ONLY",
@@ -58,8 +61,14 @@ static const char *rom_sizes[] = {
     [0x52] = "1.1MByte (72 banks)",      [0x53] = "1.2MByte (80 banks)", [0x54] = "1.5MByte (96 banks)",
 };
 
+static const size_t ram_sizes[] = {
+    [0x00] = 0, [0x01] = 0x800, [0x02] = 0x2000, [0x03] = 0x8000, [0x04] = 0x20000, [0x05] = 0x10000,
+};
+
 static uint8_t *rom_bytes = NULL;
 static size_t rom_size;
+static uint8_t cartridge_type;
+static size_t cartridge_ram_size;
 
 /******************************************************
  *** LOCAL METHODS                                  ***
@@ -71,11 +80,20 @@ static void rom_setup(void) {
     title[ROM_TITLE_LEN - 1] = '\0';
     LOG_INFO("Rom title: %s", title);
 
-    uint8_t type = rom_bytes[CARTRIDGE_TYPE_ADDR];
-    LOG_INFO("Cartridge type: %s (%02x)", cartridge_types[type], type);
+    cartridge_type = rom_bytes[CARTRIDGE_TYPE_ADDR];
+    LOG_INFO("Cartridge type: %s (%02x)", cartridge_types[cartridge_type], cartridge_type);
 
     uint8_t rom_size_index = rom_bytes[CARTRIDGE_SIZE_ADDR];
     LOG_INFO("Cartridge rom size: %s (%02x)", rom_sizes[rom_size_index], rom_size_index);
+
+    uint8_t ram_size_index = rom_bytes[CARTRIDGE_RAM_ADDR];
+    if (ram_size_index < sizeof(ram_sizes) / sizeof(ram_sizes[0])) {
+        cartridge_ram_size = ram_sizes[ram_size_index];
+    } else {
+        LOG_WARNING("Unknown cartridge ram size %02x, assuming there is none", ram_size_index);
+        cartridge_ram_size = 0;
+    }
+    LOG_INFO("Cartridge ram size: %zu bytes (%02x)", cartridge_ram_size, ram_size_index);
 }
 
 /******************************************************
@@ -108,3 +126,15 @@ void rom_destroy(void) {
 uint8_t *get_rom_bytes(void) {
     return rom_bytes;
 }
+
+size_t get_rom_size(void) {
+    return rom_size;
+}
+
+uint8_t get_cartridge_type(void) {
+    return cartridge_type;
+}
+
+size_t get_cartridge_ram_size(void) {
+    return cartridge_ram_size;
+}
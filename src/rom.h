@@ -2,9 +2,26 @@
 #define YOBEMAG_ROM_H
 
 #include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Size of a ROM bank, bank 0 is always mapped below it and the switchable bank above it
+ */
+#define ROM_BANK_SIZE (0x4000)
 
 void rom_init(const char *file_name);
 void rom_destroy(void);
 __attribute__((pure)) uint8_t *get_rom_bytes(void);
+__attribute__((pure)) size_t get_rom_size(void);
+
+/**
+ * @brief The cartridge type from the header of the loaded ROM, which identifies its memory bank controller
+ */
+__attribute__((pure)) uint8_t get_cartridge_type(void);
+
+/**
+ * @brief Bytes of RAM on the cartridge according to the header of the loaded ROM, 0 if it has none
+ */
+__attribute__((pure)) size_t get_cartridge_ram_size(void);
 
 #endif // YOBEMAG_ROM_H
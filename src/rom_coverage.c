@@ -0,0 +1,83 @@
+#define LOG_CATEGORY LOG_CAT_CPU
+
+#if defined(YOBEMAG_ROM_COVERAGE)
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+
+#include "rom_coverage.h"
+#include "rom.h"
+#include "log.h"
+
+/******************************************************
+ *** LOCAL VARIABLES                                ***
+ ******************************************************/
+
+uint8_t *rom_coverage_map;
+size_t rom_coverage_size;
+
+static FILE *output;
+
+/******************************************************
+ *** LOCAL METHODS                                  ***
+ ******************************************************/
+
+__attribute__((pure)) static size_t executed_bytes(size_t from, size_t to) {
+    size_t count = 0;
+    for (size_t byte = from; byte < to; ++byte) {
+        count += (rom_coverage_map[byte >> 3] >> (byte & 7)) & 1u;
+    }
+    return count;
+}
+
+/******************************************************
+ *** EXPOSED METHODS                                ***
+ ******************************************************/
+
+void rom_coverage_init(const char *path) {
+    output = fopen(path, "wb");
+    if (output == NULL) {
+        YOBEMAG_EXIT("Could not open coverage output %s: %s", path, strerror(errno));
+    }
+
+    rom_coverage_size = get_rom_size();
+    rom_coverage_map  = calloc((rom_coverage_size + 7) / 8, 1);
+    if (rom_coverage_map == NULL) {
+        YOBEMAG_EXIT("Could not allocate the coverage bitmap");
+    }
+}
+
+void rom_coverage_teardown(void) {
+    if (rom_coverage_map == NULL) {
+        return;
+    }
+
+    size_t length = (rom_coverage_size + 7) / 8;
+    if (fwrite(rom_coverage_map, 1, length, output) != length || fclose(output) != 0) {
+        LOG_ERROR("Could not write the coverage bitmap: %s", strerror(errno));
+    }
+    rom_coverage_report(stdout);
+
+    free(rom_coverage_map);
+    rom_coverage_map  = NULL;
+    rom_coverage_size = 0;
+}
+
+void rom_coverage_report(FILE *stream) {
+    size_t banks = (rom_coverage_size + ROM_BANK_SIZE - 1) / ROM_BANK_SIZE;
+    size_t total = executed_bytes(0, rom_coverage_size);
+
+    fprintf(stream, "ROM coverage: %zu of %zu bytes executed (%.2f%%)\n", total, rom_coverage_size,
+            rom_coverage_size ? 100.0 * (double) total / (double) rom_coverage_size : 0.0);
+    fprintf(stream, "%-6s %10s %8s\n", "bank", "executed", "share");
+    for (size_t bank = 0; bank < banks; ++bank) {
+        size_t from     = bank * ROM_BANK_SIZE;
+        size_t to       = from + ROM_BANK_SIZE < rom_coverage_size ? from + ROM_BANK_SIZE : rom_coverage_size;
+        size_t executed = executed_bytes(from, to);
+        fprintf(stream, "%-6zu %10zu %7.2f%%\n", bank, executed, 100.0 * (double) executed / (double) (to - from));
+    }
+}
+
+#endif // defined(YOBEMAG_ROM_COVERAGE)
@@ -0,0 +1,81 @@
+#ifndef YOBEMAG_ROM_COVERAGE_H
+#define YOBEMAG_ROM_COVERAGE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "rom.h"
+
+/*
+ * Execution coverage of the cartridge ROM: one bit per ROM byte that was part of an executed instruction, indexed
+ * by the offset in the ROM file (bank * ROM_BANK_SIZE + offset in the bank). Bit `offset % 8` of byte `offset / 8`,
+ * which is also the layout of the bitmap file.
+ */
+
+#if defined(YOBEMAG_ROM_COVERAGE)
+
+    #include "mmu.h"
+
+/**
+ * @brief The bitmap while recording, NULL otherwise
+ */
+extern uint8_t *rom_coverage_map;
+/**
+ * @brief Bytes of the ROM that are covered by the bitmap
+ */
+extern size_t rom_coverage_size;
+
+/**
+ * @brief   Record coverage of the ROM loaded by ::rom_init() and write the bitmap to @p path on
+ *          ::rom_coverage_teardown()
+ *
+ * @note    Exits if the file cannot be opened.
+ */
+void rom_coverage_init(const char *path);
+
+/**
+ * @brief Write the bitmap, print the summary to stdout and stop recording, does nothing if not recording
+ */
+void rom_coverage_teardown(void);
+
+/**
+ * @brief Print how many bytes of each bank were executed
+ */
+void rom_coverage_report(FILE *stream);
+
+/**
+ * @brief   Mark the @p length bytes from @p addr on as executed
+ *
+ * @note    Instructions outside the ROM and in the boot ROM, which overlays the cartridge's first bytes until it is
+ *          unmapped, are ignored.
+ */
+__attribute__((always_inline)) inline void rom_coverage_mark(uint16_t addr, unsigned length) {
+    if (__builtin_expect(rom_coverage_map == NULL || addr >= ROM_LIMIT, 0)) {
+        return;
+    }
+    if (addr < BOOT_ROM_SIZE && mmu_boot_rom_mapped()) {
+        return;
+    }
+
+    // bytes of a region's last instruction beyond its end belong to whatever is mapped there
+    size_t region_end = (size_t) (addr & ~(ROM_BANK_SIZE - 1)) + ROM_BANK_SIZE;
+    if (addr + length > region_end) {
+        length = (unsigned) (region_end - addr);
+    }
+
+    size_t offset = (size_t) mmu_get_bank(addr) * ROM_BANK_SIZE + (addr & (ROM_BANK_SIZE - 1));
+    for (size_t byte = offset; byte < offset + length && byte < rom_coverage_size; ++byte) {
+        rom_coverage_map[byte >> 3] |= (uint8_t) (1u << (byte & 7));
+    }
+}
+
+    #define ROM_COVERAGE_MARK(addr, length) rom_coverage_mark(addr, length)
+
+#else
+
+    #define ROM_COVERAGE_MARK(addr, length)
+
+#endif // defined(YOBEMAG_ROM_COVERAGE)
+
+#endif // YOBEMAG_ROM_COVERAGE_H
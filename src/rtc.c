@@ -0,0 +1,160 @@
+#define LOG_CATEGORY LOG_CAT_ROM
+
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "rtc.h"
+#include "cpu.h"
+#include "log.h"
+
+/******************************************************
+ *** LOCAL VARIABLES                                ***
+ ******************************************************/
+
+#define INDEX(number)      ((unsigned) (number) - RTC_SECONDS)
+#define RTC_REGISTER_COUNT (INDEX(RTC_DAYS_HIGH) + 1)
+#define TIMESTAMP_OFFSET   (2 * RTC_REGISTER_COUNT * sizeof(uint32_t))
+#define NS_PER_SECOND      (1000000000ull)
+
+#define DAYS_HIGH_BIT (0x01)
+#define HALT_BIT      (0x40)
+#define CARRY_BIT     (0x80)
+#define DAY_COUNT     (512)
+
+// Bits which exist in each register
+static const uint8_t masks[RTC_REGISTER_COUNT] = {0x3F, 0x3F, 0x1F, 0xFF, DAYS_HIGH_BIT | HALT_BIT | CARRY_BIT};
+
+static RTCClock source;
+
+// The registers as of `base`, a time of `source`
+static uint8_t registers[RTC_REGISTER_COUNT];
+static uint8_t latched[RTC_REGISTER_COUNT];
+static uint64_t base;
+
+/******************************************************
+ *** LOCAL METHODS                                  ***
+ ******************************************************/
+
+static uint64_t now(void) {
+    if (source == RTC_CLOCK_EMULATED) {
+        return cpu.cycle_count;
+    }
+
+    struct timespec time;
+    clock_gettime(CLOCK_REALTIME, &time);
+    return (uint64_t) time.tv_sec * NS_PER_SECOND + (uint64_t) time.tv_nsec;
+}
+
+static uint64_t ticks_per_second(void) {
+    return source == RTC_CLOCK_EMULATED ? CPU_CLOCK_HZ : NS_PER_SECOND;
+}
+
+// Carries @p seconds through the registers, the day counter wraps around and sets the carry bit
+static void advance(uint64_t seconds) {
+    uint8_t *days_high = &registers[INDEX(RTC_DAYS_HIGH)];
+
+    uint64_t total                = seconds + registers[INDEX(RTC_SECONDS)];
+    registers[INDEX(RTC_SECONDS)] = (uint8_t) (total % 60);
+    total                         = total / 60 + registers[INDEX(RTC_MINUTES)];
+    registers[INDEX(RTC_MINUTES)] = (uint8_t) (total % 60);
+    total                         = total / 60 + registers[INDEX(RTC_HOURS)];
+    registers[INDEX(RTC_HOURS)]   = (uint8_t) (total % 24);
+    total = total / 24 + registers[INDEX(RTC_DAYS_LOW)] + (uint64_t) (*days_high & DAYS_HIGH_BIT) * 0x100;
+
+    if (total >= DAY_COUNT) {
+        *days_high |= CARRY_BIT;
+    }
+    total %= DAY_COUNT;
+    registers[INDEX(RTC_DAYS_LOW)] = (uint8_t) total;
+    *days_high                     = (uint8_t) ((*days_high & ~DAYS_HIGH_BIT) | (uint8_t) (total >> 8));
+}
+
+// Folds the whole seconds since `base` into the registers, the fraction of the current one is kept in `base`
+static void update(void) {
+    uint64_t current = now();
+    if ((registers[INDEX(RTC_DAYS_HIGH)] & HALT_BIT) || current < base) {
+        base = current;
+        return;
+    }
+
+    // out-of-range values the game wrote are kept until the clock ticks
+    uint64_t seconds = (current - base) / ticks_per_second();
+    if (seconds > 0) {
+        advance(seconds);
+        base += seconds * ticks_per_second();
+    }
+}
+
+static void store_le(uint8_t *dest, uint64_t value, size_t size) {
+    for (size_t byte = 0; byte < size; ++byte) {
+        dest[byte] = (uint8_t) (value >> (8 * byte));
+    }
+}
+
+static uint64_t load_le(const uint8_t *src, size_t size) {
+    uint64_t value = 0;
+    for (size_t byte = 0; byte < size; ++byte) {
+        value |= (uint64_t) src[byte] << (8 * byte);
+    }
+    return value;
+}
+
+/******************************************************
+ *** EXPOSED METHODS                                ***
+ ******************************************************/
+
+void rtc_init(RTCClock clock) {
+    source = clock;
+    memset(registers, 0, sizeof(registers));
+    memset(latched, 0, sizeof(latched));
+    base = now();
+}
+
+void rtc_latch(void) {
+    update();
+    memcpy(latched, registers, sizeof(latched));
+
+    LOG_DEBUG("Latched the clock at day %u, %02u:%02u:%02u",
+              latched[INDEX(RTC_DAYS_LOW)] | (latched[INDEX(RTC_DAYS_HIGH)] & DAYS_HIGH_BIT) << 8,
+              latched[INDEX(RTC_HOURS)], latched[INDEX(RTC_MINUTES)], latched[INDEX(RTC_SECONDS)]);
+}
+
+uint8_t rtc_read(RTCRegister number) {
+    return latched[INDEX(number)];
+}
+
+void rtc_write(RTCRegister number, uint8_t value) {
+    update();
+    registers[INDEX(number)] = value & masks[INDEX(number)];
+
+    if (number == RTC_SECONDS) {
+        base = now();
+    }
+}
+
+void rtc_save(uint8_t state[RTC_SAVE_SIZE]) {
+    memset(state, 0, RTC_SAVE_SIZE);
+    update();
+
+    // the registers and the latched ones as 32-bit values, followed by the 64-bit UNIX time, all little-endian
+    for (unsigned i = 0; i < RTC_REGISTER_COUNT; ++i) {
+        store_le(&state[i * sizeof(uint32_t)], registers[i], sizeof(uint32_t));
+        store_le(&state[(RTC_REGISTER_COUNT + i) * sizeof(uint32_t)], latched[i], sizeof(uint32_t));
+    }
+    store_le(&state[TIMESTAMP_OFFSET], (uint64_t) time(NULL), sizeof(uint64_t));
+}
+
+void rtc_load(const uint8_t state[RTC_SAVE_SIZE]) {
+    for (unsigned i = 0; i < RTC_REGISTER_COUNT; ++i) {
+        registers[i] = state[i * sizeof(uint32_t)] & masks[i];
+        latched[i]   = state[(RTC_REGISTER_COUNT + i) * sizeof(uint32_t)] & masks[i];
+    }
+    base = now();
+
+    uint64_t saved_at = load_le(&state[TIMESTAMP_OFFSET], sizeof(uint64_t));
+    uint64_t current  = (uint64_t) time(NULL);
+    if (source == RTC_CLOCK_HOST && !(registers[INDEX(RTC_DAYS_HIGH)] & HALT_BIT) && current > saved_at) {
+        advance(current - saved_at);
+    }
+}
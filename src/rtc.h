@@ -0,0 +1,74 @@
+#ifndef YOBEMAG_RTC_H
+#define YOBEMAG_RTC_H
+
+#include <stdint.h>
+
+/**
+ * @brief Size of the clock state appended to the save RAM, in the layout of BGB and VBA
+ */
+#define RTC_SAVE_SIZE (48)
+
+/**
+ * @brief The clock registers of the MBC3, selected by writing their number into the RAM bank register
+ */
+typedef enum RTCRegister {
+    RTC_SECONDS   = 0x08,
+    RTC_MINUTES   = 0x09,
+    RTC_HOURS     = 0x0A,
+    RTC_DAYS_LOW  = 0x0B,
+    /**
+     * @brief Bit 0 is bit 8 of the day counter, bit 6 halts the clock and bit 7 is set when the day counter overflows
+     */
+    RTC_DAYS_HIGH = 0x0C,
+} RTCRegister;
+
+/**
+ * @brief What the clock counts the passing time with
+ */
+typedef enum RTCClock {
+    /**
+     * @brief `cpu.cycle_count`, the clock stands still while the emulator is not running
+     */
+    RTC_CLOCK_EMULATED,
+    /**
+     * @brief The host's wall clock, which keeps running while the emulator is closed
+     */
+    RTC_CLOCK_HOST,
+} RTCClock;
+
+/**
+ * @brief   Start the clock at day 0, 00:00:00, counting the time with @p clock
+ *
+ * @note    The clock never ticks. The time which passed is only folded into the registers when they are latched or
+ *          written.
+ */
+void rtc_init(RTCClock clock);
+
+/**
+ * @brief Bring the registers up to date and copy them to the ones ::rtc_read() returns
+ */
+void rtc_latch(void);
+
+/**
+ * @brief The value of @p reg at the last ::rtc_latch()
+ */
+__attribute__((pure)) uint8_t rtc_read(RTCRegister reg);
+
+/**
+ * @brief Set @p reg, writing ::RTC_SECONDS restarts the current second
+ */
+void rtc_write(RTCRegister reg, uint8_t value);
+
+/**
+ * @brief Store the registers and the host time into @p state, see ::RTC_SAVE_SIZE
+ */
+void rtc_save(uint8_t state[RTC_SAVE_SIZE]);
+
+/**
+ * @brief   Restore the registers from @p state, which was written by ::rtc_save()
+ *
+ * @note    With ::RTC_CLOCK_HOST, the time which passed on the host since then is added.
+ */
+void rtc_load(const uint8_t state[RTC_SAVE_SIZE]);
+
+#endif // YOBEMAG_RTC_H
@@ -0,0 +1,120 @@
+#include <string.h>
+
+#include "scheduler.h"
+#include "cpu.h"
+
+/******************************************************
+ *** LOCAL VARIABLES                                ***
+ ******************************************************/
+
+Scheduler scheduler;
+
+/******************************************************
+ *** LOCAL METHODS                                  ***
+ ******************************************************/
+
+// Ties are broken by the event type so that the order of simultaneous events is deterministic
+__attribute__((pure)) static inline bool before(uint8_t a, uint8_t b) {
+    return scheduler.deadline[a] < scheduler.deadline[b] || (scheduler.deadline[a] == scheduler.deadline[b] && a < b);
+}
+
+static inline void place(uint8_t index, uint8_t type) {
+    scheduler.heap[index]    = type;
+    scheduler.position[type] = index;
+}
+
+static void sift_up(uint8_t index) {
+    uint8_t type = scheduler.heap[index];
+
+    while (index > 0) {
+        uint8_t parent = (uint8_t) ((index - 1) / 2);
+        if (!before(type, scheduler.heap[parent])) {
+            break;
+        }
+        place(index, scheduler.heap[parent]);
+        index = parent;
+    }
+    place(index, type);
+}
+
+static void sift_down(uint8_t index) {
+    uint8_t type = scheduler.heap[index];
+
+    for (;;) {
+        uint8_t child = (uint8_t) (2 * index + 1);
+        if (child >= scheduler.size) {
+            break;
+        }
+        if (child + 1 < scheduler.size && before(scheduler.heap[child + 1], scheduler.heap[child])) {
+            ++child;
+        }
+        if (!before(scheduler.heap[child], type)) {
+            break;
+        }
+        place(index, scheduler.heap[child]);
+        index = child;
+    }
+    place(index, type);
+}
+
+/******************************************************
+ *** EXPOSED METHODS                                ***
+ ******************************************************/
+
+void scheduler_init(void) {
+    memset(&scheduler, 0, sizeof(scheduler));
+}
+
+void scheduler_register(EventType type, event_handler handler) {
+    scheduler.handler[type] = handler;
+}
+
+void scheduler_schedule(EventType type, uint64_t deadline) {
+    // an I/O write may schedule an event before the end of the running batch of instructions
+    cpu_yield_at(deadline);
+
+    if (!scheduler_is_pending(type)) {
+        scheduler.deadline[type] = deadline;
+        place(scheduler.size, (uint8_t) type);
+        sift_up(scheduler.size++);
+        return;
+    }
+
+    uint64_t previous        = scheduler.deadline[type];
+    scheduler.deadline[type] = deadline;
+    if (deadline < previous) {
+        sift_up(scheduler.position[type]);
+    } else {
+        sift_down(scheduler.position[type]);
+    }
+}
+
+void scheduler_cancel(EventType type) {
+    if (!scheduler_is_pending(type)) {
+        return;
+    }
+
+    uint8_t index = scheduler.position[type];
+    --scheduler.size;
+    if (index == scheduler.size) {
+        return;
+    }
+
+    // Move the last event into the hole, it may have to go either way
+    uint8_t moved = scheduler.heap[scheduler.size];
+    place(index, moved);
+    sift_up(index);
+    sift_down(scheduler.position[moved]);
+}
+
+void scheduler_run_due(void) {
+    while (scheduler.size && scheduler.deadline[scheduler.heap[0]] <= cpu.cycle_count) {
+        uint8_t type      = scheduler.heap[0];
+        uint64_t deadline = scheduler.deadline[type];
+
+        scheduler_cancel((EventType) type);
+        if (scheduler.handler[type]) {
+            scheduler.handler[type](deadline);
+        }
+    }
+}
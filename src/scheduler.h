@@ -0,0 +1,111 @@
+#ifndef YOBEMAG_SCHEDULER_H
+#define YOBEMAG_SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Next deadline while no event is pending, never reached by the clock
+ */
+#define EVENT_NEVER (UINT64_MAX)
+
+/**
+ * @brief Hardware events which happen at a known cycle, at most one of each kind is pending at a time
+ *
+ * @note  Events which are due at the same cycle run in the order of this enum.
+ */
+typedef enum EventType {
+    /**
+     * @brief The PPU enters its next mode (OAM scan, pixel transfer, HBlank, VBlank)
+     */
+    EVENT_PPU_MODE,
+    /**
+     * @brief TIMA overflows and is reloaded from TMA
+     */
+    EVENT_TIMER_OVERFLOW,
+    /**
+     * @brief A frame has been emulated and is presented on the host
+     */
+    EVENT_FRAME,
+    /**
+     * @brief Host input (keyboard, window events) is polled
+     */
+    EVENT_INPUT_POLL,
+    /**
+     * @brief The sampling profiler records the PC and the call stack, see pc_profiler.h
+     */
+    EVENT_PROFILE_SAMPLE,
+    EVENT_COUNT
+} EventType;
+
+/**
+ * @brief Called when an event is due
+ *
+ * @param deadline  The cycle the event was scheduled for, which is at or before the current clock.
+ *                  Periodic events reschedule themselves relative to it to not accumulate drift.
+ */
+typedef void (*event_handler)(uint64_t deadline);
+
+/**
+ * @brief Pending events ordered by their deadline in a binary min-heap, deadlines refer to `cpu.cycle_count`
+ */
+typedef struct Scheduler {
+    /**
+     * @brief Cycle at which each pending ::EventType is due
+     */
+    uint64_t deadline[EVENT_COUNT];
+    event_handler handler[EVENT_COUNT];
+    /**
+     * @brief Pending event types, heap[0] being the next one that is due
+     */
+    uint8_t heap[EVENT_COUNT];
+    /**
+     * @brief Index of each pending event type in `heap`, allows rescheduling without searching.
+     *        An event type is pending iff its index is below `size` and points back to it,
+     *        hence a zero-initialized scheduler is empty.
+     */
+    uint8_t position[EVENT_COUNT];
+    uint8_t size;
+} Scheduler;
+
+extern Scheduler scheduler;
+
+/**
+ * @brief Drop all pending events and handlers
+ */
+void scheduler_init(void);
+
+/**
+ * @brief Set the function which is run when an event of @p type is due
+ */
+void scheduler_register(EventType type, event_handler handler);
+
+/**
+ * @brief   Let @p type happen at cycle @p deadline
+ *
+ * @note    If @p type is already pending, it is moved to @p deadline instead, e.g. after an I/O register
+ *          changed the timing of the hardware that produces it. The running batch of ::cpu_run() ends by then.
+ */
+void scheduler_schedule(EventType type, uint64_t deadline);
+
+/**
+ * @brief Remove @p type from the pending events, does nothing if it is not pending
+ */
+void scheduler_cancel(EventType type);
+
+/**
+ * @brief Run the handlers of all events which are due at the master clock (`cpu.cycle_count`), earliest first
+ *
+ * @note  Events scheduled by a handler run in the same call if they are due as well.
+ */
+void scheduler_run_due(void);
+
+__attribute__((always_inline)) inline uint64_t scheduler_next_deadline(void) {
+    return scheduler.size ? scheduler.deadline[scheduler.heap[0]] : EVENT_NEVER;
+}
+
+__attribute__((always_inline)) inline bool scheduler_is_pending(EventType type) {
+    return scheduler.position[type] < scheduler.size && scheduler.heap[scheduler.position[type]] == type;
+}
+
+#endif // YOBEMAG_SCHEDULER_H
@@ -0,0 +1,214 @@
+#define LOG_CATEGORY LOG_CAT_CPU
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+
+#include "timeline.h"
+#include "frame_stats.h"
+#include "cpu.h"
+#include "log.h"
+
+/******************************************************
+ *** LOCAL VARIABLES                                ***
+ ******************************************************/
+
+#define NS_PER_US (1000.0)
+
+typedef struct TimelineEvent {
+    const char *name;
+    const char *arg_name;
+    uint64_t start;
+    uint64_t end;
+    uint32_t arg;
+    uint8_t track;
+} TimelineEvent;
+
+typedef struct Chunk {
+    TimelineEvent events[TIMELINE_CHUNK_EVENTS];
+    uint32_t count;
+    /**
+     * @brief Handed to the writer thread, the recording side must not touch it until the writer cleared this
+     */
+    bool pending;
+} Chunk;
+
+// Perfetto shows each pid as a process and each tid as one of its threads
+static const struct {
+    unsigned pid;
+    unsigned tid;
+    const char *name;
+} tracks[TIMELINE_TRACK_COUNT] = {
+    [TIMELINE_HOST]      = {1, 1, "frame loop"},
+    [TIMELINE_PPU]       = {2, 1, "PPU"},
+    [TIMELINE_INTERRUPT] = {2, 2, "interrupts"},
+};
+
+bool timeline_enabled;
+
+static Chunk *chunks;
+static unsigned recording;
+static uint64_t events_dropped;
+
+static FILE *output;
+static uint64_t host_epoch;
+static pthread_t writer;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t handed_over = PTHREAD_COND_INITIALIZER;
+static bool finishing;
+
+/******************************************************
+ *** LOCAL METHODS                                  ***
+ ******************************************************/
+
+// Host spans are relative to timeline_init() in ns, every other track counts cycles from power on
+static double timestamp_us(uint8_t track, uint64_t time) {
+    if (track == TIMELINE_HOST) {
+        return (double) (time - host_epoch) / NS_PER_US;
+    }
+    return (double) time * 1e6 / CPU_CLOCK_HZ;
+}
+
+static void write_chunk(const Chunk *chunk) {
+    for (uint32_t i = 0; i < chunk->count; ++i) {
+        const TimelineEvent *event = &chunk->events[i];
+        double start               = timestamp_us(event->track, event->start);
+        double end                 = timestamp_us(event->track, event->end);
+
+        fprintf(output, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%u,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f", event->name,
+                tracks[event->track].pid, tracks[event->track].tid, start, end - start);
+        if (event->arg_name != NULL) {
+            fprintf(output, ",\"args\":{\"%s\":%" PRIu32 "}", event->arg_name, event->arg);
+        }
+        fputc('}', output);
+    }
+}
+
+// Converts and writes the chunks in the order they were handed over, until the timeline is torn down
+static void *writer_main(void *unused) {
+    (void) unused;
+
+    unsigned next = 0;
+    pthread_mutex_lock(&lock);
+    for (;;) {
+        while (!chunks[next].pending && !finishing) {
+            pthread_cond_wait(&handed_over, &lock);
+        }
+        if (!chunks[next].pending) {
+            break;
+        }
+        pthread_mutex_unlock(&lock);
+
+        write_chunk(&chunks[next]);
+
+        pthread_mutex_lock(&lock);
+        chunks[next].count   = 0;
+        chunks[next].pending = false;
+        next ^= 1;
+    }
+    pthread_mutex_unlock(&lock);
+
+    return NULL;
+}
+
+static void hand_over(Chunk *chunk) {
+    pthread_mutex_lock(&lock);
+    chunk->pending = true;
+    pthread_cond_signal(&handed_over);
+    pthread_mutex_unlock(&lock);
+}
+
+static void write_metadata(void) {
+    fputs("{\"traceEvents\":[\n"
+          "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"host (wall clock)\"}},\n"
+          "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":2,\"args\":{\"name\":\"Game Boy (emulated clock)\"}}",
+          output);
+    for (unsigned track = 0; track < TIMELINE_TRACK_COUNT; ++track) {
+        fprintf(output, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                tracks[track].pid, tracks[track].tid, tracks[track].name);
+    }
+}
+
+/******************************************************
+ *** EXPOSED METHODS                                ***
+ ******************************************************/
+
+void timeline_init(const char *path) {
+    output = fopen(path, "w");
+    if (output == NULL) {
+        YOBEMAG_EXIT("Could not open timeline output %s: %s", path, strerror(errno));
+    }
+
+    chunks = calloc(2, sizeof(Chunk));
+    if (chunks == NULL) {
+        YOBEMAG_EXIT("Could not allocate the timeline's event buffer");
+    }
+
+    write_metadata();
+    recording        = 0;
+    events_dropped   = 0;
+    finishing        = false;
+    host_epoch       = frame_stats_now();
+    timeline_enabled = true;
+
+    if (pthread_create(&writer, NULL, writer_main, NULL) != 0) {
+        YOBEMAG_EXIT("Could not start the timeline writer");
+    }
+}
+
+void timeline_teardown(void) {
+    if (!timeline_enabled) {
+        return;
+    }
+
+    timeline_enabled = false;
+    if (chunks[recording].count > 0) {
+        hand_over(&chunks[recording]);
+    }
+
+    pthread_mutex_lock(&lock);
+    finishing = true;
+    pthread_cond_signal(&handed_over);
+    pthread_mutex_unlock(&lock);
+    pthread_join(writer, NULL);
+
+    fputs("\n]}\n", output);
+    fclose(output);
+    free(chunks);
+    chunks = NULL;
+
+    if (events_dropped > 0) {
+        LOG_WARNING("Dropped %" PRIu64 " timeline events, the writer could not keep up", events_dropped);
+    }
+}
+
+void timeline_span(TimelineTrack track, const char *name, uint64_t start, uint64_t end, const char *arg_name,
+                   uint32_t arg) {
+    Chunk *chunk = &chunks[recording];
+    if (chunk->count == TIMELINE_CHUNK_EVENTS) {
+        // the other chunk is still being written if the writer fell behind by a whole chunk
+        pthread_mutex_lock(&lock);
+        bool available = !chunks[recording ^ 1].pending;
+        pthread_mutex_unlock(&lock);
+        if (!available) {
+            ++events_dropped;
+            return;
+        }
+
+        hand_over(chunk);
+        recording ^= 1;
+        chunk = &chunks[recording];
+    }
+
+    chunk->events[chunk->count++] = (TimelineEvent){
+        .name     = name,
+        .arg_name = arg_name,
+        .start    = start,
+        .end      = end,
+        .arg      = arg,
+        .track    = (uint8_t) track,
+    };
+}
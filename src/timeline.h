@@ -0,0 +1,76 @@
+#ifndef YOBEMAG_TIMELINE_H
+#define YOBEMAG_TIMELINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Events buffered before they are handed to the writer thread, two such chunks are preallocated
+ */
+#define TIMELINE_CHUNK_EVENTS (1u << 16)
+
+/**
+ * @brief Rows of the timeline. The host track is measured in wall-clock time, the others in emulated time
+ *        (`cpu.cycle_count`), hence they are shown as two processes.
+ */
+typedef enum TimelineTrack {
+    /**
+     * @brief Frame loop, cpu_run() and the SDL calls
+     */
+    TIMELINE_HOST,
+    /**
+     * @brief Emulated frames, scanlines and PPU modes
+     */
+    TIMELINE_PPU,
+    TIMELINE_INTERRUPT,
+    TIMELINE_TRACK_COUNT
+} TimelineTrack;
+
+/**
+ * @brief Set by ::timeline_init(), events are only recorded while true
+ */
+extern bool timeline_enabled;
+
+/**
+ * @brief   Record events from now on and write them to @p path as Chrome trace-event JSON, e.g. for Perfetto
+ *
+ * @note    Recording never touches the file: full chunks are converted and written by a separate thread.
+ *          Exits if the file cannot be opened.
+ */
+void timeline_init(const char *path);
+
+/**
+ * @brief Write the remaining events, finish the JSON and stop recording, does nothing if not recording
+ */
+void timeline_teardown(void);
+
+/**
+ * @brief   Record a span of @p track from @p start to @p end
+ *
+ * @param   name        Must outlive the timeline, e.g. a string literal
+ * @param   start       ns of ::frame_stats_now() on ::TIMELINE_HOST, cycles on every other track
+ * @param   arg_name    Name of @p arg shown with the span, NULL if it has none
+ */
+void timeline_span(TimelineTrack track, const char *name, uint64_t start, uint64_t end, const char *arg_name,
+                   uint32_t arg);
+
+/**
+ * @brief Record a span on ::TIMELINE_HOST, @p start and @p end come from ::frame_stats_now()
+ */
+__attribute__((always_inline)) inline void timeline_host_span(const char *name, uint64_t start, uint64_t end) {
+    if (__builtin_expect(timeline_enabled, 0)) {
+        timeline_span(TIMELINE_HOST, name, start, end, NULL, 0);
+    }
+}
+
+/**
+ * @brief Record a span of @p track in emulated time, see ::timeline_span()
+ */
+__attribute__((always_inline)) inline void timeline_cycles(TimelineTrack track, const char *name, uint64_t start,
+                                                           uint64_t end, const char *arg_name, uint32_t arg) {
+    if (__builtin_expect(timeline_enabled, 0)) {
+        timeline_span(track, name, start, end, arg_name, arg);
+    }
+}
+
+#endif // YOBEMAG_TIMELINE_H
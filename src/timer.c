@@ -0,0 +1,124 @@
+#include <stdbool.h>
+
+#include "timer.h"
+#include "interrupt.h"
+#include "cpu.h"
+#include "scheduler.h"
+#include "mmu.h"
+
+/******************************************************
+ *** LOCAL VARIABLES                                ***
+ ******************************************************/
+
+#define TAC_ENABLE     (0x04)
+#define TAC_CLOCK_MASK (0x03)
+#define TAC_UNUSED     (0xF8)
+
+// TIMA increments whenever this bit of the internal divider falls, indexed by the clock select bits of TAC
+static const uint8_t tima_period_shift[TAC_CLOCK_MASK + 1] = {10, 4, 6, 8};
+
+// Clock at which the internal divider (whose upper byte is DIV) was 0
+static uint64_t div_base;
+// Clock up to which the increments of TIMA have been applied to `tima`
+static uint64_t tima_sync;
+
+static uint8_t tima;
+static uint8_t tma;
+static uint8_t tac;
+
+/******************************************************
+ *** LOCAL METHODS                                  ***
+ ******************************************************/
+
+__attribute__((pure)) static inline bool tima_enabled(void) {
+    return tac & TAC_ENABLE;
+}
+
+// Number of TIMA increments in the interval (from, to]
+__attribute__((pure)) static uint64_t tima_ticks(uint64_t from, uint64_t to) {
+    uint8_t shift = tima_period_shift[tac & TAC_CLOCK_MASK];
+
+    return ((to - div_base) >> shift) - ((from - div_base) >> shift);
+}
+
+static void tima_catch_up(void) {
+    if (tima_enabled()) {
+        tima = (uint8_t) (tima + tima_ticks(tima_sync, cpu.cycle_count));
+    }
+    tima_sync = cpu.cycle_count;
+}
+
+static void schedule_overflow(void) {
+    if (!tima_enabled()) {
+        scheduler_cancel(EVENT_TIMER_OVERFLOW);
+        return;
+    }
+
+    // TIMA overflows on its (256 - TIMA)th increment after the last catch up
+    uint8_t shift      = tima_period_shift[tac & TAC_CLOCK_MASK];
+    uint64_t increment = ((tima_sync - div_base) >> shift) + (uint64_t) (0x100 - tima);
+    scheduler_schedule(EVENT_TIMER_OVERFLOW, div_base + (increment << shift));
+}
+
+static void timer_overflow(uint64_t deadline) {
+    tima      = tma;
+    tima_sync = deadline;
+    interrupt_request(IF_TIMER);
+
+    schedule_overflow();
+}
+
+/******************************************************
+ *** EXPOSED METHODS                                ***
+ ******************************************************/
+
+void timer_init(void) {
+    div_base  = cpu.cycle_count;
+    tima_sync = cpu.cycle_count;
+    tima      = 0;
+    tma       = 0;
+    tac       = 0;
+
+    scheduler_register(EVENT_TIMER_OVERFLOW, timer_overflow);
+    scheduler_cancel(EVENT_TIMER_OVERFLOW);
+
+    for (uint16_t addr = TIMER_DIV; addr <= TIMER_TAC; ++addr) {
+        mmu_register_io_read(addr, timer_read);
+        mmu_register_io_write(addr, timer_write);
+    }
+}
+
+uint8_t timer_read(uint16_t addr) {
+    switch (addr) {
+        case TIMER_DIV:
+            return (uint8_t) ((cpu.cycle_count - div_base) >> 8);
+        case TIMER_TIMA:
+            return tima_enabled() ? (uint8_t) (tima + tima_ticks(tima_sync, cpu.cycle_count)) : tima;
+        case TIMER_TMA:
+            return tma;
+        default:
+            return tac | TAC_UNUSED;
+    }
+}
+
+void timer_write(uint16_t addr, uint8_t value) {
+    tima_catch_up();
+
+    switch (addr) {
+        case TIMER_DIV:
+            // Writing any value resets the whole internal divider
+            div_base = cpu.cycle_count;
+            break;
+        case TIMER_TIMA:
+            tima = value;
+            break;
+        case TIMER_TMA:
+            tma = value;
+            return;
+        default:
+            tac = value & (TAC_ENABLE | TAC_CLOCK_MASK);
+            break;
+    }
+
+    schedule_overflow();
+}
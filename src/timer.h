@@ -0,0 +1,29 @@
+#ifndef YOBEMAG_TIMER_H
+#define YOBEMAG_TIMER_H
+
+#include <stdint.h>
+
+#define TIMER_DIV  (0xFF04)
+#define TIMER_TIMA (0xFF05)
+#define TIMER_TMA  (0xFF06)
+#define TIMER_TAC  (0xFF07)
+
+/**
+ * @brief Reset DIV, TIMA, TMA and TAC and register the overflow event, requires ::scheduler_init()
+ *
+ * @note  The registers are not stepped: DIV and TIMA are derived from the master clock when they are read,
+ *        only the TIMA overflow is an event.
+ */
+void timer_init(void);
+
+/**
+ * @brief Value of the timer register at @p addr (::TIMER_DIV to ::TIMER_TAC) at the current clock
+ */
+__attribute__((pure)) uint8_t timer_read(uint16_t addr);
+
+/**
+ * @brief CPU write of @p value to the timer register at @p addr, reschedules the TIMA overflow
+ */
+void timer_write(uint16_t addr, uint8_t value);
+
+#endif // YOBEMAG_TIMER_H
@@ -0,0 +1,72 @@
+#define LOG_CATEGORY LOG_CAT_CPU
+
+#if defined(YOBEMAG_TRACE)
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/mman.h>
+
+#include "trace.h"
+#include "log.h"
+
+/******************************************************
+ *** LOCAL VARIABLES                                ***
+ ******************************************************/
+
+TraceRecord *trace_ring;
+TraceHeader *trace_header;
+
+static size_t trace_size;
+
+/******************************************************
+ *** EXPOSED METHODS                                ***
+ ******************************************************/
+
+void trace_init(const char *path, uint32_t capacity) {
+    if (capacity == 0) {
+        YOBEMAG_EXIT("The trace needs room for at least one record");
+    }
+    // round down to a power of two, so that the ring index is a mask
+    capacity = 1u << (31 - __builtin_clz(capacity));
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        YOBEMAG_EXIT("Opening trace file %s failed: %s", path, strerror(errno));
+    }
+
+    trace_size = sizeof(TraceHeader) + (size_t) capacity * sizeof(TraceRecord);
+    if (ftruncate(fd, (off_t) trace_size) == -1) {
+        YOBEMAG_EXIT("Resizing trace file %s failed: %s", path, strerror(errno));
+    }
+
+    void *map = mmap(NULL, trace_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        YOBEMAG_EXIT("mmap for trace file %s failed: %s", path, strerror(errno));
+    }
+    close(fd);
+
+    trace_header = map;
+    memcpy(trace_header->magic, TRACE_MAGIC, sizeof(trace_header->magic));
+    trace_header->record_size = sizeof(TraceRecord);
+    trace_header->capacity    = capacity;
+    trace_header->written     = 0;
+    trace_ring                = (TraceRecord *) (trace_header + 1);
+    LOG_INFO("Recording a trace of the last %u instructions to %s", capacity, path);
+}
+
+void trace_teardown(void) {
+    if (trace_ring == NULL) {
+        return;
+    }
+
+    // the kernel writes the pages back on its own, even if the emulator crashes while recording
+    if (munmap(trace_header, trace_size) == -1) {
+        YOBEMAG_EXIT("munmap of the trace failed: %s", strerror(errno));
+    }
+    trace_ring   = NULL;
+    trace_header = NULL;
+}
+
+#endif // defined(YOBEMAG_TRACE)
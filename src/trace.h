@@ -0,0 +1,110 @@
+#ifndef YOBEMAG_TRACE_H
+#define YOBEMAG_TRACE_H
+
+#include <stdint.h>
+
+/*
+ * Binary instruction trace: a TraceHeader followed by a ring of `capacity` TraceRecords, memory mapped so that
+ * recording is a plain store per field. Decoded by tools/trace_decode.c.
+ */
+
+#define TRACE_MAGIC "YBTRACE1"
+
+/**
+ * @brief Default number of records in the ring, the most recent ones are kept
+ */
+#define TRACE_DEFAULT_CAPACITY (1u << 21)
+
+typedef struct TraceHeader {
+    char magic[8];
+    uint32_t record_size;
+    /**
+     * @brief Records in the ring, a power of two
+     */
+    uint32_t capacity;
+    /**
+     * @brief Records written so far, the next one goes to `written % capacity`
+     */
+    uint64_t written;
+} TraceHeader;
+
+/**
+ * @brief CPU state before an instruction is executed, has all fields of the Gameboy Doctor log format
+ */
+typedef struct TraceRecord {
+    uint64_t cycle;
+    uint16_t pc;
+    uint16_t sp;
+    uint8_t a;
+    uint8_t f;
+    uint8_t b;
+    uint8_t c;
+    uint8_t d;
+    uint8_t e;
+    uint8_t h;
+    uint8_t l;
+    /**
+     * @brief The four bytes from PC on, the opcode being the lowest one
+     */
+    uint32_t memory;
+} TraceRecord;
+
+_Static_assert(sizeof(TraceRecord) == 24, "trace records are written to files and must not change their layout");
+
+#if defined(YOBEMAG_TRACE)
+
+    #include "cpu.h"
+    #include "mmu.h"
+
+/**
+ * @brief The ring while recording, NULL otherwise
+ */
+extern TraceRecord *trace_ring;
+extern TraceHeader *trace_header;
+
+/**
+ * @brief   Create (or truncate) the trace file at @p path with room for @p capacity records and start recording
+ *
+ * @note    @p capacity is rounded down to a power of two, exits if the file cannot be created or mapped.
+ */
+void trace_init(const char *path, uint32_t capacity);
+
+/**
+ * @brief Stop recording and unmap the trace file, does nothing if no trace is recorded
+ */
+void trace_teardown(void);
+
+// The record is assembled in registers and stored at once, stores of single bytes into the ring would alias the CPU
+// state and make the compiler reload it
+__attribute__((always_inline)) inline void trace_append(void) {
+    trace_ring[trace_header->written++ & (trace_header->capacity - 1)] = (TraceRecord){
+        .cycle  = cpu.cycle_count,
+        .pc     = cpu.PC,
+        .sp     = cpu.SP,
+        .a      = CPU_REG_A,
+        .f      = CPU_REG_F,
+        .b      = CPU_REG_B,
+        .c      = CPU_REG_C,
+        .d      = CPU_REG_D,
+        .e      = CPU_REG_E,
+        .h      = CPU_REG_H,
+        .l      = CPU_REG_L,
+        .memory = mmu_get_four_bytes(cpu.PC),
+    };
+}
+
+    // Records the instruction at PC before it is decoded and executed
+    #define TRACE_INSTRUCTION()                                                                                         \
+        do {                                                                                                            \
+            if (__builtin_expect(trace_ring != NULL, 0)) {                                                              \
+                trace_append();                                                                                         \
+            }                                                                                                           \
+        } while (0)
+
+#else
+
+    #define TRACE_INSTRUCTION()
+
+#endif // defined(YOBEMAG_TRACE)
+
+#endif // YOBEMAG_TRACE_H
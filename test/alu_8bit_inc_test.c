@@ -88,3 +88,39 @@ ParameterizedTest(SpecialTestParams *params, INC_n, INC_n_HL, .init = cpu_mmu_se
     cr_expect(eq(u16, cpu.PC, address + address_increment), "cpu.PC: %d, address: %d, address-increment: 0x%x", cpu.PC,
               address, address_increment);
 }
+
+Test(INC_n, INC_n_keeps_carry_of_previous_operation, .init = cpu_mmu_setup, .fini = cpu_teardown) {
+    clear_flag_register();
+
+    uint16_t address = (random() % (MEM_SIZE - ROM_LIMIT - 1)) + ROM_LIMIT;
+    cpu.PC           = address;
+    CPU_REG_A        = 0xF0;
+    CPU_REG_B        = 0x20;
+    CPU_REG_C        = 0x01;
+    mmu_write_byte(address, 0x80);     // ADD A, B: sets C
+    mmu_write_byte(address + 1, 0x0C); // INC C: must not touch C
+
+    cpu_step();
+    cpu_step();
+
+    cr_expect(eq(u8, CPU_REG_A, 0x10));
+    cr_expect(eq(u8, CPU_REG_C, 0x02));
+    cr_expect(eq(u8, CPU_REG_F, 0b00010000));
+}
+
+Test(INC_n, INC_n_replaces_Z_and_N_of_previous_operation, .init = cpu_mmu_setup, .fini = cpu_teardown) {
+    clear_flag_register();
+
+    uint16_t address = (random() % (MEM_SIZE - ROM_LIMIT - 1)) + ROM_LIMIT;
+    cpu.PC           = address;
+    CPU_REG_A        = 0x42;
+    CPU_REG_C        = 0x01;
+    mmu_write_byte(address, 0x97);     // SUB A, A: sets Z and N
+    mmu_write_byte(address + 1, 0x0C); // INC C: clears both
+
+    cpu_step();
+    cpu_step();
+
+    cr_expect(eq(u8, CPU_REG_C, 0x02));
+    cr_expect(eq(u8, CPU_REG_F, 0b00000000));
+}
@@ -0,0 +1,49 @@
+#include <criterion/criterion.h>
+#include <criterion/new/assert.h>
+
+#include "fixtures/cpu_mmu.h"
+
+#define CODE_ADDR (0xC000)
+
+Test(block_cache, executes_exact_instruction_budget, .init = cpu_mmu_setup, .fini = cpu_teardown) {
+    // INC B; INC B; INC B; JR -5
+    const uint8_t code[] = {0x04, 0x04, 0x04, 0x18, 0xFB};
+    load_code(CODE_ADDR, code, sizeof(code));
+    cpu.PC    = CODE_ADDR;
+    CPU_REG_B = 0;
+
+    cpu_step_n(2);
+    cr_expect(eq(u8, CPU_REG_B, 2));
+    cr_expect(eq(u16, cpu.PC, CODE_ADDR + 2));
+
+    // finish the first iteration, then run two INC B of the second one
+    cpu_step_n(4);
+    cr_expect(eq(u8, CPU_REG_B, 5));
+    cr_expect(eq(u16, cpu.PC, CODE_ADDR + 2));
+}
+
+Test(block_cache, rewritten_operand_is_decoded_again, .init = cpu_mmu_setup, .fini = cpu_teardown) {
+    // LD B, 0x11
+    mmu_write_byte(CODE_ADDR, 0x06);
+    mmu_write_byte(CODE_ADDR + 1, 0x11);
+    cpu.PC = CODE_ADDR;
+    cpu_step();
+    cr_expect(eq(u8, CPU_REG_B, 0x11));
+
+    mmu_write_byte(CODE_ADDR + 1, 0x22);
+    cpu.PC = CODE_ADDR;
+    cpu_step();
+    cr_expect(eq(u8, CPU_REG_B, 0x22));
+}
+
+Test(block_cache, code_modified_by_its_own_block, .init = cpu_mmu_setup, .fini = cpu_teardown) {
+    // LD (HL), 0x05; LD B, 0x00 where the store patches LD B, 0x00 into LD B, 0x05
+    const uint8_t code[] = {0x36, 0x05, 0x06, 0x00};
+    load_code(CODE_ADDR, code, sizeof(code));
+    cpu.PC      = CODE_ADDR;
+    CPU_DREG_HL = CODE_ADDR + 3;
+
+    cpu_step_n(2);
+    cr_expect(eq(u8, CPU_REG_B, 0x05));
+    cr_expect(eq(u16, cpu.PC, CODE_ADDR + 4));
+}
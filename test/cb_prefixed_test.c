@@ -0,0 +1,123 @@
+#include <criterion/criterion.h>
+#include <criterion/new/assert.h>
+#include <criterion/parameterized.h>
+
+#include "fixtures/cpu_mmu.h"
+
+#define CODE_ADDR (0xC000)
+#define DATA_ADDR (0xD000)
+
+// Operand of every instruction, the expectations below are for this value with all flags cleared
+#define OPERAND (0x85)
+
+typedef struct CBTestParams {
+    uint8_t opcode;
+} CBTestParams;
+
+// Rotates and shifts, indexed by y: RLC, RRC, RL, RR, SLA, SRA, SWAP, SRL
+static const uint8_t shift_result[8] = {0x0B, 0xC2, 0x0A, 0x42, 0x0A, 0xC2, 0x58, 0x42};
+static const uint8_t shift_flags[8]  = {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x00, 0x10};
+
+static uint8_t *target_reg(uint8_t z) {
+    uint8_t *const regs[8] = {&CPU_REG_B, &CPU_REG_C, &CPU_REG_D, &CPU_REG_E, &CPU_REG_H, &CPU_REG_L, NULL, &CPU_REG_A};
+
+    return regs[z];
+}
+
+static uint8_t emulate_cb(uint8_t opcode, uint8_t operand) {
+    uint8_t z                = opcode & 0x07;
+    uint16_t address         = CODE_ADDR + (uint16_t) (random() % 0x1000);
+    uint16_t operand_address = DATA_ADDR + (uint16_t) (random() % 0x1000);
+
+    cpu.PC = address;
+    mmu_write_byte(address, 0xCB);
+    mmu_write_byte(address + 1, opcode);
+
+    CPU_DREG_HL = operand_address;
+    if (z == 6) {
+        mmu_write_byte(operand_address, operand);
+    } else {
+        *target_reg(z) = operand;
+    }
+
+    cpu_step();
+
+    cr_expect(eq(u16, cpu.PC, address + 2), "op: CB 0x%x", opcode);
+
+    return z == 6 ? mmu_get_byte(operand_address) : *target_reg(z);
+}
+
+ParameterizedTestParameters(CB, opcode) {
+    static CBTestParams params[0xFF + 1];
+    for (uint16_t i = 0; i <= 0xFF; ++i) {
+        params[i].opcode = (uint8_t) i;
+    }
+
+    return cr_make_param_array(CBTestParams, params, sizeof(params) / sizeof(CBTestParams));
+}
+
+ParameterizedTest(CBTestParams *params, CB, opcode, .init = cpu_mmu_setup, .fini = cpu_teardown) {
+    uint8_t opcode = params->opcode;
+    uint8_t x      = opcode >> 6;
+    uint8_t y      = (opcode >> 3) & 0x07;
+    bool memory    = (opcode & 0x07) == 6;
+
+    clear_flag_register();
+    uint8_t actual = emulate_cb(opcode, OPERAND);
+
+    switch (x) {
+        case 0:
+            cr_expect(eq(u8, actual, shift_result[y]), "op: CB 0x%x", opcode);
+            cr_expect(eq(u8, CPU_REG_F, shift_flags[y]), "op: CB 0x%x", opcode);
+            cr_expect(eq(u64, cpu.cycle_count, memory ? 16 : 8), "op: CB 0x%x", opcode);
+            break;
+        case 1:
+            // BIT: Z is set if the bit is 0, H is always set
+            cr_expect(eq(u8, actual, OPERAND), "op: CB 0x%x", opcode);
+            cr_expect(eq(u8, CPU_REG_F, (OPERAND & (1 << y)) ? 0x20 : 0xA0), "op: CB 0x%x", opcode);
+            cr_expect(eq(u64, cpu.cycle_count, memory ? 12 : 8), "op: CB 0x%x", opcode);
+            break;
+        case 2:
+            // RES
+            cr_expect(eq(u8, actual, OPERAND & ~(1 << y)), "op: CB 0x%x", opcode);
+            cr_expect(eq(u8, CPU_REG_F, 0x00), "op: CB 0x%x", opcode);
+            cr_expect(eq(u64, cpu.cycle_count, memory ? 16 : 8), "op: CB 0x%x", opcode);
+            break;
+        default:
+            // SET
+            cr_expect(eq(u8, actual, OPERAND | (1 << y)), "op: CB 0x%x", opcode);
+            cr_expect(eq(u8, CPU_REG_F, 0x00), "op: CB 0x%x", opcode);
+            cr_expect(eq(u64, cpu.cycle_count, memory ? 16 : 8), "op: CB 0x%x", opcode);
+            break;
+    }
+}
+
+Test(CB, rotates_through_carry, .init = cpu_mmu_setup, .fini = cpu_teardown) {
+    clear_flag_register();
+    set_flag(1, C_FLAG);
+    cr_expect(eq(u8, emulate_cb(0x10, OPERAND), 0x0B)); // RL B
+    cr_expect(eq(u8, CPU_REG_F, 0x10));
+
+    clear_flag_register();
+    set_flag(1, C_FLAG);
+    cr_expect(eq(u8, emulate_cb(0x18, OPERAND), 0xC2)); // RR B
+    cr_expect(eq(u8, CPU_REG_F, 0x10));
+}
+
+Test(CB, zero_result, .init = cpu_mmu_setup, .fini = cpu_teardown) {
+    clear_flag_register();
+    cr_expect(eq(u8, emulate_cb(0x20, 0x80), 0x00)); // SLA B
+    cr_expect(eq(u8, CPU_REG_F, 0x90));
+
+    clear_flag_register();
+    cr_expect(eq(u8, emulate_cb(0x37, 0x00), 0x00)); // SWAP A
+    cr_expect(eq(u8, CPU_REG_F, 0x80));
+}
+
+Test(CB, bit_keeps_carry, .init = cpu_mmu_setup, .fini = cpu_teardown) {
+    clear_flag_register();
+    set_flag(1, C_FLAG);
+    emulate_cb(0x7C, 0x80); // BIT 7, H
+
+    cr_expect(eq(u8, CPU_REG_F, 0x30));
+}
@@ -159,3 +159,181 @@ Test(cli, cli_correct_no_log_lvl, .exit_code = EXIT_SUCCESS, .init = cr_redirect
 
     cr_assert_str_eq(cli_args.rom_path, expected_rom_path);
 }
+
+Test(cli, cli_trace_categories, .exit_code = EXIT_SUCCESS, .init = cr_redirect_stderr) {
+    char *argv[] = {"./yobemag", "-t", "cpu", "-t", "mmu", "-t", "lcd", "-t", "rom", "../build/yobemag.gb"};
+    int argc     = sizeof(argv) / sizeof(char *);
+
+    CLIArguments cli_args;
+    cli_parse(&cli_args, argc, argv);
+
+    uint32_t expected = 1u << LOG_CAT_CPU | 1u << LOG_CAT_MMU | 1u << LOG_CAT_LCD | 1u << LOG_CAT_ROM;
+    cr_expect(eq(u32, cli_args.trace_categories, expected));
+    cr_assert_str_eq(cli_args.rom_path, "../build/yobemag.gb");
+}
+
+Test(cli, cli_repeated_trace_category, .exit_code = EXIT_SUCCESS, .init = cr_redirect_stderr) {
+    char *argv[] = {"./yobemag", "-t", "mmu", "-t", "mmu", "../build/yobemag.gb"};
+    int argc     = sizeof(argv) / sizeof(char *);
+
+    CLIArguments cli_args;
+    cli_parse(&cli_args, argc, argv);
+
+    cr_expect(eq(u32, cli_args.trace_categories, 1u << LOG_CAT_MMU));
+}
+
+Test(cli, cli_no_trace_categories, .exit_code = EXIT_SUCCESS, .init = cr_redirect_stderr) {
+    char *argv[] = {"./yobemag", "../build/yobemag.gb"};
+    int argc     = sizeof(argv) / sizeof(char *);
+
+    CLIArguments cli_args;
+    cli_parse(&cli_args, argc, argv);
+
+    cr_expect(eq(u32, cli_args.trace_categories, 0));
+}
+
+Test(cli, cli_unknown_trace_category, .exit_code = EXIT_FAILURE, .init = cr_redirect_stderr) {
+    char *argv[] = {"./yobemag", "-t", "apu", "../build/yobemag.gb"};
+    int argc     = sizeof(argv) / sizeof(char *);
+
+    CLIArguments cli_args;
+    cli_parse(&cli_args, argc, argv);
+}
+
+// category names are lower case
+Test(cli, cli_upper_case_trace_category, .exit_code = EXIT_FAILURE, .init = cr_redirect_stderr) {
+    char *argv[] = {"./yobemag", "-t", "CPU", "../build/yobemag.gb"};
+    int argc     = sizeof(argv) / sizeof(char *);
+
+    CLIArguments cli_args;
+    cli_parse(&cli_args, argc, argv);
+}
+
+Test(cli, cli_no_trace_category, .exit_code = EXIT_FAILURE, .init = cr_redirect_stderr) {
+    char *argv[] = {"./yobemag", "-t"};
+    int argc     = sizeof(argv) / sizeof(char *);
+
+    CLIArguments cli_args;
+    cli_parse(&cli_args, argc, argv);
+}
+
+Test(cli, cli_unthrottled, .exit_code = EXIT_SUCCESS, .init = cr_redirect_stderr) {
+    char *argv[] = {"./yobemag", "-u", "../build/yobemag.gb"};
+    int argc     = sizeof(argv) / sizeof(char *);
+
+    CLIArguments cli_args;
+    cli_parse(&cli_args, argc, argv);
+
+    cr_expect(cli_args.unthrottled);
+    cr_assert_str_eq(cli_args.rom_path, "../build/yobemag.gb");
+}
+
+Test(cli, cli_no_idle_loop_skipping, .exit_code = EXIT_SUCCESS, .init = cr_redirect_stderr) {
+    char *argv[] = {"./yobemag", "-I", "../build/yobemag.gb"};
+    int argc     = sizeof(argv) / sizeof(char *);
+
+    CLIArguments cli_args;
+    cli_parse(&cli_args, argc, argv);
+
+    cr_expect(!cli_args.idle_loop_skipping);
+    cr_expect(!cli_args.unthrottled);
+}
+
+Test(cli, cli_profile_paths, .exit_code = EXIT_SUCCESS, .init = cr_redirect_stderr) {
+    char *argv[] = {"./yobemag", "-P", "out.folded", "-S", "game.sym", "../build/yobemag.gb"};
+    int argc     = sizeof(argv) / sizeof(char *);
+
+    CLIArguments cli_args;
+    cli_parse(&cli_args, argc, argv);
+
+    cr_assert_str_eq(cli_args.profile_path, "out.folded");
+    cr_assert_str_eq(cli_args.sym_path, "game.sym");
+    cr_assert_str_eq(cli_args.rom_path, "../build/yobemag.gb");
+}
+
+Test(cli, cli_trace_path, .exit_code = EXIT_SUCCESS, .init = cr_redirect_stderr) {
+    char *argv[] = {"./yobemag", "-T", "out.trace", "../build/yobemag.gb"};
+    int argc     = sizeof(argv) / sizeof(char *);
+
+    CLIArguments cli_args;
+    cli_parse(&cli_args, argc, argv);
+
+    cr_assert_str_eq(cli_args.trace_path, "out.trace");
+    cr_assert_str_eq(cli_args.rom_path, "../build/yobemag.gb");
+}
+
+Test(cli, cli_timeline_path, .exit_code = EXIT_SUCCESS, .init = cr_redirect_stderr) {
+    char *argv[] = {"./yobemag", "-C", "timeline.json", "../build/yobemag.gb"};
+    int argc     = sizeof(argv) / sizeof(char *);
+
+    CLIArguments cli_args;
+    cli_parse(&cli_args, argc, argv);
+
+    cr_assert_str_eq(cli_args.timeline_path, "timeline.json");
+    cr_assert_null(cli_args.trace_path);
+}
+
+Test(cli, cli_coverage_path, .exit_code = EXIT_SUCCESS, .init = cr_redirect_stderr) {
+    char *argv[] = {"./yobemag", "-V", "rom.cov", "../build/yobemag.gb"};
+    int argc     = sizeof(argv) / sizeof(char *);
+
+    CLIArguments cli_args;
+    cli_parse(&cli_args, argc, argv);
+
+    cr_assert_str_eq(cli_args.coverage_path, "rom.cov");
+    cr_assert_null(cli_args.trace_path);
+}
+
+Test(cli, cli_heatmap_path, .exit_code = EXIT_SUCCESS, .init = cr_redirect_stderr) {
+    char *argv[] = {"./yobemag", "-M", "heatmap.csv", "../build/yobemag.gb"};
+    int argc     = sizeof(argv) / sizeof(char *);
+
+    CLIArguments cli_args;
+    cli_parse(&cli_args, argc, argv);
+
+    cr_assert_str_eq(cli_args.heatmap_path, "heatmap.csv");
+    cr_assert_null(cli_args.coverage_path);
+}
+
+Test(cli, cli_perf_counters, .exit_code = EXIT_SUCCESS, .init = cr_redirect_stderr) {
+    char *argv[] = {"./yobemag", "-H", "../build/yobemag.gb"};
+    int argc     = sizeof(argv) / sizeof(char *);
+
+    CLIArguments cli_args;
+    cli_parse(&cli_args, argc, argv);
+
+    cr_assert(cli_args.perf_counters);
+}
+
+Test(cli, cli_rtc_host_time, .exit_code = EXIT_SUCCESS, .init = cr_redirect_stderr) {
+    char *argv[] = {"./yobemag", "-R", "../build/yobemag.gb"};
+    int argc     = sizeof(argv) / sizeof(char *);
+
+    CLIArguments cli_args;
+    cli_parse(&cli_args, argc, argv);
+
+    cr_assert(cli_args.rtc_host_time);
+    cr_assert(!cli_args.perf_counters);
+}
+
+Test(cli, cli_boot_rom, .exit_code = EXIT_SUCCESS, .init = cr_redirect_stderr) {
+    char *argv[] = {"./yobemag", "-B", "../build/yobemag.gb"};
+    int argc     = sizeof(argv) / sizeof(char *);
+
+    CLIArguments cli_args;
+    cli_parse(&cli_args, argc, argv);
+
+    cr_assert(cli_args.boot_rom);
+    cr_assert(!cli_args.rtc_host_time);
+}
+
+Test(cli, cli_frame_stats_path, .exit_code = EXIT_SUCCESS, .init = cr_redirect_stderr) {
+    char *argv[] = {"./yobemag", "-F", "stats.json", "../build/yobemag.gb"};
+    int argc     = sizeof(argv) / sizeof(char *);
+
+    CLIArguments cli_args;
+    cli_parse(&cli_args, argc, argv);
+
+    cr_assert_str_eq(cli_args.frame_stats_path, "stats.json");
+    cr_assert(!cli_args.perf_counters);
+}
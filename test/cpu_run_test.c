@@ -0,0 +1,258 @@
+#include <criterion/criterion.h>
+#include <criterion/new/assert.h>
+
+#include "fixtures/cpu_mmu.h"
+#include "scheduler.h"
+#include "interrupt.h"
+#include "ppu.h"
+#include "timer.h"
+
+#define CODE_ADDR (0xC000)
+
+// Cycle at which the event handler below ran
+static uint64_t fired_at;
+
+static void stop_event(uint64_t deadline) {
+    (void) deadline;
+    fired_at = cpu.cycle_count;
+    cpu_request_stop();
+}
+
+static void count_event(uint64_t deadline) {
+    (void) deadline;
+    fired_at = cpu.cycle_count;
+}
+
+static void raise_timer(uint64_t deadline) {
+    (void) deadline;
+    interrupt_request(IF_TIMER);
+}
+
+static void set_ly(uint64_t deadline) {
+    (void) deadline;
+    mmu_set_io_register(PPU_LY, 0x90);
+}
+
+static void cpu_run_setup(void) {
+    cpu_mmu_setup();
+    scheduler_init();
+    interrupt_init();
+
+    // INC B (4); NOP (4); JR -4 (12)
+    const uint8_t code[] = {0x04, 0x00, 0x18, 0xFC};
+    load_code(CODE_ADDR, code, sizeof(code));
+    cpu.PC    = CODE_ADDR;
+    CPU_REG_B = 0;
+    fired_at  = 0;
+}
+
+Test(cpu_run, spends_budget, .init = cpu_run_setup, .fini = cpu_teardown) {
+    CPURunResult result = cpu_run(200);
+
+    // 10 iterations of 20 cycles each
+    cr_expect(eq(int, result.reason, CPU_STOP_BUDGET));
+    cr_expect(eq(u64, result.cycles, 200));
+    cr_expect(eq(u64, cpu.cycle_count, 200));
+    cr_expect(eq(u8, CPU_REG_B, 10));
+    cr_expect(eq(u16, cpu.PC, CODE_ADDR));
+}
+
+Test(cpu_run, overshoots_by_last_instruction, .init = cpu_run_setup, .fini = cpu_teardown) {
+    CPURunResult result = cpu_run(10);
+
+    // INC B and NOP take 8 cycles, the JR ends at 20
+    cr_expect(eq(u64, result.cycles, 20));
+}
+
+Test(cpu_run, clock_does_not_wrap, .init = cpu_run_setup, .fini = cpu_teardown) {
+    cpu_run(20 * 0x1000);
+
+    cr_expect(eq(u64, cpu.cycle_count, 20 * 0x1000));
+}
+
+Test(cpu_run, runs_due_events, .init = cpu_run_setup, .fini = cpu_teardown) {
+    scheduler_register(EVENT_FRAME, count_event);
+    scheduler_schedule(EVENT_FRAME, 42);
+
+    CPURunResult result = cpu_run(100);
+
+    // the instruction crossing the deadline completes first
+    cr_expect(eq(int, result.reason, CPU_STOP_BUDGET));
+    cr_expect(eq(u64, fired_at, 44));
+}
+
+Test(cpu_run, event_stops_run, .init = cpu_run_setup, .fini = cpu_teardown) {
+    scheduler_register(EVENT_INPUT_POLL, stop_event);
+    scheduler_schedule(EVENT_INPUT_POLL, 40);
+
+    CPURunResult result = cpu_run(1000);
+
+    cr_expect(eq(int, result.reason, CPU_STOP_EVENT));
+    cr_expect(eq(u64, result.cycles, 40));
+    cr_expect(eq(u64, fired_at, 40));
+}
+
+Test(cpu_run, breakpoint_stops_and_resumes, .init = cpu_run_setup, .fini = cpu_teardown) {
+    cpu_set_breakpoint(CODE_ADDR + 2, true);
+
+    CPURunResult result = cpu_run(1000);
+    cr_expect(eq(int, result.reason, CPU_STOP_BREAKPOINT));
+    cr_expect(eq(u64, result.cycles, 8));
+    cr_expect(eq(u16, cpu.PC, CODE_ADDR + 2));
+
+    // resuming executes the instruction at the breakpoint
+    result = cpu_run(1000);
+    cr_expect(eq(int, result.reason, CPU_STOP_BREAKPOINT));
+    cr_expect(eq(u64, result.cycles, 20));
+    cr_expect(eq(u8, CPU_REG_B, 2));
+
+    cpu_set_breakpoint(CODE_ADDR + 2, false);
+    result = cpu_run(100);
+    cr_expect(eq(int, result.reason, CPU_STOP_BUDGET));
+}
+
+Test(cpu_run, halt_skips_to_next_event, .init = cpu_run_setup, .fini = cpu_teardown) {
+    // HALT; INC B
+    mmu_write_byte(CODE_ADDR, 0x76);
+    mmu_write_byte(CODE_ADDR + 1, 0x04);
+    scheduler_register(EVENT_FRAME, count_event);
+    scheduler_schedule(EVENT_FRAME, 1000);
+
+    CPURunResult result = cpu_run(5000);
+
+    cr_expect(eq(int, result.reason, CPU_STOP_BUDGET));
+    cr_expect(eq(u64, fired_at, 1000));
+    cr_expect(eq(u64, cpu.cycle_count, 5000));
+    cr_expect(eq(u16, cpu.PC, CODE_ADDR + 1));
+    cr_expect(cpu.halted);
+}
+
+Test(cpu_run, halt_wakes_without_ime, .init = cpu_run_setup, .fini = cpu_teardown) {
+    // HALT; INC B
+    mmu_write_byte(CODE_ADDR, 0x76);
+    mmu_write_byte(CODE_ADDR + 1, 0x04);
+    mmu_write_byte(IO_IE, IF_TIMER);
+    scheduler_register(EVENT_TIMER_OVERFLOW, raise_timer);
+    scheduler_schedule(EVENT_TIMER_OVERFLOW, 400);
+
+    cpu_run(404);
+
+    // continues after the HALT without dispatching
+    cr_expect(!cpu.halted);
+    cr_expect(eq(u8, CPU_REG_B, 1));
+    cr_expect(eq(u64, cpu.cycle_count, 404));
+    cr_expect(eq(u16, cpu.PC, CODE_ADDR + 2));
+}
+
+Test(cpu_run, halt_wakes_into_handler, .init = cpu_run_setup, .fini = cpu_teardown) {
+    // EI; HALT
+    mmu_write_byte(CODE_ADDR, 0xFB);
+    mmu_write_byte(CODE_ADDR + 1, 0x76);
+    cpu.SP = 0xD000;
+    mmu_write_byte(IO_IE, IF_TIMER);
+    scheduler_register(EVENT_TIMER_OVERFLOW, raise_timer);
+    scheduler_schedule(EVENT_TIMER_OVERFLOW, 400);
+
+    cpu_run(400);
+
+    cr_expect(!cpu.halted);
+    cr_expect(eq(u16, cpu.PC, INTERRUPT_VECTOR_BASE + 16));
+    cr_expect(eq(u16, mmu_get_two_bytes(cpu.SP), CODE_ADDR + 2));
+    cr_expect(eq(u64, cpu.cycle_count, 400 + INTERRUPT_DISPATCH_CYCLES));
+}
+
+// LDH A, (LY) (12); CP 0x90 (8); JR NZ, -6 (12/8); INC B (4); HALT with LY becoming 0x90 at cycle 10000
+static void run_ly_poll(bool skipping) {
+    const uint8_t code[] = {0xF0, 0x44, 0xFE, 0x90, 0x20, 0xFA, 0x04, 0x76};
+    load_code(CODE_ADDR, code, sizeof(code));
+    mmu_set_io_register(PPU_LY, 0);
+    cpu_set_idle_loop_skipping(skipping);
+    scheduler_register(EVENT_PPU_MODE, set_ly);
+    scheduler_schedule(EVENT_PPU_MODE, 10000);
+
+    // the event runs at 10004 (after CP), the pass starting at 10016 leaves the loop and INC B ends at 10048
+    cpu_run(10048);
+
+    cr_expect(eq(u64, cpu.cycle_count, 10048));
+    cr_expect(eq(u8, CPU_REG_B, 1));
+    cr_expect(eq(u16, cpu.PC, CODE_ADDR + 7));
+}
+
+Test(cpu_run, idle_loop_is_skipped, .init = cpu_run_setup, .fini = cpu_teardown) {
+    run_ly_poll(true);
+
+    // the first two passes prove the loop idle, the 310 passes up to the event are skipped
+    cr_expect(eq(u64, cpu_idle_cycles_skipped(), 310 * 32));
+}
+
+Test(cpu_run, idle_loop_skipping_disabled, .init = cpu_run_setup, .fini = cpu_teardown) {
+    run_ly_poll(false);
+
+    cr_expect(eq(u64, cpu_idle_cycles_skipped(), 0));
+}
+
+Test(cpu_run, loop_with_write_is_not_idle, .init = cpu_run_setup, .fini = cpu_teardown) {
+    // LDH (0x80), A; JR -4
+    const uint8_t code[] = {0xE0, 0x80, 0x18, 0xFC};
+    load_code(CODE_ADDR, code, sizeof(code));
+
+    cpu_run(1000);
+
+    cr_expect(eq(u64, cpu_idle_cycles_skipped(), 0));
+}
+
+Test(cpu_run, timer_poll_is_not_idle, .init = cpu_run_setup, .fini = cpu_teardown) {
+    // LDH A, (DIV); CP 0x90; JR NZ, -6
+    const uint8_t code[] = {0xF0, 0x04, 0xFE, 0x90, 0x20, 0xFA};
+    load_code(CODE_ADDR, code, sizeof(code));
+
+    cpu_run(1000);
+
+    cr_expect(eq(u64, cpu_idle_cycles_skipped(), 0));
+}
+
+Test(cpu_run, power_on_runs_boot_rom, .init = cpu_run_setup, .fini = cpu_teardown) {
+    cr_expect(!mmu_boot_rom_mapped());
+
+    mmu_init();
+    cpu_power_on();
+    cr_expect(eq(u16, cpu.PC, 0x0000));
+
+    // LD SP, 0xFFFE, the first instruction of the boot ROM
+    cpu_step();
+    cr_expect(eq(u16, cpu.SP, 0xFFFE));
+    cr_expect(eq(u16, cpu.PC, 0x0003));
+
+    cpu_init();
+    cr_expect(!mmu_boot_rom_mapped());
+    cr_expect(eq(u16, cpu.PC, 0x0100));
+}
+
+// Events scheduled by an instruction in the middle of a batch have to end that batch early enough
+Test(cpu_run, timer_enabled_within_batch, .init = cpu_run_setup, .fini = cpu_teardown) {
+    // EI; LD A, 0xFF; LDH (TIMA), A; LD A, 0x05; LDH (TAC), A; NOP
+    const uint8_t code[] = {0xFB, 0x3E, 0xFF, 0xE0, 0x05, 0x3E, 0x05, 0xE0, 0x07, 0x00};
+    load_code(CODE_ADDR, code, sizeof(code));
+    cpu.SP = 0xD000;
+    timer_init();
+    mmu_write_byte(IO_IE, IF_TIMER);
+
+    // TAC is written at 44, TIMA overflows at the next 16 cycle tick at 48, right after the NOP
+    cpu_run(48 + INTERRUPT_DISPATCH_CYCLES);
+
+    cr_expect(eq(u16, cpu.PC, INTERRUPT_VECTOR_BASE + 16));
+    cr_expect(eq(u16, mmu_get_two_bytes(cpu.SP), CODE_ADDR + sizeof(code)));
+}
+
+Test(cpu_run, lcd_enabled_within_batch, .init = cpu_run_setup, .fini = cpu_teardown) {
+    // LD A, LCDC_ENABLE; LDH (LCDC), A; LDH A, (LY) (12); CP 1 (8); JR NZ, -6 (12/8); INC B (4); HALT (4)
+    const uint8_t code[] = {0x3E, LCDC_ENABLE, 0xE0, 0x40, 0xF0, 0x44, 0xFE, 0x01, 0x20, 0xFA, 0x04, 0x76};
+    load_code(CODE_ADDR, code, sizeof(code));
+    ppu_init();
+
+    // the LCD is enabled at 20 and LY becomes 1 at 476, which the pass starting at 500 reads, the HALT ends at 536
+    cpu_run(536);
+
+    cr_expect(eq(u8, CPU_REG_B, 1));
+    cr_expect(eq(u16, cpu.PC, CODE_ADDR + sizeof(code)));
+}
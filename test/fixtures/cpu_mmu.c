@@ -1,9 +1,25 @@
 #include "cpu_mmu.h"
+#include "scheduler.h"
 
 void cpu_mmu_setup(void) {
     srandom(0xcafebeef);
+    mmu_init();
     cpu_init();
 }
 
 void cpu_teardown(void) {
 }
+
+void run_until(uint64_t clock) {
+    while (scheduler_next_deadline() <= clock) {
+        cpu.cycle_count = scheduler_next_deadline();
+        scheduler_run_due();
+    }
+    cpu.cycle_count = clock;
+}
+
+void load_code(uint16_t addr, const uint8_t *code, uint16_t length) {
+    for (uint16_t i = 0; i < length; ++i) {
+        mmu_write_byte(addr + i, code[i]);
+    }
+}
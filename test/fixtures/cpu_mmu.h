@@ -11,4 +11,10 @@
 void cpu_mmu_setup(void);
 void cpu_teardown(void);
 
+// Advances the clock like the main loop does, running every scheduled event that falls due on the way
+void run_until(uint64_t clock);
+
+// Writes the length bytes of code to memory from addr on, through the MMU
+void load_code(uint16_t addr, const uint8_t *code, uint16_t length);
+
 #endif // YOBEMAG_TEST_CPU_MMU_H
@@ -0,0 +1,85 @@
+#include <criterion/criterion.h>
+#include <criterion/new/assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "frame_stats.h"
+
+static char stats_path[] = "/tmp/yobemag_statsXXXXXX";
+
+static void frame_stats_setup(void) {
+    close(mkstemp(stats_path));
+    frame_stats_init(stats_path, "roms/\"quoted\".gb");
+}
+
+static void frame_stats_fini(void) {
+    frame_stats_teardown();
+    unlink(stats_path);
+}
+
+Test(frame_stats, small_values_are_exact) {
+    Histogram histogram = {0};
+    for (uint64_t value = 1; value <= 10; ++value) {
+        histogram_record(&histogram, value);
+    }
+
+    cr_expect(eq(u64, histogram_percentile(&histogram, 50), 5));
+    cr_expect(eq(u64, histogram_percentile(&histogram, 90), 9));
+    cr_expect(eq(u64, histogram_percentile(&histogram, 100), 10));
+    cr_expect(eq(u64, histogram.min, 1));
+    cr_expect(eq(u64, histogram.max, 10));
+}
+
+Test(frame_stats, large_values_within_a_sixteenth) {
+    Histogram histogram = {0};
+    // 16.6ms frames, one 40ms stutter
+    for (unsigned frame = 0; frame < 99; ++frame) {
+        histogram_record(&histogram, 16666667);
+    }
+    histogram_record(&histogram, 40000000);
+
+    uint64_t p50 = histogram_percentile(&histogram, 50);
+    cr_expect(ge(u64, p50, 16666667));
+    cr_expect(lt(u64, p50, 16666667 + 16666667 / 16));
+    cr_expect(eq(u64, histogram_percentile(&histogram, 99), p50));
+    cr_expect(eq(u64, histogram_percentile(&histogram, 99.9), 40000000));
+}
+
+Test(frame_stats, empty_histogram) {
+    Histogram histogram = {0};
+    cr_expect(eq(u64, histogram_percentile(&histogram, 50), 0));
+}
+
+Test(frame_stats, phases_of_a_frame, .init = frame_stats_setup, .fini = frame_stats_fini) {
+    frame_stats_add(FRAME_PHASE_PRESENT, 300);
+    frame_stats_add(FRAME_PHASE_INPUT, 100);
+    frame_stats_add(FRAME_PHASE_PRESENT, 200);
+    frame_stats_end_frame(2000, 5000);
+
+    cr_expect(eq(u64, frame_stats_histogram(FRAME_PHASE_EMULATE)->max, 1400));
+    cr_expect(eq(u64, frame_stats_histogram(FRAME_PHASE_PRESENT)->max, 500));
+    cr_expect(eq(u64, frame_stats_histogram(FRAME_PHASE_INPUT)->max, 100));
+    cr_expect(eq(u64, frame_stats_histogram(FRAME_PHASE_SLEEP)->max, 5000));
+    cr_expect(eq(u64, frame_stats_histogram(FRAME_PHASE_TOTAL)->max, 7000));
+
+    // the next frame starts from zero
+    frame_stats_end_frame(1000, 0);
+    cr_expect(eq(u64, frame_stats_histogram(FRAME_PHASE_PRESENT)->min, 0));
+    cr_expect(eq(u64, frame_stats_histogram(FRAME_PHASE_EMULATE)->min, 1000));
+}
+
+Test(frame_stats, dumps_json, .init = frame_stats_setup, .fini = frame_stats_fini) {
+    frame_stats_end_frame(10, 6);
+    frame_stats_dump();
+
+    char buf[8192];
+    FILE *file    = fopen(stats_path, "r");
+    size_t length = fread(buf, 1, sizeof(buf) - 1, file);
+    fclose(file);
+    buf[length] = '\0';
+
+    cr_expect_not_null(strstr(buf, "{\"rom\": \"roms/\\\"quoted\\\".gb\", \"unit\": \"ns\", \"frames\": 1"));
+    cr_expect_not_null(strstr(buf, "\"total\": {\"count\": 1, \"min\": 16, \"mean\": 16, \"max\": 16, \"p50\": 16, "
+                                   "\"p90\": 16, \"p99\": 16, \"p99.9\": 16, \"buckets\": [[16, 1]]}"));
+}
@@ -0,0 +1,127 @@
+#include <criterion/criterion.h>
+#include <criterion/new/assert.h>
+
+#include "fixtures/cpu_mmu.h"
+#include "scheduler.h"
+#include "interrupt.h"
+
+#define CODE_ADDR  (0xC000)
+#define STACK_ADDR (0xD000)
+
+static void interrupt_setup(void) {
+    cpu_mmu_setup();
+    scheduler_init();
+    interrupt_init();
+    cpu.SP = STACK_ADDR;
+}
+
+Test(interrupt, registers_are_mapped, .init = interrupt_setup, .fini = cpu_teardown) {
+    mmu_write_byte(IO_IE, IF_TIMER | IF_VBLANK);
+    mmu_write_byte(IO_IF, 0xFF);
+
+    cr_expect(eq(u8, mmu_get_byte(IO_IE), IF_TIMER | IF_VBLANK));
+    cr_expect(eq(u8, mmu_get_byte(IO_IF), 0xFF));
+    cr_expect(eq(u8, interrupts.flags, IF_MASK));
+
+    mmu_write_byte(IO_IF, 0);
+    interrupt_request(IF_STAT);
+    cr_expect(eq(u8, mmu_get_byte(IO_IF), 0xE0 | IF_STAT));
+}
+
+Test(interrupt, not_checked_while_disabled, .init = interrupt_setup, .fini = cpu_teardown) {
+    // NOP; NOP
+    const uint8_t code[] = {0x00, 0x00};
+    load_code(CODE_ADDR, code, sizeof(code));
+    cpu.PC = CODE_ADDR;
+    mmu_write_byte(IO_IE, IF_VBLANK);
+
+    interrupt_request(IF_VBLANK);
+    cr_expect(!interrupts.dirty);
+
+    cpu_run(8);
+    cr_expect(eq(u16, cpu.PC, CODE_ADDR + 2));
+    cr_expect(eq(u8, interrupts.flags, IF_VBLANK));
+}
+
+Test(interrupt, ei_takes_effect_after_next_instruction, .init = interrupt_setup, .fini = cpu_teardown) {
+    // EI; INC B
+    const uint8_t code[] = {0xFB, 0x04};
+    load_code(CODE_ADDR, code, sizeof(code));
+    cpu.PC = CODE_ADDR;
+    CPU_REG_B = 0;
+    mmu_write_byte(IO_IE, IF_VBLANK);
+    interrupt_request(IF_VBLANK);
+
+    cpu_run(1);
+
+    cr_expect(eq(u8, CPU_REG_B, 1));
+    cr_expect(eq(u16, cpu.PC, INTERRUPT_VECTOR_BASE));
+    cr_expect(eq(u16, cpu.SP, STACK_ADDR - 2));
+    cr_expect(eq(u16, mmu_get_two_bytes(cpu.SP), CODE_ADDR + 2));
+    cr_expect(eq(u64, cpu.cycle_count, 4 + 4 + INTERRUPT_DISPATCH_CYCLES));
+    cr_expect(!interrupts.ime);
+    cr_expect(eq(u8, interrupts.flags, 0));
+}
+
+Test(interrupt, di_cancels_ei, .init = interrupt_setup, .fini = cpu_teardown) {
+    // EI; DI; NOP
+    const uint8_t code[] = {0xFB, 0xF3, 0x00};
+    load_code(CODE_ADDR, code, sizeof(code));
+    cpu.PC = CODE_ADDR;
+    mmu_write_byte(IO_IE, IF_VBLANK);
+    interrupt_request(IF_VBLANK);
+
+    cpu_run(12);
+
+    cr_expect(eq(u16, cpu.PC, CODE_ADDR + 3));
+    cr_expect(!interrupts.ime);
+}
+
+Test(interrupt, highest_priority_first, .init = interrupt_setup, .fini = cpu_teardown) {
+    // EI; NOP
+    const uint8_t code[] = {0xFB, 0x00};
+    load_code(CODE_ADDR, code, sizeof(code));
+    cpu.PC = CODE_ADDR;
+    mmu_write_byte(IO_IE, IF_MASK);
+    interrupt_request(IF_TIMER | IF_STAT);
+
+    cpu_run(1);
+
+    // STAT
+    cr_expect(eq(u16, cpu.PC, INTERRUPT_VECTOR_BASE + 8));
+    cr_expect(eq(u8, interrupts.flags, IF_TIMER));
+}
+
+Test(interrupt, request_while_running_dispatches, .init = interrupt_setup, .fini = cpu_teardown) {
+    // EI; NOP; JR -2
+    const uint8_t code[] = {0xFB, 0x00, 0x18, 0xFE};
+    load_code(CODE_ADDR, code, sizeof(code));
+    cpu.PC = CODE_ADDR;
+    mmu_write_byte(IO_IE, IF_TIMER);
+
+    cpu_run(100);
+    cr_expect(interrupts.ime);
+
+    interrupt_request(IF_TIMER);
+    cpu_run(1);
+    cr_expect(eq(u16, cpu.PC, INTERRUPT_VECTOR_BASE + 16));
+    cr_expect(eq(u16, mmu_get_two_bytes(cpu.SP), CODE_ADDR + 2));
+}
+
+Test(interrupt, reti_enables_immediately, .init = interrupt_setup, .fini = cpu_teardown) {
+    // RETI
+    const uint8_t code[] = {0xD9};
+    load_code(CODE_ADDR, code, sizeof(code));
+    cpu.PC = CODE_ADDR;
+    mmu_stack_push(CODE_ADDR + 0x100);
+    mmu_write_byte(IO_IE, IF_TIMER);
+    interrupt_request(IF_TIMER);
+
+    cpu_run(1);
+
+    // returned and got interrupted again right away
+    cr_expect(eq(u16, cpu.PC, INTERRUPT_VECTOR_BASE + 16));
+    cr_expect(eq(u16, mmu_get_two_bytes(cpu.SP), CODE_ADDR + 0x100));
+    cr_expect(eq(u16, cpu.SP, STACK_ADDR - 2));
+    cr_expect(eq(u64, cpu.cycle_count, 16 + INTERRUPT_DISPATCH_CYCLES));
+}
@@ -0,0 +1,177 @@
+#include <criterion/criterion.h>
+#include <criterion/new/assert.h>
+#include <string.h>
+
+#include "fixtures/cpu_mmu.h"
+#include "block_cache.h"
+#include "scheduler.h"
+
+#if defined(YOBEMAG_JIT)
+
+    #include "jit.h"
+
+    #define CODE_ADDR    (0xC000)
+    #define DATA_ADDR    (0xD000)
+    #define INSTRUCTIONS (20000)
+    #define REWRITES     (40000)
+
+// clang-format off
+static const uint8_t alu_loop[] = {
+    0x41,       // LD B, C
+    0x03,       // INC BC
+    0x80,       // ADD A, B
+    0x22,       // LD (HL+), A
+    0xA9,       // XOR A, C
+    0x57,       // LD D, A
+    0x1D,       // DEC E
+    0x20, 0xF7, // JR NZ, -9
+    0x18, 0xFE, // JR -2
+};
+
+// Loads and stores of plain memory, echo RAM and HRAM. Echo RAM is not mapped for the native code, HRAM is only
+// accessed natively at constant addresses.
+static const uint8_t memory_loop[] = {
+    0x01, 0x80, 0xD0, // LD BC, DATA_ADDR + 0x80
+    0x16, 0xF0,       // LD D, 0xF0
+    0x0A,             // LD A, (BC)
+    0x9E,             // SBC A, (HL)
+    0x8F,             // ADC A, A
+    0x34,             // INC (HL)
+    0x12,             // LD (DE), A
+    0x3A,             // LD A, (HL-)
+    0x35,             // DEC (HL)
+    0xEA, 0x80, 0xFF, // LD (0xFF80), A
+    0x0C,             // INC C
+    0xF0, 0x80,       // LDH A, (0x80)
+    0xE0, 0x81,       // LDH (0x81), A
+    0xFA, 0x81, 0xFF, // LD A, (0xFF81)
+    0x02,             // LD (BC), A
+    0xF6, 0x01,       // OR A, 0x01
+    0x1D,             // DEC E
+    0x20, 0xE8,       // JR NZ, -24
+    0x18, 0xFE,       // JR -2
+};
+
+// LD (HL), A patches the operand of the following LD B, d8 on every iteration
+static const uint8_t self_modifying_loop[] = {
+    0x3C,       // INC A
+    0x77,       // LD (HL), A
+    0x06, 0x00, // LD B, d8
+    0x48,       // LD C, B
+    0x1D,       // DEC E
+    0x20, 0xF8, // JR NZ, -8
+    0x18, 0xFE, // JR -2
+};
+// clang-format on
+
+typedef struct Snapshot {
+    CPU cpu;
+    uint8_t data[0x100];
+} Snapshot;
+
+// Runs INSTRUCTIONS instructions, or `cycle_budget` cycles via cpu_run() if it is not 0
+static void run(const uint8_t *code, uint16_t code_size, uint16_t hl, bool jit, uint64_t cycle_budget,
+                Snapshot *snapshot) {
+    cpu_init();
+    scheduler_init();
+    block_cache_flush();
+    load_code(CODE_ADDR, code, code_size);
+    for (uint16_t i = 0; i < sizeof(snapshot->data); ++i) {
+        mmu_write_byte(DATA_ADDR + i, 0);
+    }
+    cpu.PC      = CODE_ADDR;
+    CPU_DREG_HL = hl;
+    CPU_REG_A   = 0;
+    CPU_REG_F   = 0;
+    CPU_REG_E   = 100;
+
+    if (jit) {
+        jit_init();
+    }
+    if (cycle_budget) {
+        cpu_run(cycle_budget);
+    } else {
+        cpu_step_n(INSTRUCTIONS);
+    }
+    if (jit) {
+        jit_teardown();
+    }
+
+    snapshot->cpu          = cpu;
+    snapshot->cpu.AF.dword = CPU_DREG_AF;
+    for (uint16_t i = 0; i < sizeof(snapshot->data); ++i) {
+        snapshot->data[i] = mmu_get_byte(DATA_ADDR + i);
+    }
+}
+
+static void expect_same_state(const Snapshot *interpreted, const Snapshot *compiled) {
+    cr_expect(eq(u16, compiled->cpu.AF.dword, interpreted->cpu.AF.dword));
+    cr_expect(eq(u16, compiled->cpu.BC.dword, interpreted->cpu.BC.dword));
+    cr_expect(eq(u16, compiled->cpu.DE.dword, interpreted->cpu.DE.dword));
+    cr_expect(eq(u16, compiled->cpu.HL.dword, interpreted->cpu.HL.dword));
+    cr_expect(eq(u16, compiled->cpu.SP, interpreted->cpu.SP));
+    cr_expect(eq(u16, compiled->cpu.PC, interpreted->cpu.PC));
+    cr_expect(eq(u64, compiled->cpu.cycle_count, interpreted->cpu.cycle_count));
+    cr_expect(zero(i32, memcmp(compiled->data, interpreted->data, sizeof(compiled->data))));
+}
+
+Test(jit, matches_interpreter, .init = cpu_mmu_setup, .fini = cpu_teardown) {
+    Snapshot interpreted, compiled;
+    run(alu_loop, sizeof(alu_loop), DATA_ADDR, false, 0, &interpreted);
+    run(alu_loop, sizeof(alu_loop), DATA_ADDR, true, 0, &compiled);
+
+    expect_same_state(&interpreted, &compiled);
+}
+
+Test(jit, self_modifying_code_matches_interpreter, .init = cpu_mmu_setup, .fini = cpu_teardown) {
+    Snapshot interpreted, compiled;
+    run(self_modifying_loop, sizeof(self_modifying_loop), CODE_ADDR + 3, false, 0, &interpreted);
+    run(self_modifying_loop, sizeof(self_modifying_loop), CODE_ADDR + 3, true, 0, &compiled);
+
+    expect_same_state(&interpreted, &compiled);
+    cr_expect(eq(u8, compiled.cpu.BC.words.lo, 100));
+}
+
+Test(jit, memory_access_matches_interpreter, .init = cpu_mmu_setup, .fini = cpu_teardown) {
+    Snapshot interpreted, compiled;
+    run(memory_loop, sizeof(memory_loop), DATA_ADDR + 0xC0, false, 0, &interpreted);
+    run(memory_loop, sizeof(memory_loop), DATA_ADDR + 0xC0, true, 0, &compiled);
+
+    expect_same_state(&interpreted, &compiled);
+    cr_expect(eq(u8, compiled.cpu.DE.words.lo, 0));
+}
+
+Test(jit, cycle_budget_matches_interpreter, .init = cpu_mmu_setup, .fini = cpu_teardown) {
+    Snapshot interpreted, compiled;
+    run(alu_loop, sizeof(alu_loop), DATA_ADDR, false, 12345, &interpreted);
+    run(alu_loop, sizeof(alu_loop), DATA_ADDR, true, 12345, &compiled);
+
+    expect_same_state(&interpreted, &compiled);
+}
+
+// Every rewrite invalidates the block, its recompiled code takes new space in the code buffer until that is recycled
+Test(jit, code_buffer_recycling, .init = cpu_mmu_setup, .fini = cpu_teardown) {
+    cpu_init();
+    scheduler_init();
+    block_cache_flush();
+    jit_init();
+
+    for (uint32_t i = 0; i < REWRITES; ++i) {
+        // clang-format off
+        const uint8_t code[] = {
+            0x06, (uint8_t) i, // LD B, d8
+            0x04,              // INC B
+            0x18, 0xFB,        // JR -5
+        };
+        // clang-format on
+        load_code(CODE_ADDR, code, sizeof(code));
+        cpu.PC = CODE_ADDR;
+        cpu_run(1680);
+
+        cr_assert(eq(u8, CPU_REG_B, (uint8_t) (i + 1)));
+    }
+
+    jit_teardown();
+}
+
+#endif // defined(YOBEMAG_JIT)
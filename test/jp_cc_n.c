@@ -56,4 +56,7 @@ ParameterizedTest(JrNZTestParams *params, jp_cc_n, jp_cc_n, .init = cpu_mmu_setu
     } else {
         cr_expect(eq(u8, cpu.PC, opcode_address + 3));
     }
+
+    // check if the clock is advanced by the taken/not taken cycles
+    cr_expect(eq(u64, cpu.cycle_count, params->branching_condition ? 16 : 12));
 }
@@ -69,4 +69,7 @@ ParameterizedTest(JrNZTestParams *params, jr_cc_n, jr_cc_n, .init = cpu_mmu_setu
     }
 
     cr_expect(eq(u8, cpu.PC, opcode_address + 2 + branching_addition));
+
+    // check if the clock is advanced by the taken/not taken cycles
+    cr_expect(eq(u64, cpu.cycle_count, params->branching_condition ? 12 : 8));
 }
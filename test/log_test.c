@@ -54,3 +54,28 @@ Test(log, log_warn_about_clamping, .init = cr_redirect_stderr) {
     cr_assert_not_null(strstr(buf, "higher"));
     cr_assert_not_null(strstr(buf, "WARNING"));
 }
+
+Test(log, log_respect_category_lvl, .init = cr_redirect_stderr) {
+    log_set_lvl(WARNING);
+    log_set_category_lvl(LOG_CAT_CPU, DEBUG);
+
+    // this translation unit logs as LOG_CAT_GENERAL, which stays at WARNING
+    LOG_DEBUG("Debug message");
+
+    log_teardown();
+
+    char buf[MAX_LOG_MSG_LENGTH] = {0};
+    FILE *f_stderr               = cr_get_redirected_stderr();
+    while (fread(buf, 1, sizeof(buf), f_stderr) > 0) {};
+    fclose(f_stderr);
+
+    cr_assert_null(strstr(buf, "Debug message"));
+    cr_assert(eq(int, log_category_lvl[LOG_CAT_CPU], DEBUG));
+    cr_assert(eq(int, log_category_lvl[LOG_CAT_MMU], WARNING));
+}
+
+Test(log, log_category_from_name) {
+    cr_assert(eq(int, log_category_from_name("cpu"), LOG_CAT_CPU));
+    cr_assert(eq(int, log_category_from_name("rom"), LOG_CAT_ROM));
+    cr_assert(eq(int, log_category_from_name("gpu"), LOG_CAT_COUNT));
+}
@@ -0,0 +1,197 @@
+#include <criterion/criterion.h>
+#include <criterion/new/assert.h>
+#include <criterion/redirect.h>
+#include <unistd.h>
+
+#include "mbc.h"
+#include "mmu.h"
+#include "rom.h"
+#include "cpu.h"
+
+#define BANK_NUMBER_OFFSET (0x2000)
+
+static char rom_path[] = "/tmp/yobemag_mbcXXXXXX";
+
+/*
+ * Writes a ROM of @p banks banks whose header names @p type and @p ram_size, every bank holds its number at
+ * BANK_NUMBER_OFFSET, then loads it
+ */
+static void load_rom(uint8_t type, unsigned banks, uint8_t ram_size) {
+    FILE *rom = fdopen(mkstemp(rom_path), "wb");
+    cr_assert_not_null(rom);
+
+    static uint8_t bank[ROM_BANK_SIZE];
+    for (unsigned number = 0; number < banks; ++number) {
+        memset(bank, 0, sizeof(bank));
+        bank[BANK_NUMBER_OFFSET]     = (uint8_t) number;
+        bank[BANK_NUMBER_OFFSET + 1] = (uint8_t) (number >> 8);
+        if (number == 0) {
+            bank[0x147] = type;
+            bank[0x149] = ram_size;
+        }
+        fwrite(bank, 1, sizeof(bank), rom);
+    }
+    fclose(rom);
+
+    // the mapping outlives the file
+    rom_init(rom_path);
+    unlink(rom_path);
+    mmu_init();
+    mbc_init(NULL, RTC_CLOCK_EMULATED);
+}
+
+static uint16_t bank_at(uint16_t region) {
+    return (uint16_t) (mmu_get_byte(region + BANK_NUMBER_OFFSET) | mmu_get_byte(region + BANK_NUMBER_OFFSET + 1) << 8);
+}
+
+static void mbc_fini(void) {
+    mbc_teardown();
+    rom_destroy();
+}
+
+Test(mbc, rom_only_ignores_writes, .init = cr_redirect_stderr, .fini = mbc_fini) {
+    load_rom(0x00, 2, 0x00);
+
+    mmu_write_byte(0x2000, 0x01);
+    cr_expect(eq(u16, bank_at(0x4000), 1));
+    cr_expect(eq(u8, mmu_get_byte(0x2000), 0));
+}
+
+Test(mbc, mbc1_switches_rom_banks, .init = cr_redirect_stderr, .fini = mbc_fini) {
+    load_rom(0x01, 64, 0x00);
+    cr_expect(eq(u16, bank_at(0x0000), 0));
+    cr_expect(eq(u16, bank_at(0x4000), 1));
+
+    mmu_write_byte(0x2000, 0x05);
+    cr_expect(eq(u16, bank_at(0x4000), 5));
+    cr_expect(eq(u16, mmu_get_bank(0x4000), 5));
+
+    // bank 0 cannot be selected in the switchable region, only five bits are used
+    mmu_write_byte(0x2000, 0x00);
+    cr_expect(eq(u16, bank_at(0x4000), 1));
+    mmu_write_byte(0x3FFF, 0x25);
+    cr_expect(eq(u16, bank_at(0x4000), 5));
+
+    // the upper bits extend the bank number, in mode 1 they select the bank at 0x0000 as well
+    mmu_write_byte(0x4000, 0x01);
+    cr_expect(eq(u16, bank_at(0x4000), 0x25));
+    cr_expect(eq(u16, bank_at(0x0000), 0));
+    mmu_write_byte(0x6000, 0x01);
+    cr_expect(eq(u16, bank_at(0x0000), 0x20));
+    cr_expect(eq(u16, mmu_get_bank(0x0000), 0x20));
+
+    // back in mode 0 only the switchable region keeps the upper bits
+    mmu_write_byte(0x6000, 0x00);
+    cr_expect(eq(u16, bank_at(0x0000), 0));
+    cr_expect(eq(u16, bank_at(0x4000), 0x25));
+}
+
+Test(mbc, mbc1_switches_ram_banks, .init = cr_redirect_stderr, .fini = mbc_fini) {
+    load_rom(0x03, 4, 0x03);
+
+    // disabled RAM is not there
+    mmu_write_byte(0xA000, 0x11);
+    cr_expect(eq(u8, mmu_get_byte(0xA000), 0xFF));
+
+    mmu_write_byte(0x0000, 0x0A);
+    mmu_write_byte(0xA000, 0x11);
+    mmu_write_byte(0xBFFF, 0x12);
+    cr_expect(eq(u8, mmu_get_byte(0xA000), 0x11));
+    cr_expect(eq(u8, mmu_get_byte(0xBFFF), 0x12));
+
+    // RAM banks are only switched in mode 1
+    mmu_write_byte(0x4000, 0x02);
+    cr_expect(eq(u8, mmu_get_byte(0xA000), 0x11));
+    mmu_write_byte(0x6000, 0x01);
+    cr_expect(eq(u8, mmu_get_byte(0xA000), 0x00));
+    mmu_write_byte(0xA000, 0x22);
+
+    mmu_write_byte(0x4000, 0x00);
+    cr_expect(eq(u8, mmu_get_byte(0xA000), 0x11));
+    mmu_write_byte(0x4000, 0x02);
+    cr_expect(eq(u8, mmu_get_byte(0xA000), 0x22));
+
+    mmu_write_byte(0x0000, 0x00);
+    cr_expect(eq(u8, mmu_get_byte(0xA000), 0xFF));
+}
+
+Test(mbc, mbc3_switches_banks, .init = cr_redirect_stderr, .fini = mbc_fini) {
+    load_rom(0x13, 128, 0x03);
+
+    mmu_write_byte(0x2000, 0x7F);
+    cr_expect(eq(u16, bank_at(0x4000), 0x7F));
+    mmu_write_byte(0x2000, 0x00);
+    cr_expect(eq(u16, bank_at(0x4000), 1));
+
+    mmu_write_byte(0x0000, 0x0A);
+    mmu_write_byte(0x4000, 0x03);
+    mmu_write_byte(0xA123, 0x33);
+    cr_expect(eq(u8, mmu_get_byte(0xA123), 0x33));
+    mmu_write_byte(0x4000, 0x00);
+    cr_expect(eq(u8, mmu_get_byte(0xA123), 0x00));
+}
+
+Test(mbc, mbc5_switches_banks, .init = cr_redirect_stderr, .fini = mbc_fini) {
+    load_rom(0x1B, 512, 0x04);
+
+    // all nine bits are used and bank 0 can be selected
+    mmu_write_byte(0x2000, 0x00);
+    cr_expect(eq(u16, bank_at(0x4000), 0));
+    mmu_write_byte(0x3000, 0x01);
+    cr_expect(eq(u16, bank_at(0x4000), 0x100));
+    mmu_write_byte(0x2000, 0xFF);
+    cr_expect(eq(u16, bank_at(0x4000), 0x1FF));
+    cr_expect(eq(u16, mmu_get_bank(0x7FFF), 0x1FF));
+
+    mmu_write_byte(0x0000, 0x0A);
+    mmu_write_byte(0x4000, 0x0F);
+    mmu_write_byte(0xA000, 0x44);
+    cr_expect(eq(u8, mmu_get_byte(0xA000), 0x44));
+    mmu_write_byte(0x4000, 0x00);
+    cr_expect(eq(u8, mmu_get_byte(0xA000), 0x00));
+}
+
+Test(mbc, mbc3_reads_latched_clock, .init = cr_redirect_stderr, .fini = mbc_fini) {
+    load_rom(0x10, 2, 0x02);
+    mmu_write_byte(0x0000, 0x0A);
+
+    cpu.cycle_count += 61ull * CPU_CLOCK_HZ;
+    mmu_write_byte(0x4000, RTC_SECONDS);
+    cr_expect(eq(u8, mmu_get_byte(0xA000), 0));
+
+    mmu_write_byte(0x6000, 0x00);
+    mmu_write_byte(0x6000, 0x01);
+    cr_expect(eq(u8, mmu_get_byte(0xA000), 1));
+    mmu_write_byte(0x4000, RTC_MINUTES);
+    cr_expect(eq(u8, mmu_get_byte(0xBFFF), 1));
+
+    // RAM bank 0 is still there
+    mmu_write_byte(0x4000, 0x00);
+    mmu_write_byte(0xA000, 0x77);
+    cr_expect(eq(u8, mmu_get_byte(0xA000), 0x77));
+}
+
+Test(mbc, battery_ram_is_saved, .init = cr_redirect_stderr, .fini = mbc_fini) {
+    load_rom(0x03, 2, 0x02);
+
+    // the save file is next to the ROM, which has no extension
+    char save_path[sizeof(rom_path) + 4];
+    snprintf(save_path, sizeof(save_path), "%s.sav", rom_path);
+
+    mbc_init(rom_path, RTC_CLOCK_EMULATED);
+    mmu_write_byte(0x0000, 0x0A);
+    mmu_write_byte(0xA000, 0x5A);
+    mbc_teardown();
+    cr_assert(eq(int, access(save_path, F_OK), 0));
+
+    mbc_init(rom_path, RTC_CLOCK_EMULATED);
+    mmu_write_byte(0x0000, 0x0A);
+    cr_expect(eq(u8, mmu_get_byte(0xA000), 0x5A));
+
+    // without a path, nothing is loaded or stored
+    mbc_teardown();
+    unlink(save_path);
+    mbc_init(NULL, RTC_CLOCK_EMULATED);
+    mmu_write_byte(0x0000, 0x0A);
+    cr_expect(eq(u8, mmu_get_byte(0xA000), 0x00));
+}
@@ -0,0 +1,74 @@
+#include <criterion/criterion.h>
+#include <criterion/new/assert.h>
+
+#include "mmu.h"
+
+#if defined(YOBEMAG_MEM_HEATMAP)
+
+    #include "mem_heatmap.h"
+
+static char buf[1 << 16];
+
+static void heatmap_setup(void) {
+    mem_heatmap_init(NULL);
+}
+
+static const char *csv(void) {
+    FILE *stream  = tmpfile();
+    mem_heatmap_write_csv(stream);
+    rewind(stream);
+    size_t length = fread(buf, 1, sizeof(buf) - 1, stream);
+    fclose(stream);
+    buf[length] = '\0';
+    return buf;
+}
+
+Test(mem_heatmap, counts_per_page, .init = heatmap_setup) {
+    mmu_write_byte(0xC000, 1);
+    mmu_write_byte(0xC0FF, 2);
+    mmu_get_byte(0xC010);
+    mmu_get_byte(0xC100);
+
+    cr_expect(eq(u64, mem_heatmap_writes[mem_heatmap_slot(0xC000)], 2));
+    cr_expect(eq(u64, mem_heatmap_reads[mem_heatmap_slot(0xC000)], 1));
+    cr_expect(eq(u64, mem_heatmap_reads[mem_heatmap_slot(0xC100)], 1));
+    cr_expect(eq(u64, mem_heatmap_writes[mem_heatmap_slot(0xC100)], 0));
+}
+
+Test(mem_heatmap, counts_io_registers_separately, .init = heatmap_setup) {
+    mmu_get_byte(0xFF44);
+    mmu_get_byte(0xFF44);
+    mmu_write_byte(0xFF80, 3);
+
+    cr_expect(eq(u64, mem_heatmap_reads[mem_heatmap_slot(0xFF44)], 2));
+    cr_expect(eq(u64, mem_heatmap_reads[mem_heatmap_slot(0xFF45)], 0));
+    cr_expect(eq(u64, mem_heatmap_writes[mem_heatmap_slot(0xFF80)], 1));
+}
+
+Test(mem_heatmap, counts_switchable_rom_per_bank, .init = heatmap_setup) {
+    mmu_get_byte(0x4000);
+
+    unsigned slot = mem_heatmap_slot(0x4000);
+    cr_expect(ne(u32, slot, mem_heatmap_slot(0x0000)));
+    cr_expect(ge(u32, slot, MEM_HEATMAP_PAGES + MEM_HEATMAP_PAGE_SIZE));
+    cr_expect(eq(u64, mem_heatmap_reads[slot], 1));
+}
+
+Test(mem_heatmap, writes_csv, .init = heatmap_setup) {
+    mmu_get_byte(0x4000);
+    mmu_write_byte(0xC000, 1);
+    mmu_get_byte(0xFF44);
+
+    const char *text = csv();
+    cr_expect(eq(int, strncmp(text, "region,bank,first,last,reads,writes\n", 36), 0));
+    cr_expect_not_null(strstr(text, "\nrom0,0,0x0000,0x00FF,0,0\n"));
+    cr_expect_not_null(strstr(text, "\nromx,1,0x4000,0x40FF,1,0\n"));
+    cr_expect_not_null(strstr(text, "\nwram,-1,0xC000,0xC0FF,0,1\n"));
+    cr_expect_not_null(strstr(text, "\nio,-1,0xFF44,0xFF44,1,0\n"));
+    cr_expect_not_null(strstr(text, "\nhram,-1,0xFF80,0xFF80,0,0\n"));
+    cr_expect_not_null(strstr(text, "\nie,-1,0xFFFF,0xFFFF,0,0\n"));
+    // banks which were never mapped are left out
+    cr_expect_null(strstr(text, "romx,2,"));
+}
+
+#endif // defined(YOBEMAG_MEM_HEATMAP)
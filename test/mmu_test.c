@@ -1,19 +1,24 @@
 #include <criterion/criterion.h>
 #include <criterion/new/assert.h>
 #include <criterion/logging.h>
-#include <criterion/redirect.h>
 #include <signal.h>
 #include <libgen.h>
 
 #include "mmu.h"
 #include "rom.h"
-#include "log.h"
 
-#define MAX_PATH_LENGTH    (512)
-#define MAX_LOG_MSG_LENGTH (512)
+#define MAX_PATH_LENGTH (512)
 
 static const uint8_t partial_boot_rom[] = {0x31, 0xFE, 0xAF, 0x32, 0x0E, 0xE0, 0xF9, 0x06, 0x50};
 
+static uint16_t handled_addr;
+static uint8_t handled_value;
+
+static void record_write(uint16_t addr, uint8_t value) {
+    handled_addr  = addr;
+    handled_value = value;
+}
+
 Test(mmu, mmu_init_with_rom_load, .exit_code = EXIT_SUCCESS) {
     char *file_path_copy                = strdup(__FILE__);
     char rom_file_path[MAX_PATH_LENGTH] = {0};
@@ -30,22 +35,27 @@ Test(mmu, mmu_init_with_rom_load, .exit_code = EXIT_SUCCESS) {
 }
 
 Test(mmu, mmu_get_byte_inside_rom, .exit_code = EXIT_SUCCESS) {
+    mmu_init();
     cr_assert(mmu_get_byte(113) == 0x13);
 }
 
-Test(mmu, mmu_write_byte_to_rom, .init = cr_redirect_stderr) {
-    log_set_lvl(ERROR);
-
-    mmu_write_byte(0x100, 0xFF);
+Test(mmu, mmu_write_byte_to_rom, .exit_code = EXIT_SUCCESS) {
+    char *file_path_copy                = strdup(__FILE__);
+    char rom_file_path[MAX_PATH_LENGTH] = {0};
+    snprintf(rom_file_path, MAX_PATH_LENGTH, "%s/../roms/yobemag.gb", dirname(file_path_copy));
+    rom_init(rom_file_path);
+    mmu_init();
+    mmu_register_cartridge(record_write, NULL, NULL);
 
-    char buf[MAX_LOG_MSG_LENGTH] = {0};
-    FILE *f_stderr               = cr_get_redirected_stderr();
-    while (fread(buf, 1, sizeof(buf), f_stderr) > 0) {};
-    fclose(f_stderr);
+    // the write goes to the memory bank controller, the ROM itself stays unchanged
+    uint8_t before = mmu_get_byte(0x2100);
+    mmu_write_byte(0x2100, (uint8_t) ~before);
+    cr_expect(eq(u16, handled_addr, 0x2100));
+    cr_expect(eq(u8, handled_value, (uint8_t) ~before));
+    cr_expect(eq(u8, mmu_get_byte(0x2100), before));
 
-    cr_assert_not_null(strstr(buf, "reserved"));
-    cr_assert_not_null(strstr(buf, "0x100"));
-    cr_assert_not_null(strstr(buf, "ERROR"));
+    rom_destroy();
+    free(file_path_copy);
 }
 
 Test(mmu, mmu_write_byte_outside_rom, .exit_code = EXIT_SUCCESS) {
@@ -53,22 +63,155 @@ Test(mmu, mmu_write_byte_outside_rom, .exit_code = EXIT_SUCCESS) {
     cr_assert(mmu_get_byte(ROM_LIMIT + 1) == 0xFF);
 }
 
-Test(mmu, mmu_write_two_bytes_to_rom, .init = cr_redirect_stderr) {
-    log_set_lvl(ERROR);
+Test(mmu, mmu_write_two_bytes_outside_rom, .exit_code = EXIT_SUCCESS) {
+    mmu_write_two_bytes(ROM_LIMIT, 0xFF);
+    cr_assert(mmu_get_two_bytes(ROM_LIMIT) == 0xFF);
+}
+
+Test(mmu, mmu_get_four_bytes, .exit_code = EXIT_SUCCESS) {
+    mmu_write_two_bytes(ROM_LIMIT, 0x2211);
+    mmu_write_two_bytes(ROM_LIMIT + 2, 0x4433);
+    cr_assert(eq(u32, mmu_get_four_bytes(ROM_LIMIT), 0x44332211));
+
+    // the boot ROM is read at once as well
+    mmu_init();
+    cr_assert(eq(u32, mmu_get_four_bytes(0), 0xAFFFFE31));
+}
+
+Test(mmu, mmu_reads_rom_in_place, .exit_code = EXIT_SUCCESS) {
+    char *file_path_copy                = strdup(__FILE__);
+    char rom_file_path[MAX_PATH_LENGTH] = {0};
+    snprintf(rom_file_path, MAX_PATH_LENGTH, "%s/../roms/yobemag.gb", dirname(file_path_copy));
+    rom_init(rom_file_path);
+    mmu_init();
+
+    const uint8_t *rom_bytes = get_rom_bytes();
+    cr_expect(eq(u8, mmu_get_byte(0x0150), rom_bytes[0x0150]));
+    cr_expect(eq(u8, mmu_get_byte(0x4000), rom_bytes[0x4000]));
+    cr_expect(eq(u8, mmu_get_byte(ROM_LIMIT - 1), rom_bytes[ROM_LIMIT - 1]));
+    // the boot ROM still overlays the first page
+    cr_expect(eq(u8, mmu_get_byte(0x0000), partial_boot_rom[0]));
 
-    mmu_write_two_bytes(ROM_LIMIT - 1, 0xAB);
+    rom_destroy();
+    free(file_path_copy);
+}
 
-    char buf[MAX_LOG_MSG_LENGTH] = {0};
-    FILE *f_stderr               = cr_get_redirected_stderr();
-    while (fread(buf, 1, sizeof(buf), f_stderr) > 0) {};
-    fclose(f_stderr);
+Test(mmu, mmu_get_two_bytes_across_pages, .exit_code = EXIT_SUCCESS) {
+    mmu_write_byte(0xC0FF, 0x34);
+    mmu_write_byte(0xC100, 0x12);
+    cr_assert(eq(u16, mmu_get_two_bytes(0xC0FF), 0x1234));
 
-    cr_assert_not_null(strstr(buf, "reserved"));
-    cr_assert_not_null(strstr(buf, "0x7fff"));
-    cr_assert_not_null(strstr(buf, "ERROR"));
+    // HRAM shares the I/O page, which is read byte by byte
+    mmu_write_two_bytes(0xFF80, 0xBEEF);
+    cr_assert(eq(u16, mmu_get_two_bytes(0xFF80), 0xBEEF));
 }
 
-Test(mmu, mmu_write_two_bytes_outside_rom, .exit_code = EXIT_SUCCESS) {
-    mmu_write_two_bytes(ROM_LIMIT, 0xFF);
-    cr_assert(mmu_get_two_bytes(ROM_LIMIT) == 0xFF);
+Test(mmu, mmu_fetch_byte_follows_writes, .exit_code = EXIT_SUCCESS) {
+    mmu_init();
+
+    mmu_write_byte(0xC000, 0x12);
+    cr_expect(eq(u8, mmu_fetch_byte(0xC000), 0x12));
+    // the page is remembered, but its memory is read on every fetch
+    mmu_write_byte(0xC001, 0x34);
+    cr_expect(eq(u8, mmu_fetch_byte(0xC001), 0x34));
+    cr_expect(eq(u32, mmu_code_page_index, 0xC0));
+
+    // code in HRAM shares the I/O page, which is never remembered
+    mmu_write_byte(0xFF80, 0x56);
+    cr_expect(eq(u8, mmu_fetch_byte(0xFF80), 0x56));
+    cr_expect(eq(u32, mmu_code_page_index, 0xC0));
+}
+
+Test(mmu, mmu_io_write_handler, .exit_code = EXIT_SUCCESS) {
+    mmu_init();
+    mmu_register_io_write(0xFF01, record_write);
+
+    mmu_write_byte(0xFF01, 0x42);
+    cr_expect(eq(u16, handled_addr, 0xFF01));
+    cr_expect(eq(u8, handled_value, 0x42));
+    // the handler decides whether the value is stored
+    cr_expect(eq(u8, mmu_get_byte(0xFF01), 0));
+
+    mmu_register_io_write(0xFF01, NULL);
+    mmu_write_byte(0xFF01, 0x43);
+    cr_expect(eq(u8, mmu_get_byte(0xFF01), 0x43));
+}
+
+Test(mmu, mmu_hram_is_plain_memory, .exit_code = EXIT_SUCCESS) {
+    mmu_init();
+    mmu_register_io_write(0xFFFF, record_write);
+
+    mmu_write_byte(0xFF80, 0x12);
+    mmu_write_byte(0xFFFE, 0x34);
+    cr_expect(eq(u8, mmu_get_byte(0xFF80), 0x12));
+    cr_expect(eq(u8, mmu_get_byte(0xFFFE), 0x34));
+
+    // IE shares the page with HRAM, but keeps its handler
+    mmu_write_byte(0xFFFF, 0x1F);
+    cr_expect(eq(u16, handled_addr, 0xFFFF));
+    cr_expect(eq(u8, handled_value, 0x1F));
+}
+
+Test(mmu, mmu_write_two_bytes_to_rom, .exit_code = EXIT_SUCCESS) {
+    mmu_init();
+    mmu_register_cartridge(record_write, NULL, NULL);
+
+    // both bytes reach the cartridge, e.g. its bank registers
+    mmu_write_two_bytes(0x2000, 0x0305);
+    cr_expect(eq(u16, handled_addr, 0x2001));
+    cr_expect(eq(u8, handled_value, 0x03));
+}
+
+Test(mmu, mmu_echo_ram_mirrors_wram, .exit_code = EXIT_SUCCESS) {
+    mmu_init();
+
+    mmu_write_byte(0xC123, 0x11);
+    cr_expect(eq(u8, mmu_get_byte(0xE123), 0x11));
+    mmu_write_byte(0xFDFF, 0x22);
+    cr_expect(eq(u8, mmu_get_byte(0xDDFF), 0x22));
+}
+
+Test(mmu, mmu_write_to_mapped_rom_is_ignored, .exit_code = EXIT_SUCCESS) {
+    char *file_path_copy                = strdup(__FILE__);
+    char rom_file_path[MAX_PATH_LENGTH] = {0};
+    snprintf(rom_file_path, MAX_PATH_LENGTH, "%s/../roms/yobemag.gb", dirname(file_path_copy));
+    rom_init(rom_file_path);
+    mmu_init();
+
+    uint8_t before = mmu_get_byte(0x0150);
+    mmu_write_byte(0x0150, (uint8_t) ~before);
+    cr_expect(eq(u8, mmu_get_byte(0x0150), before));
+
+    rom_destroy();
+    free(file_path_copy);
+}
+
+Test(mmu, mmu_boot_write_unmaps_boot_rom, .exit_code = EXIT_SUCCESS) {
+    char *file_path_copy                = strdup(__FILE__);
+    char rom_file_path[MAX_PATH_LENGTH] = {0};
+    snprintf(rom_file_path, MAX_PATH_LENGTH, "%s/../roms/yobemag.gb", dirname(file_path_copy));
+    rom_init(rom_file_path);
+    mmu_init();
+
+    const uint8_t *rom_bytes = get_rom_bytes();
+    cr_expect(mmu_boot_rom_mapped());
+    cr_expect(eq(u8, mmu_fetch_byte(0x0000), partial_boot_rom[0]));
+
+    // writing 0 does not unmap it
+    mmu_write_byte(IO_BOOT, 0x00);
+    cr_expect(eq(u8, mmu_get_byte(0x0000), partial_boot_rom[0]));
+
+    // the RST vectors and the code page are read from the ROM afterwards
+    mmu_write_byte(IO_BOOT, 0x01);
+    cr_expect(!mmu_boot_rom_mapped());
+    cr_expect(eq(u8, mmu_get_byte(0x0038), rom_bytes[0x0038]));
+    cr_expect(eq(u8, mmu_fetch_byte(0x0000), rom_bytes[0x0000]));
+    cr_expect(eq(u32, mmu_get_four_bytes(0x0000), *(const uint32_t *) rom_bytes));
+
+    // mmu_init() maps it again
+    mmu_init();
+    cr_expect(eq(u8, mmu_get_byte(0x0000), partial_boot_rom[0]));
+
+    rom_destroy();
+    free(file_path_copy);
 }
@@ -0,0 +1,60 @@
+#include <criterion/criterion.h>
+#include <criterion/new/assert.h>
+#include <string.h>
+
+#include "fixtures/cpu_mmu.h"
+#include "opcode_profile.h"
+
+#if defined(YOBEMAG_PROFILE)
+
+    #define CODE_ADDR (0xC000)
+
+static void opcode_profile_setup(void) {
+    cpu_mmu_setup();
+    opcode_profile_reset();
+
+    // INC B (4); BIT 0, B (8); NOP (4); JR -6 (12)
+    const uint8_t code[] = {0x04, 0xCB, 0x40, 0x00, 0x18, 0xFA};
+    load_code(CODE_ADDR, code, sizeof(code));
+    cpu.PC = CODE_ADDR;
+}
+
+Test(opcode_profile, counts_executions_and_cycles, .init = opcode_profile_setup, .fini = cpu_teardown) {
+    cpu_step_n(8);
+
+    cr_expect(eq(u64, opcode_profile.count[0x04], 2));
+    cr_expect(eq(u64, opcode_profile.cycles[0x04], 8));
+    cr_expect(eq(u64, opcode_profile.count[0x00], 2));
+    cr_expect(eq(u64, opcode_profile.cycles[0x18], 24));
+}
+
+Test(opcode_profile, counts_cb_prefixed_by_second_byte, .init = opcode_profile_setup, .fini = cpu_teardown) {
+    cpu_step_n(8);
+
+    cr_expect(eq(u64, opcode_profile.count[0xCB], 0));
+    cr_expect(eq(u64, opcode_profile.cb_count[0x40], 2));
+    cr_expect(eq(u64, opcode_profile.cb_cycles[0x40], 16));
+}
+
+Test(opcode_profile, report_is_sorted_by_cycles, .init = opcode_profile_setup, .fini = cpu_teardown) {
+    cpu_step_n(8);
+
+    char buf[1024] = {0};
+    FILE *report   = tmpfile();
+    opcode_profile_report(report);
+    rewind(report);
+    size_t length = fread(buf, 1, sizeof(buf) - 1, report);
+    fclose(report);
+    buf[length] = '\0';
+
+    cr_assert_not_null(strstr(buf, "4 opcodes executed in 56 cycles"));
+    // JR (24 cycles) comes before BIT 0, B (16), INC B and NOP (8 each) follow in opcode order
+    char *jr  = strstr(buf, "\n18 ");
+    char *bit = strstr(buf, "\nCB 40");
+    char *nop = strstr(buf, "\n00 ");
+    char *inc = strstr(buf, "\n04 ");
+    cr_assert(jr && bit && nop && inc);
+    cr_expect(jr < bit && bit < nop && nop < inc);
+}
+
+#endif // defined(YOBEMAG_PROFILE)
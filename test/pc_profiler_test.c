@@ -0,0 +1,109 @@
+#include <criterion/criterion.h>
+#include <criterion/new/assert.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "fixtures/cpu_mmu.h"
+#include "pc_profiler.h"
+#include "scheduler.h"
+#include "interrupt.h"
+
+#define CODE_ADDR (0xC000)
+
+static char sym_path[]    = "/tmp/yobemag_symXXXXXX";
+static char output_path[] = "/tmp/yobemag_profileXXXXXX";
+
+static void write_temp_file(char *path, const char *content) {
+    int fd = mkstemp(path);
+    cr_assert(fd >= 0);
+    cr_assert(eq(sz, (size_t) write(fd, content, strlen(content)), strlen(content)));
+    close(fd);
+}
+
+static void pc_profiler_setup(void) {
+    cpu_mmu_setup();
+    scheduler_init();
+    interrupt_init();
+
+    write_temp_file(sym_path, "; File generated by rgblink\n"
+                              "00:0150 Start\n"
+                              "00:0160 Start.loop\n"
+                              "00:C000 Main\n"
+                              "00:C010 Wait\n"
+                              "01:4000 Banked\n");
+    write_temp_file(output_path, "");
+    pc_profiler_init(output_path, sym_path);
+}
+
+static void pc_profiler_fini(void) {
+    pc_profiler_teardown();
+    unlink(sym_path);
+    unlink(output_path);
+    cpu_teardown();
+}
+
+// Stops the profiler and returns the collapsed stacks it wrote
+static void read_profile(char *buf, size_t size) {
+    pc_profiler_teardown();
+
+    FILE *file    = fopen(output_path, "r");
+    size_t length = fread(buf, 1, size - 1, file);
+    fclose(file);
+    buf[length] = '\0';
+}
+
+Test(pc_profiler, resolves_global_labels, .init = pc_profiler_setup, .fini = pc_profiler_fini) {
+    cr_assert_str_eq(pc_profiler_symbol(0, 0x0150), "Start");
+    // local labels belong to the function before them
+    cr_assert_str_eq(pc_profiler_symbol(0, 0x0165), "Start");
+    cr_assert_str_eq(pc_profiler_symbol(1, 0x4100), "Banked");
+    cr_expect_null(pc_profiler_symbol(0, 0x0100));
+    cr_expect_null(pc_profiler_symbol(2, 0x4100));
+}
+
+Test(pc_profiler, samples_call_stack, .init = pc_profiler_setup, .fini = pc_profiler_fini) {
+    // Main: CALL Wait; JR Main
+    const uint8_t main_code[] = {0xCD, 0x10, 0xC0, 0x18, 0xFB};
+    // Wait: NOP; JR Wait
+    const uint8_t wait_code[] = {0x00, 0x18, 0xFD};
+    load_code(CODE_ADDR, main_code, sizeof(main_code));
+    load_code(CODE_ADDR + 0x10, wait_code, sizeof(wait_code));
+    cpu.PC = CODE_ADDR;
+    cpu.SP = 0xD000;
+
+    cpu_run(10 * PC_PROFILER_PERIOD);
+
+    char buf[256];
+    read_profile(buf, sizeof(buf));
+    cr_expect_str_eq(buf, "Main;Wait 10\n");
+}
+
+Test(pc_profiler, returns_drop_frames, .init = pc_profiler_setup, .fini = pc_profiler_fini) {
+    // Main: CALL Wait; JR -2
+    const uint8_t main_code[] = {0xCD, 0x10, 0xC0, 0x18, 0xFE};
+    // Wait: RET
+    const uint8_t wait_code[] = {0xC9};
+    load_code(CODE_ADDR, main_code, sizeof(main_code));
+    load_code(CODE_ADDR + 0x10, wait_code, sizeof(wait_code));
+    cpu.PC = CODE_ADDR;
+    cpu.SP = 0xD000;
+
+    cpu_run(10 * PC_PROFILER_PERIOD);
+
+    char buf[256];
+    read_profile(buf, sizeof(buf));
+    cr_expect_str_eq(buf, "Main 10\n");
+}
+
+Test(pc_profiler, unknown_code_as_address, .init = pc_profiler_setup, .fini = pc_profiler_fini) {
+    // JR -2 below the first symbol
+    const uint8_t code[] = {0x18, 0xFE};
+    load_code(0xA000, code, sizeof(code));
+    cpu.PC = 0xA000;
+
+    cpu_run(3 * PC_PROFILER_PERIOD);
+
+    char buf[256];
+    read_profile(buf, sizeof(buf));
+    cr_expect_str_eq(buf, "00:A000 3\n");
+}
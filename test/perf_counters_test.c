@@ -0,0 +1,62 @@
+#include <criterion/criterion.h>
+#include <criterion/new/assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "perf_counters.h"
+
+static char buf[4096];
+
+static void perf_counters_fini(void) {
+    perf_counters_teardown();
+}
+
+static const char *report(void) {
+    FILE *stream  = tmpfile();
+    perf_counters_report(stream);
+    rewind(stream);
+    size_t length = fread(buf, 1, sizeof(buf) - 1, stream);
+    fclose(stream);
+    buf[length] = '\0';
+    return buf;
+}
+
+Test(perf_counters, percentiles_per_slice, .fini = perf_counters_fini) {
+    // hosts without perf events (e.g. containers) still record, the report just has no counter rows
+    bool available = perf_counters_init();
+
+    for (uint64_t slice = 1; slice <= 100; ++slice) {
+        uint64_t deltas[PERF_COUNTER_COUNT] = {
+            [PERF_COUNTER_CYCLES]        = 1000 * slice,
+            [PERF_COUNTER_INSTRUCTIONS]  = 2000 * slice,
+            [PERF_COUNTER_BRANCH_MISSES] = 4 * slice,
+            [PERF_COUNTER_ICACHE_MISSES] = slice,
+            [PERF_COUNTER_TASK_CLOCK]    = 10 * slice,
+        };
+        perf_counters_record(deltas);
+    }
+
+    const char *text = report();
+    cr_expect_not_null(strstr(text, "100 slices"));
+    if (available && strstr(text, "task-clock") != NULL) {
+        cr_expect_not_null(strstr(text, "task-clock (ns)            500.00         900.00         990.00        1000.00"));
+    }
+    if (available && strstr(text, "IPC") != NULL) {
+        cr_expect_not_null(strstr(text, "IPC                          2.00           2.00           2.00           2.00"));
+    }
+}
+
+Test(perf_counters, measures_slices, .fini = perf_counters_fini) {
+    perf_counters_init();
+
+    for (unsigned slice = 0; slice < 3; ++slice) {
+        perf_counters_begin();
+        perf_counters_end();
+    }
+
+    cr_expect_not_null(strstr(report(), "3 slices"));
+}
+
+Test(perf_counters, empty_report) {
+    cr_expect_str_eq(report(), "Host performance counters per slice: 0 slices\n");
+}
@@ -0,0 +1,91 @@
+#include <criterion/criterion.h>
+#include <criterion/new/assert.h>
+
+#include "fixtures/cpu_mmu.h"
+#include "scheduler.h"
+#include "interrupt.h"
+#include "ppu.h"
+
+static void ppu_setup(void) {
+    cpu_mmu_setup();
+    scheduler_init();
+    ppu_init();
+    interrupt_init();
+}
+
+Test(ppu, lcd_off_schedules_nothing, .init = ppu_setup) {
+    cr_expect(!scheduler_is_pending(EVENT_PPU_MODE));
+    cr_expect(eq(u8, mmu_get_byte(PPU_LY), 0));
+}
+
+Test(ppu, modes_of_a_visible_line, .init = ppu_setup) {
+    mmu_write_byte(PPU_LCDC, LCDC_ENABLE);
+    cr_expect(eq(u8, mmu_get_byte(PPU_STAT) & 0x03, PPU_MODE_OAM_SCAN));
+
+    run_until(80);
+    cr_expect(eq(u8, mmu_get_byte(PPU_STAT) & 0x03, PPU_MODE_TRANSFER));
+
+    run_until(80 + 172);
+    cr_expect(eq(u8, mmu_get_byte(PPU_STAT) & 0x03, PPU_MODE_HBLANK));
+
+    run_until(CYCLES_PER_LINE);
+    cr_expect(eq(u8, mmu_get_byte(PPU_STAT) & 0x03, PPU_MODE_OAM_SCAN));
+    cr_expect(eq(u8, mmu_get_byte(PPU_LY), 1));
+}
+
+Test(ppu, vblank_and_frame_wrap, .init = ppu_setup) {
+    mmu_write_byte(PPU_LCDC, LCDC_ENABLE);
+
+    run_until(CYCLES_PER_LINE * VISIBLE_LINES);
+    cr_expect(eq(u8, mmu_get_byte(PPU_LY), VISIBLE_LINES));
+    cr_expect(eq(u8, mmu_get_byte(PPU_STAT) & 0x03, PPU_MODE_VBLANK));
+    cr_expect(eq(u8, mmu_get_byte(IO_IF) & IF_VBLANK, IF_VBLANK));
+
+    run_until(CYCLES_PER_FRAME - 1);
+    cr_expect(eq(u8, mmu_get_byte(PPU_LY), LINES_PER_FRAME - 1));
+
+    run_until(CYCLES_PER_FRAME);
+    cr_expect(eq(u8, mmu_get_byte(PPU_LY), 0));
+    cr_expect(eq(u8, mmu_get_byte(PPU_STAT) & 0x03, PPU_MODE_OAM_SCAN));
+}
+
+Test(ppu, lcdc_write_stops_and_restarts, .init = ppu_setup) {
+    mmu_write_byte(PPU_LCDC, LCDC_ENABLE);
+    run_until(CYCLES_PER_LINE * 10 + 5);
+
+    mmu_write_byte(PPU_LCDC, 0);
+    cr_expect(!scheduler_is_pending(EVENT_PPU_MODE));
+    cr_expect(eq(u8, mmu_get_byte(PPU_LY), 0));
+
+    mmu_write_byte(PPU_LCDC, LCDC_ENABLE);
+    cr_expect(eq(u64, scheduler_next_deadline(), CYCLES_PER_LINE * 10 + 5 + 80));
+}
+
+Test(ppu, ly_is_read_only, .init = ppu_setup) {
+    mmu_write_byte(PPU_LCDC, LCDC_ENABLE);
+    run_until(CYCLES_PER_LINE * 3);
+
+    mmu_write_byte(PPU_LY, 0x42);
+    cr_expect(eq(u8, mmu_get_byte(PPU_LY), 3));
+}
+
+Test(ppu, stat_keeps_mode_and_coincidence, .init = ppu_setup) {
+    mmu_write_byte(PPU_LCDC, LCDC_ENABLE);
+
+    // LY and LYC are both 0, hence the coincidence flag stays set while the written mode bits are dropped
+    mmu_write_byte(PPU_STAT, 0x78 | 0x03);
+    cr_expect(eq(u8, mmu_get_byte(PPU_STAT), 0x80 | 0x78 | 0x04 | PPU_MODE_OAM_SCAN));
+}
+
+Test(ppu, dma_copies_to_oam, .init = ppu_setup) {
+    for (uint16_t offset = 0; offset < OAM_LENGTH; ++offset) {
+        mmu_write_byte(0xC100 + offset, (uint8_t) (offset ^ 0x5A));
+    }
+
+    mmu_write_byte(PPU_DMA, 0xC1);
+
+    cr_expect(eq(u8, mmu_get_byte(PPU_DMA), 0xC1));
+    for (uint16_t offset = 0; offset < OAM_LENGTH; ++offset) {
+        cr_assert(eq(u8, mmu_get_byte(OAM_START + offset), (uint8_t) (offset ^ 0x5A)));
+    }
+}
@@ -0,0 +1,123 @@
+#include <criterion/criterion.h>
+#include <criterion/new/assert.h>
+#include <libgen.h>
+#include <unistd.h>
+
+#include "rom.h"
+#include "mmu.h"
+
+#if defined(YOBEMAG_ROM_COVERAGE)
+
+    #include "rom_coverage.h"
+
+    #define MAX_PATH_LENGTH (512)
+
+static char coverage_path[] = "/tmp/yobemag_coverageXXXXXX";
+static char buf[1024];
+
+static void coverage_setup(void) {
+    char *file_path_copy                = strdup(__FILE__);
+    char rom_file_path[MAX_PATH_LENGTH] = {0};
+    snprintf(rom_file_path, MAX_PATH_LENGTH, "%s/../roms/yobemag.gb", dirname(file_path_copy));
+    rom_init(rom_file_path);
+    mmu_init();
+    free(file_path_copy);
+
+    close(mkstemp(coverage_path));
+    rom_coverage_init(coverage_path);
+}
+
+static void coverage_fini(void) {
+    rom_coverage_teardown();
+    unlink(coverage_path);
+    rom_destroy();
+}
+
+static const char *report(void) {
+    FILE *stream  = tmpfile();
+    rom_coverage_report(stream);
+    rewind(stream);
+    size_t length = fread(buf, 1, sizeof(buf) - 1, stream);
+    fclose(stream);
+    buf[length] = '\0';
+    return buf;
+}
+
+static bool executed(size_t offset) {
+    return (rom_coverage_map[offset / 8] >> (offset % 8)) & 1u;
+}
+
+Test(rom_coverage, marks_instruction_bytes, .init = coverage_setup, .fini = coverage_fini) {
+    cr_assert(eq(sz, rom_coverage_size, get_rom_size()));
+
+    rom_coverage_mark(0x150, 3);
+
+    cr_expect(!executed(0x14F));
+    cr_expect(executed(0x150));
+    cr_expect(executed(0x151));
+    cr_expect(executed(0x152));
+    cr_expect(!executed(0x153));
+}
+
+Test(rom_coverage, maps_switchable_bank_to_file_offset, .init = coverage_setup, .fini = coverage_fini) {
+    rom_coverage_mark(0x4000, 1);
+
+    size_t offset = (size_t) mmu_get_bank(0x4000) * ROM_BANK_SIZE;
+    cr_expect(executed(offset));
+    cr_expect(!executed(offset + 1));
+}
+
+Test(rom_coverage, ignores_boot_rom_and_ram, .init = coverage_setup, .fini = coverage_fini) {
+    rom_coverage_mark(0x0000, 3);
+    rom_coverage_mark(BOOT_ROM_SIZE - 1, 1);
+    rom_coverage_mark(0xC000, 3);
+
+    for (size_t byte = 0; byte < (rom_coverage_size + 7) / 8; ++byte) {
+        cr_assert(eq(u8, rom_coverage_map[byte], 0));
+    }
+}
+
+Test(rom_coverage, marks_rst_vectors_after_boot, .init = coverage_setup, .fini = coverage_fini) {
+    mmu_unmap_boot_rom();
+    rom_coverage_mark(0x0038, 1);
+
+    cr_expect(executed(0x38));
+}
+
+Test(rom_coverage, stops_at_region_end, .init = coverage_setup, .fini = coverage_fini) {
+    rom_coverage_mark(ROM_BANK_SIZE - 1, 3);
+
+    cr_expect(executed(ROM_BANK_SIZE - 1));
+    cr_expect(!executed(ROM_BANK_SIZE));
+}
+
+Test(rom_coverage, reports_banks, .init = coverage_setup, .fini = coverage_fini) {
+    rom_coverage_mark(0x100, 2);
+    rom_coverage_mark(0x200, 2);
+
+    const char *text = report();
+    cr_expect_not_null(strstr(text, "4 of 131072 bytes"));
+    // bank 0, then bank 7 as the last one of the 128 KiB test ROM
+    cr_expect_not_null(strstr(text, "\n0               4    0.02%\n"));
+    cr_expect_not_null(strstr(text, "\n7               0    0.00%\n"));
+}
+
+Test(rom_coverage, writes_bitmap, .init = coverage_setup) {
+    rom_coverage_mark(0x100, 2);
+    size_t size = rom_coverage_size;
+    rom_coverage_teardown();
+
+    FILE *bitmap = fopen(coverage_path, "rb");
+    cr_assert_not_null(bitmap);
+    uint8_t first[0x100 / 8 + 1];
+    cr_assert(eq(sz, fread(first, 1, sizeof(first), bitmap), sizeof(first)));
+    cr_expect(eq(u8, first[0x100 / 8], 0x03));
+    fseek(bitmap, 0, SEEK_END);
+    cr_expect(eq(sz, (size_t) ftell(bitmap), (size + 7) / 8));
+    fclose(bitmap);
+
+    unlink(coverage_path);
+    rom_destroy();
+}
+
+#endif // defined(YOBEMAG_ROM_COVERAGE)
@@ -0,0 +1,101 @@
+#include <criterion/criterion.h>
+#include <criterion/new/assert.h>
+#include <time.h>
+
+#include "rtc.h"
+#include "cpu.h"
+
+static void rtc_setup(void) {
+    cpu.cycle_count = 0;
+    rtc_init(RTC_CLOCK_EMULATED);
+}
+
+static void run_seconds(uint64_t seconds) {
+    cpu.cycle_count += seconds * CPU_CLOCK_HZ;
+}
+
+Test(rtc, counts_emulated_time_when_latched, .init = rtc_setup) {
+    run_seconds(2 * 86400 + 3 * 3600 + 4 * 60 + 5);
+    cr_expect(eq(u8, rtc_read(RTC_SECONDS), 0));
+
+    rtc_latch();
+    cr_expect(eq(u8, rtc_read(RTC_SECONDS), 5));
+    cr_expect(eq(u8, rtc_read(RTC_MINUTES), 4));
+    cr_expect(eq(u8, rtc_read(RTC_HOURS), 3));
+    cr_expect(eq(u8, rtc_read(RTC_DAYS_LOW), 2));
+    cr_expect(eq(u8, rtc_read(RTC_DAYS_HIGH), 0));
+
+    // the fraction of a second is not lost between latches
+    cpu.cycle_count += CPU_CLOCK_HZ / 2;
+    rtc_latch();
+    cpu.cycle_count += CPU_CLOCK_HZ / 2;
+    rtc_latch();
+    cr_expect(eq(u8, rtc_read(RTC_SECONDS), 6));
+}
+
+Test(rtc, day_counter_overflows, .init = rtc_setup) {
+    rtc_write(RTC_DAYS_LOW, 0xFF);
+    rtc_write(RTC_DAYS_HIGH, 0x01);
+    rtc_latch();
+    cr_expect(eq(u8, rtc_read(RTC_DAYS_HIGH), 0x01));
+
+    run_seconds(86400);
+    rtc_latch();
+    cr_expect(eq(u8, rtc_read(RTC_DAYS_LOW), 0x00));
+    cr_expect(eq(u8, rtc_read(RTC_DAYS_HIGH), 0x80));
+}
+
+Test(rtc, halt_stops_the_clock, .init = rtc_setup) {
+    run_seconds(10);
+    rtc_write(RTC_DAYS_HIGH, 0x40);
+    run_seconds(100);
+    rtc_latch();
+    cr_expect(eq(u8, rtc_read(RTC_SECONDS), 10));
+
+    rtc_write(RTC_DAYS_HIGH, 0x00);
+    run_seconds(1);
+    rtc_latch();
+    cr_expect(eq(u8, rtc_read(RTC_SECONDS), 11));
+}
+
+Test(rtc, writes_are_masked, .init = rtc_setup) {
+    rtc_write(RTC_HOURS, 0xFF);
+    rtc_write(RTC_DAYS_HIGH, 0xFF);
+    rtc_latch();
+    cr_expect(eq(u8, rtc_read(RTC_HOURS), 0x1F));
+    cr_expect(eq(u8, rtc_read(RTC_DAYS_HIGH), 0xC1));
+}
+
+Test(rtc, save_and_load, .init = rtc_setup) {
+    run_seconds(3661);
+    rtc_latch();
+    run_seconds(1);
+
+    uint8_t state[RTC_SAVE_SIZE];
+    rtc_save(state);
+    // the registers are stored as 32-bit values
+    cr_expect(eq(u8, state[0], 2));
+    cr_expect(eq(u8, state[4], 1));
+    cr_expect(eq(u8, state[20], 1));
+
+    rtc_init(RTC_CLOCK_EMULATED);
+    rtc_load(state);
+    cr_expect(eq(u8, rtc_read(RTC_SECONDS), 1));
+    rtc_latch();
+    cr_expect(eq(u8, rtc_read(RTC_SECONDS), 2));
+    cr_expect(eq(u8, rtc_read(RTC_HOURS), 1));
+}
+
+Test(rtc, host_clock_catches_up_on_load, .init = rtc_setup) {
+    uint8_t state[RTC_SAVE_SIZE] = {0};
+    uint64_t saved_at            = (uint64_t) time(NULL) - 3600;
+    for (unsigned byte = 0; byte < sizeof(saved_at); ++byte) {
+        state[40 + byte] = (uint8_t) (saved_at >> (8 * byte));
+    }
+
+    rtc_init(RTC_CLOCK_HOST);
+    rtc_load(state);
+    rtc_latch();
+    cr_expect(eq(u8, rtc_read(RTC_HOURS), 1));
+    cr_expect(eq(u8, rtc_read(RTC_DAYS_LOW), 0));
+}
@@ -0,0 +1,120 @@
+#include <criterion/criterion.h>
+#include <criterion/new/assert.h>
+
+#include "cpu.h"
+#include "scheduler.h"
+
+static EventType order[16];
+static uint64_t order_deadline[16];
+static unsigned fired;
+
+static void record(EventType type, uint64_t deadline) {
+    order[fired]          = type;
+    order_deadline[fired] = deadline;
+    ++fired;
+}
+
+static void on_ppu(uint64_t deadline) {
+    record(EVENT_PPU_MODE, deadline);
+}
+
+static void on_timer(uint64_t deadline) {
+    record(EVENT_TIMER_OVERFLOW, deadline);
+}
+
+static void on_frame(uint64_t deadline) {
+    record(EVENT_FRAME, deadline);
+}
+
+// Reschedules itself periodically
+static void on_input(uint64_t deadline) {
+    record(EVENT_INPUT_POLL, deadline);
+    scheduler_schedule(EVENT_INPUT_POLL, deadline + 10);
+}
+
+static void scheduler_setup(void) {
+    fired = 0;
+    scheduler_init();
+    scheduler_register(EVENT_PPU_MODE, on_ppu);
+    scheduler_register(EVENT_TIMER_OVERFLOW, on_timer);
+    scheduler_register(EVENT_FRAME, on_frame);
+    scheduler_register(EVENT_INPUT_POLL, on_input);
+}
+
+Test(scheduler, empty_never_due, .init = scheduler_setup) {
+    cr_expect(eq(u64, scheduler_next_deadline(), EVENT_NEVER));
+
+    cpu.cycle_count = 1000;
+    scheduler_run_due();
+    cr_expect(eq(u32, fired, 0));
+}
+
+Test(scheduler, runs_events_in_deadline_order, .init = scheduler_setup) {
+    scheduler_schedule(EVENT_FRAME, 300);
+    scheduler_schedule(EVENT_PPU_MODE, 200);
+    scheduler_schedule(EVENT_TIMER_OVERFLOW, 100);
+    cr_expect(eq(u64, scheduler_next_deadline(), 100));
+
+    cpu.cycle_count = 250;
+    scheduler_run_due();
+    cr_assert(eq(u32, fired, 2));
+    cr_expect(eq(int, order[0], EVENT_TIMER_OVERFLOW));
+    cr_expect(eq(int, order[1], EVENT_PPU_MODE));
+    cr_expect(eq(u64, order_deadline[1], 200));
+    cr_expect(eq(u64, scheduler_next_deadline(), 300));
+    cr_expect(!scheduler_is_pending(EVENT_PPU_MODE));
+}
+
+Test(scheduler, simultaneous_events_run_in_type_order, .init = scheduler_setup) {
+    scheduler_schedule(EVENT_FRAME, 50);
+    scheduler_schedule(EVENT_PPU_MODE, 50);
+
+    cpu.cycle_count = 50;
+    scheduler_run_due();
+    cr_assert(eq(u32, fired, 2));
+    cr_expect(eq(int, order[0], EVENT_PPU_MODE));
+    cr_expect(eq(int, order[1], EVENT_FRAME));
+}
+
+Test(scheduler, reschedule_moves_pending_event, .init = scheduler_setup) {
+    scheduler_schedule(EVENT_TIMER_OVERFLOW, 100);
+    scheduler_schedule(EVENT_FRAME, 200);
+
+    scheduler_schedule(EVENT_TIMER_OVERFLOW, 400);
+    cr_expect(eq(u64, scheduler_next_deadline(), 200));
+
+    scheduler_schedule(EVENT_TIMER_OVERFLOW, 20);
+    cr_expect(eq(u64, scheduler_next_deadline(), 20));
+
+    cpu.cycle_count = 1000;
+    scheduler_run_due();
+    cr_assert(eq(u32, fired, 2));
+    cr_expect(eq(int, order[0], EVENT_TIMER_OVERFLOW));
+    cr_expect(eq(u64, order_deadline[0], 20));
+}
+
+Test(scheduler, cancel_removes_event, .init = scheduler_setup) {
+    scheduler_schedule(EVENT_PPU_MODE, 10);
+    scheduler_schedule(EVENT_TIMER_OVERFLOW, 20);
+    scheduler_schedule(EVENT_FRAME, 30);
+
+    scheduler_cancel(EVENT_PPU_MODE);
+    scheduler_cancel(EVENT_PPU_MODE);
+    cr_expect(eq(u64, scheduler_next_deadline(), 20));
+
+    cpu.cycle_count = 30;
+    scheduler_run_due();
+    cr_assert(eq(u32, fired, 2));
+    cr_expect(eq(int, order[0], EVENT_TIMER_OVERFLOW));
+    cr_expect(eq(int, order[1], EVENT_FRAME));
+}
+
+Test(scheduler, periodic_event_catches_up, .init = scheduler_setup) {
+    scheduler_schedule(EVENT_INPUT_POLL, 10);
+
+    cpu.cycle_count = 35;
+    scheduler_run_due();
+    cr_assert(eq(u32, fired, 3));
+    cr_expect(eq(u64, order_deadline[2], 30));
+    cr_expect(eq(u64, scheduler_next_deadline(), 40));
+}
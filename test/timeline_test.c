@@ -0,0 +1,92 @@
+#include <criterion/criterion.h>
+#include <criterion/new/assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "fixtures/cpu_mmu.h"
+#include "scheduler.h"
+#include "interrupt.h"
+#include "ppu.h"
+#include "timeline.h"
+
+static char timeline_path[] = "/tmp/yobemag_timelineXXXXXX";
+static char buf[1 << 25];
+
+static void timeline_setup(void) {
+    cpu_mmu_setup();
+    scheduler_init();
+    ppu_init();
+    interrupt_init();
+
+    close(mkstemp(timeline_path));
+    timeline_init(timeline_path);
+}
+
+static void timeline_fini(void) {
+    timeline_teardown();
+    unlink(timeline_path);
+    cpu_teardown();
+}
+
+// Stops the timeline and returns the JSON it wrote
+static const char *read_timeline(void) {
+    timeline_teardown();
+
+    FILE *file    = fopen(timeline_path, "r");
+    size_t length = fread(buf, 1, sizeof(buf) - 1, file);
+    fclose(file);
+    buf[length] = '\0';
+    return buf;
+}
+
+static size_t count(const char *haystack, const char *needle) {
+    size_t n = 0;
+    for (const char *at = strstr(haystack, needle); at != NULL; at = strstr(at + 1, needle)) {
+        ++n;
+    }
+    return n;
+}
+
+Test(timeline, ppu_spans_in_emulated_time, .init = timeline_setup, .fini = timeline_fini) {
+    mmu_write_byte(PPU_LCDC, LCDC_ENABLE);
+    run_until(CYCLES_PER_FRAME);
+
+    const char *json = read_timeline();
+    cr_assert(eq(int, strncmp(json, "{\"traceEvents\":[", 16), 0));
+    cr_expect(eq(int, strcmp(json + strlen(json) - 4, "\n]}\n"), 0));
+
+    cr_expect(eq(sz, count(json, "\"name\":\"frame\""), 1));
+    cr_expect(eq(sz, count(json, "\"name\":\"line\""), LINES_PER_FRAME));
+    cr_expect(eq(sz, count(json, "\"name\":\"OAM scan\""), VISIBLE_LINES));
+    // the first OAM scan takes 80 cycles, which are 19.073us
+    cr_expect_not_null(strstr(json, "{\"name\":\"OAM scan\",\"ph\":\"X\",\"pid\":2,\"tid\":1,\"ts\":0.000,\"dur\":19.073,"
+                                    "\"args\":{\"ly\":0}}"));
+}
+
+Test(timeline, interrupt_dispatch, .init = timeline_setup, .fini = timeline_fini) {
+    cpu.PC = 0xC123;
+    cpu.SP = 0xD000;
+    interrupt_write(IO_IE, IF_TIMER);
+    interrupt_enable_now();
+    interrupt_request(IF_TIMER);
+    interrupt_dispatch();
+
+    const char *json = read_timeline();
+    cr_expect_not_null(strstr(json, "{\"name\":\"timer\",\"ph\":\"X\",\"pid\":2,\"tid\":2"));
+    cr_expect_not_null(strstr(json, "\"args\":{\"pc\":49443}"));
+}
+
+Test(timeline, chunks_are_written_in_order, .init = timeline_setup, .fini = timeline_fini) {
+    uint32_t events = 2 * TIMELINE_CHUNK_EVENTS + 7;
+    for (uint32_t i = 0; i < events; ++i) {
+        timeline_cycles(TIMELINE_PPU, "span", i, i + 1, "i", i);
+    }
+
+    // events are dropped while the writer is a whole chunk behind, but never the first chunk
+    const char *json = read_timeline();
+    cr_expect(ge(sz, count(json, "\"name\":\"span\""), TIMELINE_CHUNK_EVENTS));
+    cr_expect_not_null(strstr(json, "\"args\":{\"i\":0}}"));
+    cr_expect_not_null(strstr(json, "\"args\":{\"i\":65535}}"));
+    cr_expect(eq(int, strcmp(json + strlen(json) - 4, "\n]}\n"), 0));
+}
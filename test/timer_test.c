@@ -0,0 +1,69 @@
+#include <criterion/criterion.h>
+#include <criterion/new/assert.h>
+
+#include "fixtures/cpu_mmu.h"
+#include "scheduler.h"
+#include "interrupt.h"
+#include "timer.h"
+
+#define TAC_ENABLE_16 (0x05)
+
+static void timer_setup(void) {
+    cpu_mmu_setup();
+    scheduler_init();
+    timer_init();
+}
+
+Test(timer, div_follows_clock, .init = timer_setup) {
+    run_until(0x1234);
+    cr_expect(eq(u8, mmu_get_byte(TIMER_DIV), 0x12));
+
+    mmu_write_byte(TIMER_DIV, 0xAB);
+    cr_expect(eq(u8, mmu_get_byte(TIMER_DIV), 0x00));
+
+    run_until(0x1234 + 0x300);
+    cr_expect(eq(u8, mmu_get_byte(TIMER_DIV), 0x03));
+}
+
+Test(timer, disabled_timer_schedules_nothing, .init = timer_setup) {
+    mmu_write_byte(TIMER_TIMA, 0xFE);
+    run_until(100000);
+
+    cr_expect(!scheduler_is_pending(EVENT_TIMER_OVERFLOW));
+    cr_expect(eq(u8, mmu_get_byte(TIMER_TIMA), 0xFE));
+    cr_expect(eq(u8, mmu_get_byte(TIMER_TAC), 0xF8));
+}
+
+Test(timer, tima_counts_without_events, .init = timer_setup) {
+    mmu_write_byte(TIMER_TAC, TAC_ENABLE_16);
+    run_until(16 * 10 + 3);
+
+    cr_expect(eq(u8, mmu_get_byte(TIMER_TIMA), 10));
+    cr_expect(eq(u64, scheduler_next_deadline(), 16 * 0x100));
+}
+
+Test(timer, overflow_reloads_tma_and_requests_interrupt, .init = timer_setup) {
+    mmu_write_byte(TIMER_TMA, 0xF0);
+    mmu_write_byte(TIMER_TIMA, 0xFF);
+    mmu_write_byte(TIMER_TAC, TAC_ENABLE_16);
+    interrupt_init();
+
+    run_until(16);
+    cr_expect(eq(u8, mmu_get_byte(TIMER_TIMA), 0xF0));
+    cr_expect(eq(u8, mmu_get_byte(IO_IF) & IF_TIMER, IF_TIMER));
+
+    // the next overflow is 16 increments after the reload
+    cr_expect(eq(u64, scheduler_next_deadline(), 16 + 16 * 16));
+}
+
+Test(timer, tac_write_reschedules_overflow, .init = timer_setup) {
+    mmu_write_byte(TIMER_TAC, TAC_ENABLE_16);
+    cr_expect(eq(u64, scheduler_next_deadline(), 16 * 0x100));
+
+    // 1024 cycles per increment
+    mmu_write_byte(TIMER_TAC, 0x04);
+    cr_expect(eq(u64, scheduler_next_deadline(), 1024 * 0x100));
+
+    mmu_write_byte(TIMER_TAC, 0x00);
+    cr_expect(!scheduler_is_pending(EVENT_TIMER_OVERFLOW));
+}
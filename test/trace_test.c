@@ -0,0 +1,88 @@
+#include <criterion/criterion.h>
+#include <criterion/new/assert.h>
+#include <unistd.h>
+
+#include "fixtures/cpu_mmu.h"
+#include "scheduler.h"
+#include "interrupt.h"
+
+#if defined(YOBEMAG_TRACE)
+
+    #include "trace.h"
+
+    #define CODE_ADDR (0xC000)
+
+static char trace_path[] = "/tmp/yobemag_traceXXXXXX";
+
+static void trace_setup(void) {
+    cpu_mmu_setup();
+    scheduler_init();
+    interrupt_init();
+
+    close(mkstemp(trace_path));
+}
+
+static void trace_fini(void) {
+    trace_teardown();
+    unlink(trace_path);
+    cpu_teardown();
+}
+
+Test(trace, records_state_before_instruction, .init = trace_setup, .fini = trace_fini) {
+    // NOP; LD B,0x12; loop: INC B; JR loop
+    const uint8_t code[] = {0x00, 0x06, 0x12, 0x04, 0x18, 0xFD};
+    load_code(CODE_ADDR, code, sizeof(code));
+    cpu.PC = CODE_ADDR;
+    cpu.SP = 0xD000;
+    trace_init(trace_path, 16);
+
+    uint64_t start = cpu.cycle_count;
+    cpu_run(40);
+
+    cr_assert(ge(u64, trace_header->written, 4));
+    cr_assert(eq(u32, trace_header->capacity, 16));
+
+    const TraceRecord *nop = &trace_ring[0];
+    cr_expect(eq(u16, nop->pc, CODE_ADDR));
+    cr_expect(eq(u16, nop->sp, 0xD000));
+    cr_expect(eq(u64, nop->cycle, start));
+    // NOP; LD B,0x12; INC B
+    cr_expect(eq(u32, nop->memory, 0x04120600));
+
+    const TraceRecord *ld = &trace_ring[1];
+    cr_expect(eq(u16, ld->pc, CODE_ADDR + 1));
+    cr_expect(eq(u64, ld->cycle, start + 4));
+
+    // registers are recorded before the instruction changes them
+    const TraceRecord *inc = &trace_ring[2];
+    cr_expect(eq(u16, inc->pc, CODE_ADDR + 3));
+    cr_expect(eq(u64, inc->cycle, start + 12));
+    cr_expect(eq(u8, inc->b, 0x12));
+    cr_expect(eq(u8, trace_ring[4].b, 0x13));
+    cr_expect(eq(u16, trace_ring[4].pc, CODE_ADDR + 3));
+}
+
+Test(trace, ring_keeps_latest_records, .init = trace_setup, .fini = trace_fini) {
+    // loop: NOP; JR loop
+    const uint8_t code[] = {0x00, 0x18, 0xFD};
+    load_code(CODE_ADDR, code, sizeof(code));
+    cpu.PC = CODE_ADDR;
+    cpu.SP = 0xD000;
+    trace_init(trace_path, 6);
+
+    cpu_run(1000);
+
+    cr_assert(eq(u32, trace_header->capacity, 4));
+    cr_assert(gt(u64, trace_header->written, 4));
+
+    // the newest record overwrote the oldest one, each previous record is an older instruction
+    uint64_t newest = trace_header->written - 1;
+    for (uint64_t i = newest; i > newest - 3; --i) {
+        const TraceRecord *record = &trace_ring[i & 3];
+        const TraceRecord *before = &trace_ring[(i - 1) & 3];
+        cr_expect(gt(u64, record->cycle, before->cycle));
+        cr_expect(ne(u16, record->pc, before->pc));
+    }
+}
+
+#endif // defined(YOBEMAG_TRACE)
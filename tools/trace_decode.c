@@ -0,0 +1,87 @@
+/*
+ * Decodes a binary instruction trace recorded by `yobemag -T <trace>` (TRACE=1 builds), oldest instruction first.
+ *
+ * Usage: yobemag_trace_decode [-d] <trace>
+ *   -d  Print the Gameboy Doctor log format instead of the annotated text format
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <getopt.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "trace.h"
+
+#define MEMORY_BYTE(record, i) ((unsigned) ((record)->memory >> (8 * (i))) & 0xFF)
+
+static void print_text(const TraceRecord *record) {
+    printf("%14" PRIu64 "  %04X: %02X %02X %02X %02X  A:%02X F:%c%c%c%c BC:%02X%02X DE:%02X%02X HL:%02X%02X SP:%04X\n",
+           record->cycle, record->pc, MEMORY_BYTE(record, 0), MEMORY_BYTE(record, 1), MEMORY_BYTE(record, 2),
+           MEMORY_BYTE(record, 3), record->a, record->f & 0x80 ? 'Z' : '-', record->f & 0x40 ? 'N' : '-',
+           record->f & 0x20 ? 'H' : '-', record->f & 0x10 ? 'C' : '-', record->b, record->c, record->d, record->e,
+           record->h, record->l, record->sp);
+}
+
+static void print_doctor(const TraceRecord *record) {
+    printf("A:%02X F:%02X B:%02X C:%02X D:%02X E:%02X H:%02X L:%02X SP:%04X PC:%04X PCMEM:%02X,%02X,%02X,%02X\n",
+           record->a, record->f, record->b, record->c, record->d, record->e, record->h, record->l, record->sp,
+           record->pc, MEMORY_BYTE(record, 0), MEMORY_BYTE(record, 1), MEMORY_BYTE(record, 2), MEMORY_BYTE(record, 3));
+}
+
+int main(int argc, char **argv) {
+    bool doctor = false;
+    int c;
+    while ((c = getopt(argc, argv, "d")) != -1) {
+        if (c != 'd') {
+            fprintf(stderr, "Usage: %s [-d] <trace>\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+        doctor = true;
+    }
+    if (optind + 1 != argc) {
+        fprintf(stderr, "Usage: %s [-d] <trace>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const char *path = argv[optind];
+    int fd           = open(path, O_RDONLY);
+    struct stat st;
+    if (fd == -1 || fstat(fd, &st) == -1) {
+        perror(path);
+        return EXIT_FAILURE;
+    }
+
+    size_t size   = (size_t) st.st_size;
+    void *mapping = size >= sizeof(TraceHeader) ? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+
+    const TraceHeader *header  = mapping;
+    const TraceRecord *records = (const TraceRecord *) (header + 1);
+    if (mapping == MAP_FAILED || memcmp(header->magic, TRACE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->record_size != sizeof(TraceRecord) ||
+        size < sizeof(TraceHeader) + (size_t) header->capacity * sizeof(TraceRecord)) {
+        fprintf(stderr, "%s is not a trace of this version\n", path);
+        return EXIT_FAILURE;
+    }
+
+    // once the ring wrapped, the oldest record follows the newest one
+    uint64_t first = header->written > header->capacity ? header->written - header->capacity : 0;
+    for (uint64_t i = first; i < header->written; ++i) {
+        const TraceRecord *record = &records[i & (header->capacity - 1)];
+        if (doctor) {
+            print_doctor(record);
+        } else {
+            print_text(record);
+        }
+    }
+
+    munmap(mapping, size);
+    return EXIT_SUCCESS;
+}